@@ -0,0 +1,707 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#ifndef KERNEL
+
+#    include <AK/Atomic.h>
+#    include <AK/ByteBuffer.h>
+#    include <AK/Function.h>
+#    include <AK/Noncopyable.h>
+#    include <AK/NonnullOwnPtr.h>
+#    include <AK/OSError.h>
+#    include <AK/Queue.h>
+#    include <AK/Result.h>
+#    include <AK/Span.h>
+#    include <AK/Stream.h>
+#    include <AK/Types.h>
+#    include <AK/Vector.h>
+#    include <errno.h>
+#    include <fcntl.h>
+#    include <poll.h>
+#    include <pthread.h>
+#    include <sys/types.h>
+#    include <unistd.h>
+
+#    ifdef __linux__
+#        include <linux/io_uring.h>
+#        include <sys/eventfd.h>
+#        include <sys/mman.h>
+#        include <sys/syscall.h>
+#        include <sys/uio.h>
+#    endif
+
+namespace AK {
+
+/* Reads and writes files without blocking the calling thread.
+ *
+ * read() and write() only queue a request; submit() hands everything queued
+ * so far to the backend in one batch. Completion callbacks never run behind
+ * your back: process_completions() and wait() run them on the calling thread.
+ * To hook this up to an event loop, watch notify_fd() for readability (e.g.
+ * with a Core::Notifier) and call process_completions() when it fires.
+ *
+ * On Linux, the io_uring backend is used if the kernel supports it. Reads and
+ * writes that fall within a buffer passed to register_buffers() then become
+ * fixed-buffer operations, which saves the kernel from pinning the pages for
+ * every request. Otherwise a small pool of threads does pread() and pwrite().
+ *
+ * Buffers have to stay alive until their callback has run, and the callbacks
+ * of requests that are still in flight are dropped when the engine goes away.
+ */
+class AsyncFileIO {
+    AK_MAKE_NONCOPYABLE(AsyncFileIO);
+    AK_MAKE_NONMOVABLE(AsyncFileIO);
+
+public:
+    enum class Backend {
+        Automatic,
+        IOUring,
+        ThreadPool,
+    };
+
+    // Receives the number of bytes transferred, or a negative errno value.
+    using Callback = Function<void(ssize_t)>;
+
+    static Result<NonnullOwnPtr<AsyncFileIO>, OSError> create(Backend = Backend::Automatic, u32 queue_depth = 64);
+
+    virtual ~AsyncFileIO() = default;
+
+    virtual Backend backend() const = 0;
+
+    void read(int fd, Bytes buffer, u64 offset, Callback callback)
+    {
+        m_queued.append({ Request::Type::Read, fd, buffer.data(), buffer.size(), offset, store_callback(move(callback)) });
+    }
+
+    void write(int fd, ReadonlyBytes buffer, u64 offset, Callback callback)
+    {
+        m_queued.append({ Request::Type::Write, fd, const_cast<u8*>(buffer.data()), buffer.size(), offset, store_callback(move(callback)) });
+    }
+
+    // Returns how many requests were handed to the backend.
+    size_t submit()
+    {
+        if (m_queued.is_empty())
+            return 0;
+        auto batch = move(m_queued);
+        m_in_flight += batch.size();
+        submit_batch(batch);
+        return batch.size();
+    }
+
+    virtual Result<void, OSError> register_buffers(Span<Bytes>) { return {}; }
+
+    // Becomes readable whenever there are completions waiting for process_completions().
+    virtual int notify_fd() const = 0;
+
+    // Runs the callbacks of all requests that have completed so far, without blocking. Returns how many ran.
+    size_t process_completions() { return run_callbacks(reap_completions(false)); }
+
+    // Submits whatever is queued, then blocks until at least `minimum` callbacks have run,
+    // or nothing is in flight anymore. Returns how many ran.
+    size_t wait(size_t minimum = 1)
+    {
+        submit();
+        size_t processed = process_completions();
+        while (processed < minimum && m_in_flight > 0)
+            processed += run_callbacks(reap_completions(true));
+        return processed;
+    }
+
+    size_t in_flight() const { return m_in_flight; }
+    size_t queued() const { return m_queued.size(); }
+
+protected:
+    AsyncFileIO() = default;
+
+    struct Request {
+        enum class Type {
+            Read,
+            Write,
+        };
+
+        Type type;
+        int fd;
+        u8* data;
+        size_t size;
+        u64 offset;
+        size_t callback_slot;
+    };
+
+    struct Completion {
+        size_t callback_slot;
+        ssize_t result;
+    };
+
+    virtual void submit_batch(Vector<Request>&) = 0;
+    // Collects the completions that are ready, or blocks until at least one is if `block` is set.
+    virtual Vector<Completion> reap_completions(bool block) = 0;
+
+    static ssize_t perform_blocking(const Request& request)
+    {
+        for (;;) {
+            auto rc = request.type == Request::Type::Read
+                ? ::pread(request.fd, request.data, request.size, request.offset)
+                : ::pwrite(request.fd, request.data, request.size, request.offset);
+            if (rc >= 0)
+                return rc;
+            if (errno != EINTR)
+                return -errno;
+        }
+    }
+
+private:
+    size_t store_callback(Callback&& callback)
+    {
+        if (!m_free_callback_slots.is_empty()) {
+            auto slot = m_free_callback_slots.take_last();
+            m_callbacks[slot] = move(callback);
+            return slot;
+        }
+        m_callbacks.append(move(callback));
+        return m_callbacks.size() - 1;
+    }
+
+    size_t run_callbacks(Vector<Completion> completions)
+    {
+        // Everything is taken out of the tables before the first callback runs, since callbacks may queue more requests.
+        Vector<Callback> callbacks;
+        callbacks.ensure_capacity(completions.size());
+        for (auto& completion : completions) {
+            callbacks.unchecked_append(move(m_callbacks[completion.callback_slot]));
+            m_callbacks[completion.callback_slot] = nullptr;
+            m_free_callback_slots.append(completion.callback_slot);
+        }
+        VERIFY(m_in_flight >= completions.size());
+        m_in_flight -= completions.size();
+
+        for (size_t i = 0; i < completions.size(); ++i) {
+            if (callbacks[i])
+                callbacks[i](completions[i].result);
+        }
+        return completions.size();
+    }
+
+    Vector<Request> m_queued;
+    Vector<Callback> m_callbacks;
+    Vector<size_t> m_free_callback_slots;
+    size_t m_in_flight { 0 };
+};
+
+namespace Detail {
+
+class ThreadPoolFileIO final : public AsyncFileIO {
+public:
+    static Result<NonnullOwnPtr<AsyncFileIO>, OSError> create(u32 queue_depth)
+    {
+        int fds[2];
+        if (::pipe(fds) < 0)
+            return OSError(errno);
+        for (auto fd : fds) {
+            ::fcntl(fd, F_SETFL, O_NONBLOCK);
+            ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+
+        auto io = adopt_own(*new ThreadPoolFileIO(fds[0], fds[1]));
+        auto thread_count = clamp<u32>(queue_depth / 8, 1, 8);
+        for (u32 i = 0; i < thread_count; ++i) {
+            pthread_t thread;
+            int rc = pthread_create(
+                &thread, nullptr, [](void* argument) -> void* {
+                    static_cast<ThreadPoolFileIO*>(argument)->work();
+                    return nullptr;
+                },
+                io.ptr());
+            if (rc != 0)
+                return OSError(rc);
+            io->m_threads.append(thread);
+        }
+        return NonnullOwnPtr<AsyncFileIO>(move(io));
+    }
+
+    ~ThreadPoolFileIO() override
+    {
+        pthread_mutex_lock(&m_mutex);
+        m_shutting_down = true;
+        pthread_cond_broadcast(&m_work_available);
+        pthread_mutex_unlock(&m_mutex);
+        for (auto thread : m_threads)
+            pthread_join(thread, nullptr);
+
+        ::close(m_notify_read_fd);
+        ::close(m_notify_write_fd);
+        pthread_cond_destroy(&m_work_available);
+        pthread_cond_destroy(&m_completion_available);
+        pthread_mutex_destroy(&m_mutex);
+    }
+
+    Backend backend() const override { return Backend::ThreadPool; }
+    int notify_fd() const override { return m_notify_read_fd; }
+
+private:
+    ThreadPoolFileIO(int notify_read_fd, int notify_write_fd)
+        : m_notify_read_fd(notify_read_fd)
+        , m_notify_write_fd(notify_write_fd)
+    {
+        pthread_mutex_init(&m_mutex, nullptr);
+        pthread_cond_init(&m_work_available, nullptr);
+        pthread_cond_init(&m_completion_available, nullptr);
+    }
+
+    void submit_batch(Vector<Request>& batch) override
+    {
+        pthread_mutex_lock(&m_mutex);
+        for (auto& request : batch)
+            m_work.enqueue(request);
+        pthread_cond_broadcast(&m_work_available);
+        pthread_mutex_unlock(&m_mutex);
+    }
+
+    Vector<Completion> reap_completions(bool block) override
+    {
+        pthread_mutex_lock(&m_mutex);
+        while (block && m_completions.is_empty())
+            pthread_cond_wait(&m_completion_available, &m_mutex);
+        auto completions = move(m_completions);
+        // Drain the pipe while holding the lock, so a worker can't slip in a notification we'd then swallow.
+        u8 drain[64];
+        while (::read(m_notify_read_fd, drain, sizeof(drain)) > 0)
+            ;
+        pthread_mutex_unlock(&m_mutex);
+        return completions;
+    }
+
+    void work()
+    {
+        pthread_mutex_lock(&m_mutex);
+        for (;;) {
+            while (m_work.is_empty() && !m_shutting_down)
+                pthread_cond_wait(&m_work_available, &m_mutex);
+            // Requests still in flight are finished before shutting down, as their buffers are still being written to.
+            if (m_work.is_empty())
+                break;
+            auto request = m_work.dequeue();
+            pthread_mutex_unlock(&m_mutex);
+
+            auto result = perform_blocking(request);
+
+            pthread_mutex_lock(&m_mutex);
+            if (m_completions.is_empty()) {
+                u8 byte = 0;
+                [[maybe_unused]] auto rc = ::write(m_notify_write_fd, &byte, 1);
+                pthread_cond_broadcast(&m_completion_available);
+            }
+            m_completions.append({ request.callback_slot, result });
+        }
+        pthread_mutex_unlock(&m_mutex);
+    }
+
+    int m_notify_read_fd { -1 };
+    int m_notify_write_fd { -1 };
+    Vector<pthread_t> m_threads;
+
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_work_available;
+    pthread_cond_t m_completion_available;
+    Queue<Request> m_work;
+    Vector<Completion> m_completions;
+    bool m_shutting_down { false };
+};
+
+#    ifdef __linux__
+
+class IOUringFileIO final : public AsyncFileIO {
+public:
+    static Result<NonnullOwnPtr<AsyncFileIO>, OSError> create(u32 queue_depth)
+    {
+        io_uring_params params {};
+        // Leave the completion queue enough room for a few batches that haven't been reaped yet.
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = queue_depth * 4;
+        int ring_fd = ::syscall(__NR_io_uring_setup, queue_depth, &params);
+        if (ring_fd < 0)
+            return OSError(errno);
+
+        auto io = adopt_own(*new IOUringFileIO(ring_fd));
+        if (!(params.features & IORING_FEAT_NODROP))
+            return OSError(ENOTSUP);
+
+        io->m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+        io->m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        io->m_sq_ring = ::mmap(nullptr, io->m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if (io->m_sq_ring == MAP_FAILED)
+            return OSError(errno);
+        io->m_cq_ring = ::mmap(nullptr, io->m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if (io->m_cq_ring == MAP_FAILED)
+            return OSError(errno);
+        io->m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        auto* sqes = ::mmap(nullptr, io->m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+            return OSError(errno);
+        io->m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+        auto* sq = static_cast<u8*>(io->m_sq_ring);
+        io->m_sq_head = reinterpret_cast<u32*>(sq + params.sq_off.head);
+        io->m_sq_tail = reinterpret_cast<u32*>(sq + params.sq_off.tail);
+        io->m_sq_mask = *reinterpret_cast<u32*>(sq + params.sq_off.ring_mask);
+        io->m_sq_entries = params.sq_entries;
+        io->m_sq_array = reinterpret_cast<u32*>(sq + params.sq_off.array);
+
+        auto* cq = static_cast<u8*>(io->m_cq_ring);
+        io->m_cq_head = reinterpret_cast<u32*>(cq + params.cq_off.head);
+        io->m_cq_tail = reinterpret_cast<u32*>(cq + params.cq_off.tail);
+        io->m_cq_mask = *reinterpret_cast<u32*>(cq + params.cq_off.ring_mask);
+        io->m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        io->m_event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (io->m_event_fd < 0)
+            return OSError(errno);
+        if (::syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_EVENTFD, &io->m_event_fd, 1) < 0)
+            return OSError(errno);
+
+        return NonnullOwnPtr<AsyncFileIO>(move(io));
+    }
+
+    ~IOUringFileIO() override
+    {
+        // The kernel may still be writing into buffers for requests in flight, so let those finish first.
+        auto outstanding = in_flight() - m_pending_completions.size();
+        while (outstanding > 0) {
+            auto nreaped = reap_from_ring().size();
+            if (nreaped == 0 && ::syscall(__NR_io_uring_enter, m_ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+                break;
+            outstanding -= min(nreaped, outstanding);
+        }
+
+        if (m_event_fd >= 0)
+            ::close(m_event_fd);
+        if (m_sqes)
+            ::munmap(m_sqes, m_sqes_size);
+        if (m_cq_ring && m_cq_ring != MAP_FAILED)
+            ::munmap(m_cq_ring, m_cq_ring_size);
+        if (m_sq_ring && m_sq_ring != MAP_FAILED)
+            ::munmap(m_sq_ring, m_sq_ring_size);
+        ::close(m_ring_fd);
+    }
+
+    Backend backend() const override { return Backend::IOUring; }
+    int notify_fd() const override { return m_event_fd; }
+
+    Result<void, OSError> register_buffers(AK::Span<Bytes> buffers) override
+    {
+        if (!m_registered_buffers.is_empty()) {
+            if (::syscall(__NR_io_uring_register, m_ring_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0) < 0)
+                return OSError(errno);
+            m_registered_buffers.clear();
+        }
+        if (buffers.is_empty())
+            return {};
+
+        Vector<iovec> vectors;
+        for (auto buffer : buffers)
+            vectors.append(iovec { buffer.data(), buffer.size() });
+        if (::syscall(__NR_io_uring_register, m_ring_fd, IORING_REGISTER_BUFFERS, vectors.data(), vectors.size()) < 0)
+            return OSError(errno);
+        m_registered_buffers.append(buffers.data(), buffers.size());
+        return {};
+    }
+
+private:
+    explicit IOUringFileIO(int ring_fd)
+        : m_ring_fd(ring_fd)
+    {
+    }
+
+    Optional<u16> registered_buffer_index(const Request& request) const
+    {
+        for (size_t i = 0; i < m_registered_buffers.size(); ++i) {
+            auto buffer = m_registered_buffers[i];
+            if (request.data >= buffer.data() && request.data + request.size <= buffer.data() + buffer.size())
+                return static_cast<u16>(i);
+        }
+        return {};
+    }
+
+    void submit_batch(Vector<Request>& batch) override
+    {
+        size_t next = 0;
+        while (next < batch.size()) {
+            u32 tail = *m_sq_tail;
+            u32 head = AK::atomic_load(m_sq_head, AK::memory_order_acquire);
+            u32 to_submit = 0;
+            while (next < batch.size() && tail - head < m_sq_entries) {
+                auto& request = batch[next++];
+                auto index = tail & m_sq_mask;
+                auto& sqe = m_sqes[index];
+                __builtin_memset(&sqe, 0, sizeof(sqe));
+                auto buffer_index = registered_buffer_index(request);
+                if (buffer_index.has_value()) {
+                    sqe.opcode = request.type == Request::Type::Read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+                    sqe.buf_index = buffer_index.value();
+                } else {
+                    sqe.opcode = request.type == Request::Type::Read ? IORING_OP_READ : IORING_OP_WRITE;
+                }
+                sqe.fd = request.fd;
+                sqe.addr = reinterpret_cast<FlatPtr>(request.data);
+                sqe.len = request.size;
+                sqe.off = request.offset;
+                sqe.user_data = request.callback_slot;
+                m_sq_array[index] = index;
+                ++tail;
+                ++to_submit;
+            }
+            AK::atomic_store(m_sq_tail, tail, AK::memory_order_release);
+
+            while (to_submit > 0) {
+                auto rc = ::syscall(__NR_io_uring_enter, m_ring_fd, to_submit, 0, 0, nullptr, 0);
+                if (rc < 0) {
+                    if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                        // The completion queue is backed up; make room by reaping, and try again.
+                        m_pending_completions.append(reap_from_ring());
+                        continue;
+                    }
+                    // Whatever the kernel didn't take can't be submitted at all; fail those requests.
+                    auto error = errno;
+                    for (size_t i = next - to_submit; i < next; ++i)
+                        m_pending_completions.append({ batch[i].callback_slot, -error });
+                    AK::atomic_store(m_sq_tail, tail - to_submit, AK::memory_order_release);
+                    break;
+                }
+                to_submit -= rc;
+            }
+        }
+    }
+
+    Vector<Completion> reap_from_ring()
+    {
+        Vector<Completion> completions;
+        u32 head = *m_cq_head;
+        u32 tail = AK::atomic_load(m_cq_tail, AK::memory_order_acquire);
+        for (; head != tail; ++head) {
+            auto& cqe = m_cqes[head & m_cq_mask];
+            completions.append({ static_cast<size_t>(cqe.user_data), cqe.res });
+        }
+        AK::atomic_store(m_cq_head, head, AK::memory_order_release);
+        return completions;
+    }
+
+    Vector<Completion> reap_completions(bool block) override
+    {
+        u64 counter;
+        [[maybe_unused]] auto rc = ::read(m_event_fd, &counter, sizeof(counter));
+
+        auto completions = move(m_pending_completions);
+        completions.append(reap_from_ring());
+        while (block && completions.is_empty()) {
+            if (::syscall(__NR_io_uring_enter, m_ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+                break;
+            completions.append(reap_from_ring());
+        }
+        return completions;
+    }
+
+    int m_ring_fd { -1 };
+    int m_event_fd { -1 };
+
+    void* m_sq_ring { nullptr };
+    size_t m_sq_ring_size { 0 };
+    void* m_cq_ring { nullptr };
+    size_t m_cq_ring_size { 0 };
+    io_uring_sqe* m_sqes { nullptr };
+    size_t m_sqes_size { 0 };
+
+    u32* m_sq_head { nullptr };
+    u32* m_sq_tail { nullptr };
+    u32* m_sq_array { nullptr };
+    u32 m_sq_mask { 0 };
+    u32 m_sq_entries { 0 };
+
+    u32* m_cq_head { nullptr };
+    u32* m_cq_tail { nullptr };
+    io_uring_cqe* m_cqes { nullptr };
+    u32 m_cq_mask { 0 };
+
+    Vector<Bytes> m_registered_buffers;
+    Vector<Completion> m_pending_completions;
+};
+
+#    endif
+
+}
+
+inline Result<NonnullOwnPtr<AsyncFileIO>, OSError> AsyncFileIO::create(Backend backend, u32 queue_depth)
+{
+    VERIFY(queue_depth > 0);
+#    ifdef __linux__
+    if (backend != Backend::ThreadPool) {
+        auto io_uring = Detail::IOUringFileIO::create(queue_depth);
+        if (!io_uring.is_error() || backend == Backend::IOUring)
+            return io_uring;
+    }
+#    else
+    if (backend == Backend::IOUring)
+        return OSError(ENOTSUP);
+#    endif
+    return Detail::ThreadPoolFileIO::create(queue_depth);
+}
+
+/* Reads a file front to back through an AsyncFileIO, keeping a few blocks
+ * ahead of the reader in flight, so the disk is busy while the data that has
+ * already arrived is being processed.
+ *
+ * A short read is taken to mean the end of the file, so this is meant for
+ * regular files.
+ */
+class AsyncInputStream final : public InputStream {
+    AK_MAKE_NONCOPYABLE(AsyncInputStream);
+    AK_MAKE_NONMOVABLE(AsyncInputStream);
+
+public:
+    AsyncInputStream(AsyncFileIO& io, int fd, u64 offset = 0, size_t block_size = 64 * KiB, size_t read_ahead = 4)
+        : m_io(io)
+        , m_fd(fd)
+        , m_next_offset(offset)
+        , m_block_size(block_size)
+    {
+        VERIFY(read_ahead > 0);
+        m_blocks.resize(read_ahead);
+        for (size_t i = 0; i < read_ahead; ++i) {
+            m_blocks[i].buffer = ByteBuffer::create_uninitialized(block_size);
+            issue(i);
+        }
+        m_io.submit();
+    }
+
+    ~AsyncInputStream()
+    {
+        // The callbacks point back at us, and the kernel may still be writing into our buffers.
+        for (;;) {
+            bool all_done = true;
+            for (auto& block : m_blocks)
+                all_done &= !block.in_flight;
+            if (all_done)
+                break;
+            m_io.wait();
+        }
+    }
+
+    bool unreliable_eof() const override { return m_eof; }
+    bool eof() const { return m_eof; }
+
+    size_t read(Bytes bytes) override
+    {
+        if (has_any_error())
+            return 0;
+
+        size_t nread = 0;
+        while (nread < bytes.size() && !m_eof) {
+            auto& block = m_blocks[m_current];
+            while (block.in_flight)
+                m_io.wait();
+
+            if (block.result < 0) {
+                set_fatal_error();
+                break;
+            }
+
+            auto available = static_cast<size_t>(block.result) - m_offset_in_block;
+            auto ncopied = min(available, bytes.size() - nread);
+            __builtin_memcpy(bytes.data() + nread, block.buffer.data() + m_offset_in_block, ncopied);
+            nread += ncopied;
+            m_offset_in_block += ncopied;
+
+            if (m_offset_in_block == static_cast<size_t>(block.result)) {
+                if (static_cast<size_t>(block.result) < m_block_size) {
+                    m_eof = true;
+                    break;
+                }
+                issue(m_current);
+                m_io.submit();
+                m_current = (m_current + 1) % m_blocks.size();
+                m_offset_in_block = 0;
+            }
+        }
+        return nread;
+    }
+
+    bool read_or_error(Bytes bytes) override
+    {
+        if (read(bytes) < bytes.size()) {
+            set_recoverable_error();
+            return false;
+        }
+        return true;
+    }
+
+    bool discard_or_error(size_t count) override
+    {
+        u8 buffer[4096];
+        while (count > 0) {
+            auto nread = read({ buffer, min(count, sizeof(buffer)) });
+            if (nread == 0) {
+                set_recoverable_error();
+                return false;
+            }
+            count -= nread;
+        }
+        return true;
+    }
+
+private:
+    struct Block {
+        ByteBuffer buffer;
+        ssize_t result { 0 };
+        bool in_flight { false };
+    };
+
+    void issue(size_t index)
+    {
+        auto& block = m_blocks[index];
+        block.in_flight = true;
+        m_io.read(m_fd, block.buffer, m_next_offset, [this, index](ssize_t result) {
+            m_blocks[index].result = result;
+            m_blocks[index].in_flight = false;
+        });
+        m_next_offset += m_block_size;
+    }
+
+    AsyncFileIO& m_io;
+    int m_fd { -1 };
+    u64 m_next_offset { 0 };
+    size_t m_block_size { 0 };
+    Vector<Block> m_blocks;
+    size_t m_current { 0 };
+    size_t m_offset_in_block { 0 };
+    bool m_eof { false };
+};
+
+}
+
+using AK::AsyncFileIO;
+using AK::AsyncInputStream;
+
+#endif
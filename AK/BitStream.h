@@ -22,36 +22,72 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+
 #pragma once
 
-#include <AK/Optional.h>
+#include <AK/Endian.h>
+#include <AK/Noncopyable.h>
+#include <AK/Span.h>
 #include <AK/Stream.h>
 
 namespace AK {
 
+enum class BitOrder {
+    // The first bit in the stream is the least significant bit of the first byte, as in DEFLATE.
+    LSBFirst,
+    // The first bit in the stream is the most significant bit of the first byte, as in JPEG.
+    MSBFirst,
+};
+
+/* Bits are kept in a 64-bit buffer that is refilled a whole word at a time,
+ * either straight from an in-memory span or from a small staging buffer in
+ * front of another stream. Table-driven decoders can use peek_bits() to look
+ * ahead and consume_bits() to drop only as many bits as the matched code had.
+ *
+ * NOTE: When reading from another stream, this reads ahead, so once bits have
+ * been read, all further reads have to go through the InputBitStream.
+ */
 class InputBitStream final : public InputStream {
+    AK_MAKE_NONCOPYABLE(InputBitStream);
+    AK_MAKE_NONMOVABLE(InputBitStream);
+
 public:
-    explicit InputBitStream(InputStream& stream)
-        : m_stream(stream)
+    explicit InputBitStream(InputStream& stream, BitOrder order = BitOrder::LSBFirst)
+        : m_stream(&stream)
+        , m_order(order)
+    {
+    }
+
+    explicit InputBitStream(ReadonlyBytes bytes, BitOrder order = BitOrder::LSBFirst)
+        : m_source(bytes)
+        , m_order(order)
     {
     }
 
+    // Aligns to the next byte boundary before reading.
     size_t read(Bytes bytes) override
     {
         if (has_any_error())
             return 0;
 
-        size_t nread = 0;
-        if (bytes.size() >= 1) {
-            if (m_next_byte.has_value()) {
-                bytes[0] = m_next_byte.value();
-                m_next_byte.clear();
+        align_to_byte_boundary();
 
-                ++nread;
-            }
+        size_t nread = 0;
+        while (nread < bytes.size() && m_bit_count >= 8) {
+            bytes[nread++] = static_cast<u8>(peek_bits_unchecked(8));
+            consume_bits_unchecked(8);
         }
+        if (nread == bytes.size())
+            return nread;
+
+        m_bit_buffer = 0;
+        auto ncopied = m_source.copy_trimmed_to(bytes.slice(nread));
+        m_source = m_source.slice(ncopied);
+        nread += ncopied;
 
-        return nread + m_stream.read(bytes.slice(nread));
+        if (nread < bytes.size() && m_stream)
+            nread += m_stream->read(bytes.slice(nread));
+        return nread;
     }
 
     bool read_or_error(Bytes bytes) override
@@ -64,81 +100,193 @@ public:
         return true;
     }
 
-    bool unreliable_eof() const override { return !m_next_byte.has_value() && m_stream.unreliable_eof(); }
+    bool unreliable_eof() const override { return m_bit_count == 0 && m_source.is_empty() && (!m_stream || m_stream->unreliable_eof()); }
 
+    // Aligns to the next byte boundary before discarding.
     bool discard_or_error(size_t count) override
     {
-        if (count >= 1) {
-            if (m_next_byte.has_value()) {
-                m_next_byte.clear();
-                --count;
-            }
+        align_to_byte_boundary();
+
+        while (count > 0 && m_bit_count >= 8) {
+            consume_bits_unchecked(8);
+            --count;
         }
+        if (count == 0)
+            return true;
 
-        return m_stream.discard_or_error(count);
+        m_bit_buffer = 0;
+        auto nskipped = min(count, m_source.size());
+        m_source = m_source.slice(nskipped);
+        count -= nskipped;
+        if (count == 0)
+            return true;
+
+        if (!m_stream || !m_stream->discard_or_error(count)) {
+            set_fatal_error();
+            return false;
+        }
+        return true;
     }
 
-    u32 read_bits(size_t count)
+    // Returns the next count bits without consuming them. Past the end of the stream, the missing bits read as zero.
+    u32 peek_bits(size_t count)
     {
-        u32 result = 0;
+        VERIFY(count <= 32);
+        if (m_bit_count < count)
+            refill();
+        return peek_bits_unchecked(count);
+    }
 
-        size_t nread = 0;
-        while (nread < count) {
-            if (m_stream.has_any_error()) {
+    bool consume_bits(size_t count)
+    {
+        VERIFY(count <= 32);
+        if (m_bit_count < count) {
+            refill();
+            if (m_bit_count < count) {
                 set_fatal_error();
-                return 0;
+                return false;
             }
+        }
+        consume_bits_unchecked(count);
+        return true;
+    }
 
-            if (m_next_byte.has_value()) {
-                const auto bit = (m_next_byte.value() >> m_bit_offset) & 1;
-                result |= bit << nread;
-                ++nread;
-
-                if (m_bit_offset++ == 7)
-                    m_next_byte.clear();
-            } else {
-                m_stream >> m_next_byte;
-                m_bit_offset = 0;
+    // With BitOrder::LSBFirst the first bit read ends up in the least significant bit of the result,
+    // with BitOrder::MSBFirst in the most significant one.
+    u32 read_bits(size_t count)
+    {
+        VERIFY(count <= 32);
+        if (m_bit_count < count) {
+            refill();
+            if (m_bit_count < count) {
+                set_fatal_error();
+                return 0;
             }
         }
-
-        return result;
+        auto bits = peek_bits_unchecked(count);
+        consume_bits_unchecked(count);
+        return bits;
     }
 
     bool read_bit() { return static_cast<bool>(read_bits(1)); }
 
-    void align_to_byte_boundary()
-    {
-        if (m_next_byte.has_value())
-            m_next_byte.clear();
-    }
+    void align_to_byte_boundary() { consume_bits_unchecked(m_bit_count % 8); }
 
     bool handle_any_error() override
     {
-        bool handled_errors = m_stream.handle_any_error();
+        bool handled_errors = m_stream && m_stream->handle_any_error();
         return Stream::handle_any_error() || handled_errors;
     }
 
 private:
-    Optional<u8> m_next_byte;
-    size_t m_bit_offset { 0 };
-    InputStream& m_stream;
+    static constexpr size_t staging_size = 256;
+
+    u32 peek_bits_unchecked(size_t count) const
+    {
+        if (count == 0)
+            return 0;
+        if (m_order == BitOrder::LSBFirst)
+            return static_cast<u32>(m_bit_buffer & ((1ull << count) - 1));
+        return static_cast<u32>(m_bit_buffer >> (64 - count));
+    }
+
+    void consume_bits_unchecked(size_t count)
+    {
+        VERIFY(count <= m_bit_count);
+        if (m_order == BitOrder::LSBFirst)
+            m_bit_buffer >>= count;
+        else
+            m_bit_buffer <<= count;
+        m_bit_count -= count;
+    }
+
+    // Tops up the bit buffer to at least 56 bits, unless the stream runs out first.
+    void refill()
+    {
+        if (m_source.size() < sizeof(u64) && m_stream)
+            refill_staging();
+
+        if (m_source.size() >= sizeof(u64)) {
+            // Load a whole word, but only count the bytes that fit completely. The bits of the next byte that
+            // sneak into the buffer as well are the same ones the next refill is going to put there.
+            u64 word;
+            __builtin_memcpy(&word, m_source.data(), sizeof(word));
+            if (m_order == BitOrder::LSBFirst)
+                m_bit_buffer |= convert_between_host_and_little_endian(word) << m_bit_count;
+            else
+                m_bit_buffer |= convert_between_host_and_big_endian(word) >> m_bit_count;
+            auto nbytes = (63 - m_bit_count) / 8;
+            m_source = m_source.slice(nbytes);
+            m_bit_count += nbytes * 8;
+            return;
+        }
+
+        while (m_bit_count <= 56 && !m_source.is_empty()) {
+            u64 byte = m_source[0];
+            if (m_order == BitOrder::LSBFirst)
+                m_bit_buffer |= byte << m_bit_count;
+            else
+                m_bit_buffer |= byte << (56 - m_bit_count);
+            m_source = m_source.slice(1);
+            m_bit_count += 8;
+        }
+    }
+
+    void refill_staging()
+    {
+        auto remaining = m_source.size();
+        // The source is empty, and its data() may be null, whenever everything has been consumed.
+        if (remaining)
+            __builtin_memmove(m_staging, m_source.data(), remaining);
+        auto nread = m_stream->read({ m_staging + remaining, staging_size - remaining });
+        if (m_stream->has_any_error())
+            set_fatal_error();
+        m_source = { m_staging, remaining + nread };
+    }
+
+    InputStream* m_stream { nullptr };
+    ReadonlyBytes m_source;
+    BitOrder m_order;
+
+    u64 m_bit_buffer { 0 };
+    size_t m_bit_count { 0 };
+
+    u8 m_staging[staging_size];
 };
 
+/* Bits are collected in a 64-bit buffer and written out whole bytes at a
+ * time into a small staging buffer, which is handed to the underlying stream
+ * when it fills up, on flush(), and on destruction.
+ *
+ * NOTE: A partially written byte is only written out once the stream is
+ * aligned to a byte boundary, e.g. by flush().
+ */
 class OutputBitStream final : public OutputStream {
 public:
-    explicit OutputBitStream(OutputStream& stream)
+    explicit OutputBitStream(OutputStream& stream, BitOrder order = BitOrder::LSBFirst)
         : m_stream(stream)
+        , m_order(order)
     {
     }
 
+    ~OutputBitStream()
+    {
+        if (m_buffered > 0)
+            m_stream.write_or_error({ m_staging, m_buffered });
+    }
+
     // WARNING: write aligns to the next byte boundary before writing, if unaligned writes are needed this should be rewritten
     size_t write(ReadonlyBytes bytes) override
     {
         if (has_any_error())
             return 0;
         align_to_byte_boundary();
-        if (has_fatal_error()) // if align_to_byte_boundary failed
+        if (bytes.size() <= staging_size - m_buffered) {
+            __builtin_memcpy(m_staging + m_buffered, bytes.data(), bytes.size());
+            m_buffered += bytes.size();
+            return bytes.size();
+        }
+        if (!flush_staging())
             return 0;
         return m_stream.write(bytes);
     }
@@ -152,41 +300,23 @@ public:
         return true;
     }
 
+    // With BitOrder::LSBFirst the least significant bit of bits is written first,
+    // with BitOrder::MSBFirst the most significant one of the count bits.
     void write_bits(u32 bits, size_t count)
     {
         VERIFY(count <= 32);
-
-        if (count == 32 && !m_next_byte.has_value()) { // fast path for aligned 32 bit writes
-            m_stream << bits;
+        if (count == 0 || has_any_error())
             return;
-        }
 
-        size_t n_written = 0;
-        while (n_written < count) {
-            if (m_stream.has_any_error()) {
-                set_fatal_error();
-                return;
-            }
+        u64 value = bits & ((1ull << count) - 1);
+        if (m_order == BitOrder::LSBFirst)
+            m_bit_buffer |= value << m_bit_count;
+        else
+            m_bit_buffer |= value << (64 - m_bit_count - count);
+        m_bit_count += count;
 
-            if (m_next_byte.has_value()) {
-                m_next_byte.value() |= ((bits >> n_written) & 1) << m_bit_offset;
-                ++n_written;
-
-                if (m_bit_offset++ == 7) {
-                    m_stream << m_next_byte.value();
-                    m_next_byte.clear();
-                }
-            } else if (count - n_written >= 16) { // fast path for aligned 16 bit writes
-                m_stream << (u16)((bits >> n_written) & 0xFFFF);
-                n_written += 16;
-            } else if (count - n_written >= 8) { // fast path for aligned 8 bit writes
-                m_stream << (u8)((bits >> n_written) & 0xFF);
-                n_written += 8;
-            } else {
-                m_bit_offset = 0;
-                m_next_byte = 0;
-            }
-        }
+        if (m_bit_count >= 8)
+            emit_whole_bytes();
     }
 
     void write_bit(bool bit)
@@ -194,28 +324,73 @@ public:
         write_bits(bit, 1);
     }
 
+    // Pads the current byte with zero bits.
     void align_to_byte_boundary()
     {
-        if (m_next_byte.has_value()) {
-            if (!m_stream.write_or_error(ReadonlyBytes { &m_next_byte.value(), 1 })) {
-                set_fatal_error();
-            }
-            m_next_byte.clear();
-        }
+        if (m_bit_count == 0)
+            return;
+        m_bit_count = 8;
+        emit_whole_bytes();
+    }
+
+    // Aligns to the next byte boundary and hands everything written so far to the underlying stream.
+    bool flush()
+    {
+        align_to_byte_boundary();
+        return flush_staging();
     }
 
     size_t bit_offset() const
     {
-        return m_bit_offset;
+        return m_bit_count;
     }
 
 private:
-    Optional<u8> m_next_byte;
-    size_t m_bit_offset { 0 };
+    static constexpr size_t staging_size = 256;
+
+    void emit_whole_bytes()
+    {
+        // Always store the whole word; only the completed bytes count, the rest gets overwritten later.
+        if (staging_size - m_buffered < sizeof(u64) && !flush_staging())
+            return;
+
+        u64 word = m_order == BitOrder::LSBFirst
+            ? convert_between_host_and_little_endian(m_bit_buffer)
+            : convert_between_host_and_big_endian(m_bit_buffer);
+        __builtin_memcpy(m_staging + m_buffered, &word, sizeof(word));
+
+        auto nbytes = m_bit_count / 8;
+        m_buffered += nbytes;
+        if (m_order == BitOrder::LSBFirst)
+            m_bit_buffer >>= nbytes * 8;
+        else
+            m_bit_buffer <<= nbytes * 8;
+        m_bit_count -= nbytes * 8;
+    }
+
+    bool flush_staging()
+    {
+        if (m_buffered == 0)
+            return true;
+        auto success = m_stream.write_or_error({ m_staging, m_buffered });
+        m_buffered = 0;
+        if (!success)
+            set_fatal_error();
+        return success;
+    }
+
     OutputStream& m_stream;
+    BitOrder m_order;
+
+    u64 m_bit_buffer { 0 };
+    size_t m_bit_count { 0 };
+
+    u8 m_staging[staging_size];
+    size_t m_buffered { 0 };
 };
 
 }
 
+using AK::BitOrder;
 using AK::InputBitStream;
 using AK::OutputBitStream;
@@ -82,9 +82,12 @@ public:
             count = __builtin_popcount(byte);
         } else {
             count = __builtin_popcount(byte);
-            byte = *last;
-            byte &= bitmask_last_byte[(start + len) % 8];
-            count += __builtin_popcount(byte);
+            // A range that ends on a byte boundary has no bits in *last, which may be past the end of the bitmap.
+            if ((start + len) % 8) {
+                byte = *last;
+                byte &= bitmask_last_byte[(start + len) % 8];
+                count += __builtin_popcount(byte);
+            }
             if (++first < last) {
                 const u32* ptr32 = (const u32*)(((FlatPtr)first + sizeof(u32) - 1) & ~(sizeof(u32) - 1));
                 if ((const u8*)ptr32 > last)
@@ -152,18 +155,21 @@ public:
                 *first |= byte_mask;
             else
                 *first &= ~byte_mask;
+            // A range that ends on a byte boundary has no bits in *last, which may be past the end of the bitmap.
             byte_mask = bitmask_last_byte[(start + len) % 8];
-            if constexpr (verify_that_all_bits_flip) {
-                if constexpr (VALUE) {
-                    VERIFY((*last & byte_mask) == 0);
-                } else {
-                    VERIFY((*last & byte_mask) == byte_mask);
+            if (byte_mask) {
+                if constexpr (verify_that_all_bits_flip) {
+                    if constexpr (VALUE) {
+                        VERIFY((*last & byte_mask) == 0);
+                    } else {
+                        VERIFY((*last & byte_mask) == byte_mask);
+                    }
                 }
+                if constexpr (VALUE)
+                    *last |= byte_mask;
+                else
+                    *last &= ~byte_mask;
             }
-            if constexpr (VALUE)
-                *last |= byte_mask;
-            else
-                *last &= ~byte_mask;
             if (++first < last) {
                 if constexpr (VALUE)
                     __builtin_memset(first, 0xFF, last - first);
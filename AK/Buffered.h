@@ -25,9 +25,11 @@
 #pragma once
 
 #include <AK/Noncopyable.h>
+#include <AK/Optional.h>
 #include <AK/Span.h>
 #include <AK/StdLibExtras.h>
 #include <AK/Stream.h>
+#include <AK/StringView.h>
 #include <AK/Types.h>
 #include <AK/kmalloc.h>
 
@@ -38,6 +40,9 @@ namespace AK {
 template<typename StreamType, size_t Size = 4096, typename = void>
 class Buffered;
 
+// The buffered bytes live in m_buffer[m_begin, m_end). Reads just advance m_begin, and the buffer is
+// refilled from the start once it runs dry, so bytes are never shifted around except when peek() or
+// read_until() need more contiguous bytes than fit behind m_begin.
 template<typename StreamType, size_t Size>
 class Buffered<StreamType, Size, typename EnableIf<IsBaseOf<InputStream, StreamType>::value>::Type> final : public InputStream {
     AK_MAKE_NONCOPYABLE(Buffered);
@@ -52,8 +57,10 @@ public:
     Buffered(Buffered&& other)
         : m_stream(move(other.m_stream))
     {
-        other.buffer().copy_to(buffer());
-        m_buffered = exchange(other.m_buffered, 0);
+        other.buffered().copy_to(buffer());
+        m_end = other.buffered().size();
+        other.m_begin = 0;
+        other.m_end = 0;
     }
 
     bool has_recoverable_error() const override { return m_stream.has_recoverable_error(); }
@@ -72,18 +79,32 @@ public:
         if (has_any_error())
             return 0;
 
-        auto nread = buffer().trim(m_buffered).copy_trimmed_to(bytes);
-
-        m_buffered -= nread;
-        buffer().slice(nread, m_buffered).copy_to(buffer());
-
-        if (nread < bytes.size()) {
-            m_buffered = m_stream.read(buffer());
-
-            if (m_buffered == 0)
-                return nread;
+        if (bytes.size() <= m_end - m_begin) {
+            __builtin_memcpy(bytes.data(), m_buffer + m_begin, bytes.size());
+            consume(bytes.size());
+            return bytes.size();
+        }
 
-            nread += read(bytes.slice(nread));
+        auto nread = buffered().copy_trimmed_to(bytes);
+        consume(nread);
+
+        while (nread < bytes.size()) {
+            auto remaining = bytes.slice(nread);
+
+            // Don't bother copying through the buffer if the rest doesn't fit into it anyway.
+            if (remaining.size() >= Size) {
+                auto ndirect = m_stream.read(remaining);
+                if (ndirect == 0)
+                    break;
+                nread += ndirect;
+                continue;
+            }
+
+            if (!fill_buffer())
+                break;
+            auto ncopied = buffered().copy_trimmed_to(remaining);
+            consume(ncopied);
+            nread += ncopied;
         }
 
         return nread;
@@ -99,39 +120,134 @@ public:
         return true;
     }
 
-    bool unreliable_eof() const override { return m_buffered == 0 && m_stream.unreliable_eof(); }
+    bool unreliable_eof() const override { return m_begin == m_end && m_stream.unreliable_eof(); }
 
     bool eof() const
     {
-        if (m_buffered > 0)
+        if (m_begin != m_end)
             return false;
 
-        m_buffered = m_stream.read(buffer());
-
-        return m_buffered == 0;
+        return !fill_buffer();
     }
 
     bool discard_or_error(size_t count) override
     {
-        size_t ndiscarded = 0;
-        while (ndiscarded < count) {
-            u8 dummy[Size];
-
-            if (!read_or_error({ dummy, min(Size, count - ndiscarded) }))
-                return false;
+        auto ndiscarded = min(count, buffered().size());
+        consume(ndiscarded);
+        if (ndiscarded == count)
+            return true;
 
-            ndiscarded += min(Size, count - ndiscarded);
+        if (!m_stream.discard_or_error(count - ndiscarded)) {
+            set_fatal_error();
+            return false;
         }
 
         return true;
     }
 
+    // Returns up to count bytes without consuming them, fewer only if the stream runs out first.
+    // The view stays valid until the next call that reads from this stream.
+    ReadonlyBytes peek(size_t count)
+    {
+        VERIFY(count <= Size);
+        if (has_any_error())
+            return {};
+
+        while (buffered().size() < count) {
+            if (m_begin + count > Size)
+                compact();
+            if (!fill_buffer())
+                break;
+        }
+        return buffered().trim(count);
+    }
+
+    void consume(size_t count)
+    {
+        VERIFY(count <= buffered().size());
+        m_begin += count;
+        if (m_begin == m_end) {
+            m_begin = 0;
+            m_end = 0;
+        }
+    }
+
+    // Returns a view of everything up to (but not including) the next delimiter, and consumes both.
+    // At the end of the stream, whatever is left is returned even if it isn't terminated by a delimiter.
+    // Returns nothing if the stream has run dry, or if no delimiter shows up within Size bytes; in the
+    // latter case the bytes stay buffered and can be read() out as usual.
+    // The view stays valid until the next call that reads from this stream.
+    Optional<ReadonlyBytes> read_until(u8 delimiter)
+    {
+        if (has_any_error())
+            return {};
+
+        size_t searched = 0;
+        for (;;) {
+            auto available = buffered();
+            auto* found = static_cast<const u8*>(__builtin_memchr(available.data() + searched, delimiter, available.size() - searched));
+            if (found) {
+                auto length = static_cast<size_t>(found - available.data());
+                consume(length + 1);
+                // consume() only resets the cursors, so the bytes are still where the view points.
+                return available.trim(length);
+            }
+            searched = available.size();
+
+            if (searched == Size)
+                return {};
+            if (m_end == Size)
+                compact();
+            if (!fill_buffer()) {
+                auto rest = buffered();
+                if (rest.is_empty())
+                    return {};
+                consume(rest.size());
+                return rest;
+            }
+        }
+    }
+
+    // Like read_until('\n'), but also strips a trailing '\r'.
+    Optional<StringView> read_line()
+    {
+        auto line = read_until('\n');
+        if (!line.has_value())
+            return {};
+        auto bytes = line.value();
+        if (!bytes.is_empty() && bytes[bytes.size() - 1] == '\r')
+            bytes = bytes.trim(bytes.size() - 1);
+        return StringView { bytes };
+    }
+
+    size_t buffered_size() const { return m_end - m_begin; }
+
 private:
     Bytes buffer() const { return { m_buffer, Size }; }
+    ReadonlyBytes buffered() const { return { m_buffer + m_begin, m_end - m_begin }; }
+
+    // Moves the buffered bytes to the front of the buffer, making room for more behind them.
+    void compact()
+    {
+        if (m_begin == 0)
+            return;
+        __builtin_memmove(m_buffer, m_buffer + m_begin, m_end - m_begin);
+        m_end -= m_begin;
+        m_begin = 0;
+    }
+
+    bool fill_buffer() const
+    {
+        VERIFY(m_end < Size);
+        auto nread = m_stream.read(buffer().slice(m_end));
+        m_end += nread;
+        return nread > 0;
+    }
 
     mutable StreamType m_stream;
     mutable u8 m_buffer[Size];
-    mutable size_t m_buffered { 0 };
+    mutable size_t m_begin { 0 };
+    mutable size_t m_end { 0 };
 };
 
 template<typename StreamType, size_t Size>
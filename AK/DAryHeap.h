@@ -0,0 +1,345 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Assertions.h>
+#include <AK/Optional.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+namespace AK {
+
+/* Growable d-ary min-heaps. Unlike BinaryHeap these allocate their storage
+ * from a Vector, so they never run out of room, and the default arity of 4
+ * halves the tree height while keeping all children of a node on the same
+ * cache line or two.
+ *
+ * Sifting moves a "hole" through the tree instead of swapping at each level,
+ * so every element is moved once per level rather than three times.
+ */
+
+namespace Detail {
+
+template<size_t Arity>
+struct DAryHeapShape {
+    static_assert(Arity >= 2);
+
+    static constexpr size_t parent(size_t index) { return (index - 1) / Arity; }
+    static constexpr size_t first_child(size_t index) { return index * Arity + 1; }
+};
+
+}
+
+template<typename K, typename V, size_t Arity = 4>
+class DAryHeap {
+    using Shape = Detail::DAryHeapShape<Arity>;
+
+public:
+    DAryHeap() = default;
+    ~DAryHeap() = default;
+
+    // Builds the heap in O(n) instead of O(n log n) for repeated insertions.
+    DAryHeap(K keys[], V values[], size_t size)
+    {
+        m_elements.ensure_capacity(size);
+        for (size_t i = 0; i < size; ++i)
+            m_elements.unchecked_append({ move(keys[i]), move(values[i]) });
+        if (size < 2)
+            return;
+        for (size_t i = Shape::parent(size - 1) + 1; i-- > 0;)
+            sift_down(i);
+    }
+
+    [[nodiscard]] size_t size() const { return m_elements.size(); }
+    [[nodiscard]] bool is_empty() const { return m_elements.is_empty(); }
+
+    void ensure_capacity(size_t capacity) { m_elements.ensure_capacity(capacity); }
+
+    void insert(K key, V value)
+    {
+        m_elements.append({ move(key), move(value) });
+        sift_up(m_elements.size() - 1);
+    }
+
+    V pop_min()
+    {
+        VERIFY(!is_empty());
+        auto last = m_elements.take_last();
+        if (m_elements.is_empty())
+            return move(last.value);
+        auto min_value = move(m_elements[0].value);
+        m_elements[0] = move(last);
+        sift_down(0);
+        return min_value;
+    }
+
+    const V& peek_min() const
+    {
+        VERIFY(!is_empty());
+        return m_elements[0].value;
+    }
+
+    const K& peek_min_key() const
+    {
+        VERIFY(!is_empty());
+        return m_elements[0].key;
+    }
+
+    void clear() { m_elements.clear_with_capacity(); }
+
+private:
+    struct Element {
+        K key;
+        V value;
+    };
+
+    // These run on raw pointers, as the bounds checks in Vector::at() dominate the loops otherwise.
+    void sift_up(size_t index)
+    {
+        auto* elements = m_elements.data();
+        auto element = move(elements[index]);
+        while (index != 0) {
+            auto parent = Shape::parent(index);
+            if (!(element.key < elements[parent].key))
+                break;
+            elements[index] = move(elements[parent]);
+            index = parent;
+        }
+        elements[index] = move(element);
+    }
+
+    void sift_down(size_t index)
+    {
+        auto* elements = m_elements.data();
+        auto size = m_elements.size();
+        auto element = move(elements[index]);
+        for (;;) {
+            auto first_child = Shape::first_child(index);
+            if (first_child >= size)
+                break;
+            auto last_child = min(first_child + Arity, size);
+            auto min_child = first_child;
+            for (auto child = first_child + 1; child < last_child; ++child) {
+                if (elements[child].key < elements[min_child].key)
+                    min_child = child;
+            }
+            if (!(elements[min_child].key < element.key))
+                break;
+            elements[index] = move(elements[min_child]);
+            index = min_child;
+        }
+        elements[index] = move(element);
+    }
+
+    Vector<Element> m_elements;
+};
+
+/* IndexedDAryHeap additionally hands out a stable handle for every inserted
+ * value, which can be used to change its key or remove it in O(log n). This
+ * is what schedulers and shortest-path searches need for "decrease-key".
+ * Handles of removed or popped values are recycled by later insertions.
+ */
+template<typename K, typename V, size_t Arity = 4>
+class IndexedDAryHeap {
+    using Shape = Detail::DAryHeapShape<Arity>;
+
+public:
+    using Handle = size_t;
+
+    IndexedDAryHeap() = default;
+    ~IndexedDAryHeap() = default;
+
+    [[nodiscard]] size_t size() const { return m_heap.size(); }
+    [[nodiscard]] bool is_empty() const { return m_heap.is_empty(); }
+
+    void ensure_capacity(size_t capacity)
+    {
+        m_heap.ensure_capacity(capacity);
+        m_slots.ensure_capacity(capacity);
+    }
+
+    Handle insert(K key, V value)
+    {
+        Handle handle;
+        if (!m_free_handles.is_empty()) {
+            handle = m_free_handles.take_last();
+            m_slots[handle].value = move(value);
+        } else {
+            handle = m_slots.size();
+            m_slots.append({ move(value), 0 });
+        }
+        m_heap.append({ move(key), handle });
+        m_slots[handle].heap_index = m_heap.size() - 1;
+        sift_up(m_heap.size() - 1);
+        return handle;
+    }
+
+    bool contains(Handle handle) const { return handle < m_slots.size() && m_slots[handle].value.has_value(); }
+
+    const K& key(Handle handle) const
+    {
+        VERIFY(contains(handle));
+        return m_heap[m_slots[handle].heap_index].key;
+    }
+
+    const V& value(Handle handle) const
+    {
+        VERIFY(contains(handle));
+        return m_slots[handle].value.value();
+    }
+
+    V& value(Handle handle)
+    {
+        VERIFY(contains(handle));
+        return m_slots[handle].value.value();
+    }
+
+    void update_key(Handle handle, K key)
+    {
+        VERIFY(contains(handle));
+        auto index = m_slots[handle].heap_index;
+        bool decreased = key < m_heap[index].key;
+        m_heap[index].key = move(key);
+        if (decreased)
+            sift_up(index);
+        else
+            sift_down(index);
+    }
+
+    V remove(Handle handle)
+    {
+        VERIFY(contains(handle));
+        auto index = m_slots[handle].heap_index;
+        auto last = m_heap.take_last();
+        if (index != m_heap.size()) {
+            bool decreased = last.key < m_heap[index].key;
+            m_heap[index] = move(last);
+            m_slots[m_heap[index].handle].heap_index = index;
+            if (decreased)
+                sift_up(index);
+            else
+                sift_down(index);
+        }
+        return release(handle);
+    }
+
+    V pop_min()
+    {
+        VERIFY(!is_empty());
+        return remove(m_heap[0].handle);
+    }
+
+    Handle peek_min_handle() const
+    {
+        VERIFY(!is_empty());
+        return m_heap[0].handle;
+    }
+
+    const V& peek_min() const { return value(peek_min_handle()); }
+
+    const K& peek_min_key() const
+    {
+        VERIFY(!is_empty());
+        return m_heap[0].key;
+    }
+
+    void clear()
+    {
+        m_heap.clear_with_capacity();
+        m_slots.clear_with_capacity();
+        m_free_handles.clear_with_capacity();
+    }
+
+private:
+    struct Element {
+        K key;
+        Handle handle;
+    };
+
+    struct Slot {
+        Optional<V> value;
+        size_t heap_index;
+    };
+
+    V release(Handle handle)
+    {
+        auto value = m_slots[handle].value.release_value();
+        m_free_handles.append(handle);
+        return value;
+    }
+
+    void place(size_t index, Element&& element)
+    {
+        m_slots.data()[element.handle].heap_index = index;
+        m_heap.data()[index] = move(element);
+    }
+
+    void sift_up(size_t index)
+    {
+        auto* heap = m_heap.data();
+        auto element = move(heap[index]);
+        while (index != 0) {
+            auto parent = Shape::parent(index);
+            if (!(element.key < heap[parent].key))
+                break;
+            place(index, move(heap[parent]));
+            index = parent;
+        }
+        place(index, move(element));
+    }
+
+    void sift_down(size_t index)
+    {
+        auto* heap = m_heap.data();
+        auto size = m_heap.size();
+        auto element = move(heap[index]);
+        for (;;) {
+            auto first_child = Shape::first_child(index);
+            if (first_child >= size)
+                break;
+            auto last_child = min(first_child + Arity, size);
+            auto min_child = first_child;
+            for (auto child = first_child + 1; child < last_child; ++child) {
+                if (heap[child].key < heap[min_child].key)
+                    min_child = child;
+            }
+            if (!(heap[min_child].key < element.key))
+                break;
+            place(index, move(heap[min_child]));
+            index = min_child;
+        }
+        place(index, move(element));
+    }
+
+    Vector<Element> m_heap;
+    Vector<Slot> m_slots;
+    Vector<Handle> m_free_handles;
+};
+
+}
+
+using AK::DAryHeap;
+using AK::IndexedDAryHeap;
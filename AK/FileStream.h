@@ -24,10 +24,18 @@
 
 #pragma once
 
+#include <AK/Noncopyable.h>
 #include <AK/Stream.h>
 #ifndef KERNEL
 #    include <errno.h>
 #    include <stdio.h>
+#    include <sys/stat.h>
+#    include <sys/uio.h>
+#    include <unistd.h>
+#    ifdef __linux__
+#        include <fcntl.h>
+#        include <sys/sendfile.h>
+#    endif
 
 namespace AK {
 
@@ -184,9 +192,260 @@ private:
     bool m_owned { false };
 };
 
+/* InputFDStream and OutputFDStream talk to the file descriptor directly
+ * instead of going through stdio. That makes them a poor fit for lots of
+ * tiny reads or writes (wrap them in Buffered<> for that), but lets
+ * read_vectored() and write_vectored() map onto a single readv() or writev(),
+ * and lets copy_stream() move data between two of them inside the kernel.
+ *
+ * Like InputFileStream and OutputFileStream, they close the file descriptor
+ * when they are destroyed.
+ */
+class InputFDStream final : public InputStream {
+    AK_MAKE_NONCOPYABLE(InputFDStream);
+
+public:
+    explicit InputFDStream(int fd)
+        : m_fd(fd)
+    {
+        if (m_fd < 0)
+            set_fatal_error();
+    }
+
+    ~InputFDStream()
+    {
+        if (m_fd >= 0)
+            ::close(m_fd);
+    }
+
+    int fd() const { return m_fd; }
+
+    bool unreliable_eof() const override { return m_eof; }
+    bool eof() const { return m_eof; }
+
+    size_t read(Bytes bytes) override
+    {
+        return read_vectored({ &bytes, 1 });
+    }
+
+    size_t read_vectored(Span<Bytes> buffers) override
+    {
+        if (has_any_error())
+            return 0;
+
+        iovec vectors[max_vectors_per_call];
+        size_t vector_count = 0;
+        size_t total_size = 0;
+        for (auto buffer : buffers) {
+            if (vector_count == max_vectors_per_call)
+                break;
+            vectors[vector_count++] = { buffer.data(), buffer.size() };
+            total_size += buffer.size();
+        }
+        if (total_size == 0)
+            return 0;
+
+        for (;;) {
+            auto rc = ::readv(m_fd, vectors, vector_count);
+            if (rc < 0) {
+                if (errno == EINTR)
+                    continue;
+                set_fatal_error();
+                return 0;
+            }
+            if (rc == 0)
+                m_eof = true;
+            return rc;
+        }
+    }
+
+    bool read_or_error(Bytes bytes) override
+    {
+        size_t nread = 0;
+        while (nread < bytes.size()) {
+            auto nread_now = read(bytes.slice(nread));
+            if (nread_now == 0) {
+                set_recoverable_error();
+                return false;
+            }
+            nread += nread_now;
+        }
+        return true;
+    }
+
+    bool discard_or_error(size_t count) override
+    {
+        // Seeking skips the data without reading it, but a regular file can be seeked past its end,
+        // so that's only done within the file. Everything else is read, which fails at the end.
+        struct stat st;
+        auto offset = ::lseek(m_fd, 0, SEEK_CUR);
+        if (offset >= 0 && ::fstat(m_fd, &st) == 0 && S_ISREG(st.st_mode) && static_cast<u64>(offset) + count <= static_cast<u64>(st.st_size)) {
+            if (::lseek(m_fd, count, SEEK_CUR) >= 0)
+                return true;
+        }
+
+        u8 buffer[4096];
+        while (count > 0) {
+            auto nread = read({ buffer, min(count, sizeof(buffer)) });
+            if (nread == 0) {
+                set_recoverable_error();
+                return false;
+            }
+            count -= nread;
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t max_vectors_per_call = 64;
+
+    int m_fd { -1 };
+    bool m_eof { false };
+};
+
+class OutputFDStream final : public OutputStream {
+    AK_MAKE_NONCOPYABLE(OutputFDStream);
+
+public:
+    explicit OutputFDStream(int fd)
+        : m_fd(fd)
+    {
+        if (m_fd < 0)
+            set_fatal_error();
+    }
+
+    ~OutputFDStream()
+    {
+        if (m_fd >= 0)
+            ::close(m_fd);
+    }
+
+    int fd() const { return m_fd; }
+
+    size_t write(ReadonlyBytes bytes) override
+    {
+        return write_vectored({ &bytes, 1 });
+    }
+
+    // Keeps calling writev() until everything is written, picking up partial writes where they left off.
+    size_t write_vectored(Span<const ReadonlyBytes> buffers) override
+    {
+        if (has_any_error())
+            return 0;
+
+        size_t nwritten = 0;
+        size_t buffer_index = 0;
+        size_t offset_in_buffer = 0;
+        for (;;) {
+            while (buffer_index < buffers.size() && offset_in_buffer == buffers[buffer_index].size()) {
+                ++buffer_index;
+                offset_in_buffer = 0;
+            }
+            if (buffer_index == buffers.size())
+                return nwritten;
+
+            iovec vectors[max_vectors_per_call];
+            size_t vector_count = 0;
+            for (size_t i = buffer_index; i < buffers.size() && vector_count < max_vectors_per_call; ++i) {
+                auto buffer = i == buffer_index ? buffers[i].slice(offset_in_buffer) : buffers[i];
+                vectors[vector_count++] = { const_cast<u8*>(buffer.data()), buffer.size() };
+            }
+
+            auto rc = ::writev(m_fd, vectors, vector_count);
+            if (rc < 0) {
+                if (errno == EINTR)
+                    continue;
+                set_fatal_error();
+                return nwritten;
+            }
+            nwritten += rc;
+
+            for (size_t left = rc; left > 0;) {
+                auto left_in_buffer = buffers[buffer_index].size() - offset_in_buffer;
+                if (left < left_in_buffer) {
+                    offset_in_buffer += left;
+                    break;
+                }
+                left -= left_in_buffer;
+                ++buffer_index;
+                offset_in_buffer = 0;
+            }
+        }
+    }
+
+    bool write_or_error(ReadonlyBytes bytes) override
+    {
+        if (write(bytes) < bytes.size()) {
+            set_fatal_error();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t max_vectors_per_call = 64;
+
+    int m_fd { -1 };
+};
+
+// Copies everything left in input over to output. On Linux this stays inside the kernel where possible:
+// copy_file_range() between regular files, sendfile() from a file to anything, and splice() to or from a pipe.
+inline size_t copy_stream(InputFDStream& input, OutputFDStream& output)
+{
+    if (input.has_any_error() || output.has_any_error())
+        return 0;
+
+    size_t ncopied = 0;
+
+#    ifdef __linux__
+    static constexpr size_t max_chunk_size = 1 * GiB;
+
+    // Each of these returns the byte count on success, 0 at the end of the input, and -1 with errno set
+    // if the method isn't supported for this pair of file descriptors, or if something actually went wrong.
+    // The errors don't say which side they came from, so on those the portable copy below takes over: it
+    // runs into the same error on the stream it belongs to, and reports it there.
+    bool has_failed = false;
+    auto copy_with = [&](auto copy_chunk, auto method_is_unsupported) -> bool {
+        for (;;) {
+            auto rc = copy_chunk();
+            if (rc > 0) {
+                ncopied += rc;
+                continue;
+            }
+            if (rc == 0)
+                return true;
+            if (errno == EINTR)
+                continue;
+            if (!method_is_unsupported(errno))
+                has_failed = true;
+            return false;
+        }
+    };
+    auto is_unsupported = [](int error) {
+        return error == EINVAL || error == EXDEV || error == ENOSYS || error == EOPNOTSUPP;
+    };
+    // copy_file_range() refuses outputs opened with O_APPEND with EBADF. Otherwise that means a bad descriptor.
+    bool output_is_append_only = (::fcntl(output.fd(), F_GETFL) & O_APPEND) != 0;
+    auto is_unsupported_by_copy_file_range = [&](int error) {
+        return is_unsupported(error) || (error == EBADF && output_is_append_only);
+    };
+
+    if (copy_with([&] { return ::copy_file_range(input.fd(), nullptr, output.fd(), nullptr, max_chunk_size, 0); }, is_unsupported_by_copy_file_range))
+        return ncopied;
+    if (!has_failed && copy_with([&] { return ::sendfile(output.fd(), input.fd(), nullptr, max_chunk_size); }, is_unsupported))
+        return ncopied;
+    if (!has_failed && copy_with([&] { return ::splice(input.fd(), nullptr, output.fd(), nullptr, max_chunk_size, SPLICE_F_MOVE); }, is_unsupported))
+        return ncopied;
+#    endif
+
+    return ncopied + copy_stream(static_cast<InputStream&>(input), static_cast<OutputStream&>(output));
+}
+
 }
 
+using AK::InputFDStream;
 using AK::InputFileStream;
+using AK::OutputFDStream;
 using AK::OutputFileStream;
 
 #endif
@@ -24,11 +24,100 @@
 
 #include <AK/Assertions.h>
 #include <AK/GenericLexer.h>
+#include <AK/SIMDExtras.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
 
+#ifndef KERNEL
+#    include <string.h>
+#endif
+
 namespace AK {
 
+using SIMD::u8x16;
+
+static constexpr size_t block_size = sizeof(u8x16);
+
+template<bool in_set>
+size_t CharacterSet::find_first(const char* characters, size_t length) const
+{
+    if (length == 0)
+        return 0;
+    // Nothing is in an empty set, and the vector paths below need at least one member.
+    if (m_size == 0)
+        return in_set ? length : 0;
+    // Runs of skipped characters (e.g. whitespace) are usually short, so don't set up the vectors for nothing.
+    if (contains_byte(characters[0]) == in_set)
+        return 0;
+
+    size_t offset = 0;
+    auto scan_blocks = [&](auto match) -> size_t {
+        for (; offset + block_size <= length; offset += block_size) {
+            auto lane = SIMD::first_set_lane(in_set ? match(SIMD::load_unaligned(characters + offset)) : ~match(SIMD::load_unaligned(characters + offset)));
+            if (lane != block_size)
+                return offset + lane;
+        }
+        // Re-scan the last full block instead of going byte by byte through the tail.
+        // Its already scanned lanes have no match, so the first match is in the tail.
+        if (offset != length && length >= block_size) {
+            offset = length - block_size;
+            auto lane = SIMD::first_set_lane(in_set ? match(SIMD::load_unaligned(characters + offset)) : ~match(SIMD::load_unaligned(characters + offset)));
+            return offset + lane;
+        }
+        return offset;
+    };
+
+    bool scanned = false;
+#if defined(__SSSE3__) && !defined(__clang__)
+    if (m_is_ascii && m_size > 2) {
+        u8x16 low_nibble_bits;
+        u8x16 high_nibble_bits;
+        __builtin_memcpy(&low_nibble_bits, m_low_nibble_bits, sizeof(low_nibble_bits));
+        __builtin_memcpy(&high_nibble_bits, m_high_nibble_bits, sizeof(high_nibble_bits));
+        offset = scan_blocks([&](u8x16 block) {
+            // Both shuffles compile to pshufb, which looks up 16 bytes in a 16-entry table at once.
+            auto low = __builtin_shuffle(low_nibble_bits, block & 0xf);
+            auto high = __builtin_shuffle(high_nibble_bits, block >> 4);
+            return SIMD::to_mask((low & high) != 0);
+        });
+        scanned = true;
+    }
+#endif
+    if (!scanned && m_size <= max_compared_members) {
+        u8x16 members[max_compared_members];
+        for (size_t i = 0; i < m_size; ++i)
+            members[i] = u8x16 {} + m_members[i];
+        offset = scan_blocks([&](u8x16 block) {
+            auto mask = SIMD::to_mask(block == members[0]);
+            for (size_t i = 1; i < m_size; ++i)
+                mask |= SIMD::to_mask(block == members[i]);
+            return mask;
+        });
+    }
+
+    for (; offset < length; ++offset) {
+        if (contains_byte(characters[offset]) == in_set)
+            return offset;
+    }
+    return length;
+}
+
+size_t CharacterSet::find_first_in(const char* characters, size_t length) const
+{
+#ifndef KERNEL
+    if (m_size == 1) {
+        auto* match = static_cast<const char*>(memchr(characters, m_members[0], length));
+        return match ? match - characters : length;
+    }
+#endif
+    return find_first<true>(characters, length);
+}
+
+size_t CharacterSet::find_first_not_in(const char* characters, size_t length) const
+{
+    return find_first<false>(characters, length);
+}
+
 GenericLexer::GenericLexer(const StringView& input)
     : m_input(input)
 {
@@ -141,17 +230,12 @@ StringView GenericLexer::consume_all()
 // Consume until a new line is found
 StringView GenericLexer::consume_line()
 {
-    size_t start = m_index;
-    while (!is_eof() && peek() != '\r' && peek() != '\n')
-        m_index++;
-    size_t length = m_index - start;
+    static constexpr CharacterSet line_terminators { "\r\n" };
 
+    auto line = consume_until(line_terminators);
     consume_specific('\r');
     consume_specific('\n');
-
-    if (length == 0)
-        return {};
-    return m_input.substring_view(start, length);
+    return line;
 }
 
 // Consume and return characters until `stop` is peek'd
@@ -159,15 +243,10 @@ StringView GenericLexer::consume_line()
 StringView GenericLexer::consume_until(char stop)
 {
     size_t start = m_index;
-    while (!is_eof() && peek() != stop)
-        m_index++;
-    size_t length = m_index - start;
-
+    ignore_until(CharacterSet(StringView(&stop, 1)));
+    auto result = consumed_since(start);
     ignore();
-
-    if (length == 0)
-        return {};
-    return m_input.substring_view(start, length);
+    return result;
 }
 
 // Consume and return characters until the string `stop` is found
@@ -175,15 +254,26 @@ StringView GenericLexer::consume_until(char stop)
 StringView GenericLexer::consume_until(const char* stop)
 {
     size_t start = m_index;
-    while (!is_eof() && !next_is(stop))
-        m_index++;
-    size_t length = m_index - start;
-
+    seek_to(stop);
+    auto result = consumed_since(start);
     ignore(__builtin_strlen(stop));
+    return result;
+}
 
-    if (length == 0)
-        return {};
-    return m_input.substring_view(start, length);
+// Consume and return characters until one in `set` is peek'd
+StringView GenericLexer::consume_until(const CharacterSet& set)
+{
+    size_t start = m_index;
+    ignore_until(set);
+    return consumed_since(start);
+}
+
+// Consume and return characters while they are in `set`
+StringView GenericLexer::consume_while(const CharacterSet& set)
+{
+    size_t start = m_index;
+    ignore_while(set);
+    return consumed_since(start);
 }
 
 /*
@@ -258,9 +348,7 @@ void GenericLexer::ignore(size_t count)
 // The `stop` character is ignored as it is user-defined
 void GenericLexer::ignore_until(char stop)
 {
-    while (!is_eof() && peek() != stop)
-        m_index++;
-
+    ignore_until(CharacterSet(StringView(&stop, 1)));
     ignore();
 }
 
@@ -268,10 +356,44 @@ void GenericLexer::ignore_until(char stop)
 // The `stop` string is ignored, as it is user-defined
 void GenericLexer::ignore_until(const char* stop)
 {
-    while (!is_eof() && !next_is(stop))
-        m_index++;
-
+    seek_to(stop);
     ignore(__builtin_strlen(stop));
 }
 
+// Ignore characters until one in `set` is peek'd
+void GenericLexer::ignore_until(const CharacterSet& set)
+{
+    m_index += set.find_first_in(m_input.characters_without_null_termination() + m_index, tell_remaining());
+}
+
+// Ignore characters while they are in `set`
+void GenericLexer::ignore_while(const CharacterSet& set)
+{
+    m_index += set.find_first_not_in(m_input.characters_without_null_termination() + m_index, tell_remaining());
+}
+
+void GenericLexer::ignore_whitespace()
+{
+    ignore_while(is_ascii_whitespace);
+}
+
+// Moves the index to the next occurrence of `stop`, or to the end of the input
+void GenericLexer::seek_to(const char* stop)
+{
+    size_t stop_length = __builtin_strlen(stop);
+    if (stop_length == 0)
+        return;
+    auto first = CharacterSet(StringView(stop, 1));
+    while (!is_eof()) {
+        ignore_until(first);
+        if (tell_remaining() < stop_length) {
+            m_index = m_input.length();
+            return;
+        }
+        if (__builtin_memcmp(m_input.characters_without_null_termination() + m_index, stop, stop_length) == 0)
+            return;
+        m_index++;
+    }
+}
+
 }
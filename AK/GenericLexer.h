@@ -24,9 +24,79 @@
 #pragma once
 
 #include <AK/StringView.h>
+#include <AK/Types.h>
 
 namespace AK {
 
+/*
+ * A set of bytes that can be searched for 16 bytes at a time, rather than by
+ * calling a condition for every character. Sets of up to eight bytes are
+ * matched with one vector compare per member. Larger ASCII sets use a nibble
+ * lookup table when the target has a byte shuffle (SSSE3), and anything else
+ * falls back to a 256-bit table.
+ * A CharacterSet is itself a condition, so it can be passed anywhere one is
+ * expected.
+ */
+class CharacterSet {
+public:
+    constexpr explicit CharacterSet(const StringView& characters)
+    {
+        for (size_t i = 0; i < characters.length(); ++i)
+            add(static_cast<u8>(characters[i]));
+    }
+
+    template<typename T>
+    constexpr bool operator()(T c) const { return contains(c); }
+
+    template<typename T>
+    constexpr bool contains(T c) const
+    {
+        if constexpr (sizeof(T) > 1) {
+            if (static_cast<u32>(c) > 0xff)
+                return false;
+        }
+        return contains_byte(static_cast<u8>(c));
+    }
+
+    size_t size() const { return m_size; }
+
+    // These return the offset of the first byte that is (not) in the set, or `length` if there is none.
+    size_t find_first_in(const char* characters, size_t length) const;
+    size_t find_first_not_in(const char* characters, size_t length) const;
+
+private:
+    static constexpr size_t max_compared_members = 8;
+
+    constexpr bool contains_byte(u8 c) const { return m_bitmap[c >> 6] & (1ull << (c & 63)); }
+
+    constexpr void add(u8 c)
+    {
+        if (contains_byte(c))
+            return;
+        m_bitmap[c >> 6] |= 1ull << (c & 63);
+        if (m_size < max_compared_members)
+            m_members[m_size] = c;
+        ++m_size;
+        if (c < 0x80) {
+            m_low_nibble_bits[c & 0xf] |= 1 << (c >> 4);
+            m_high_nibble_bits[c >> 4] = 1 << (c >> 4);
+        } else {
+            m_is_ascii = false;
+        }
+    }
+
+    template<bool in_set>
+    size_t find_first(const char* characters, size_t length) const;
+
+    u64 m_bitmap[4] {};
+    // A byte is in the set iff low[byte & 0xf] & high[byte >> 4] is non-zero.
+    u8 m_low_nibble_bits[16] {};
+    u8 m_high_nibble_bits[16] {};
+    u8 m_members[max_compared_members] {};
+    u16 m_size { 0 };
+    bool m_is_ascii { true };
+};
+
 class GenericLexer {
 public:
     explicit GenericLexer(const StringView& input);
@@ -57,12 +127,21 @@ public:
     StringView consume_line();
     StringView consume_until(char);
     StringView consume_until(const char*);
+    StringView consume_until_any_of(const StringView& characters) { return consume_until(CharacterSet(characters)); }
     StringView consume_quoted_string(char escape_char = 0);
     String consume_and_unescape_string(char escape_char = '\\');
 
     void ignore(size_t count = 1);
     void ignore_until(char);
     void ignore_until(const char*);
+    void ignore_until_any_of(const StringView& characters) { ignore_until(CharacterSet(characters)); }
+    void ignore_whitespace();
+
+    // Like the condition versions below, but scanning many characters at a time.
+    StringView consume_while(const CharacterSet&);
+    StringView consume_until(const CharacterSet&);
+    void ignore_while(const CharacterSet&);
+    void ignore_until(const CharacterSet&);
 
     /*
      * Conditions are used to match arbitrary characters. You can use lambdas,
@@ -85,13 +164,8 @@ public:
     StringView consume_while(C condition)
     {
         size_t start = m_index;
-        while (!is_eof() && condition(peek()))
-            m_index++;
-        size_t length = m_index - start;
-
-        if (length == 0)
-            return {};
-        return m_input.substring_view(start, length);
+        ignore_while(condition);
+        return consumed_since(start);
     }
 
     // Consume and return characters until `condition` return true
@@ -99,20 +173,16 @@ public:
     StringView consume_until(C condition)
     {
         size_t start = m_index;
-        while (!is_eof() && !condition(peek()))
-            m_index++;
-        size_t length = m_index - start;
-
-        if (length == 0)
-            return {};
-        return m_input.substring_view(start, length);
+        ignore_until(condition);
+        return consumed_since(start);
     }
 
     // Ignore characters while `condition` returns true
     template<typename C>
     void ignore_while(C condition)
     {
-        while (!is_eof() && condition(peek()))
+        auto* characters = m_input.characters_without_null_termination();
+        while (m_index < m_input.length() && condition(characters[m_index]))
             m_index++;
     }
 
@@ -121,26 +191,41 @@ public:
     template<typename C>
     void ignore_until(C condition)
     {
-        while (!is_eof() && !condition(peek()))
+        auto* characters = m_input.characters_without_null_termination();
+        while (m_index < m_input.length() && !condition(characters[m_index]))
             m_index++;
     }
 
 protected:
+    StringView consumed_since(size_t start) const
+    {
+        if (m_index == start)
+            return {};
+        return m_input.substring_view(start, m_index - start);
+    }
+
     StringView m_input;
     size_t m_index { 0 };
+
+private:
+    void seek_to(const char* stop);
 };
 
-constexpr auto is_any_of(const StringView& values)
+constexpr CharacterSet is_any_of(const StringView& values)
 {
-    return [values](auto c) { return values.contains(c); };
+    return CharacterSet(values);
 }
 
 constexpr auto is_path_separator = is_any_of("/\\");
 constexpr auto is_quote = is_any_of("'\"");
+// The same characters as isspace() in the C locale.
+constexpr auto is_ascii_whitespace = is_any_of(" \t\n\v\f\r");
 
 }
 
+using AK::CharacterSet;
 using AK::GenericLexer;
 using AK::is_any_of;
+using AK::is_ascii_whitespace;
 using AK::is_path_separator;
 using AK::is_quote;
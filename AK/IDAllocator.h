@@ -22,43 +22,268 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+
 #pragma once
 
-#include <AK/Forward.h>
-#include <AK/HashTable.h>
+#include <AK/Atomic.h>
+#include <AK/Bitmap.h>
+#include <AK/Noncopyable.h>
+#include <AK/Optional.h>
+#include <AK/Random.h>
+#include <AK/Types.h>
 
 namespace AK {
 
+enum class IDAllocatorStart {
+    Lowest,
+    Randomized,
+};
+
+enum class IDAllocatorConcurrency {
+    SingleThreaded,
+    LockFree,
+};
+
+/* Hands out unique IDs from the inclusive range [min_id, max_id].
+ *
+ * Allocated IDs are tracked in a bitmap, viewed as 64-bit words. A second,
+ * much smaller bitmap has one bit per word that is set once the word is full,
+ * so finding a free ID only has to scan 1/64th of the range, and usually just
+ * the one summary word at the search hint.
+ *
+ * With IDAllocatorStart::Randomized (the default) every search begins at a
+ * random word and bit, so IDs are as hard to guess as they were back when
+ * this probed a hash table at rand(). With IDAllocatorStart::Lowest the
+ * lowest free ID is preferred, which keeps IDs dense.
+ *
+ * With IDAllocatorConcurrency::LockFree, allocate() and deallocate() may be
+ * called from multiple threads at once. Bits are claimed with a CAS on their
+ * word; the summary bitmap is only ever used as a hint in that mode.
+ *
+ * The bitmap takes one bit per ID in the range, so a default-constructed
+ * allocator covers [1, 0xffff] and VERIFYs in allocate() once all of those are
+ * live. Before the bitmap, IDs were random numbers up to about 2^31. Callers
+ * that may hold more than 65535 IDs at once have to ask for a bigger range.
+ */
 class IDAllocator {
+    AK_MAKE_NONCOPYABLE(IDAllocator);
+    AK_MAKE_NONMOVABLE(IDAllocator);
 
 public:
-    IDAllocator() = default;
+    static constexpr int default_min_id = 1;
+    static constexpr int default_max_id = 0xffff;
+
+    IDAllocator()
+        : IDAllocator(default_min_id, default_max_id)
+    {
+    }
+
+    IDAllocator(int min_id, int max_id, IDAllocatorStart start = IDAllocatorStart::Randomized, IDAllocatorConcurrency concurrency = IDAllocatorConcurrency::SingleThreaded)
+        : m_min_id(min_id)
+        , m_id_count(static_cast<size_t>(static_cast<i64>(max_id) - min_id) + 1)
+        , m_start(start)
+        , m_concurrency(concurrency)
+    {
+        VERIFY(min_id <= max_id);
+
+        // Both bitmaps are rounded up to whole words, and the bits past the end are marked as allocated.
+        auto word_count = ceil_div(m_id_count, bits_per_word);
+        m_ids = Bitmap(word_count * bits_per_word, false);
+        if (m_id_count != m_ids.size())
+            m_ids.set_range(m_id_count, m_ids.size() - m_id_count, true);
+
+        m_full_words = Bitmap(ceil_div(word_count, bits_per_word) * bits_per_word, false);
+        if (word_count != m_full_words.size())
+            m_full_words.set_range(word_count, m_full_words.size() - word_count, true);
+
+        m_random_state.store(get_random<u64>(), AK::memory_order_relaxed);
+    }
+
     ~IDAllocator() = default;
 
+    int min_id() const { return m_min_id; }
+    int max_id() const { return static_cast<int>(m_min_id + static_cast<i64>(m_id_count) - 1); }
+    size_t allocated_count() const { return m_allocated_count.load(AK::memory_order_relaxed); }
+
     int allocate()
     {
-        int r = rand();
-        for (int i = 0; i < 100000; ++i) {
-            int allocated_id = r + i;
-            // Make sure we never vend ID 0, as some code may interpret that as "no ID"
-            if (allocated_id == 0)
-                ++allocated_id;
-            if (!m_allocated_ids.contains(allocated_id)) {
-                m_allocated_ids.set(allocated_id);
-                return allocated_id;
+        auto id = try_allocate();
+        VERIFY(id.has_value());
+        return id.value();
+    }
+
+    Optional<int> try_allocate()
+    {
+        size_t word_count = m_ids.size() / bits_per_word;
+        size_t word_index;
+        unsigned start_bit = 0;
+        if (m_start == IDAllocatorStart::Randomized) {
+            auto random = next_random();
+            word_index = random % word_count;
+            start_bit = (random >> 32) % bits_per_word;
+        } else {
+            word_index = m_lowest_free_word_hint.load(AK::memory_order_relaxed);
+        }
+
+        for (;;) {
+            auto found_word = find_word_with_free_bits(word_index);
+            if (!found_word.has_value())
+                return {};
+            word_index = found_word.value();
+
+            auto bit = claim_bit_in_word(word_index, start_bit);
+            if (bit.has_value()) {
+                if (m_start == IDAllocatorStart::Lowest)
+                    m_lowest_free_word_hint.store(word_index, AK::memory_order_relaxed);
+                m_allocated_count.fetch_add(1, AK::memory_order_relaxed);
+                return static_cast<int>(m_min_id + static_cast<i64>(word_index * bits_per_word + bit.value()));
             }
+
+            // Another thread took the last free bit of this word between the summary lookup and our CAS.
+            start_bit = 0;
+            if (++word_index == word_count)
+                word_index = 0;
         }
-        VERIFY_NOT_REACHED();
     }
 
+    // IDs that aren't allocated, including those outside the range, are ignored.
     void deallocate(int id)
     {
-        m_allocated_ids.remove(id);
+        if (id < m_min_id || id > max_id())
+            return;
+        auto index = index_of(id);
+        auto word_index = index / bits_per_word;
+        u64 bit = 1ull << (index % bits_per_word);
+
+        if (m_concurrency == IDAllocatorConcurrency::LockFree) {
+            auto previous = AK::atomic_fetch_and(&word(word_index), ~bit, AK::memory_order_acq_rel);
+            if (!(previous & bit))
+                return;
+            if (previous == full_word)
+                AK::atomic_fetch_and(&m_full_words.data()[word_index / 8], static_cast<u8>(~(1u << (word_index % 8))), AK::memory_order_release);
+        } else {
+            if (!(word(word_index) & bit))
+                return;
+            if (word(word_index) == full_word)
+                m_full_words.set(word_index, false);
+            word(word_index) &= ~bit;
+        }
+
+        if (m_start == IDAllocatorStart::Lowest && word_index < m_lowest_free_word_hint.load(AK::memory_order_relaxed))
+            m_lowest_free_word_hint.store(word_index, AK::memory_order_relaxed);
+        m_allocated_count.fetch_sub(1, AK::memory_order_relaxed);
+    }
+
+    bool is_allocated(int id) const
+    {
+        if (id < m_min_id || id > max_id())
+            return false;
+        auto index = index_of(id);
+        return AK::atomic_load(&word(index / bits_per_word), AK::memory_order_relaxed) & (1ull << (index % bits_per_word));
     }
 
 private:
-    HashTable<int> m_allocated_ids;
+    static constexpr size_t bits_per_word = 64;
+    static constexpr u64 full_word = ~0ull;
+
+    // The bitmap is stored little-endian, so bit N of byte B is bit 8 * B + N of the 64-bit word.
+    u64& word(size_t word_index) { return reinterpret_cast<u64*>(m_ids.data())[word_index]; }
+    const u64& word(size_t word_index) const { return reinterpret_cast<const u64*>(m_ids.data())[word_index]; }
+
+    size_t index_of(int id) const
+    {
+        VERIFY(id >= m_min_id && id <= max_id());
+        return static_cast<size_t>(static_cast<i64>(id) - m_min_id);
+    }
+
+    // splitmix64 over an atomic counter, so we only need the entropy pool once and stay thread-safe.
+    u64 next_random()
+    {
+        u64 z = m_random_state.fetch_add(0x9e3779b97f4a7c15ull, AK::memory_order_relaxed) + 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    Optional<size_t> find_word_with_free_bits(size_t hint)
+    {
+        if (m_concurrency == IDAllocatorConcurrency::SingleThreaded)
+            return m_full_words.find_one_anywhere_unset(hint);
+
+        // Other threads flip summary bits with atomic byte operations, so the summary is read a byte at a time the same way.
+        auto* summary = m_full_words.data();
+        size_t byte_count = m_full_words.size_in_bytes();
+        size_t hint_byte = hint / 8;
+        for (size_t i = 0; i <= byte_count; ++i) {
+            size_t byte_index = (hint_byte + i) % byte_count;
+            u8 full_bits = AK::atomic_load(&summary[byte_index], AK::memory_order_relaxed);
+            // The words before the hint in its byte are looked at last, after wrapping around.
+            if (i == 0)
+                full_bits |= static_cast<u8>((1u << (hint % 8)) - 1);
+            if (full_bits != 0xff)
+                return byte_index * 8 + __builtin_ctz(static_cast<u8>(~full_bits));
+        }
+        return {};
+    }
+
+    static Optional<unsigned> pick_free_bit(u64 value, unsigned start_bit)
+    {
+        u64 free_bits = ~value;
+        if (!free_bits)
+            return {};
+        // Prefer free bits at or above start_bit, wrapping around to the low bits otherwise.
+        u64 above_start = free_bits & (full_word << start_bit);
+        return __builtin_ctzll(above_start ? above_start : free_bits);
+    }
+
+    Optional<unsigned> claim_bit_in_word(size_t word_index, unsigned start_bit)
+    {
+        auto& value = word(word_index);
+
+        if (m_concurrency == IDAllocatorConcurrency::SingleThreaded) {
+            auto bit = pick_free_bit(value, start_bit);
+            VERIFY(bit.has_value());
+            value |= 1ull << bit.value();
+            if (value == full_word)
+                m_full_words.set(word_index, true);
+            return bit;
+        }
+
+        u64 expected = AK::atomic_load(&value, AK::memory_order_relaxed);
+        for (;;) {
+            auto bit = pick_free_bit(expected, start_bit);
+            if (!bit.has_value())
+                return {};
+            u64 desired = expected | (1ull << bit.value());
+            if (!AK::atomic_compare_exchange_strong(&value, expected, desired, AK::memory_order_acq_rel))
+                continue;
+            if (desired == full_word) {
+                auto& summary_byte = m_full_words.data()[word_index / 8];
+                u8 summary_bit = 1u << (word_index % 8);
+                AK::atomic_fetch_or(&summary_byte, summary_bit, AK::memory_order_release);
+                // A deallocation may have slipped in before we marked the word full; don't let the summary hide it.
+                if (AK::atomic_load(&value, AK::memory_order_acquire) != full_word)
+                    AK::atomic_fetch_and(&summary_byte, static_cast<u8>(~summary_bit), AK::memory_order_release);
+            }
+            return bit;
+        }
+    }
+
+    int m_min_id { 0 };
+    size_t m_id_count { 0 };
+    IDAllocatorStart m_start;
+    IDAllocatorConcurrency m_concurrency;
+
+    Bitmap m_ids;
+    Bitmap m_full_words;
+
+    Atomic<size_t> m_lowest_free_word_hint { 0 };
+    Atomic<size_t> m_allocated_count { 0 };
+    Atomic<u64> m_random_state { 0 };
 };
+
 }
 
 using AK::IDAllocator;
+using AK::IDAllocatorConcurrency;
+using AK::IDAllocatorStart;
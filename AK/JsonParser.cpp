@@ -25,7 +25,6 @@
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonParser.h>
-#include <ctype.h>
 
 namespace AK {
 
@@ -35,31 +34,12 @@ String JsonParser::consume_and_unescape_string()
         return {};
     StringBuilder final_sb;
 
-    for (;;) {
-        size_t peek_index = m_index;
-        char ch = 0;
-        for (;;) {
-            if (peek_index == m_input.length())
-                break;
-            ch = m_input[peek_index];
-            if (ch == '"' || ch == '\\')
-                break;
-            ++peek_index;
-        }
-
-        while (peek_index != m_index) {
-            final_sb.append(m_input[m_index]);
-            m_index++;
-        }
+    static constexpr CharacterSet string_delimiters { "\"\\" };
 
-        if (m_index == m_input.length())
-            break;
-        if (ch == '"')
+    for (;;) {
+        final_sb.append(consume_until(string_delimiters));
+        if (is_eof() || peek() == '"')
             break;
-        if (ch != '\\') {
-            final_sb.append(consume());
-            continue;
-        }
         ignore();
         char escaped_ch = consume();
         switch (escaped_ch) {
@@ -102,27 +82,27 @@ Optional<JsonValue> JsonParser::parse_object()
     if (!consume_specific('{'))
         return {};
     for (;;) {
-        ignore_while(isspace);
+        ignore_whitespace();
         if (peek() == '}')
             break;
-        ignore_while(isspace);
+        ignore_whitespace();
         auto name = consume_and_unescape_string();
         if (name.is_null())
             return {};
-        ignore_while(isspace);
+        ignore_whitespace();
         if (!consume_specific(':'))
             return {};
-        ignore_while(isspace);
+        ignore_whitespace();
         auto value = parse_helper();
         if (!value.has_value())
             return {};
         object.set(name, move(value.value()));
-        ignore_while(isspace);
+        ignore_whitespace();
         if (peek() == '}')
             break;
         if (!consume_specific(','))
             return {};
-        ignore_while(isspace);
+        ignore_whitespace();
         if (peek() == '}')
             return {};
     }
@@ -137,23 +117,23 @@ Optional<JsonValue> JsonParser::parse_array()
     if (!consume_specific('['))
         return {};
     for (;;) {
-        ignore_while(isspace);
+        ignore_whitespace();
         if (peek() == ']')
             break;
         auto element = parse_helper();
         if (!element.has_value())
             return {};
         array.append(element.value());
-        ignore_while(isspace);
+        ignore_whitespace();
         if (peek() == ']')
             break;
         if (!consume_specific(','))
             return {};
-        ignore_while(isspace);
+        ignore_whitespace();
         if (peek() == ']')
             return {};
     }
-    ignore_while(isspace);
+    ignore_whitespace();
     if (!consume_specific(']'))
         return {};
     return array;
@@ -265,7 +245,7 @@ Optional<JsonValue> JsonParser::parse_null()
 
 Optional<JsonValue> JsonParser::parse_helper()
 {
-    ignore_while(isspace);
+    ignore_whitespace();
     auto type_hint = peek();
     switch (type_hint) {
     case '{':
@@ -302,7 +282,7 @@ Optional<JsonValue> JsonParser::parse()
     auto result = parse_helper();
     if (!result.has_value())
         return {};
-    ignore_while(isspace);
+    ignore_whitespace();
     if (!is_eof())
         return {};
     return result;
@@ -30,81 +30,138 @@
 namespace AK {
 
 LexicalPath::LexicalPath(const StringView& s)
-    : m_string(s)
 {
-    canonicalize();
+    if (canonicalize(s))
+        m_string = s;
     m_is_valid = true;
 }
 
-void LexicalPath::canonicalize()
+LexicalPath::LexicalPath(const String& s)
 {
-    if (m_string.is_empty()) {
-        m_parts.clear();
-        return;
-    }
-
-    m_is_absolute = m_string[0] == '/';
-    auto parts = m_string.split_view('/');
+    if (canonicalize(s))
+        m_string = s;
+    m_is_valid = true;
+}
 
-    size_t approximate_canonical_length = 0;
-    Vector<String> canonical_parts;
+// Builds the canonical path in a single pass. Components are appended to one buffer as
+// they are found, and a ".." simply truncates the buffer back to where its parent started.
+// Returns true without setting m_string if the path was canonical to begin with.
+bool LexicalPath::canonicalize(const StringView& path)
+{
+    if (path.is_empty())
+        return true;
+
+    m_is_absolute = path[0] == '/';
+
+    Vector<char, 256> buffer;
+    buffer.ensure_capacity(path.length() + 1);
+
+    auto append_component = [&](const StringView& part) {
+        if (m_is_absolute || !m_components.is_empty())
+            buffer.unchecked_append('/');
+        m_components.append({ static_cast<u32>(buffer.size()), static_cast<u32>(part.length()) });
+        buffer.append(part.characters_without_null_termination(), part.length());
+    };
+
+    auto last_component_is_dotdot = [&] {
+        auto& last = m_components.last();
+        return last.length == 2 && buffer[last.offset] == '.' && buffer[last.offset + 1] == '.';
+    };
+
+    size_t start = 0;
+    while (start < path.length()) {
+        if (path[start] == '/') {
+            ++start;
+            continue;
+        }
+        auto end = start;
+        while (end < path.length() && path[end] != '/')
+            ++end;
+        auto part = path.substring_view(start, end - start);
+        start = end;
 
-    for (size_t i = 0; i < parts.size(); ++i) {
-        auto& part = parts[i];
         if (part == ".")
             continue;
         if (part == "..") {
-            if (canonical_parts.is_empty()) {
+            if (m_components.is_empty()) {
                 if (m_is_absolute) {
                     // At the root, .. does nothing.
                     continue;
                 }
-            } else {
-                if (canonical_parts.last() != "..") {
-                    // A .. and a previous non-.. part cancel each other.
-                    canonical_parts.take_last();
-                    continue;
-                }
+            } else if (!last_component_is_dotdot()) {
+                // A .. and a previous non-.. part cancel each other.
+                auto last = m_components.take_last();
+                buffer.shrink(last.offset == 0 ? 0 : last.offset - 1, true);
+                continue;
             }
         }
-        if (!part.is_empty()) {
-            approximate_canonical_length += part.length() + 1;
-            canonical_parts.append(part);
-        }
-    }
-    if (canonical_parts.is_empty()) {
-        m_string = m_basename = m_dirname = "/";
-        return;
+        append_component(part);
     }
 
-    StringBuilder dirname_builder(approximate_canonical_length);
-    for (size_t i = 0; i < canonical_parts.size() - 1; ++i) {
-        auto& canonical_part = canonical_parts[i];
-        if (m_is_absolute || i != 0)
-            dirname_builder.append('/');
-        dirname_builder.append(canonical_part);
+    if (m_components.is_empty()) {
+        m_string = "/";
+        return false;
     }
-    m_dirname = dirname_builder.to_string();
 
-    m_basename = canonical_parts.last();
+    if (buffer.size() == path.length() && __builtin_memcmp(buffer.data(), path.characters_without_null_termination(), path.length()) == 0)
+        return true;
+    m_string = StringView { buffer.data(), buffer.size() };
+    return false;
+}
 
-    Optional<size_t> last_dot = StringView(m_basename).find_last_of('.');
-    if (last_dot.has_value()) {
-        m_title = m_basename.substring(0, last_dot.value());
-        m_extension = m_basename.substring(last_dot.value() + 1, m_basename.length() - last_dot.value() - 1);
-    } else {
-        m_title = m_basename;
-    }
+StringView LexicalPath::dirname() const
+{
+    if (m_components.is_empty())
+        return m_string.is_empty() ? StringView {} : "/";
+    auto offset = m_components.last().offset;
+    return m_string.view().substring_view(0, offset == 0 ? 0 : offset - 1);
+}
 
-    StringBuilder builder(approximate_canonical_length);
-    for (size_t i = 0; i < canonical_parts.size(); ++i) {
-        auto& canonical_part = canonical_parts[i];
-        if (m_is_absolute || i != 0)
-            builder.append('/');
-        builder.append(canonical_part);
-    }
-    m_parts = move(canonical_parts);
-    m_string = builder.to_string();
+StringView LexicalPath::basename() const
+{
+    if (m_components.is_empty())
+        return m_string.is_empty() ? StringView {} : "/";
+    return component(m_components.size() - 1);
+}
+
+StringView LexicalPath::title() const
+{
+    if (m_components.is_empty())
+        return {};
+    auto basename = this->basename();
+    auto last_dot = basename.find_last_of('.');
+    if (!last_dot.has_value())
+        return basename;
+    return basename.substring_view(0, last_dot.value());
+}
+
+StringView LexicalPath::extension() const
+{
+    if (m_components.is_empty())
+        return {};
+    auto basename = this->basename();
+    auto last_dot = basename.find_last_of('.');
+    if (!last_dot.has_value())
+        return {};
+    return basename.substring_view(last_dot.value() + 1);
+}
+
+Vector<StringView> LexicalPath::parts_view() const
+{
+    Vector<StringView> parts;
+    parts.ensure_capacity(m_components.size());
+    for (auto part : *this)
+        parts.unchecked_append(part);
+    return parts;
+}
+
+Vector<String> LexicalPath::parts() const
+{
+    Vector<String> parts;
+    parts.ensure_capacity(m_components.size());
+    for (auto part : *this)
+        parts.unchecked_append(part);
+    return parts;
 }
 
 bool LexicalPath::has_extension(const StringView& extension) const
@@ -112,14 +169,28 @@ bool LexicalPath::has_extension(const StringView& extension) const
     return m_string.ends_with(extension, CaseSensitivity::CaseInsensitive);
 }
 
+bool LexicalPath::is_child_of(const LexicalPath& parent) const
+{
+    if (m_is_absolute != parent.m_is_absolute || m_components.size() <= parent.m_components.size())
+        return false;
+    // Both paths are canonical, so comparing the strings is the same as comparing the components,
+    // as long as the parent's last component isn't just a prefix of ours.
+    if (parent.m_components.is_empty())
+        return true;
+    auto& parent_string = parent.m_string;
+    return m_string.length() > parent_string.length()
+        && m_string[parent_string.length()] == '/'
+        && m_string.view().starts_with(parent_string);
+}
+
 String LexicalPath::canonicalized_path(const StringView& path)
 {
     return LexicalPath(path).string();
 }
 
-String LexicalPath::relative_path(const String absolute_path, const String& prefix)
+String LexicalPath::relative_path(const StringView& absolute_path, const StringView& prefix)
 {
-    if (!LexicalPath { absolute_path }.is_absolute() || !LexicalPath { prefix }.is_absolute())
+    if (!absolute_path.starts_with('/') || !prefix.starts_with('/'))
         return {};
 
     if (!absolute_path.starts_with(prefix))
@@ -129,7 +200,7 @@ String LexicalPath::relative_path(const String absolute_path, const String& pref
     if (prefix_length >= absolute_path.length())
         return {};
 
-    return absolute_path.substring(prefix_length);
+    return absolute_path.substring_view(prefix_length);
 }
 
 }
@@ -25,40 +25,88 @@
 #pragma once
 
 #include <AK/String.h>
+#include <AK/StringView.h>
 #include <AK/Vector.h>
 
 namespace AK {
 
+// A canonicalized path, stored as a single string plus the offsets of its
+// components. The accessors hand out views into that string, so they don't
+// allocate, and they stay valid for as long as the LexicalPath (or a copy of it).
 class LexicalPath {
+    struct Component {
+        u32 offset;
+        u32 length;
+    };
+
 public:
     LexicalPath() = default;
     explicit LexicalPath(const StringView&);
+    // Shares the string instead of copying it if the path is already canonical.
+    explicit LexicalPath(const String&);
+    explicit LexicalPath(const char* path)
+        : LexicalPath(StringView { path })
+    {
+    }
 
     bool is_valid() const { return m_is_valid; }
     bool is_absolute() const { return m_is_absolute; }
     const String& string() const { return m_string; }
 
-    const String& dirname() const { return m_dirname; }
-    const String& basename() const { return m_basename; }
-    const String& title() const { return m_title; }
-    const String& extension() const { return m_extension; }
+    StringView dirname() const;
+    StringView basename() const;
+    StringView title() const;
+    StringView extension() const;
+
+    size_t component_count() const { return m_components.size(); }
+    StringView component(size_t index) const
+    {
+        auto& component = m_components[index];
+        return m_string.view().substring_view(component.offset, component.length);
+    }
 
-    const Vector<String>& parts() const { return m_parts; }
+    class ComponentIterator {
+    public:
+        StringView operator*() const { return m_path.component(m_index); }
+        ComponentIterator& operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+        bool operator!=(const ComponentIterator& other) const { return m_index != other.m_index; }
+
+    private:
+        friend class LexicalPath;
+        ComponentIterator(const LexicalPath& path, size_t index)
+            : m_path(path)
+            , m_index(index)
+        {
+        }
+
+        const LexicalPath& m_path;
+        size_t m_index { 0 };
+    };
+
+    // Iterates over the components as StringViews, e.g. `for (auto part : path)`.
+    ComponentIterator begin() const { return { *this, 0 }; }
+    ComponentIterator end() const { return { *this, m_components.size() }; }
+
+    Vector<StringView> parts_view() const;
+    Vector<String> parts() const;
 
     bool has_extension(const StringView&) const;
 
+    // Whether this path lies somewhere below the given one. A path is not its own child.
+    bool is_child_of(const LexicalPath& parent) const;
+
     static String canonicalized_path(const StringView&);
-    static String relative_path(const String absolute_path, const String& prefix);
+    static String relative_path(const StringView& absolute_path, const StringView& prefix);
 
 private:
-    void canonicalize();
+    bool canonicalize(const StringView&);
 
-    Vector<String> m_parts;
     String m_string;
-    String m_dirname;
-    String m_basename;
-    String m_title;
-    String m_extension;
+    Vector<Component, 16> m_components;
     bool m_is_valid { false };
     bool m_is_absolute { false };
 };
@@ -27,19 +27,75 @@
 #include <AK/String.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 namespace AK {
 
+// Not every system knows every hint; the ones it doesn't know are silently skipped.
+static Optional<int> madvise_flag(MappedFile::Advice advice)
+{
+    switch (advice) {
+#ifdef MADV_NORMAL
+    case MappedFile::Advice::Normal:
+        return MADV_NORMAL;
+#endif
+#ifdef MADV_SEQUENTIAL
+    case MappedFile::Advice::Sequential:
+        return MADV_SEQUENTIAL;
+#endif
+#ifdef MADV_RANDOM
+    case MappedFile::Advice::Random:
+        return MADV_RANDOM;
+#endif
+#ifdef MADV_WILLNEED
+    case MappedFile::Advice::WillNeed:
+        return MADV_WILLNEED;
+#endif
+    default:
+        return {};
+    }
+}
+
+static Result<void*, OSError> map_pages(int fd, MappedFile::Mode mode, off_t offset, size_t size, bool populate)
+{
+    int prot = PROT_READ;
+    if (mode == MappedFile::Mode::ReadWrite)
+        prot |= PROT_WRITE;
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (populate)
+        flags |= MAP_POPULATE;
+#else
+    (void)populate;
+#endif
+    auto* ptr = mmap(nullptr, size, prot, flags, fd, offset);
+    if (ptr == MAP_FAILED)
+        return OSError(errno);
+    return ptr;
+}
+
 Result<NonnullRefPtr<MappedFile>, OSError> MappedFile::map(const String& path)
 {
-    int fd = open(path.characters(), O_RDONLY | O_CLOEXEC, 0);
+    return map(path, Options {});
+}
+
+Result<NonnullRefPtr<MappedFile>, OSError> MappedFile::map(const String& path, const Options& options)
+{
+    VERIFY(!options.create || options.mode == Mode::ReadWrite);
+
+    int open_flags = O_CLOEXEC;
+    open_flags |= options.mode == Mode::ReadWrite ? O_RDWR : O_RDONLY;
+    if (options.create)
+        open_flags |= O_CREAT;
+
+    int fd = open(path.characters(), open_flags, 0644);
     if (fd < 0)
         return OSError(errno);
 
-    ScopeGuard fd_close_guard = [fd] {
+    ArmedScopeGuard fd_close_guard = [fd] {
         close(fd);
     };
 
@@ -49,25 +105,163 @@ Result<NonnullRefPtr<MappedFile>, OSError> MappedFile::map(const String& path)
         return OSError(saved_errno);
     }
 
-    auto size = st.st_size;
-    auto* ptr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (options.offset < 0 || options.offset > st.st_size)
+        return OSError(EINVAL);
+    size_t available = st.st_size - options.offset;
+    auto size = options.size.value_or(available);
+    if (size > available)
+        return OSError(EINVAL);
 
-    if (ptr == MAP_FAILED)
-        return OSError(errno);
+    // mmap() wants a page aligned file offset, so start mapping a little earlier if needed.
+    size_t mapping_offset = options.offset % PAGE_SIZE;
+    size_t mapping_size = mapping_offset + size;
+
+    void* mapping = nullptr;
+    if (size != 0) {
+        auto mapping_or_error = map_pages(fd, options.mode, options.offset - mapping_offset, mapping_size, options.populate);
+        if (mapping_or_error.is_error())
+            return mapping_or_error.error();
+        mapping = mapping_or_error.value();
+    }
+
+    int kept_fd = -1;
+    if (options.mode == Mode::ReadWrite) {
+        fd_close_guard.disarm();
+        kept_fd = fd;
+    }
 
-    return adopt(*new MappedFile(ptr, size));
+    auto mapped_file = adopt(*new MappedFile(kept_fd, options, mapping, mapping_size, size));
+    if (size != 0) {
+        mapped_file->apply_huge_pages_hint();
+        if (options.advice != Advice::Normal) {
+            auto result = mapped_file->apply_advice(options.advice, mapped_file->m_data, size);
+            if (result.is_error())
+                return result.error();
+        }
+#ifndef MAP_POPULATE
+        if (options.populate)
+            (void)mapped_file->apply_advice(Advice::WillNeed, mapped_file->m_data, size);
+#endif
+    }
+    return mapped_file;
 }
 
-MappedFile::MappedFile(void* ptr, size_t size)
-    : m_data(ptr)
+MappedFile::MappedFile(int fd, const Options& options, void* mapping, size_t mapping_size, size_t size)
+    : m_fd(fd)
+    , m_mode(options.mode)
+    , m_offset(options.offset)
+    , m_advice(options.advice)
+    , m_huge_pages(options.huge_pages)
     , m_size(size)
+    , m_mapping(mapping)
+    , m_mapping_size(mapping_size)
 {
+    if (m_mapping)
+        m_data = static_cast<u8*>(m_mapping) + (m_mapping_size - m_size);
 }
 
 MappedFile::~MappedFile()
 {
-    auto rc = munmap(m_data, m_size);
-    VERIFY(rc == 0);
+    if (m_mapping) {
+        auto rc = munmap(m_mapping, m_mapping_size);
+        VERIFY(rc == 0);
+    }
+    if (m_fd >= 0)
+        close(m_fd);
+}
+
+Result<void, OSError> MappedFile::apply_advice(Advice advice, u8* start, size_t length)
+{
+    auto flag = madvise_flag(advice);
+    if (!flag.has_value() || length == 0)
+        return {};
+    auto misalignment = reinterpret_cast<FlatPtr>(start) % PAGE_SIZE;
+    if (madvise(start - misalignment, length + misalignment, flag.value()) < 0)
+        return OSError(errno);
+    return {};
+}
+
+void MappedFile::apply_huge_pages_hint()
+{
+#ifdef MADV_HUGEPAGE
+    // This is only a hint, and file systems without huge page support reject it.
+    if (m_huge_pages)
+        (void)madvise(m_mapping, m_mapping_size, MADV_HUGEPAGE);
+#endif
+}
+
+Result<void, OSError> MappedFile::advise(Advice advice, size_t offset, Optional<size_t> length)
+{
+    VERIFY(offset <= m_size);
+    auto range_length = length.value_or(m_size - offset);
+    VERIFY(range_length <= m_size - offset);
+    if (offset == 0 && range_length == m_size)
+        m_advice = advice;
+    return apply_advice(advice, m_data + offset, range_length);
+}
+
+Result<void, OSError> MappedFile::sync(SyncMode mode, size_t offset, Optional<size_t> length)
+{
+    VERIFY(offset <= m_size);
+    auto range_length = length.value_or(m_size - offset);
+    VERIFY(range_length <= m_size - offset);
+    if (m_mode == Mode::ReadOnly || range_length == 0)
+        return {};
+
+    auto* start = m_data + offset;
+    auto misalignment = reinterpret_cast<FlatPtr>(start) % PAGE_SIZE;
+    int flags = mode == SyncMode::Synchronous ? MS_SYNC : MS_ASYNC;
+    if (msync(start - misalignment, range_length + misalignment, flags) < 0)
+        return OSError(errno);
+    return {};
+}
+
+Result<void, OSError> MappedFile::grow(size_t new_size)
+{
+    VERIFY(m_mode == Mode::ReadWrite);
+    VERIFY(m_fd >= 0);
+    if (new_size <= m_size)
+        return {};
+
+    struct stat st;
+    if (fstat(m_fd, &st) < 0)
+        return OSError(errno);
+    auto required_file_size = m_offset + static_cast<off_t>(new_size);
+    if (st.st_size < required_file_size && ftruncate(m_fd, required_file_size) < 0)
+        return OSError(errno);
+
+    size_t mapping_offset = m_offset % PAGE_SIZE;
+    size_t new_mapping_size = mapping_offset + new_size;
+
+    void* new_mapping = nullptr;
+#ifdef MREMAP_MAYMOVE
+    if (m_mapping) {
+        // The kernel can usually extend the mapping in place, and moves the page tables along if it can't.
+        new_mapping = mremap(m_mapping, m_mapping_size, new_mapping_size, MREMAP_MAYMOVE);
+        if (new_mapping == MAP_FAILED)
+            return OSError(errno);
+    }
+#endif
+    if (!new_mapping) {
+        auto mapping_or_error = map_pages(m_fd, m_mode, m_offset - mapping_offset, new_mapping_size, false);
+        if (mapping_or_error.is_error())
+            return mapping_or_error.error();
+        new_mapping = mapping_or_error.value();
+        if (m_mapping) {
+            auto rc = munmap(m_mapping, m_mapping_size);
+            VERIFY(rc == 0);
+        }
+    }
+
+    m_mapping = new_mapping;
+    m_mapping_size = new_mapping_size;
+    m_data = static_cast<u8*>(m_mapping) + mapping_offset;
+    m_size = new_size;
+
+    apply_huge_pages_hint();
+    if (m_advice != Advice::Normal)
+        return apply_advice(m_advice, m_data, m_size);
+    return {};
 }
 
 }
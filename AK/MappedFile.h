@@ -27,8 +27,10 @@
 #include <AK/Noncopyable.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/OSError.h>
+#include <AK/Optional.h>
 #include <AK/RefCounted.h>
 #include <AK/Result.h>
+#include <sys/types.h>
 
 namespace AK {
 
@@ -37,21 +39,88 @@ class MappedFile : public RefCounted<MappedFile> {
     AK_MAKE_NONMOVABLE(MappedFile);
 
 public:
+    enum class Mode {
+        ReadOnly,
+        // Writes go straight to the page cache and end up in the file.
+        ReadWrite,
+    };
+
+    enum class Advice {
+        Normal,
+        Sequential,
+        Random,
+        WillNeed,
+    };
+
+    struct Options {
+        Mode mode { Mode::ReadOnly };
+        // Only used with Mode::ReadWrite; the file is created empty if it doesn't exist.
+        bool create { false };
+        // The offset doesn't have to be page aligned.
+        off_t offset { 0 };
+        // Maps everything from the offset to the end of the file by default.
+        Optional<size_t> size;
+        Advice advice { Advice::Normal };
+        // Fault in the whole range up front instead of page by page.
+        bool populate { false };
+        // Ask for transparent huge pages. Most file systems ignore this.
+        bool huge_pages { false };
+    };
+
     static Result<NonnullRefPtr<MappedFile>, OSError> map(const String& path);
+    static Result<NonnullRefPtr<MappedFile>, OSError> map(const String& path, const Options&);
     ~MappedFile();
 
     void* data() { return m_data; }
     const void* data() const { return m_data; }
 
     size_t size() const { return m_size; }
+    off_t offset() const { return m_offset; }
+    Mode mode() const { return m_mode; }
 
     ReadonlyBytes bytes() const { return { m_data, m_size }; }
 
+    Bytes writable_bytes()
+    {
+        VERIFY(m_mode == Mode::ReadWrite);
+        return { m_data, m_size };
+    }
+
+    // Changes the access pattern hint for the given part of the mapping, or all of it.
+    Result<void, OSError> advise(Advice, size_t offset = 0, Optional<size_t> length = {});
+
+    enum class SyncMode {
+        Synchronous,
+        Asynchronous,
+    };
+
+    // Writes dirty pages in the given part of the mapping, or all of it, back to the file.
+    Result<void, OSError> sync(SyncMode = SyncMode::Synchronous, size_t offset = 0, Optional<size_t> length = {});
+
+    // Extends the file so that the mapping can cover new_size bytes, and remaps it.
+    // Only possible with Mode::ReadWrite. This may move the mapping, so any pointers
+    // into data() or bytes() are invalid afterwards.
+    Result<void, OSError> grow(size_t new_size);
+
 private:
-    explicit MappedFile(void*, size_t);
+    MappedFile(int fd, const Options&, void* mapping, size_t mapping_size, size_t size);
+
+    Result<void, OSError> apply_advice(Advice, u8* start, size_t length);
+    void apply_huge_pages_hint();
 
-    void* m_data { nullptr };
+    // The fd is kept open only for read-write mappings, which can grow.
+    int m_fd { -1 };
+    Mode m_mode { Mode::ReadOnly };
+    off_t m_offset { 0 };
+    Advice m_advice { Advice::Normal };
+    bool m_huge_pages { false };
+
+    u8* m_data { nullptr };
     size_t m_size { 0 };
+
+    // mmap() needs a page aligned offset, so the mapping may start a bit before m_data.
+    void* m_mapping { nullptr };
+    size_t m_mapping_size { 0 };
 };
 
 }
@@ -201,9 +201,27 @@ private:
     Bytes m_bytes;
 };
 
+// A FIFO of bytes stored in a list of chunks. Consumed chunks go back to a small
+// free list and are reused by later writes, so a stream that is written and read
+// in turns stops allocating after warming up. Whole chunks can also be borrowed
+// or moved in and out of the stream without copying the bytes.
 class DuplexMemoryStream final : public DuplexStream {
 public:
-    static constexpr size_t chunk_size = 4 * 1024;
+    static constexpr size_t default_chunk_size = 4 * KiB;
+    static constexpr size_t max_pooled_chunks = 16;
+
+    DuplexMemoryStream()
+        : DuplexMemoryStream(default_chunk_size)
+    {
+    }
+
+    explicit DuplexMemoryStream(size_t chunk_size)
+        : m_chunk_size(chunk_size)
+    {
+        VERIFY(chunk_size > 0);
+    }
+
+    size_t chunk_size() const { return m_chunk_size; }
 
     bool unreliable_eof() const override { return eof(); }
     bool eof() const { return m_write_offset == m_read_offset; }
@@ -215,45 +233,104 @@ public:
             return false;
         }
 
-        m_read_offset += count;
-        try_discard_chunks();
+        consume(count);
         return true;
     }
 
     Optional<size_t> offset_of(ReadonlyBytes value) const
     {
-        // We can't directly pass m_chunks to memmem since we have a limited read/write range we want to search in.
-        Vector<ReadonlyBytes> spans;
-        auto chunk_index = (m_read_offset - m_base_offset) / chunk_size;
-        auto chunk_read_offset = (m_read_offset - m_base_offset) % chunk_size;
-        auto bytes_to_search = m_write_offset - m_read_offset;
-        for (; bytes_to_search > 0;) {
-            ReadonlyBytes span = m_chunks[chunk_index];
-            if (chunk_read_offset) {
-                span = span.slice(chunk_read_offset);
-                chunk_read_offset = 0;
-            }
-            if (bytes_to_search < span.size()) {
-                spans.append(span.slice(0, bytes_to_search));
-                break;
+        if (value.is_empty())
+            return 0;
+        if (value.size() > size())
+            return {};
+
+        // Long needles go through KMP, which can't degrade into quadratic behaviour.
+        if (value.size() >= 32) {
+            auto* end = m_chunks.data() + m_chunks.size();
+            return memmem(ChunkIterator { m_chunks.data() + m_first_chunk, end }, ChunkIterator { end, end }, value);
+        }
+
+        // Short needles are found by skipping to candidates for their first byte with memchr().
+        size_t chunk_offset = 0;
+        for (size_t i = m_first_chunk; i < m_chunks.size(); ++i) {
+            auto chunk = m_chunks[i].readable_bytes();
+            for (size_t position = 0; position < chunk.size(); ++position) {
+                auto* candidate = static_cast<const u8*>(__builtin_memchr(chunk.data() + position, value[0], chunk.size() - position));
+                if (!candidate)
+                    break;
+                position = candidate - chunk.data();
+                if (matches_at(i, position, value))
+                    return chunk_offset + position;
             }
-            bytes_to_search -= span.size();
-            spans.append(move(span));
-            ++chunk_index;
+            chunk_offset += chunk.size();
         }
+        return {};
+    }
 
-        return memmem(spans.begin(), spans.end(), value);
+    // Returns the readable bytes as one span per chunk, without copying them. Hand these to write_vectored()
+    // and discard_or_error() what was written to drain the stream without going through an intermediate buffer.
+    // The spans stay valid until the next read, discard or write.
+    Vector<ReadonlyBytes> readable_spans() const
+    {
+        Vector<ReadonlyBytes> spans;
+        spans.ensure_capacity(m_chunks.size() - m_first_chunk);
+        for (size_t i = m_first_chunk; i < m_chunks.size(); ++i)
+            spans.unchecked_append(m_chunks[i].readable_bytes());
+        return spans;
+    }
+
+    // Borrows the readable part of the first chunk. It stays valid until the next read, discard or write.
+    ReadonlyBytes peek_chunk() const
+    {
+        if (eof())
+            return {};
+        return m_chunks[m_first_chunk].readable_bytes();
+    }
+
+    // Takes the readable part of the first chunk out of the stream. The buffer is handed over as is
+    // unless part of it was already read, in which case the rest is moved to its front first.
+    Optional<ByteBuffer> take_chunk()
+    {
+        if (eof())
+            return {};
+
+        auto chunk = move(m_chunks[m_first_chunk]);
+        ++m_first_chunk;
+        compact_chunk_list();
+
+        auto size = chunk.end - chunk.begin;
+        if (chunk.begin != 0)
+            __builtin_memmove(chunk.buffer.data(), chunk.buffer.data() + chunk.begin, size);
+        chunk.buffer.trim(size);
+        m_read_offset += size;
+        return move(chunk.buffer);
+    }
+
+    // Appends a whole buffer to the stream without copying it. Later writes start a new chunk.
+    void append_chunk(ByteBuffer&& buffer)
+    {
+        auto size = buffer.size();
+        if (size == 0)
+            return;
+        // An empty chunk would otherwise end up in the middle of the stream.
+        if (m_chunks.size() != m_first_chunk && m_chunks.last().begin == m_chunks.last().end)
+            recycle_chunk(m_chunks.take_last().buffer);
+        m_chunks.append({ move(buffer), 0, size });
+        m_write_offset += size;
+    }
+
+    // Gives a buffer that is no longer needed, e.g. one returned by take_chunk(), back to the pool.
+    void recycle_chunk(ByteBuffer&& buffer)
+    {
+        if (buffer.size() == m_chunk_size && m_free_chunks.size() < max_pooled_chunks)
+            m_free_chunks.append(move(buffer));
     }
 
     size_t read_without_consuming(Bytes bytes) const
     {
         size_t nread = 0;
-        while (bytes.size() - nread > 0 && m_write_offset - m_read_offset - nread > 0) {
-            const auto chunk_index = (m_read_offset - m_base_offset + nread) / chunk_size;
-            const auto chunk_bytes = m_chunks[chunk_index].bytes().slice((m_read_offset + nread) % chunk_size).trim(m_write_offset - m_read_offset - nread);
-            nread += chunk_bytes.copy_trimmed_to(bytes.slice(nread));
-        }
-
+        for (size_t i = m_first_chunk; i < m_chunks.size() && nread < bytes.size(); ++i)
+            nread += m_chunks[i].readable_bytes().copy_trimmed_to(bytes.slice(nread));
         return nread;
     }
 
@@ -263,10 +340,7 @@ public:
             return 0;
 
         const auto nread = read_without_consuming(bytes);
-
-        m_read_offset += nread;
-        try_discard_chunks();
-
+        consume(nread);
         return nread;
     }
 
@@ -282,14 +356,15 @@ public:
 
     size_t write(ReadonlyBytes bytes) override
     {
-        // FIXME: This doesn't write around chunk borders correctly?
-
         size_t nwritten = 0;
-        while (bytes.size() - nwritten > 0) {
-            if ((m_write_offset + nwritten) % chunk_size == 0)
-                m_chunks.append(ByteBuffer::create_uninitialized(chunk_size));
-
-            nwritten += bytes.slice(nwritten).copy_trimmed_to(m_chunks.last().bytes().slice((m_write_offset + nwritten) % chunk_size));
+        while (nwritten < bytes.size()) {
+            if (m_chunks.size() == m_first_chunk || m_chunks.last().is_full())
+                m_chunks.append({ allocate_chunk(), 0, 0 });
+
+            auto& chunk = m_chunks.last();
+            auto count = bytes.slice(nwritten).copy_trimmed_to(chunk.buffer.bytes().slice(chunk.end));
+            chunk.end += count;
+            nwritten += count;
         }
 
         m_write_offset += nwritten;
@@ -318,20 +393,130 @@ public:
     size_t size() const { return m_write_offset - m_read_offset; }
 
 private:
-    void try_discard_chunks()
+    struct Chunk {
+        ByteBuffer buffer;
+        // The unread bytes of the chunk are [begin, end).
+        size_t begin { 0 };
+        size_t end { 0 };
+
+        ReadonlyBytes readable_bytes() const { return { buffer.data() + begin, end - begin }; }
+        bool is_full() const { return end == buffer.size(); }
+    };
+
+    // Walks the readable parts of the chunks for memmem(), without collecting them into a Vector first.
+    // memmem() dereferences the iterator for every byte, so the current span is cached.
+    class ChunkIterator {
+    public:
+        ChunkIterator(const Chunk* chunk, const Chunk* end)
+            : m_chunk(chunk)
+            , m_end(end)
+        {
+            update_bytes();
+        }
+
+        const ReadonlyBytes& operator*() const { return m_bytes; }
+        ChunkIterator& operator++()
+        {
+            ++m_chunk;
+            update_bytes();
+            return *this;
+        }
+        bool operator!=(const ChunkIterator& other) const { return m_chunk != other.m_chunk; }
+
+    private:
+        void update_bytes()
+        {
+            if (m_chunk != m_end)
+                m_bytes = m_chunk->readable_bytes();
+        }
+
+        const Chunk* m_chunk { nullptr };
+        const Chunk* m_end { nullptr };
+        ReadonlyBytes m_bytes;
+    };
+
+    bool matches_at(size_t chunk_index, size_t position, ReadonlyBytes value) const
     {
-        while (m_read_offset - m_base_offset >= chunk_size) {
-            m_chunks.take_first();
-            m_base_offset += chunk_size;
+        for (; chunk_index < m_chunks.size(); ++chunk_index, position = 0) {
+            auto chunk = m_chunks[chunk_index].readable_bytes().slice(position);
+            auto count = min(chunk.size(), value.size());
+            if (__builtin_memcmp(chunk.data(), value.data(), count) != 0)
+                return false;
+            value = value.slice(count);
+            if (value.is_empty())
+                return true;
         }
+        return false;
     }
 
-    Vector<ByteBuffer> m_chunks;
+    ByteBuffer allocate_chunk()
+    {
+        if (!m_free_chunks.is_empty())
+            return m_free_chunks.take_last();
+        return ByteBuffer::create_uninitialized(m_chunk_size);
+    }
+
+    void consume(size_t count)
+    {
+        m_read_offset += count;
+        while (count > 0) {
+            auto& chunk = m_chunks[m_first_chunk];
+            auto available = chunk.end - chunk.begin;
+            if (count < available || (count == available && m_first_chunk == m_chunks.size() - 1 && !chunk.is_full())) {
+                // Keep the chunk that is still being written to around.
+                chunk.begin += count;
+                break;
+            }
+            count -= available;
+            recycle_chunk(move(chunk.buffer));
+            ++m_first_chunk;
+        }
+        compact_chunk_list();
+    }
+
+    // Consumed chunks are dropped from the front of the list lazily, so that reading doesn't shift
+    // the whole list every time a chunk is used up.
+    void compact_chunk_list()
+    {
+        if (m_first_chunk == m_chunks.size()) {
+            m_chunks.clear_with_capacity();
+            m_first_chunk = 0;
+        } else if (m_first_chunk >= 32 && m_first_chunk * 2 >= m_chunks.size()) {
+            m_chunks.remove(0, m_first_chunk);
+            m_first_chunk = 0;
+        }
+    }
+
+    size_t m_chunk_size { default_chunk_size };
+    Vector<Chunk> m_chunks;
+    size_t m_first_chunk { 0 };
+    Vector<ByteBuffer, max_pooled_chunks> m_free_chunks;
     size_t m_write_offset { 0 };
     size_t m_read_offset { 0 };
-    size_t m_base_offset { 0 };
 };
 
+// Drains the chunks of a DuplexMemoryStream with a single vectored write, without copying them first.
+inline size_t copy_stream(DuplexMemoryStream& input, OutputStream& output)
+{
+    auto nwritten = output.write_vectored(input.readable_spans());
+    input.discard_or_error(nwritten);
+    return nwritten;
+}
+
+// Moves whole chunks from one stream to the other instead of copying their contents.
+inline size_t copy_stream(DuplexMemoryStream& input, DuplexMemoryStream& output)
+{
+    size_t ncopied = 0;
+    for (;;) {
+        auto chunk = input.take_chunk();
+        if (!chunk.has_value())
+            break;
+        ncopied += chunk->size();
+        output.append_chunk(chunk.release_value());
+    }
+    return ncopied;
+}
+
 }
 
 using AK::DuplexMemoryStream;
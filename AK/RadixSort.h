@@ -0,0 +1,496 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/Assertions.h>
+#include <AK/BitCast.h>
+#include <AK/NumericLimits.h>
+#include <AK/Span.h>
+#include <AK/StdLibExtras.h>
+#include <AK/String.h>
+#include <AK/StringView.h>
+#include <AK/Traits.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+#include <AK/kmalloc.h>
+
+#ifndef KERNEL
+#    include <pthread.h>
+#    include <unistd.h>
+#endif
+
+namespace AK {
+
+/* These are stable radix sorts for fixed-width keys (integers and floats) and
+ * for string keys. Fixed-width keys use an LSD sort with one 8-bit digit per
+ * pass; the histograms for all passes are built up front in a single sweep,
+ * and any pass where every key has the same digit is skipped entirely, so
+ * sorting e.g. small file sizes stored in a u64 only pays for the low bytes.
+ * String keys use an MSD sort that falls back to insertion sort for small
+ * buckets.
+ *
+ * Trivial element types are scattered directly between the input and a
+ * scratch buffer. Everything else is sorted as (key, index) pairs and then
+ * permuted into place with moves, so elements are never copied.
+ *
+ * RadixSortHistogram::Parallel splits the histogram sweep across threads.
+ * It only pays off for large inputs, and small inputs ignore it.
+ */
+
+enum class RadixSortHistogram {
+    Serial,
+    Parallel,
+};
+
+namespace Detail {
+
+template<typename T>
+struct RadixKey;
+
+template<typename T>
+requires(IsIntegral<T>::value) struct RadixKey<T> {
+    using Type = typename MakeUnsigned<typename RemoveCV<T>::Type>::Type;
+    static constexpr Type encode(T value)
+    {
+        if constexpr (IsSigned<typename RemoveCV<T>::Type>::value)
+            return static_cast<Type>(value) ^ (static_cast<Type>(1) << (sizeof(Type) * 8 - 1));
+        else
+            return static_cast<Type>(value);
+    }
+};
+
+// Positive floats order correctly by their bit pattern once the sign bit is
+// set; negative floats order in reverse, so all of their bits are flipped.
+template<>
+struct RadixKey<float> {
+    using Type = u32;
+    static Type encode(float value)
+    {
+        auto bits = bit_cast<u32>(value);
+        return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    }
+};
+
+template<>
+struct RadixKey<double> {
+    using Type = u64;
+    static Type encode(double value)
+    {
+        auto bits = bit_cast<u64>(value);
+        return (bits & 0x8000000000000000ull) ? ~bits : (bits | 0x8000000000000000ull);
+    }
+};
+
+template<typename T>
+inline constexpr bool is_string_key = IsSame<typename RemoveCV<typename RemoveReference<T>::Type>::Type, StringView>::value
+    || IsSame<typename RemoveCV<typename RemoveReference<T>::Type>::Type, String>::value;
+
+template<typename T>
+inline constexpr bool can_scatter_directly = IsArithmetic<T>::value || Traits<T>::is_trivial();
+
+static constexpr size_t radix_sort_parallel_threshold = 1 << 16;
+static constexpr size_t radix_sort_max_threads = 16;
+static constexpr size_t msd_insertion_sort_threshold = 32;
+
+template<typename Key>
+using RadixHistograms = Array<Array<size_t, 256>, sizeof(Key)>;
+
+template<typename Key, typename T, typename KeyOf>
+void accumulate_radix_histograms(const T* data, size_t size, KeyOf& key_of, RadixHistograms<Key>& histograms)
+{
+    for (size_t i = 0; i < size; ++i) {
+        Key key = key_of(data[i]);
+        for (size_t pass = 0; pass < sizeof(Key); ++pass)
+            ++histograms[pass][(key >> (pass * 8)) & 0xff];
+    }
+}
+
+#ifndef KERNEL
+template<typename Key, typename T, typename KeyOf>
+struct RadixHistogramJob {
+    const T* data { nullptr };
+    size_t size { 0 };
+    KeyOf* key_of { nullptr };
+    RadixHistograms<Key> histograms {};
+    pthread_t thread {};
+    bool did_spawn { false };
+};
+
+template<typename Key, typename T, typename KeyOf>
+void accumulate_radix_histograms_in_parallel(const T* data, size_t size, KeyOf& key_of, RadixHistograms<Key>& histograms)
+{
+    using Job = RadixHistogramJob<Key, T, KeyOf>;
+
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t thread_count = min(cpu_count > 1 ? static_cast<size_t>(cpu_count) : 1, radix_sort_max_threads);
+    thread_count = min(thread_count, size / (radix_sort_parallel_threshold / 4));
+    if (thread_count <= 1) {
+        accumulate_radix_histograms<Key>(data, size, key_of, histograms);
+        return;
+    }
+
+    Vector<Job> jobs;
+    jobs.resize(thread_count);
+    size_t chunk_size = size / thread_count;
+    for (size_t i = 0; i < thread_count; ++i) {
+        auto& job = jobs[i];
+        job.data = data + i * chunk_size;
+        job.size = (i == thread_count - 1) ? size - i * chunk_size : chunk_size;
+        job.key_of = &key_of;
+    }
+
+    // The calling thread takes the first chunk itself.
+    for (size_t i = 1; i < thread_count; ++i) {
+        auto& job = jobs[i];
+        int rc = pthread_create(
+            &job.thread, nullptr, [](void* argument) -> void* {
+                auto& job = *static_cast<Job*>(argument);
+                accumulate_radix_histograms<Key>(job.data, job.size, *job.key_of, job.histograms);
+                return nullptr;
+            },
+            &job);
+        job.did_spawn = rc == 0;
+    }
+
+    accumulate_radix_histograms<Key>(jobs[0].data, jobs[0].size, key_of, jobs[0].histograms);
+
+    for (auto& job : jobs) {
+        if (job.did_spawn)
+            pthread_join(job.thread, nullptr);
+        else if (&job != &jobs[0])
+            accumulate_radix_histograms<Key>(job.data, job.size, key_of, job.histograms);
+
+        for (size_t pass = 0; pass < sizeof(Key); ++pass) {
+            for (size_t digit = 0; digit < 256; ++digit)
+                histograms[pass][digit] += job.histograms[pass][digit];
+        }
+    }
+}
+#endif
+
+// Sorts `data` using `scratch` (at least `size` elements) as the ping-pong buffer.
+// `key_of` must return an unsigned, order-preserving key.
+template<typename T, typename KeyOf>
+void lsd_radix_sort(T* data, T* scratch, size_t size, KeyOf key_of, RadixSortHistogram histogram_mode)
+{
+    using Key = decltype(key_of(*data));
+    static_assert(IsUnsigned<Key>::value);
+
+    if (size < 2)
+        return;
+
+    RadixHistograms<Key> histograms {};
+#ifndef KERNEL
+    if (histogram_mode == RadixSortHistogram::Parallel && size >= radix_sort_parallel_threshold)
+        accumulate_radix_histograms_in_parallel<Key>(data, size, key_of, histograms);
+    else
+        accumulate_radix_histograms<Key>(data, size, key_of, histograms);
+#else
+    (void)histogram_mode;
+    accumulate_radix_histograms<Key>(data, size, key_of, histograms);
+#endif
+
+    T* from = data;
+    T* to = scratch;
+    for (size_t pass = 0; pass < sizeof(Key); ++pass) {
+        auto& counts = histograms[pass];
+        size_t shift = pass * 8;
+
+        // Every key has the same digit here, so this pass would be the identity.
+        if (counts[(key_of(*from) >> shift) & 0xff] == size)
+            continue;
+
+        Array<size_t, 256> offsets;
+        size_t total = 0;
+        for (size_t digit = 0; digit < 256; ++digit) {
+            offsets[digit] = total;
+            total += counts[digit];
+        }
+
+        for (size_t i = 0; i < size; ++i)
+            to[offsets[(key_of(from[i]) >> shift) & 0xff]++] = from[i];
+
+        swap(from, to);
+    }
+
+    if (from != data)
+        __builtin_memcpy(data, from, size * sizeof(T));
+}
+
+template<typename T>
+class RadixScratchBuffer {
+public:
+    explicit RadixScratchBuffer(size_t size)
+        : m_data(static_cast<T*>(kmalloc(size * sizeof(T))))
+    {
+        VERIFY(m_data || !size);
+    }
+
+    ~RadixScratchBuffer() { kfree(m_data); }
+
+    T* data() { return m_data; }
+
+private:
+    T* m_data { nullptr };
+};
+
+template<typename Key>
+struct RadixIndexedKey {
+    Key key;
+    u32 index;
+};
+
+// Moves values[order[i]] to position i for every i, following permutation cycles.
+// `order` is clobbered.
+template<typename T>
+void apply_radix_permutation(AK::Span<T> values, u32* order)
+{
+    for (size_t start = 0; start < values.size(); ++start) {
+        if (order[start] == start)
+            continue;
+        T saved = move(values[start]);
+        size_t current = start;
+        while (order[current] != start) {
+            size_t next = order[current];
+            values[current] = move(values[next]);
+            order[current] = current;
+            current = next;
+        }
+        values[current] = move(saved);
+        order[current] = current;
+    }
+}
+
+inline int compare_string_keys_from(const StringView& a, const StringView& b, size_t depth)
+{
+    size_t a_length = a.length() - depth;
+    size_t b_length = b.length() - depth;
+    if (int result = __builtin_memcmp(a.characters_without_null_termination() + depth, b.characters_without_null_termination() + depth, min(a_length, b_length)))
+        return result;
+    if (a_length == b_length)
+        return 0;
+    return a_length < b_length ? -1 : 1;
+}
+
+struct MSDStringEntry {
+    StringView key;
+    u32 index;
+};
+
+// Bucket 0 holds keys that end at `depth`, buckets 1..256 hold byte values 0..255.
+inline size_t msd_bucket_of(const StringView& key, size_t depth)
+{
+    if (key.length() <= depth)
+        return 0;
+    return static_cast<u8>(key.characters_without_null_termination()[depth]) + 1;
+}
+
+inline void msd_radix_sort(MSDStringEntry* entries, size_t size)
+{
+    struct Range {
+        size_t begin;
+        size_t end;
+        size_t depth;
+    };
+
+    if (size < 2)
+        return;
+
+    Vector<MSDStringEntry> scratch;
+    scratch.resize(size);
+
+    Vector<Range, 64> stack;
+    stack.append({ 0, size, 0 });
+
+    while (!stack.is_empty()) {
+        auto range = stack.take_last();
+        auto* begin = entries + range.begin;
+        size_t count = range.end - range.begin;
+
+        if (count <= msd_insertion_sort_threshold) {
+            for (size_t i = 1; i < count; ++i) {
+                auto entry = begin[i];
+                size_t j = i;
+                for (; j > 0 && compare_string_keys_from(entry.key, begin[j - 1].key, range.depth) < 0; --j)
+                    begin[j] = begin[j - 1];
+                begin[j] = entry;
+            }
+            continue;
+        }
+
+        Array<size_t, 257> counts {};
+        for (size_t i = 0; i < count; ++i)
+            ++counts[msd_bucket_of(begin[i].key, range.depth)];
+
+        // A shared byte at this depth means there is nothing to scatter; just look further in.
+        size_t shared_bucket = msd_bucket_of(begin[0].key, range.depth);
+        if (counts[shared_bucket] == count) {
+            if (shared_bucket != 0)
+                stack.append({ range.begin, range.end, range.depth + 1 });
+            continue;
+        }
+
+        Array<size_t, 257> offsets;
+        size_t total = 0;
+        for (size_t bucket = 0; bucket < 257; ++bucket) {
+            offsets[bucket] = total;
+            total += counts[bucket];
+        }
+
+        for (size_t i = 0; i < count; ++i)
+            scratch[offsets[msd_bucket_of(begin[i].key, range.depth)]++] = begin[i];
+        __builtin_memcpy(begin, scratch.data(), count * sizeof(MSDStringEntry));
+
+        // Bucket 0 is already final: all of its keys are equal.
+        size_t bucket_begin = range.begin + counts[0];
+        for (size_t bucket = 1; bucket < 257; ++bucket) {
+            if (counts[bucket] > 1)
+                stack.append({ bucket_begin, bucket_begin + counts[bucket], range.depth + 1 });
+            bucket_begin += counts[bucket];
+        }
+    }
+}
+
+template<typename T, typename KeyExtractor>
+void radix_sort_by_string_key(AK::Span<T> values, KeyExtractor key_of)
+{
+    VERIFY(values.size() <= NumericLimits<u32>::max());
+
+    // Keys returned by value have to outlive the views we sort by.
+    constexpr bool key_is_temporary_string = IsSame<decltype(key_of(values[0])), String>::value;
+    Vector<String> owned_keys;
+    if constexpr (key_is_temporary_string)
+        owned_keys.ensure_capacity(values.size());
+
+    Vector<MSDStringEntry> entries;
+    entries.ensure_capacity(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        if constexpr (key_is_temporary_string) {
+            owned_keys.unchecked_append(key_of(values[i]));
+            entries.unchecked_append({ owned_keys.last().view(), static_cast<u32>(i) });
+        } else {
+            entries.unchecked_append({ StringView(key_of(values[i])), static_cast<u32>(i) });
+        }
+    }
+
+    msd_radix_sort(entries.data(), entries.size());
+
+    if constexpr (IsSame<T, StringView>::value) {
+        for (size_t i = 0; i < values.size(); ++i)
+            values[i] = entries[i].key;
+    } else {
+        Vector<u32> order;
+        order.ensure_capacity(values.size());
+        for (auto& entry : entries)
+            order.unchecked_append(entry.index);
+        apply_radix_permutation(values, order.data());
+    }
+}
+
+template<typename T, typename KeyExtractor>
+void radix_sort_by_fixed_width_key(AK::Span<T> values, KeyExtractor key_of, RadixSortHistogram histogram_mode)
+{
+    using UserKey = typename RemoveCV<typename RemoveReference<decltype(key_of(values[0]))>::Type>::Type;
+    using Encoder = RadixKey<UserKey>;
+    using Key = typename Encoder::Type;
+
+    if (values.size() < 2)
+        return;
+
+    if constexpr (can_scatter_directly<T>) {
+        RadixScratchBuffer<T> scratch(values.size());
+        lsd_radix_sort(
+            values.data(), scratch.data(), values.size(), [&](const T& value) { return Encoder::encode(key_of(value)); }, histogram_mode);
+    } else {
+        VERIFY(values.size() <= NumericLimits<u32>::max());
+        using Entry = RadixIndexedKey<Key>;
+
+        RadixScratchBuffer<Entry> entries(values.size() * 2);
+        Entry* keys = entries.data();
+        for (size_t i = 0; i < values.size(); ++i)
+            keys[i] = { Encoder::encode(key_of(values[i])), static_cast<u32>(i) };
+
+        lsd_radix_sort(
+            keys, keys + values.size(), values.size(), [](const Entry& entry) { return entry.key; }, histogram_mode);
+
+        // The second half of the scratch space is free again, reuse it for the permutation.
+        u32* order = reinterpret_cast<u32*>(keys + values.size());
+        for (size_t i = 0; i < values.size(); ++i)
+            order[i] = keys[i].index;
+        apply_radix_permutation(values, order);
+    }
+}
+
+}
+
+template<typename T>
+void radix_sort(Span<T> values, RadixSortHistogram histogram_mode = RadixSortHistogram::Serial) requires(IsArithmetic<T>::value)
+{
+    Detail::radix_sort_by_fixed_width_key(
+        values, [](T value) { return value; }, histogram_mode);
+}
+
+inline void radix_sort(Span<StringView> values)
+{
+    Detail::radix_sort_by_string_key(values, [](const StringView& value) -> const StringView& { return value; });
+}
+
+inline void radix_sort(Span<String> values)
+{
+    Detail::radix_sort_by_string_key(values, [](const String& value) -> const String& { return value; });
+}
+
+// `key_of` projects each element to the key it is sorted by: an integer, a
+// float, a String or a StringView.
+template<typename T, typename KeyExtractor>
+void radix_sort(Span<T> values, KeyExtractor key_of, RadixSortHistogram histogram_mode = RadixSortHistogram::Serial) requires(!IsSame<KeyExtractor, RadixSortHistogram>::value)
+{
+    if constexpr (Detail::is_string_key<decltype(key_of(values[0]))>) {
+        (void)histogram_mode;
+        Detail::radix_sort_by_string_key(values, move(key_of));
+    } else {
+        Detail::radix_sort_by_fixed_width_key(values, move(key_of), histogram_mode);
+    }
+}
+
+// Like the above, but for trivial element types, using caller-provided
+// scratch space of at least values.size() elements instead of allocating.
+template<typename T, typename KeyExtractor>
+void radix_sort(Span<T> values, Span<T> scratch, KeyExtractor key_of, RadixSortHistogram histogram_mode = RadixSortHistogram::Serial)
+{
+    static_assert(Detail::can_scatter_directly<T>, "radix_sort with a scratch buffer needs a trivial element type");
+    using UserKey = typename RemoveCV<typename RemoveReference<decltype(key_of(values[0]))>::Type>::Type;
+    using Encoder = Detail::RadixKey<UserKey>;
+
+    VERIFY(scratch.size() >= values.size());
+    Detail::lsd_radix_sort(
+        values.data(), scratch.data(), values.size(), [&](const T& value) { return Encoder::encode(key_of(value)); }, histogram_mode);
+}
+
+}
+
+using AK::radix_sort;
+using AK::RadixSortHistogram;
@@ -0,0 +1,411 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Assertions.h>
+#include <AK/NumericLimits.h>
+#include <AK/Optional.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+namespace AK {
+
+/* RadixTrie is a compressed (Patricia) trie over byte strings, for prefix
+ * lookups such as command completion or URL matching.
+ *
+ * Unlike Trie, which has one heap-allocated node (and HashMap) per element,
+ * runs of single-child nodes are collapsed into one edge whose label is a
+ * slice of a shared byte arena. All nodes live in one contiguous arena and
+ * refer to each other by index. Nodes with few children keep them inline as
+ * a sorted array of first bytes; only wider nodes spill into a sorted
+ * overflow list. Children are always visited in byte order, so prefix
+ * enumeration yields keys in lexicographic order.
+ *
+ * Removing a key destroys its value, but its node stays in the arena until
+ * clear(), and setting the key again reuses the node's value slot.
+ */
+
+template<typename ValueType>
+class RadixTrie {
+public:
+    RadixTrie() { clear(); }
+
+    size_t size() const { return m_size; }
+    bool is_empty() const { return m_size == 0; }
+
+    void clear()
+    {
+        m_nodes.clear();
+        m_labels.clear();
+        m_values.clear();
+        m_overflow_children.clear();
+        m_nodes.append(Node {});
+        m_size = 0;
+    }
+
+    // Returns true if the key was newly inserted, false if an existing value was replaced.
+    bool set(const StringView& key, ValueType value)
+    {
+        u32 node_index = 0;
+        size_t position = 0;
+        for (;;) {
+            if (position == key.length())
+                return set_value(node_index, move(value));
+
+            u8 first_byte = key[position];
+            auto child_index = find_child(node_index, first_byte);
+            if (!child_index.has_value()) {
+                auto leaf_index = create_node(append_label(key.substring_view(position)), key.length() - position);
+                add_child(node_index, first_byte, leaf_index);
+                return set_value(leaf_index, move(value));
+            }
+
+            auto label = label_of(child_index.value());
+            size_t common = common_prefix_length(label, key.substring_view(position));
+            if (common == label.length()) {
+                node_index = child_index.value();
+                position += common;
+                continue;
+            }
+
+            // Split the edge: the first `common` bytes move to a new node in between.
+            auto middle_index = create_node(m_nodes[child_index.value()].label_offset, common);
+            m_nodes[child_index.value()].label_offset += common;
+            m_nodes[child_index.value()].label_length -= common;
+            replace_child(node_index, first_byte, middle_index);
+            add_child(middle_index, label[common], child_index.value());
+
+            node_index = middle_index;
+            position += common;
+        }
+    }
+
+    Optional<ValueType> get(const StringView& key) const
+    {
+        auto node_index = find_node(key);
+        if (!node_index.has_value() || !has_value(node_index.value()))
+            return {};
+        return m_values[m_nodes[node_index.value()].value_index];
+    }
+
+    bool contains(const StringView& key) const { return get(key).has_value(); }
+
+    bool remove(const StringView& key)
+    {
+        auto node_index = find_node(key);
+        if (!node_index.has_value() || !has_value(node_index.value()))
+            return false;
+        m_values[m_nodes[node_index.value()].value_index].clear();
+        --m_size;
+        return true;
+    }
+
+    // Calls `callback(key, value)` for every entry whose key starts with
+    // `prefix`, in lexicographic order. The key is only valid during the call.
+    template<typename Callback>
+    void for_each_with_prefix(const StringView& prefix, Callback callback) const
+    {
+        u32 node_index = 0;
+        size_t position = 0;
+        Vector<char, 128> key_buffer;
+        key_buffer.append(prefix.characters_without_null_termination(), prefix.length());
+
+        while (position < prefix.length()) {
+            auto child_index = find_child(node_index, prefix[position]);
+            if (!child_index.has_value())
+                return;
+            auto label = label_of(child_index.value());
+            size_t remaining = prefix.length() - position;
+            size_t common = common_prefix_length(label, prefix.substring_view(position));
+            if (common < min(label.length(), remaining))
+                return;
+            // The prefix may end in the middle of this edge; complete the key with the rest of it.
+            if (label.length() > remaining)
+                key_buffer.append(label.characters_without_null_termination() + remaining, label.length() - remaining);
+            node_index = child_index.value();
+            position += min(label.length(), remaining);
+        }
+
+        visit_subtree(node_index, key_buffer, callback);
+    }
+
+    Vector<ValueType> values_with_prefix(const StringView& prefix) const
+    {
+        Vector<ValueType> values;
+        for_each_with_prefix(prefix, [&](auto&, auto& value) {
+            values.append(value);
+            return IterationDecision::Continue;
+        });
+        return values;
+    }
+
+    // The value of the longest key that is a prefix of `string`, if any.
+    Optional<ValueType> longest_prefix_of(const StringView& string) const
+    {
+        Optional<ValueType> result;
+        u32 node_index = 0;
+        size_t position = 0;
+        for (;;) {
+            if (has_value(node_index))
+                result = m_values[m_nodes[node_index].value_index];
+            if (position == string.length())
+                return result;
+            auto child_index = find_child(node_index, string[position]);
+            if (!child_index.has_value())
+                return result;
+            auto label = label_of(child_index.value());
+            if (!string.substring_view(position).starts_with(label))
+                return result;
+            node_index = child_index.value();
+            position += label.length();
+        }
+    }
+
+    size_t node_count() const { return m_nodes.size(); }
+
+    size_t memory_usage() const
+    {
+        size_t bytes = m_nodes.capacity() * sizeof(Node) + m_labels.capacity() + m_values.capacity() * sizeof(m_values[0]);
+        bytes += m_overflow_children.capacity() * sizeof(m_overflow_children[0]);
+        for (auto& children : m_overflow_children)
+            bytes += children.capacity() * sizeof(Child);
+        return bytes;
+    }
+
+private:
+    static constexpr u32 no_index = 0xffffffff;
+    static constexpr size_t inline_child_count = 4;
+
+    struct Child {
+        u8 first_byte;
+        u32 node_index;
+    };
+
+    struct Node {
+        u32 label_offset { 0 };
+        u32 label_length { 0 };
+        // The node's slot in m_values, once it has had a value. The slot is empty while the key is removed.
+        u32 value_index { no_index };
+        // Index into m_overflow_children once there are more than inline_child_count children.
+        u32 overflow_index { no_index };
+        u8 child_count { 0 };
+        u8 first_bytes[inline_child_count] {};
+        u32 children[inline_child_count] {};
+    };
+
+    static size_t common_prefix_length(const StringView& a, const StringView& b)
+    {
+        size_t length = min(a.length(), b.length());
+        size_t i = 0;
+        while (i < length && a[i] == b[i])
+            ++i;
+        return i;
+    }
+
+    StringView label_of(u32 node_index) const
+    {
+        auto& node = m_nodes[node_index];
+        return { m_labels.data() + node.label_offset, node.label_length };
+    }
+
+    u32 append_label(const StringView& label)
+    {
+        VERIFY(m_labels.size() + label.length() <= NumericLimits<u32>::max());
+        u32 offset = m_labels.size();
+        m_labels.append(label.characters_without_null_termination(), label.length());
+        return offset;
+    }
+
+    u32 create_node(u32 label_offset, size_t label_length)
+    {
+        VERIFY(m_nodes.size() < no_index);
+        Node node;
+        node.label_offset = label_offset;
+        node.label_length = label_length;
+        m_nodes.append(node);
+        return m_nodes.size() - 1;
+    }
+
+    bool has_value(u32 node_index) const
+    {
+        auto value_index = m_nodes[node_index].value_index;
+        return value_index != no_index && m_values[value_index].has_value();
+    }
+
+    bool set_value(u32 node_index, ValueType value)
+    {
+        auto& node = m_nodes[node_index];
+        if (node.value_index != no_index) {
+            bool is_new = !m_values[node.value_index].has_value();
+            m_values[node.value_index] = move(value);
+            if (is_new)
+                ++m_size;
+            return is_new;
+        }
+        node.value_index = m_values.size();
+        m_values.append(move(value));
+        ++m_size;
+        return true;
+    }
+
+    Optional<u32> find_child(u32 node_index, u8 first_byte) const
+    {
+        auto& node = m_nodes[node_index];
+        if (node.overflow_index == no_index) {
+            for (size_t i = 0; i < node.child_count; ++i) {
+                if (node.first_bytes[i] == first_byte)
+                    return node.children[i];
+            }
+            return {};
+        }
+
+        auto& children = m_overflow_children[node.overflow_index];
+        size_t low = 0;
+        size_t high = children.size();
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (children[middle].first_byte < first_byte)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        if (low < children.size() && children[low].first_byte == first_byte)
+            return children[low].node_index;
+        return {};
+    }
+
+    void add_child(u32 node_index, u8 first_byte, u32 child_index)
+    {
+        auto& node = m_nodes[node_index];
+        if (node.overflow_index == no_index && node.child_count < inline_child_count) {
+            size_t i = node.child_count;
+            for (; i > 0 && node.first_bytes[i - 1] > first_byte; --i) {
+                node.first_bytes[i] = node.first_bytes[i - 1];
+                node.children[i] = node.children[i - 1];
+            }
+            node.first_bytes[i] = first_byte;
+            node.children[i] = child_index;
+            ++node.child_count;
+            return;
+        }
+
+        if (node.overflow_index == no_index) {
+            node.overflow_index = m_overflow_children.size();
+            Vector<Child> children;
+            for (size_t i = 0; i < node.child_count; ++i)
+                children.append({ node.first_bytes[i], node.children[i] });
+            m_overflow_children.append(move(children));
+        }
+
+        auto& children = m_overflow_children[node.overflow_index];
+        size_t i = 0;
+        while (i < children.size() && children[i].first_byte < first_byte)
+            ++i;
+        children.insert(i, { first_byte, child_index });
+        node.child_count = min<size_t>(children.size(), 0xff);
+    }
+
+    void replace_child(u32 node_index, u8 first_byte, u32 new_child_index)
+    {
+        auto& node = m_nodes[node_index];
+        if (node.overflow_index == no_index) {
+            for (size_t i = 0; i < node.child_count; ++i) {
+                if (node.first_bytes[i] == first_byte) {
+                    node.children[i] = new_child_index;
+                    return;
+                }
+            }
+            VERIFY_NOT_REACHED();
+        }
+        for (auto& child : m_overflow_children[node.overflow_index]) {
+            if (child.first_byte == first_byte) {
+                child.node_index = new_child_index;
+                return;
+            }
+        }
+        VERIFY_NOT_REACHED();
+    }
+
+    Optional<u32> find_node(const StringView& key) const
+    {
+        u32 node_index = 0;
+        size_t position = 0;
+        while (position < key.length()) {
+            auto child_index = find_child(node_index, key[position]);
+            if (!child_index.has_value())
+                return {};
+            auto label = label_of(child_index.value());
+            if (!key.substring_view(position).starts_with(label))
+                return {};
+            node_index = child_index.value();
+            position += label.length();
+        }
+        return node_index;
+    }
+
+    template<typename Callback>
+    IterationDecision visit_subtree(u32 node_index, Vector<char, 128>& key_buffer, Callback& callback) const
+    {
+        auto& node = m_nodes[node_index];
+        if (has_value(node_index)) {
+            StringView key { key_buffer.data(), key_buffer.size() };
+            if (callback(key, m_values[node.value_index].value()) == IterationDecision::Break)
+                return IterationDecision::Break;
+        }
+
+        auto visit_child = [&](u32 child_index) {
+            auto label = label_of(child_index);
+            size_t saved_length = key_buffer.size();
+            key_buffer.append(label.characters_without_null_termination(), label.length());
+            auto decision = visit_subtree(child_index, key_buffer, callback);
+            key_buffer.shrink(saved_length, true);
+            return decision;
+        };
+
+        if (node.overflow_index == no_index) {
+            for (size_t i = 0; i < node.child_count; ++i) {
+                if (visit_child(node.children[i]) == IterationDecision::Break)
+                    return IterationDecision::Break;
+            }
+        } else {
+            for (auto& child : m_overflow_children[node.overflow_index]) {
+                if (visit_child(child.node_index) == IterationDecision::Break)
+                    return IterationDecision::Break;
+            }
+        }
+        return IterationDecision::Continue;
+    }
+
+    Vector<Node> m_nodes;
+    Vector<char> m_labels;
+    Vector<Optional<ValueType>> m_values;
+    Vector<Vector<Child>> m_overflow_children;
+    size_t m_size { 0 };
+};
+
+}
+
+using AK::RadixTrie;
@@ -0,0 +1,102 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <AK/SIMD.h>
+#include <AK/Types.h>
+
+// Helpers for scanning and transforming byte strings 16 bytes at a time.
+// These only use GCC vector extensions, so they compile to SSE2 on x86.
+
+namespace AK::SIMD {
+
+ALWAYS_INLINE u8x16 load_unaligned(const void* address)
+{
+    u8x16 vector;
+    __builtin_memcpy(&vector, address, sizeof(vector));
+    return vector;
+}
+
+ALWAYS_INLINE void store_unaligned(void* address, u8x16 vector)
+{
+    __builtin_memcpy(address, &vector, sizeof(vector));
+}
+
+// Turns a lane-wise comparison result (0 or -1 per lane) back into a u8x16.
+ALWAYS_INLINE u8x16 to_mask(i8x16 comparison)
+{
+    return (u8x16)comparison;
+}
+
+ALWAYS_INLINE bool any_lane_set(u8x16 mask)
+{
+    u64 halves[2];
+    __builtin_memcpy(halves, &mask, sizeof(halves));
+    return (halves[0] | halves[1]) != 0;
+}
+
+// Returns the index of the first non-zero lane of a mask, or 16 if there is none.
+ALWAYS_INLINE size_t first_set_lane(u8x16 mask)
+{
+    u64 halves[2];
+    __builtin_memcpy(halves, &mask, sizeof(halves));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (halves[0])
+        return __builtin_ctzll(halves[0]) / 8;
+    if (halves[1])
+        return 8 + __builtin_ctzll(halves[1]) / 8;
+#else
+    if (halves[0])
+        return __builtin_clzll(halves[0]) / 8;
+    if (halves[1])
+        return 8 + __builtin_clzll(halves[1]) / 8;
+#endif
+    return sizeof(u8x16);
+}
+
+// Lanes are 0xff where the byte is an ASCII upper/lowercase letter.
+ALWAYS_INLINE u8x16 ascii_uppercase_mask(u8x16 bytes)
+{
+    return to_mask(bytes >= 'A') & to_mask(bytes <= 'Z');
+}
+
+ALWAYS_INLINE u8x16 ascii_lowercase_mask(u8x16 bytes)
+{
+    return to_mask(bytes >= 'a') & to_mask(bytes <= 'z');
+}
+
+// Like the scalar versions in StringUtils, bytes outside of ASCII are left alone.
+ALWAYS_INLINE u8x16 to_ascii_lowercase(u8x16 bytes)
+{
+    return bytes | (ascii_uppercase_mask(bytes) & 0x20);
+}
+
+ALWAYS_INLINE u8x16 to_ascii_uppercase(u8x16 bytes)
+{
+    return bytes & ~(ascii_lowercase_mask(bytes) & 0x20);
+}
+
+}
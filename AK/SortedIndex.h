@@ -0,0 +1,245 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Assertions.h>
+#include <AK/Noncopyable.h>
+#include <AK/NumericLimits.h>
+#include <AK/Optional.h>
+#include <AK/Span.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+namespace AK {
+
+/* SortedIndex is a read-only search structure over a sorted array of numbers.
+ * binary_search() touches a new cache line on almost every probe once the
+ * array outgrows the cache; SortedIndex re-lays the values so that the probes
+ * of a search are close together in memory:
+ *
+ * - Eytzinger: the implicit binary heap order (children of k at 2k and 2k+1).
+ *   The search loop is branchless, and the 16 great-grandchildren of the
+ *   current node share a cache line, so it is prefetched four levels ahead.
+ * - BTree: an implicit B-tree ("S-tree") with one cache line of keys per node
+ *   and B + 1 children per node. Each node is searched with a single vector
+ *   comparison, so a lookup costs about log_(B+1)(n) cache misses.
+ *
+ * All searches return the rank of the result in the original sorted order,
+ * which can be used to index any arrays that run parallel to it.
+ */
+
+enum class SortedIndexLayout {
+    Eytzinger,
+    BTree,
+};
+
+template<typename T, SortedIndexLayout layout = SortedIndexLayout::Eytzinger>
+class SortedIndex {
+    static_assert(IsArithmetic<T>::value, "SortedIndex only supports arithmetic keys");
+
+    // The keys are aligned within m_storage, which a copy would not preserve.
+    AK_MAKE_NONCOPYABLE(SortedIndex);
+
+public:
+    static constexpr size_t cache_line_size = 64;
+    static constexpr size_t keys_per_node = cache_line_size / sizeof(T);
+
+    SortedIndex() = default;
+    SortedIndex(SortedIndex&&) = default;
+    SortedIndex& operator=(SortedIndex&&) = default;
+
+    explicit SortedIndex(Span<const T> sorted_values)
+    {
+        VERIFY(sorted_values.size() < NumericLimits<u32>::max());
+        m_size = sorted_values.size();
+        if constexpr (layout == SortedIndexLayout::Eytzinger)
+            build_eytzinger(sorted_values);
+        else
+            build_btree(sorted_values);
+    }
+
+    size_t size() const { return m_size; }
+    bool is_empty() const { return m_size == 0; }
+
+    // Rank of the first value not less than `value`, or size() if there is none.
+    size_t lower_bound(T value) const { return rank_of_slot(search<false>(value)); }
+
+    // Rank of the first value greater than `value`, or size() if there is none.
+    size_t upper_bound(T value) const { return rank_of_slot(search<true>(value)); }
+
+    Optional<size_t> find(T value) const
+    {
+        size_t slot = search<false>(value);
+        if (slot == no_slot || keys()[slot] != value || m_ranks[slot] == m_size)
+            return {};
+        return m_ranks[slot];
+    }
+
+private:
+    static constexpr size_t no_slot = NumericLimits<size_t>::max();
+
+    size_t rank_of_slot(size_t slot) const { return slot == no_slot ? m_size : m_ranks[slot]; }
+
+    const T* keys() const { return m_storage.data() + m_alignment_offset; }
+    T* keys() { return m_storage.data() + m_alignment_offset; }
+
+    // Allocates `count` keys starting on a cache line boundary.
+    void allocate_keys(size_t count)
+    {
+        constexpr size_t slack = cache_line_size / sizeof(T);
+        m_storage.resize(count + slack);
+        auto address = reinterpret_cast<FlatPtr>(m_storage.data());
+        m_alignment_offset = ((cache_line_size - (address % cache_line_size)) % cache_line_size) / sizeof(T);
+    }
+
+    void build_eytzinger(Span<const T> sorted_values)
+    {
+        // Slot 0 is unused so that the children of k are at 2k and 2k + 1.
+        allocate_keys(m_size + 1);
+        m_ranks.resize(m_size + 1);
+        size_t next_rank = 0;
+        fill_eytzinger(sorted_values, next_rank, 1);
+    }
+
+    void fill_eytzinger(Span<const T> sorted_values, size_t& next_rank, size_t k)
+    {
+        if (k > m_size)
+            return;
+        fill_eytzinger(sorted_values, next_rank, 2 * k);
+        keys()[k] = sorted_values[next_rank];
+        m_ranks[k] = next_rank++;
+        fill_eytzinger(sorted_values, next_rank, 2 * k + 1);
+    }
+
+    static size_t btree_child(size_t node, size_t index) { return node * (keys_per_node + 1) + index + 1; }
+
+    void build_btree(Span<const T> sorted_values)
+    {
+        m_node_count = (m_size + keys_per_node - 1) / keys_per_node;
+        allocate_keys(m_node_count * keys_per_node);
+        m_ranks.resize(m_node_count * keys_per_node);
+        size_t next_rank = 0;
+        fill_btree(sorted_values, next_rank, 0);
+    }
+
+    void fill_btree(Span<const T> sorted_values, size_t& next_rank, size_t node)
+    {
+        if (node >= m_node_count)
+            return;
+        for (size_t i = 0; i <= keys_per_node; ++i) {
+            fill_btree(sorted_values, next_rank, btree_child(node, i));
+            if (i == keys_per_node)
+                break;
+            // Padding only ever follows all real keys in order, so the maximum
+            // value with a past-the-end rank is never picked over a real key.
+            size_t slot = node * keys_per_node + i;
+            if (next_rank < m_size) {
+                keys()[slot] = sorted_values[next_rank];
+                m_ranks[slot] = next_rank++;
+            } else {
+                keys()[slot] = NumericLimits<T>::max();
+                m_ranks[slot] = m_size;
+            }
+        }
+    }
+
+    template<bool or_equal>
+    ALWAYS_INLINE static bool goes_right(T key, T value)
+    {
+        if constexpr (or_equal)
+            return !(value < key);
+        else
+            return key < value;
+    }
+
+    template<bool or_equal>
+    size_t search(T value) const
+    {
+        if constexpr (layout == SortedIndexLayout::Eytzinger)
+            return search_eytzinger<or_equal>(value);
+        else
+            return search_btree<or_equal>(value);
+    }
+
+    template<bool or_equal>
+    size_t search_eytzinger(T value) const
+    {
+        constexpr size_t prefetch_distance = cache_line_size / sizeof(T);
+        const T* data = keys();
+        size_t k = 1;
+        while (k <= m_size) {
+            __builtin_prefetch(data + k * prefetch_distance);
+            k = 2 * k + goes_right<or_equal>(data[k], value);
+        }
+        // Undo the right turns taken after the last left turn; that node is the answer.
+        k >>= __builtin_ctzl(~static_cast<unsigned long>(k)) + 1;
+        return k == 0 ? no_slot : k;
+    }
+
+    // Number of keys in the node that the search has to pass to the right of.
+    template<bool or_equal>
+    ALWAYS_INLINE static size_t count_passed_keys(const T* node, T value)
+    {
+        typedef T NodeVector __attribute__((vector_size(cache_line_size)));
+        NodeVector node_keys;
+        __builtin_memcpy(&node_keys, node, sizeof(node_keys));
+        NodeVector needle = NodeVector {} + value;
+        auto mask = or_equal ? (node_keys <= needle) : (node_keys < needle);
+
+        // Every lane of the mask is either 0 or -1.
+        size_t count = 0;
+        for (size_t i = 0; i < keys_per_node; ++i)
+            count -= mask[i];
+        return count;
+    }
+
+    template<bool or_equal>
+    size_t search_btree(T value) const
+    {
+        const T* data = keys();
+        size_t result = no_slot;
+        size_t node = 0;
+        while (node < m_node_count) {
+            size_t index = count_passed_keys<or_equal>(data + node * keys_per_node, value);
+            if (index < keys_per_node)
+                result = node * keys_per_node + index;
+            node = btree_child(node, index);
+            __builtin_prefetch(data + btree_child(node, 0) * keys_per_node);
+        }
+        return result;
+    }
+
+    Vector<T> m_storage;
+    Vector<u32> m_ranks;
+    size_t m_alignment_offset { 0 };
+    size_t m_node_count { 0 };
+    size_t m_size { 0 };
+};
+
+}
+
+using AK::SortedIndex;
+using AK::SortedIndexLayout;
@@ -90,12 +90,52 @@ public:
 
     virtual bool read_or_error(Bytes) = 0;
     virtual bool discard_or_error(size_t count) = 0;
+
+    // Scatters the data over the given buffers in order, and stops at the first one that can't be filled
+    // completely. Streams that can do this in one go (e.g. with readv()) should override this.
+    virtual size_t read_vectored(Span<Bytes> buffers)
+    {
+        size_t nread = 0;
+        for (auto buffer : buffers) {
+            auto nread_into_buffer = read(buffer);
+            nread += nread_into_buffer;
+            if (nread_into_buffer < buffer.size())
+                break;
+        }
+        return nread;
+    }
 };
 
 class OutputStream : public virtual AK::Detail::Stream {
 public:
     virtual size_t write(ReadonlyBytes) = 0;
     virtual bool write_or_error(ReadonlyBytes) = 0;
+
+    // Gathers the data from the given buffers in order, and stops at the first one that can't be written
+    // completely. Streams that can do this in one go (e.g. with writev()) should override this.
+    virtual size_t write_vectored(Span<const ReadonlyBytes> buffers)
+    {
+        size_t nwritten = 0;
+        for (auto buffer : buffers) {
+            auto nwritten_from_buffer = write(buffer);
+            nwritten += nwritten_from_buffer;
+            if (nwritten_from_buffer < buffer.size())
+                break;
+        }
+        return nwritten;
+    }
+
+    bool write_vectored_or_error(Span<const ReadonlyBytes> buffers)
+    {
+        size_t total_size = 0;
+        for (auto buffer : buffers)
+            total_size += buffer.size();
+        if (write_vectored(buffers) < total_size) {
+            set_fatal_error();
+            return false;
+        }
+        return true;
+    }
 };
 
 class DuplexStream
@@ -158,6 +198,23 @@ OutputStream& operator<<(OutputStream& stream, Integral value) requires IsIntegr
     return stream;
 }
 
+// Copies everything that is left in input over to output, and returns how many bytes that were.
+// Stops early if either stream runs into an error.
+inline size_t copy_stream(InputStream& input, OutputStream& output)
+{
+    u8 buffer[4096];
+    size_t ncopied = 0;
+    while (!input.has_any_error() && !output.has_any_error()) {
+        auto nread = input.read({ buffer, sizeof(buffer) });
+        if (nread == 0)
+            break;
+        if (!output.write_or_error({ buffer, nread }))
+            break;
+        ncopied += nread;
+    }
+    return ncopied;
+}
+
 #ifndef KERNEL
 
 template<typename FloatingPoint>
@@ -176,3 +233,5 @@ OutputStream& operator<<(OutputStream& stream, FloatingPoint value) requires IsF
 #endif
 
 }
+
+using AK::copy_stream;
@@ -303,8 +303,13 @@ struct Traits<String> : public GenericTraits<String> {
 };
 
 struct CaseInsensitiveStringTraits : public Traits<String> {
-    static unsigned hash(const String& s) { return s.impl() ? s.to_lowercase().impl()->hash() : 0; }
-    static bool equals(const String& a, const String& b) { return a.to_lowercase() == b.to_lowercase(); }
+    static unsigned hash(const String& s) { return s.impl() ? StringUtils::case_insensitive_hash(s) : 0; }
+    static bool equals(const String& a, const String& b)
+    {
+        if (a.is_null() || b.is_null())
+            return a.is_null() && b.is_null();
+        return a.equals_ignoring_case(b);
+    }
 };
 
 bool operator<(const char*, const String&);
@@ -26,6 +26,7 @@
 #include <AK/FlyString.h>
 #include <AK/HashTable.h>
 #include <AK/Memory.h>
+#include <AK/SIMDExtras.h>
 #include <AK/StdLibExtras.h>
 #include <AK/StringImpl.h>
 #include <AK/kmalloc.h>
@@ -157,36 +158,51 @@ static inline char to_ascii_uppercase(char c)
     return c;
 }
 
-NonnullRefPtr<StringImpl> StringImpl::to_lowercase() const
+template<bool uppercase>
+static NonnullRefPtr<StringImpl> to_ascii_case(const StringImpl& string)
 {
-    for (size_t i = 0; i < m_length; ++i) {
-        if (!is_ascii_lowercase(characters()[i]))
-            goto slow_path;
-    }
-    return const_cast<StringImpl&>(*this);
+    using SIMD::u8x16;
+    auto* characters = string.characters();
+    size_t length = string.length();
+
+    auto convert = [](char c) { return uppercase ? to_ascii_uppercase(c) : to_ascii_lowercase(c); };
+    auto convert_block = [](u8x16 block) { return uppercase ? SIMD::to_ascii_uppercase(block) : SIMD::to_ascii_lowercase(block); };
+    auto find_first_change = [&]() -> size_t {
+        size_t offset = 0;
+        for (; offset + sizeof(u8x16) <= length; offset += sizeof(u8x16)) {
+            auto block = SIMD::load_unaligned(characters + offset);
+            auto changed = uppercase ? SIMD::ascii_lowercase_mask(block) : SIMD::ascii_uppercase_mask(block);
+            if (SIMD::any_lane_set(changed))
+                return offset + SIMD::first_set_lane(changed);
+        }
+        while (offset < length && convert(characters[offset]) == characters[offset])
+            ++offset;
+        return offset;
+    };
+
+    // Strings that are already in the requested case are shared instead of copied.
+    size_t offset = find_first_change();
+    if (offset == length)
+        return const_cast<StringImpl&>(string);
 
-slow_path:
     char* buffer;
-    auto lowercased = create_uninitialized(m_length, buffer);
-    for (size_t i = 0; i < m_length; ++i)
-        buffer[i] = to_ascii_lowercase(characters()[i]);
-    return lowercased;
+    auto converted = StringImpl::create_uninitialized(length, buffer);
+    __builtin_memcpy(buffer, characters, offset);
+    for (; offset + sizeof(u8x16) <= length; offset += sizeof(u8x16))
+        SIMD::store_unaligned(buffer + offset, convert_block(SIMD::load_unaligned(characters + offset)));
+    for (; offset < length; ++offset)
+        buffer[offset] = convert(characters[offset]);
+    return converted;
 }
 
-NonnullRefPtr<StringImpl> StringImpl::to_uppercase() const
+NonnullRefPtr<StringImpl> StringImpl::to_lowercase() const
 {
-    for (size_t i = 0; i < m_length; ++i) {
-        if (!is_ascii_uppercase(characters()[i]))
-            goto slow_path;
-    }
-    return const_cast<StringImpl&>(*this);
+    return to_ascii_case<false>(*this);
+}
 
-slow_path:
-    char* buffer;
-    auto uppercased = create_uninitialized(m_length, buffer);
-    for (size_t i = 0; i < m_length; ++i)
-        buffer[i] = to_ascii_uppercase(characters()[i]);
-    return uppercased;
+NonnullRefPtr<StringImpl> StringImpl::to_uppercase() const
+{
+    return to_ascii_case<true>(*this);
 }
 
 void StringImpl::compute_hash() const
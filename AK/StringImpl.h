@@ -128,6 +128,23 @@ constexpr u32 string_hash(const char* characters, size_t length)
     return hash;
 }
 
+// The same as string_hash() of the string with its ASCII letters lowercased, without creating that string.
+constexpr u32 case_insensitive_string_hash(const char* characters, size_t length)
+{
+    u32 hash = 0;
+    for (size_t i = 0; i < length; ++i) {
+        char c = characters[i];
+        c |= static_cast<char>(static_cast<u8>(c - 'A') < 26) << 5;
+        hash += (u32)c;
+        hash += (hash << 10);
+        hash ^= (hash >> 6);
+    }
+    hash += hash << 3;
+    hash ^= hash >> 11;
+    hash += hash << 15;
+    return hash;
+}
+
 template<>
 struct Formatter<StringImpl> : Formatter<StringView> {
     void format(FormatBuilder& builder, const StringImpl& value)
@@ -139,6 +156,7 @@ struct Formatter<StringImpl> : Formatter<StringView> {
 }
 
 using AK::Chomp;
+using AK::case_insensitive_string_hash;
 using AK::NoChomp;
 using AK::string_hash;
 using AK::StringImpl;
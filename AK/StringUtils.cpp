@@ -22,9 +22,11 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/GenericLexer.h>
 #include <AK/MemMem.h>
 #include <AK/Memory.h>
 #include <AK/Optional.h>
+#include <AK/SIMDExtras.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
 #include <AK/StringUtils.h>
@@ -216,17 +218,39 @@ static inline char to_lowercase(char c)
     return c;
 }
 
+static inline char to_uppercase(char c)
+{
+    if (c >= 'a' && c <= 'z')
+        return c & ~0x20;
+    return c;
+}
+
+// Compares 16 bytes at a time by folding both sides to lowercase. Like the scalar
+// version, only ASCII letters are folded and all other bytes must match exactly.
+static bool bytes_equal_ignoring_case(const char* a, const char* b, size_t length)
+{
+    using SIMD::u8x16;
+    size_t offset = 0;
+    for (; offset + sizeof(u8x16) <= length; offset += sizeof(u8x16)) {
+        auto a_block = SIMD::load_unaligned(a + offset);
+        auto b_block = SIMD::load_unaligned(b + offset);
+        if (SIMD::any_lane_set(SIMD::to_ascii_lowercase(a_block) ^ SIMD::to_ascii_lowercase(b_block)))
+            return false;
+    }
+    for (; offset < length; ++offset) {
+        if (to_lowercase(a[offset]) != to_lowercase(b[offset]))
+            return false;
+    }
+    return true;
+}
+
 bool equals_ignoring_case(const StringView& a, const StringView& b)
 {
     if (a.impl() && a.impl() == b.impl())
         return true;
     if (a.length() != b.length())
         return false;
-    for (size_t i = 0; i < a.length(); ++i) {
-        if (to_lowercase(a.characters_without_null_termination()[i]) != to_lowercase(b.characters_without_null_termination()[i]))
-            return false;
-    }
-    return true;
+    return bytes_equal_ignoring_case(a.characters_without_null_termination(), b.characters_without_null_termination(), a.length());
 }
 
 bool ends_with(const StringView& str, const StringView& end, CaseSensitivity case_sensitivity)
@@ -238,18 +262,10 @@ bool ends_with(const StringView& str, const StringView& end, CaseSensitivity cas
     if (end.length() > str.length())
         return false;
 
+    auto str_chars = str.characters_without_null_termination() + (str.length() - end.length());
     if (case_sensitivity == CaseSensitivity::CaseSensitive)
-        return !memcmp(str.characters_without_null_termination() + (str.length() - end.length()), end.characters_without_null_termination(), end.length());
-
-    auto str_chars = str.characters_without_null_termination();
-    auto end_chars = end.characters_without_null_termination();
-
-    size_t si = str.length() - end.length();
-    for (size_t ei = 0; ei < end.length(); ++si, ++ei) {
-        if (to_lowercase(str_chars[si]) != to_lowercase(end_chars[ei]))
-            return false;
-    }
-    return true;
+        return !memcmp(str_chars, end.characters_without_null_termination(), end.length());
+    return bytes_equal_ignoring_case(str_chars, end.characters_without_null_termination(), end.length());
 }
 
 bool starts_with(const StringView& str, const StringView& start, CaseSensitivity case_sensitivity)
@@ -265,16 +281,7 @@ bool starts_with(const StringView& str, const StringView& start, CaseSensitivity
 
     if (case_sensitivity == CaseSensitivity::CaseSensitive)
         return !memcmp(str.characters_without_null_termination(), start.characters_without_null_termination(), start.length());
-
-    auto str_chars = str.characters_without_null_termination();
-    auto start_chars = start.characters_without_null_termination();
-
-    size_t si = 0;
-    for (size_t starti = 0; starti < start.length(); ++si, ++starti) {
-        if (to_lowercase(str_chars[si]) != to_lowercase(start_chars[starti]))
-            return false;
-    }
-    return true;
+    return bytes_equal_ignoring_case(str.characters_without_null_termination(), start.characters_without_null_termination(), start.length());
 }
 
 bool contains(const StringView& str, const StringView& needle, CaseSensitivity case_sensitivity)
@@ -288,22 +295,25 @@ bool contains(const StringView& str, const StringView& needle, CaseSensitivity c
     if (case_sensitivity == CaseSensitivity::CaseSensitive)
         return memmem(str_chars, str.length(), needle_chars, needle.length()) != nullptr;
 
-    auto needle_first = to_lowercase(needle_chars[0]);
-    for (size_t si = 0; si < str.length(); si++) {
-        if (to_lowercase(str_chars[si]) != needle_first)
-            continue;
-        for (size_t ni = 0; si + ni < str.length(); ni++) {
-            if (to_lowercase(str_chars[si + ni]) != to_lowercase(needle_chars[ni])) {
-                si += ni;
-                break;
-            }
-            if (ni + 1 == needle.length())
-                return true;
-        }
+    // Jump between occurrences of the first needle character in either case, then compare the rest.
+    char first_variants[] = { to_lowercase(needle_chars[0]), to_uppercase(needle_chars[0]) };
+    CharacterSet first(StringView(first_variants, sizeof(first_variants)));
+    size_t last_start = str.length() - needle.length();
+    for (size_t si = 0; si <= last_start; ++si) {
+        si += first.find_first_in(str_chars + si, last_start + 1 - si);
+        if (si > last_start)
+            return false;
+        if (bytes_equal_ignoring_case(str_chars + si + 1, needle_chars + 1, needle.length() - 1))
+            return true;
     }
     return false;
 }
 
+unsigned case_insensitive_hash(const StringView& str)
+{
+    return case_insensitive_string_hash(str.characters_without_null_termination(), str.length());
+}
+
 bool is_whitespace(const StringView& str)
 {
     for (auto ch : str) {
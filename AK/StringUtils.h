@@ -65,6 +65,7 @@ bool equals_ignoring_case(const StringView&, const StringView&);
 bool ends_with(const StringView& a, const StringView& b, CaseSensitivity);
 bool starts_with(const StringView&, const StringView&, CaseSensitivity);
 bool contains(const StringView&, const StringView&, CaseSensitivity);
+unsigned case_insensitive_hash(const StringView&);
 bool is_whitespace(const StringView&);
 StringView trim_whitespace(const StringView&, TrimMode mode);
 Optional<size_t> find(const StringView& haystack, const StringView& needle);
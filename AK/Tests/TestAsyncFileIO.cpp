@@ -0,0 +1,294 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/TestSuite.h>
+
+#include <AK/AsyncFileIO.h>
+#include <AK/ByteBuffer.h>
+#include <AK/FileStream.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static int create_temporary_file(size_t size)
+{
+    char path[] = "/tmp/TestAsyncFileIO.XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT(fd >= 0);
+    unlink(path);
+
+    u8 block[4096];
+    for (size_t offset = 0; offset < size; offset += sizeof(block)) {
+        for (size_t i = 0; i < sizeof(block); ++i)
+            block[i] = static_cast<u8>((offset + i) * 31 >> 3);
+        auto nwritten = write(fd, block, min(sizeof(block), size - offset));
+        EXPECT(nwritten > 0);
+    }
+    return fd;
+}
+
+static u8 expected_byte_at(u64 offset)
+{
+    return static_cast<u8>(offset * 31 >> 3);
+}
+
+static Vector<AsyncFileIO::Backend> backends()
+{
+    Vector<AsyncFileIO::Backend> backends { AsyncFileIO::Backend::ThreadPool };
+    if (!AsyncFileIO::create(AsyncFileIO::Backend::IOUring).is_error())
+        backends.append(AsyncFileIO::Backend::IOUring);
+    return backends;
+}
+
+TEST_CASE(write_then_read)
+{
+    for (auto backend : backends()) {
+        auto io = AsyncFileIO::create(backend).release_value();
+        EXPECT(io->backend() == backend);
+        int fd = create_temporary_file(0);
+
+        auto data = ByteBuffer::create_uninitialized(64 * KiB);
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<u8>(i ^ 0x5a);
+
+        size_t written = 0;
+        for (size_t i = 0; i < 16; ++i) {
+            io->write(fd, data.span().slice(i * 4 * KiB, 4 * KiB), i * 4 * KiB, [&](ssize_t result) {
+                EXPECT_EQ(result, 4096);
+                written += result;
+            });
+        }
+        EXPECT_EQ(io->queued(), 16u);
+        EXPECT_EQ(io->submit(), 16u);
+        io->wait(16);
+        EXPECT_EQ(written, data.size());
+        EXPECT_EQ(io->in_flight(), 0u);
+
+        auto read_back = ByteBuffer::create_zeroed(data.size());
+        ssize_t read_result = 0;
+        io->read(fd, read_back, 0, [&](ssize_t result) { read_result = result; });
+        io->wait();
+        EXPECT_EQ(read_result, static_cast<ssize_t>(data.size()));
+        EXPECT(read_back == data);
+        close(fd);
+    }
+}
+
+TEST_CASE(errors_are_reported_through_the_callback)
+{
+    for (auto backend : backends()) {
+        auto io = AsyncFileIO::create(backend).release_value();
+        u8 buffer[16];
+        ssize_t read_result = 0;
+        io->read(-1, { buffer, sizeof(buffer) }, 0, [&](ssize_t result) { read_result = result; });
+        io->wait();
+        EXPECT_EQ(read_result, -EBADF);
+    }
+}
+
+TEST_CASE(notify_fd_and_chained_requests)
+{
+    for (auto backend : backends()) {
+        auto io = AsyncFileIO::create(backend).release_value();
+        int fd = create_temporary_file(16 * KiB);
+
+        // Each callback queues the next read, the way a state machine driven by an event loop would.
+        u8 buffer[4096];
+        size_t reads = 0;
+        Function<void(ssize_t)> on_read = [&](ssize_t result) {
+            EXPECT_EQ(result, 4096);
+            EXPECT_EQ(buffer[0], expected_byte_at(reads * 4096));
+            if (++reads < 4) {
+                io->read(fd, { buffer, sizeof(buffer) }, reads * 4096, [&](ssize_t result) { on_read(result); });
+                io->submit();
+            }
+        };
+        io->read(fd, { buffer, sizeof(buffer) }, 0, [&](ssize_t result) { on_read(result); });
+        io->submit();
+
+        while (reads < 4) {
+            pollfd poll_fd { io->notify_fd(), POLLIN, 0 };
+            EXPECT_EQ(poll(&poll_fd, 1, 5000), 1);
+            io->process_completions();
+        }
+        EXPECT_EQ(io->in_flight(), 0u);
+        close(fd);
+    }
+}
+
+TEST_CASE(registered_buffers)
+{
+    for (auto backend : backends()) {
+        auto io = AsyncFileIO::create(backend).release_value();
+        int fd = create_temporary_file(64 * KiB);
+
+        auto pool = ByteBuffer::create_zeroed(64 * KiB);
+        Bytes pool_span = pool;
+        EXPECT(!io->register_buffers({ &pool_span, 1 }).is_error());
+
+        size_t completed = 0;
+        for (size_t i = 0; i < 16; ++i) {
+            io->read(fd, pool.span().slice(i * 4 * KiB, 4 * KiB), i * 4 * KiB, [&](ssize_t result) {
+                EXPECT_EQ(result, 4096);
+                ++completed;
+            });
+        }
+        io->wait(16);
+        EXPECT_EQ(completed, 16u);
+        for (size_t i = 0; i < pool.size(); i += 997)
+            EXPECT_EQ(pool[i], expected_byte_at(i));
+        EXPECT(!io->register_buffers({}).is_error());
+        close(fd);
+    }
+}
+
+TEST_CASE(async_input_stream)
+{
+    for (auto backend : backends()) {
+        auto io = AsyncFileIO::create(backend).release_value();
+        size_t file_size = 300 * KiB + 123;
+        int fd = create_temporary_file(file_size);
+
+        AsyncInputStream stream(*io, fd, 0, 16 * KiB, 3);
+        u8 buffer[1000];
+        u64 offset = 0;
+        while (!stream.eof()) {
+            auto nread = stream.read({ buffer, sizeof(buffer) });
+            for (size_t i = 0; i < nread; ++i)
+                EXPECT_EQ(buffer[i], expected_byte_at(offset + i));
+            offset += nread;
+        }
+        EXPECT_EQ(offset, file_size);
+        close(fd);
+    }
+}
+
+// Enough to not be a pure cache benchmark while still fitting in this VM.
+static constexpr size_t benchmark_file_size = 128 * MiB;
+static constexpr size_t benchmark_random_reads = 65536;
+
+static int s_benchmark_fd = -1;
+
+static int benchmark_fd()
+{
+    if (s_benchmark_fd < 0)
+        s_benchmark_fd = create_temporary_file(benchmark_file_size);
+    return s_benchmark_fd;
+}
+
+// Runs first, so that writing out the file isn't counted against the first real benchmark.
+BENCHMARK_CASE(create_benchmark_file)
+{
+    EXPECT(benchmark_fd() >= 0);
+}
+
+BENCHMARK_CASE(sequential_4k_blocking)
+{
+    InputFileStream stream(dup(benchmark_fd()));
+    stream.seek(0);
+    u8 buffer[4096];
+    size_t total = 0;
+    while (auto nread = stream.read({ buffer, sizeof(buffer) }))
+        total += nread;
+    EXPECT_EQ(total, benchmark_file_size);
+}
+
+static void benchmark_sequential_async(AsyncFileIO::Backend backend)
+{
+    auto io = AsyncFileIO::create(backend).release_value();
+    AsyncInputStream stream(*io, benchmark_fd());
+    u8 buffer[4096];
+    size_t total = 0;
+    while (auto nread = stream.read({ buffer, sizeof(buffer) }))
+        total += nread;
+    EXPECT_EQ(total, benchmark_file_size);
+}
+
+BENCHMARK_CASE(sequential_4k_async_io_uring)
+{
+    benchmark_sequential_async(AsyncFileIO::Backend::Automatic);
+}
+
+BENCHMARK_CASE(sequential_4k_async_thread_pool)
+{
+    benchmark_sequential_async(AsyncFileIO::Backend::ThreadPool);
+}
+
+static u64 random_block_offset(size_t i)
+{
+    u64 x = (i + 1) * 0x9e3779b97f4a7c15ull;
+    x ^= x >> 31;
+    return (x % (benchmark_file_size / 4096)) * 4096;
+}
+
+BENCHMARK_CASE(random_4k_blocking)
+{
+    int fd = benchmark_fd();
+    u8 buffer[4096];
+    u64 checksum = 0;
+    for (size_t i = 0; i < benchmark_random_reads; ++i) {
+        EXPECT_EQ(pread(fd, buffer, sizeof(buffer), random_block_offset(i)), 4096);
+        checksum += buffer[100];
+    }
+    EXPECT(checksum > 0);
+}
+
+static void benchmark_random_async(AsyncFileIO::Backend backend)
+{
+    static constexpr size_t queue_depth = 32;
+    auto io = AsyncFileIO::create(backend, queue_depth).release_value();
+    int fd = benchmark_fd();
+
+    auto pool = ByteBuffer::create_uninitialized(queue_depth * 4096);
+    Bytes pool_span = pool;
+    EXPECT(!io->register_buffers({ &pool_span, 1 }).is_error());
+
+    size_t issued = 0;
+    size_t completed = 0;
+    Function<void(size_t)> issue = [&](size_t slot) {
+        io->read(fd, pool.span().slice(slot * 4096, 4096), random_block_offset(issued++), [&, slot](ssize_t result) {
+            EXPECT_EQ(result, 4096);
+            ++completed;
+            if (issued < benchmark_random_reads)
+                issue(slot);
+        });
+    };
+    for (size_t slot = 0; slot < queue_depth; ++slot)
+        issue(slot);
+    while (completed < benchmark_random_reads)
+        io->wait();
+}
+
+BENCHMARK_CASE(random_4k_async_io_uring)
+{
+    benchmark_random_async(AsyncFileIO::Backend::Automatic);
+}
+
+BENCHMARK_CASE(random_4k_async_thread_pool)
+{
+    benchmark_random_async(AsyncFileIO::Backend::ThreadPool);
+}
+
+TEST_MAIN(AsyncFileIO)
@@ -0,0 +1,222 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/TestSuite.h>
+
+#include <AK/BitStream.h>
+#include <AK/ByteBuffer.h>
+#include <AK/MemoryStream.h>
+#include <AK/Vector.h>
+
+static u64 s_seed = 0x6a09e667f3bcc908;
+
+static u32 next_random()
+{
+    s_seed = s_seed * 6364136223846793005ull + 1442695040888963407ull;
+    return static_cast<u32>(s_seed >> 32);
+}
+
+TEST_CASE(lsb_first_layout)
+{
+    DuplexMemoryStream memory;
+    {
+        OutputBitStream stream(memory);
+        stream.write_bits(0b101, 3);
+        stream.write_bits(0b11, 2);
+        stream.write_bits(0b0110, 4);
+        stream.write_bits(0xABCD, 16);
+        EXPECT(stream.flush());
+    }
+    auto bytes = memory.copy_into_contiguous_buffer();
+    EXPECT_EQ(bytes.size(), 4u);
+    EXPECT_EQ(bytes[0], 0b11011101);
+    EXPECT_EQ(bytes[1], 0b10011010);
+    EXPECT_EQ(bytes[2], 0b01010111);
+    EXPECT_EQ(bytes[3], 0b00000001);
+}
+
+TEST_CASE(msb_first_layout)
+{
+    DuplexMemoryStream memory;
+    {
+        OutputBitStream stream(memory, BitOrder::MSBFirst);
+        stream.write_bits(0b101, 3);
+        stream.write_bits(0b11, 2);
+        stream.write_bits(0b0110, 4);
+        stream.write_bits(0xABCD, 16);
+        EXPECT(stream.flush());
+    }
+    auto bytes = memory.copy_into_contiguous_buffer();
+    EXPECT_EQ(bytes.size(), 4u);
+    EXPECT_EQ(bytes[0], 0b10111011);
+    EXPECT_EQ(bytes[1], 0b01010101);
+    EXPECT_EQ(bytes[2], 0b11100110);
+    EXPECT_EQ(bytes[3], 0b10000000);
+
+    InputBitStream input(bytes, BitOrder::MSBFirst);
+    EXPECT_EQ(input.read_bits(3), 0b101u);
+    EXPECT_EQ(input.read_bits(2), 0b11u);
+    EXPECT_EQ(input.read_bits(4), 0b0110u);
+    EXPECT_EQ(input.read_bits(16), 0xABCDu);
+}
+
+static void read_back(InputBitStream& input, const Vector<u32>& values, const Vector<u8>& widths)
+{
+    for (size_t i = 0; i < values.size(); ++i)
+        EXPECT_EQ(input.read_bits(widths[i]), values[i]);
+    input.align_to_byte_boundary();
+    EXPECT(input.unreliable_eof());
+}
+
+template<BitOrder order>
+static void roundtrip_random_widths()
+{
+    Vector<u32> values;
+    Vector<u8> widths;
+    DuplexMemoryStream memory;
+    {
+        OutputBitStream stream(memory, order);
+        for (size_t i = 0; i < 10000; ++i) {
+            auto width = static_cast<u8>(next_random() % 33);
+            auto value = width == 32 ? next_random() : next_random() & ((1u << width) - 1);
+            widths.append(width);
+            values.append(value);
+            stream.write_bits(value, width);
+        }
+        EXPECT(stream.flush());
+    }
+    auto bytes = memory.copy_into_contiguous_buffer();
+
+    InputBitStream from_memory(bytes, order);
+    read_back(from_memory, values, widths);
+
+    InputMemoryStream memory_input(bytes);
+    InputBitStream from_stream(memory_input, order);
+    read_back(from_stream, values, widths);
+}
+
+TEST_CASE(roundtrip)
+{
+    roundtrip_random_widths<BitOrder::LSBFirst>();
+    roundtrip_random_widths<BitOrder::MSBFirst>();
+}
+
+TEST_CASE(peek_and_consume)
+{
+    u8 bytes[] = { 0b10110100, 0b00001111 };
+    InputBitStream stream(ReadonlyBytes { bytes, sizeof(bytes) });
+    EXPECT_EQ(stream.peek_bits(4), 0b0100u);
+    EXPECT_EQ(stream.peek_bits(12), 0b111110110100u);
+    EXPECT(stream.consume_bits(3));
+    EXPECT_EQ(stream.peek_bits(5), 0b10110u);
+    EXPECT(stream.consume_bits(13));
+
+    // Peeking past the end pads with zeroes, consuming past it is an error.
+    EXPECT_EQ(stream.peek_bits(8), 0u);
+    EXPECT(!stream.consume_bits(1));
+    EXPECT(stream.handle_any_error());
+}
+
+TEST_CASE(aligned_bytes_after_bits)
+{
+    auto data = ByteBuffer::create_uninitialized(1000);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<u8>(i * 7);
+
+    DuplexMemoryStream memory;
+    {
+        OutputBitStream stream(memory);
+        stream.write_bits(0b101, 3);
+        EXPECT(stream.write_or_error(data.span().trim(10)));
+        stream.write_bits(0x3fff, 14);
+        EXPECT(stream.write_or_error(data));
+        EXPECT(stream.flush());
+    }
+    EXPECT_EQ(memory.size(), 1u + 10u + 2u + 1000u);
+
+    auto bytes = memory.copy_into_contiguous_buffer();
+    InputMemoryStream memory_input(bytes);
+    InputBitStream stream(memory_input);
+    EXPECT_EQ(stream.read_bits(3), 0b101u);
+    u8 small[10];
+    EXPECT(stream.read_or_error({ small, sizeof(small) }));
+    EXPECT(ReadonlyBytes(small, sizeof(small)) == data.span().trim(10));
+    EXPECT_EQ(stream.read_bits(14), 0x3fffu);
+    auto large = ByteBuffer::create_uninitialized(1000);
+    EXPECT(stream.read_or_error(large));
+    EXPECT(large == data);
+    EXPECT(stream.unreliable_eof());
+}
+
+static constexpr size_t benchmark_count = 16'000'000;
+
+BENCHMARK_CASE(write_bits_throughput)
+{
+    auto buffer = ByteBuffer::create_uninitialized(benchmark_count * 2);
+    OutputMemoryStream memory(buffer);
+    size_t bit_count = 0;
+    {
+        OutputBitStream stream(memory);
+        for (size_t i = 0; i < benchmark_count; ++i) {
+            stream.write_bits(static_cast<u32>(i), (i % 13) + 1);
+            bit_count += (i % 13) + 1;
+        }
+        EXPECT(stream.flush());
+    }
+    EXPECT_EQ(memory.size(), ceil_div(bit_count, static_cast<size_t>(8)));
+}
+
+BENCHMARK_CASE(read_bits_throughput)
+{
+    auto buffer = ByteBuffer::create_uninitialized(benchmark_count * 2);
+    for (size_t i = 0; i < buffer.size(); ++i)
+        buffer[i] = static_cast<u8>(next_random());
+
+    InputMemoryStream memory(buffer);
+    InputBitStream stream(memory);
+    u64 checksum = 0;
+    for (size_t i = 0; i < benchmark_count; ++i)
+        checksum += stream.read_bits((i % 13) + 1);
+    EXPECT(checksum > 0);
+}
+
+BENCHMARK_CASE(peek_consume_throughput)
+{
+    auto buffer = ByteBuffer::create_uninitialized(benchmark_count * 2);
+    for (size_t i = 0; i < buffer.size(); ++i)
+        buffer[i] = static_cast<u8>(next_random());
+
+    InputBitStream stream(buffer);
+    u64 checksum = 0;
+    for (size_t i = 0; i < benchmark_count; ++i) {
+        // Pretend to look up a 9-bit Huffman table and consume a code of 1-8 bits.
+        auto bits = stream.peek_bits(9);
+        checksum += bits;
+        stream.consume_bits((bits & 7) + 1);
+    }
+    EXPECT(checksum > 0);
+}
+
+TEST_MAIN(BitStream)
@@ -167,6 +167,18 @@ TEST_CASE(set_range)
         }
         EXPECT_EQ(bitmap.count_slow(true), 32u + 39u + 71u - 7u);
     }
+    {
+        // Ranges that end on the last byte boundary mustn't touch the byte after it. Run under ASan to see.
+        Bitmap bitmap(64, false);
+        bitmap.set_range(63, 1, true);
+        bitmap.set_range(3, 61, true);
+        bitmap.view().set_range_and_verify_that_all_bits_flip(0, 3, true);
+        EXPECT_EQ(bitmap.count_slow(true), 64u);
+        bitmap.set_range(8, 56, false);
+        EXPECT_EQ(bitmap.count_slow(true), 8u);
+        EXPECT_EQ(bitmap.get(7), true);
+        EXPECT_EQ(bitmap.get(8), false);
+    }
 }
 
 TEST_CASE(find_first_fit)
@@ -0,0 +1,203 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/TestSuite.h>
+
+#include <AK/Buffered.h>
+#include <AK/ByteBuffer.h>
+#include <AK/MemoryStream.h>
+#include <AK/String.h>
+
+// Hands out at most a few bytes per read(), like a socket would, and counts how often it is read from.
+class TrickleStream final : public InputStream {
+public:
+    TrickleStream(ReadonlyBytes bytes, size_t chunk_size)
+        : m_stream(bytes)
+        , m_chunk_size(chunk_size)
+    {
+    }
+
+    size_t read(Bytes bytes) override
+    {
+        ++m_read_calls;
+        return m_stream.read(bytes.trim(m_chunk_size));
+    }
+    bool read_or_error(Bytes bytes) override { return m_stream.read_or_error(bytes); }
+    bool discard_or_error(size_t count) override { return m_stream.discard_or_error(count); }
+    bool unreliable_eof() const override { return m_stream.unreliable_eof(); }
+
+    size_t read_calls() const { return m_read_calls; }
+
+private:
+    InputMemoryStream m_stream;
+    size_t m_chunk_size;
+    size_t m_read_calls { 0 };
+};
+
+static ByteBuffer make_counting_bytes(size_t size)
+{
+    auto bytes = ByteBuffer::create_uninitialized(size);
+    for (size_t i = 0; i < size; ++i)
+        bytes[i] = static_cast<u8>(i % 251);
+    return bytes;
+}
+
+TEST_CASE(small_reads)
+{
+    auto bytes = make_counting_bytes(10000);
+    Buffered<TrickleStream, 64> stream(bytes, 7);
+
+    size_t offset = 0;
+    u8 chunk[13];
+    while (offset < bytes.size()) {
+        auto nread = stream.read({ chunk, sizeof(chunk) });
+        EXPECT(nread > 0);
+        for (size_t i = 0; i < nread; ++i)
+            EXPECT_EQ(chunk[i], bytes[offset + i]);
+        offset += nread;
+    }
+    EXPECT_EQ(offset, bytes.size());
+    EXPECT(stream.eof());
+    EXPECT_EQ(stream.read({ chunk, sizeof(chunk) }), 0u);
+}
+
+TEST_CASE(large_reads_bypass_the_buffer)
+{
+    auto bytes = make_counting_bytes(100000);
+    Buffered<InputMemoryStream, 64> stream(bytes);
+
+    u8 first[10];
+    EXPECT(stream.read_or_error({ first, sizeof(first) }));
+    EXPECT_EQ(stream.buffered_size(), 54u);
+
+    auto rest = ByteBuffer::create_uninitialized(bytes.size() - 10);
+    EXPECT(stream.read_or_error(rest));
+    EXPECT_EQ(stream.buffered_size(), 0u);
+    EXPECT(rest.span() == bytes.span().slice(10));
+    EXPECT(stream.eof());
+}
+
+TEST_CASE(peek_and_consume)
+{
+    auto bytes = make_counting_bytes(100);
+    Buffered<TrickleStream, 16> stream(bytes, 3);
+
+    auto peeked = stream.peek(5);
+    EXPECT_EQ(peeked.size(), 5u);
+    EXPECT(peeked == bytes.span().trim(5));
+    stream.consume(4);
+
+    // Needs more bytes than fit behind the cursor, so the buffered ones are moved to the front.
+    peeked = stream.peek(16);
+    EXPECT_EQ(peeked.size(), 16u);
+    EXPECT(peeked == bytes.span().slice(4, 16));
+
+    EXPECT(stream.discard_or_error(90));
+    peeked = stream.peek(16);
+    EXPECT_EQ(peeked.size(), 6u);
+    EXPECT(peeked == bytes.span().slice(94));
+    stream.consume(6);
+    EXPECT(stream.eof());
+}
+
+TEST_CASE(read_lines)
+{
+    auto text = "NICK kling\r\nUSER kling 0 * :Andreas\r\n\nPING :irc.example.com\nno newline at the end"sv;
+    Buffered<TrickleStream, 32> stream(text.bytes(), 5);
+
+    EXPECT_EQ(stream.read_line().value(), "NICK kling");
+    EXPECT_EQ(stream.read_line().value(), "USER kling 0 * :Andreas");
+    EXPECT_EQ(stream.read_line().value(), "");
+    EXPECT_EQ(stream.read_line().value(), "PING :irc.example.com");
+    EXPECT_EQ(stream.read_line().value(), "no newline at the end");
+    EXPECT(!stream.read_line().has_value());
+}
+
+TEST_CASE(read_until_overlong_line)
+{
+    auto text = "0123456789abcdefXYZ;tail"sv;
+    Buffered<InputMemoryStream, 16> stream(text.bytes());
+
+    // No delimiter within a full buffer: nothing is consumed.
+    EXPECT(!stream.read_until(';').has_value());
+    EXPECT_EQ(stream.buffered_size(), 16u);
+
+    u8 skipped[16];
+    EXPECT(stream.read_or_error({ skipped, sizeof(skipped) }));
+    EXPECT_EQ(StringView(stream.read_until(';').value()), "XYZ");
+    EXPECT_EQ(StringView(stream.read_until(';').value()), "tail");
+}
+
+TEST_CASE(move_keeps_buffered_bytes)
+{
+    auto bytes = make_counting_bytes(300);
+    Buffered<InputMemoryStream, 128> stream(bytes);
+    stream.discard_or_error(10);
+
+    auto moved = move(stream);
+    u8 byte;
+    EXPECT(moved.read_or_error({ &byte, 1 }));
+    EXPECT_EQ(byte, bytes[10]);
+}
+
+static constexpr size_t benchmark_size = 64 * MiB;
+
+BENCHMARK_CASE(small_read_throughput)
+{
+    auto bytes = make_counting_bytes(benchmark_size);
+    Buffered<InputMemoryStream> stream(bytes);
+
+    u32 value;
+    u64 checksum = 0;
+    for (size_t i = 0; i < benchmark_size / sizeof(value); ++i) {
+        EXPECT(stream.read_or_error({ &value, sizeof(value) }));
+        checksum += value;
+    }
+    EXPECT(checksum > 0);
+    EXPECT(stream.eof());
+}
+
+BENCHMARK_CASE(read_line_throughput)
+{
+    StringBuilder builder;
+    for (size_t i = 0; builder.length() < benchmark_size / 4; ++i)
+        builder.appendff(":nick{}!user@host PRIVMSG #channel :message number {}\r\n", i % 100, i);
+    auto text = builder.to_string();
+    Buffered<InputMemoryStream> stream(text.bytes());
+
+    size_t lines = 0;
+    size_t characters = 0;
+    for (;;) {
+        auto line = stream.read_line();
+        if (!line.has_value())
+            break;
+        ++lines;
+        characters += line->length();
+    }
+    EXPECT(lines > 0);
+    EXPECT_EQ(characters + 2 * lines, text.length());
+}
+
+TEST_MAIN(Buffered)
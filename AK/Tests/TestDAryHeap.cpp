@@ -0,0 +1,228 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/BinaryHeap.h>
+#include <AK/DAryHeap.h>
+#include <AK/OwnPtr.h>
+#include <AK/String.h>
+
+static u64 s_seed = 0xda3e39cb94b95bdb;
+
+static u32 next_random()
+{
+    s_seed = s_seed * 6364136223846793005ull + 1442695040888963407ull;
+    return static_cast<u32>(s_seed >> 32);
+}
+
+TEST_CASE(construct)
+{
+    DAryHeap<int, int> empty;
+    EXPECT(empty.is_empty());
+    EXPECT_EQ(empty.size(), 0u);
+}
+
+TEST_CASE(construct_from_existing)
+{
+    int keys[] = { 5, 3, 2, 4, 1, 6 };
+    char values[] = { 'e', 'c', 'b', 'd', 'a', 'f' };
+    DAryHeap<int, char> from_existing(keys, values, 6);
+    EXPECT_EQ(from_existing.size(), 6u);
+    for (char expected = 'a'; expected <= 'f'; ++expected)
+        EXPECT_EQ(from_existing.pop_min(), expected);
+}
+
+TEST_CASE(grows_past_any_fixed_capacity)
+{
+    DAryHeap<int, int> ints;
+    for (int i = 99999; i >= 0; --i)
+        ints.insert(i, i);
+    EXPECT_EQ(ints.size(), 100000u);
+    for (int i = 0; i < 100000; ++i) {
+        EXPECT_EQ(ints.peek_min_key(), i);
+        EXPECT_EQ(ints.pop_min(), i);
+    }
+    EXPECT(ints.is_empty());
+}
+
+TEST_CASE(other_arities_and_strings)
+{
+    DAryHeap<u32, String, 2> binary;
+    DAryHeap<u32, String, 8> octal;
+    for (size_t i = 0; i < 1000; ++i) {
+        auto key = next_random() % 500;
+        binary.insert(key, String::number(key));
+        octal.insert(key, String::number(key));
+    }
+    u32 previous = 0;
+    while (!binary.is_empty()) {
+        auto key = binary.peek_min_key();
+        EXPECT(key >= previous);
+        EXPECT_EQ(binary.pop_min(), String::number(key));
+        EXPECT_EQ(octal.pop_min(), String::number(key));
+        previous = key;
+    }
+    EXPECT(octal.is_empty());
+}
+
+TEST_CASE(indexed_update_key)
+{
+    IndexedDAryHeap<int, char> heap;
+    auto a = heap.insert(10, 'a');
+    auto b = heap.insert(20, 'b');
+    auto c = heap.insert(30, 'c');
+    EXPECT_EQ(heap.peek_min(), 'a');
+
+    heap.update_key(c, 5);
+    EXPECT_EQ(heap.peek_min(), 'c');
+    EXPECT_EQ(heap.key(c), 5);
+
+    heap.update_key(c, 50);
+    heap.update_key(a, 25);
+    EXPECT_EQ(heap.peek_min(), 'b');
+    EXPECT_EQ(heap.pop_min(), 'b');
+    EXPECT_EQ(heap.pop_min(), 'a');
+    EXPECT_EQ(heap.pop_min(), 'c');
+    EXPECT(heap.is_empty());
+    EXPECT(!heap.contains(a));
+    EXPECT(!heap.contains(b));
+}
+
+TEST_CASE(indexed_remove)
+{
+    IndexedDAryHeap<int, int> heap;
+    Vector<IndexedDAryHeap<int, int>::Handle> handles;
+    for (int i = 0; i < 100; ++i)
+        handles.append(heap.insert(i, i));
+
+    // Remove every third element, including the current minimum.
+    for (int i = 0; i < 100; i += 3)
+        EXPECT_EQ(heap.remove(handles[i]), i);
+    EXPECT_EQ(heap.size(), 66u);
+
+    for (int i = 0; i < 100; ++i) {
+        if (i % 3 == 0)
+            continue;
+        EXPECT_EQ(heap.peek_min_key(), i);
+        EXPECT_EQ(heap.pop_min(), i);
+    }
+    EXPECT(heap.is_empty());
+
+    // Handles are recycled.
+    auto handle = heap.insert(1, 1);
+    EXPECT(handle < 100u);
+    EXPECT_EQ(heap.value(handle), 1);
+}
+
+TEST_CASE(indexed_randomized_against_sorted_order)
+{
+    IndexedDAryHeap<u32, size_t> heap;
+    Vector<IndexedDAryHeap<u32, size_t>::Handle> handles;
+    Vector<u32> keys;
+    for (size_t i = 0; i < 2000; ++i) {
+        keys.append(next_random() % 10000);
+        handles.append(heap.insert(keys.last(), i));
+    }
+    for (size_t i = 0; i < 2000; ++i) {
+        auto index = next_random() % 2000;
+        keys[index] = next_random() % 10000;
+        heap.update_key(handles[index], keys[index]);
+    }
+
+    u32 previous = 0;
+    while (!heap.is_empty()) {
+        auto key = heap.peek_min_key();
+        auto index = heap.pop_min();
+        EXPECT_EQ(keys[index], key);
+        EXPECT(key >= previous);
+        previous = key;
+    }
+}
+
+static constexpr size_t benchmark_size = 1'000'000;
+
+BENCHMARK_CASE(binary_heap_push_pop)
+{
+    auto heap = make<BinaryHeap<u32, u32, benchmark_size>>();
+    for (size_t i = 0; i < benchmark_size; ++i)
+        heap->insert(next_random(), i);
+    u32 previous = 0;
+    while (!heap->is_empty()) {
+        auto key = heap->peek_min_key();
+        EXPECT(key >= previous);
+        heap->pop_min();
+        previous = key;
+    }
+}
+
+template<size_t Arity>
+static void benchmark_dary_heap_push_pop()
+{
+    DAryHeap<u32, u32, Arity> heap;
+    for (size_t i = 0; i < benchmark_size; ++i)
+        heap.insert(next_random(), i);
+    u32 previous = 0;
+    while (!heap.is_empty()) {
+        auto key = heap.peek_min_key();
+        EXPECT(key >= previous);
+        heap.pop_min();
+        previous = key;
+    }
+}
+
+BENCHMARK_CASE(dary_heap_2_push_pop)
+{
+    benchmark_dary_heap_push_pop<2>();
+}
+
+BENCHMARK_CASE(dary_heap_4_push_pop)
+{
+    benchmark_dary_heap_push_pop<4>();
+}
+
+BENCHMARK_CASE(dary_heap_8_push_pop)
+{
+    benchmark_dary_heap_push_pop<8>();
+}
+
+BENCHMARK_CASE(indexed_dary_heap_decrease_key)
+{
+    IndexedDAryHeap<u32, u32> heap;
+    heap.ensure_capacity(benchmark_size);
+    Vector<IndexedDAryHeap<u32, u32>::Handle> handles;
+    handles.ensure_capacity(benchmark_size);
+    for (size_t i = 0; i < benchmark_size; ++i)
+        handles.unchecked_append(heap.insert(next_random() | 0x80000000u, i));
+
+    for (size_t i = 0; i < benchmark_size; ++i) {
+        auto handle = handles[next_random() % benchmark_size];
+        heap.update_key(handle, heap.key(handle) / 2);
+    }
+
+    while (!heap.is_empty())
+        heap.pop_min();
+}
+
+TEST_MAIN(DAryHeap)
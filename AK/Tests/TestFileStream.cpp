@@ -0,0 +1,230 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/TestSuite.h>
+
+#include <AK/ByteBuffer.h>
+#include <AK/FileStream.h>
+#include <AK/MemoryStream.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static int create_temporary_file()
+{
+    char path[] = "/tmp/TestFileStream.XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT(fd >= 0);
+    unlink(path);
+    return fd;
+}
+
+static ByteBuffer make_test_data(size_t size)
+{
+    auto data = ByteBuffer::create_uninitialized(size);
+    for (size_t i = 0; i < size; ++i)
+        data[i] = static_cast<u8>(i * 13);
+    return data;
+}
+
+TEST_CASE(fd_stream_roundtrip)
+{
+    int fd = create_temporary_file();
+    auto data = make_test_data(10000);
+    {
+        OutputFDStream output(dup(fd));
+        output << static_cast<u32>(0xcafebabe);
+        EXPECT(output.write_or_error(data));
+    }
+
+    lseek(fd, 0, SEEK_SET);
+    InputFDStream input(fd);
+    u32 magic;
+    input >> magic;
+    EXPECT_EQ(magic, 0xcafebabe);
+
+    auto read_back = ByteBuffer::create_uninitialized(data.size());
+    EXPECT(input.read_or_error(read_back));
+    EXPECT(read_back == data);
+
+    u8 byte;
+    EXPECT_EQ(input.read({ &byte, 1 }), 0u);
+    EXPECT(input.eof());
+}
+
+TEST_CASE(fd_stream_discard)
+{
+    int fd = create_temporary_file();
+    auto data = make_test_data(10000);
+    EXPECT_EQ(write(fd, data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    lseek(fd, 0, SEEK_SET);
+
+    InputFDStream input(fd);
+    EXPECT(input.discard_or_error(9000));
+    u8 byte;
+    EXPECT_EQ(input.read({ &byte, 1 }), 1u);
+    EXPECT_EQ(byte, data[9000]);
+    EXPECT(!input.has_any_error());
+
+    // Only 999 bytes are left.
+    EXPECT(!input.discard_or_error(1000));
+    EXPECT(input.handle_recoverable_error());
+    EXPECT(input.eof());
+}
+
+TEST_CASE(fd_stream_vectored)
+{
+    int fd = create_temporary_file();
+    auto data = make_test_data(100);
+
+    // More spans than a single writev() call takes, to exercise the batching.
+    Vector<ReadonlyBytes> spans;
+    for (size_t i = 0; i < 200; ++i)
+        spans.append(data.span().slice(i % 100, 1));
+    {
+        OutputFDStream output(dup(fd));
+        EXPECT(output.write_vectored_or_error(spans));
+    }
+
+    lseek(fd, 0, SEEK_SET);
+    InputFDStream input(fd);
+    u8 first[50], second[150];
+    Bytes buffers[] = { { first, sizeof(first) }, { second, sizeof(second) } };
+    EXPECT_EQ(input.read_vectored(buffers), 200u);
+    for (size_t i = 0; i < 50; ++i)
+        EXPECT_EQ(first[i], data[i]);
+    for (size_t i = 0; i < 150; ++i)
+        EXPECT_EQ(second[i], data[(i + 50) % 100]);
+}
+
+TEST_CASE(copy_between_files)
+{
+    int input_fd = create_temporary_file();
+    int output_fd = create_temporary_file();
+    auto data = make_test_data(1 * MiB + 123);
+    EXPECT_EQ(write(input_fd, data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    lseek(input_fd, 0, SEEK_SET);
+    {
+        InputFDStream input(input_fd);
+        OutputFDStream output(dup(output_fd));
+        EXPECT_EQ(copy_stream(input, output), data.size());
+    }
+
+    lseek(output_fd, 0, SEEK_SET);
+    InputFDStream copy(output_fd);
+    auto read_back = ByteBuffer::create_uninitialized(data.size());
+    EXPECT(copy.read_or_error(read_back));
+    EXPECT(read_back == data);
+}
+
+TEST_CASE(copy_through_pipe)
+{
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+    auto data = make_test_data(1000);
+    EXPECT_EQ(write(pipe_fds[1], data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    close(pipe_fds[1]);
+
+    int output_fd = create_temporary_file();
+    {
+        InputFDStream input(pipe_fds[0]);
+        OutputFDStream output(dup(output_fd));
+        EXPECT_EQ(copy_stream(input, output), data.size());
+    }
+
+    lseek(output_fd, 0, SEEK_SET);
+    InputFDStream copy(output_fd);
+    auto read_back = ByteBuffer::create_uninitialized(data.size());
+    EXPECT(copy.read_or_error(read_back));
+    EXPECT(read_back == data);
+}
+
+TEST_CASE(copy_to_append_only_file)
+{
+    int input_fd = create_temporary_file();
+    auto data = make_test_data(1000);
+    EXPECT_EQ(write(input_fd, data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    lseek(input_fd, 0, SEEK_SET);
+
+    char path[] = "/tmp/TestFileStream.XXXXXX";
+    int output_fd = mkstemp(path);
+    EXPECT(output_fd >= 0);
+    {
+        InputFDStream input(input_fd);
+        OutputFDStream output(open(path, O_WRONLY | O_APPEND));
+        EXPECT_EQ(copy_stream(input, output), data.size());
+    }
+    unlink(path);
+
+    InputFDStream copy(output_fd);
+    auto read_back = ByteBuffer::create_uninitialized(data.size());
+    EXPECT(copy.read_or_error(read_back));
+    EXPECT(read_back == data);
+}
+
+TEST_CASE(copy_errors_go_to_their_stream)
+{
+    char path[] = "/tmp/TestFileStream.XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT(fd >= 0);
+    auto data = make_test_data(1000);
+    EXPECT_EQ(write(fd, data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    close(fd);
+
+    {
+        // Not open for reading.
+        InputFDStream input(open(path, O_WRONLY));
+        OutputFDStream output(create_temporary_file());
+        EXPECT_EQ(copy_stream(input, output), 0u);
+        EXPECT(input.handle_fatal_error());
+        EXPECT(!output.has_any_error());
+    }
+    {
+        // Not open for writing.
+        InputFDStream input(open(path, O_RDONLY));
+        OutputFDStream output(open(path, O_RDONLY));
+        EXPECT_EQ(copy_stream(input, output), 0u);
+        EXPECT(output.handle_fatal_error());
+        EXPECT(!input.has_fatal_error());
+    }
+    unlink(path);
+}
+
+TEST_CASE(flush_chunk_list_in_one_call)
+{
+    auto data = make_test_data(DuplexMemoryStream::default_chunk_size * 3 + 7);
+    DuplexMemoryStream memory;
+    memory << data;
+
+    int fd = create_temporary_file();
+    {
+        OutputFDStream output(dup(fd));
+        EXPECT_EQ(copy_stream(memory, output), data.size());
+    }
+    EXPECT_EQ(lseek(fd, 0, SEEK_END), static_cast<off_t>(data.size()));
+    close(fd);
+}
+
+TEST_MAIN(FileStream)
@@ -0,0 +1,271 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/GenericLexer.h>
+#include <AK/String.h>
+#include <AK/StringBuilder.h>
+
+static u64 s_seed = 0x9e3779b97f4a7c15;
+
+static u32 next_random()
+{
+    s_seed = s_seed * 6364136223846793005ull + 1442695040888963407ull;
+    return static_cast<u32>(s_seed >> 32);
+}
+
+TEST_CASE(character_set_membership)
+{
+    constexpr auto brackets = is_any_of("<>[]");
+    static_assert(brackets('<'));
+    static_assert(!brackets('a'));
+    EXPECT_EQ(brackets.size(), 4u);
+
+    CharacterSet with_high_bytes("a\xe9\xff");
+    EXPECT(with_high_bytes('a'));
+    EXPECT(with_high_bytes('\xe9'));
+    EXPECT(with_high_bytes(static_cast<u8>(0xff)));
+    EXPECT(!with_high_bytes(0x1ff));
+    EXPECT(!with_high_bytes(-1));
+    EXPECT(!with_high_bytes('b'));
+
+    CharacterSet duplicates("aaab");
+    EXPECT_EQ(duplicates.size(), 2u);
+
+    EXPECT(is_ascii_whitespace(' '));
+    EXPECT(is_ascii_whitespace('\v'));
+    EXPECT(!is_ascii_whitespace('\0'));
+}
+
+TEST_CASE(character_set_find_matches_scalar_scan)
+{
+    // One member (memchr), a few (vector compares), whitespace, more than fit in compares, and non-ASCII.
+    const char* sets[] = { "x", "\r\n", " \t\n\v\f\r", "0123456789abcdef", "\x80\xfe" "z" };
+    char alphabet[] = "abcxyz \t\r\n019f\x80\xfe";
+
+    for (auto* set_characters : sets) {
+        CharacterSet set(set_characters);
+        for (size_t round = 0; round < 300; ++round) {
+            char buffer[80];
+            size_t length = next_random() % sizeof(buffer);
+            for (size_t i = 0; i < length; ++i)
+                buffer[i] = alphabet[next_random() % (sizeof(alphabet) - 1)];
+
+            size_t expected_in = 0;
+            while (expected_in < length && !set(buffer[expected_in]))
+                ++expected_in;
+            size_t expected_not_in = 0;
+            while (expected_not_in < length && set(buffer[expected_not_in]))
+                ++expected_not_in;
+
+            EXPECT_EQ(set.find_first_in(buffer, length), expected_in);
+            EXPECT_EQ(set.find_first_not_in(buffer, length), expected_not_in);
+        }
+    }
+}
+
+TEST_CASE(character_set_long_runs)
+{
+    String spaces = String::repeated(' ', 100);
+    EXPECT_EQ(is_ascii_whitespace.find_first_not_in(spaces.characters(), spaces.length()), 100u);
+    auto text = String::formatted("{}x", spaces);
+    EXPECT_EQ(is_ascii_whitespace.find_first_not_in(text.characters(), text.length()), 100u);
+    EXPECT_EQ(is_any_of("xy").find_first_in(text.characters(), text.length()), 100u);
+    EXPECT_EQ(is_any_of("xy").find_first_in(spaces.characters(), spaces.length()), 100u);
+}
+
+TEST_CASE(character_set_empty)
+{
+    CharacterSet empty("");
+    EXPECT_EQ(empty.size(), 0u);
+    auto text = String::formatted("{}x", String::repeated(' ', 40));
+    EXPECT_EQ(empty.find_first_in(text.characters(), text.length()), text.length());
+    EXPECT_EQ(empty.find_first_not_in(text.characters(), text.length()), 0u);
+
+    GenericLexer lexer(text);
+    EXPECT_EQ(lexer.consume_until_any_of(""), text.view());
+    EXPECT(lexer.is_eof());
+}
+
+TEST_CASE(consume_until)
+{
+    GenericLexer lexer("key=value;rest");
+    EXPECT_EQ(lexer.consume_until('='), "key");
+    EXPECT_EQ(lexer.consume_until_any_of(";,"), "value");
+    EXPECT(lexer.next_is(';'));
+    lexer.ignore();
+    EXPECT_EQ(lexer.consume_until('!'), "rest");
+    EXPECT(lexer.is_eof());
+
+    GenericLexer empty_run("=x");
+    EXPECT(empty_run.consume_until('=').is_null());
+    EXPECT_EQ(empty_run.tell(), 1u);
+}
+
+TEST_CASE(consume_until_string)
+{
+    GenericLexer lexer("a -- b --- c -");
+    EXPECT_EQ(lexer.consume_until("--"), "a ");
+    EXPECT_EQ(lexer.consume_until("---"), " b ");
+    EXPECT_EQ(lexer.consume_until("--"), " c -");
+    EXPECT(lexer.is_eof());
+
+    GenericLexer comment("/* comment */ code");
+    comment.ignore_until("*/");
+    EXPECT_EQ(comment.remaining(), " code");
+    comment.ignore_until("*/");
+    EXPECT(comment.is_eof());
+}
+
+TEST_CASE(consume_line)
+{
+    GenericLexer lexer("first\r\nsecond\n\nthird");
+    EXPECT_EQ(lexer.consume_line(), "first");
+    EXPECT_EQ(lexer.consume_line(), "second");
+    EXPECT(lexer.consume_line().is_null());
+    EXPECT_EQ(lexer.consume_line(), "third");
+    EXPECT(lexer.is_eof());
+}
+
+TEST_CASE(while_and_whitespace)
+{
+    GenericLexer lexer("  \t\n  12345abc  \r\n");
+    lexer.ignore_whitespace();
+    EXPECT_EQ(lexer.consume_while(is_any_of("0123456789")), "12345");
+    EXPECT_EQ(lexer.consume_while([](char c) { return c >= 'a' && c <= 'z'; }), "abc");
+    EXPECT(lexer.consume_while(is_any_of("xyz")).is_null());
+    lexer.ignore_whitespace();
+    EXPECT(lexer.is_eof());
+    lexer.ignore_whitespace();
+    EXPECT(lexer.is_eof());
+}
+
+static String make_benchmark_text()
+{
+    // Indented lines of words, which looks roughly like source code or pretty-printed JSON.
+    StringBuilder builder;
+    while (builder.length() < 1 * MiB) {
+        builder.append(String::repeated(' ', next_random() % 16));
+        size_t words = 1 + next_random() % 10;
+        for (size_t i = 0; i < words; ++i) {
+            builder.append(String::repeated('a' + next_random() % 26, 1 + next_random() % 10));
+            builder.append(' ');
+        }
+        builder.append(next_random() % 4 ? "\n" : "\r\n");
+    }
+    return builder.to_string();
+}
+
+static constexpr size_t benchmark_rounds = 100;
+
+BENCHMARK_CASE(consume_until_char)
+{
+    auto text = make_benchmark_text();
+    size_t count = 0;
+    for (size_t round = 0; round < benchmark_rounds; ++round) {
+        GenericLexer lexer(text);
+        while (!lexer.is_eof()) {
+            lexer.consume_until('\n');
+            ++count;
+        }
+    }
+    EXPECT(count > 0);
+}
+
+BENCHMARK_CASE(consume_line)
+{
+    auto text = make_benchmark_text();
+    size_t count = 0;
+    for (size_t round = 0; round < benchmark_rounds; ++round) {
+        GenericLexer lexer(text);
+        while (!lexer.is_eof()) {
+            lexer.consume_line();
+            ++count;
+        }
+    }
+    EXPECT(count > 0);
+}
+
+BENCHMARK_CASE(consume_until_string)
+{
+    auto text = make_benchmark_text();
+    size_t count = 0;
+    for (size_t round = 0; round < benchmark_rounds; ++round) {
+        GenericLexer lexer(text);
+        while (!lexer.is_eof()) {
+            lexer.consume_until("\r\n");
+            ++count;
+        }
+    }
+    EXPECT(count > 0);
+}
+
+BENCHMARK_CASE(consume_until_any_of)
+{
+    auto text = make_benchmark_text();
+    auto delimiters = is_any_of("{}[]\r\n");
+    size_t count = 0;
+    for (size_t round = 0; round < benchmark_rounds; ++round) {
+        GenericLexer lexer(text);
+        while (!lexer.is_eof()) {
+            lexer.consume_until(delimiters);
+            lexer.ignore();
+            ++count;
+        }
+    }
+    EXPECT(count > 0);
+}
+
+BENCHMARK_CASE(ignore_whitespace_and_words)
+{
+    auto text = make_benchmark_text();
+    size_t count = 0;
+    for (size_t round = 0; round < benchmark_rounds; ++round) {
+        GenericLexer lexer(text);
+        while (!lexer.is_eof()) {
+            lexer.ignore_whitespace();
+            lexer.consume_until(is_ascii_whitespace);
+            ++count;
+        }
+    }
+    EXPECT(count > 0);
+}
+
+BENCHMARK_CASE(consume_while_condition)
+{
+    auto text = make_benchmark_text();
+    size_t count = 0;
+    for (size_t round = 0; round < benchmark_rounds; ++round) {
+        GenericLexer lexer(text);
+        while (!lexer.is_eof()) {
+            lexer.consume_while([](char c) { return c != '\n'; });
+            lexer.ignore();
+            ++count;
+        }
+    }
+    EXPECT(count > 0);
+}
+
+TEST_MAIN(GenericLexer)
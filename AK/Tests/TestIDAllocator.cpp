@@ -0,0 +1,200 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <AK/TestSuite.h>
+
+#include <AK/HashTable.h>
+#include <AK/IDAllocator.h>
+#include <AK/Vector.h>
+#include <pthread.h>
+
+TEST_CASE(never_vends_zero_or_duplicates)
+{
+    IDAllocator allocator;
+    HashTable<int> seen;
+    for (int i = 0; i < 10000; ++i) {
+        auto id = allocator.allocate();
+        EXPECT(id >= IDAllocator::default_min_id && id <= IDAllocator::default_max_id);
+        EXPECT(!seen.contains(id));
+        seen.set(id);
+    }
+    EXPECT_EQ(allocator.allocated_count(), 10000u);
+}
+
+TEST_CASE(lowest_first)
+{
+    IDAllocator allocator(10, 200, IDAllocatorStart::Lowest);
+    for (int i = 10; i <= 200; ++i)
+        EXPECT_EQ(allocator.allocate(), i);
+    EXPECT(!allocator.try_allocate().has_value());
+
+    allocator.deallocate(150);
+    allocator.deallocate(42);
+    EXPECT(!allocator.is_allocated(42));
+    EXPECT_EQ(allocator.allocate(), 42);
+    EXPECT_EQ(allocator.allocate(), 150);
+    EXPECT(allocator.is_allocated(150));
+    EXPECT(!allocator.try_allocate().has_value());
+}
+
+TEST_CASE(deallocating_unknown_ids_does_nothing)
+{
+    for (auto concurrency : { IDAllocatorConcurrency::SingleThreaded, IDAllocatorConcurrency::LockFree }) {
+        IDAllocator allocator(1, 100, IDAllocatorStart::Lowest, concurrency);
+        EXPECT_EQ(allocator.allocate(), 1);
+        allocator.deallocate(2);
+        allocator.deallocate(0);
+        allocator.deallocate(1000);
+        EXPECT_EQ(allocator.allocated_count(), 1u);
+        EXPECT(allocator.is_allocated(1));
+        allocator.deallocate(1);
+        allocator.deallocate(1);
+        EXPECT_EQ(allocator.allocated_count(), 0u);
+        EXPECT_EQ(allocator.allocate(), 1);
+    }
+}
+
+TEST_CASE(randomized_fills_whole_range)
+{
+    // Not a multiple of 64, so the padding bits in the last word are exercised.
+    IDAllocator allocator(-100, 1000);
+    Vector<int> ids;
+    for (int i = -100; i <= 1000; ++i)
+        ids.append(allocator.allocate());
+    EXPECT(!allocator.try_allocate().has_value());
+    for (int i = -100; i <= 1000; ++i)
+        EXPECT(allocator.is_allocated(i));
+    EXPECT(!allocator.is_allocated(-101));
+    EXPECT(!allocator.is_allocated(1001));
+
+    for (size_t i = 0; i < ids.size(); i += 2)
+        allocator.deallocate(ids[i]);
+    for (size_t i = 0; i < ids.size(); i += 2) {
+        auto id = allocator.allocate();
+        EXPECT(id >= -100 && id <= 1000);
+    }
+    EXPECT_EQ(allocator.allocated_count(), ids.size());
+    EXPECT(!allocator.try_allocate().has_value());
+}
+
+TEST_CASE(randomized_is_not_sequential)
+{
+    IDAllocator allocator(1, 1 << 20);
+    size_t sequential = 0;
+    int previous = allocator.allocate();
+    for (int i = 0; i < 100; ++i) {
+        auto id = allocator.allocate();
+        if (id == previous + 1)
+            ++sequential;
+        previous = id;
+    }
+    EXPECT(sequential < 10);
+}
+
+TEST_CASE(single_id_range)
+{
+    IDAllocator allocator(7, 7, IDAllocatorStart::Randomized, IDAllocatorConcurrency::LockFree);
+    EXPECT_EQ(allocator.allocate(), 7);
+    EXPECT(!allocator.try_allocate().has_value());
+    allocator.deallocate(7);
+    EXPECT_EQ(allocator.allocate(), 7);
+}
+
+struct ThreadContext {
+    IDAllocator* allocator { nullptr };
+    Vector<int> ids;
+};
+
+static void* allocate_and_churn(void* argument)
+{
+    auto& context = *static_cast<ThreadContext*>(argument);
+    for (size_t round = 0; round < 100; ++round) {
+        for (size_t i = 0; i < 100; ++i)
+            context.ids.append(context.allocator->allocate());
+        for (size_t i = 0; i < 50; ++i)
+            context.allocator->deallocate(context.ids.take_last());
+    }
+    return nullptr;
+}
+
+TEST_CASE(lock_free_threads_get_unique_ids)
+{
+    static constexpr size_t thread_count = 4;
+    // Each thread holds at most 5050 IDs at once, so the range is completely full at the peak.
+    IDAllocator allocator(1, thread_count * 5050, IDAllocatorStart::Randomized, IDAllocatorConcurrency::LockFree);
+
+    ThreadContext contexts[thread_count];
+    pthread_t threads[thread_count];
+    for (size_t i = 0; i < thread_count; ++i) {
+        contexts[i].allocator = &allocator;
+        pthread_create(&threads[i], nullptr, allocate_and_churn, &contexts[i]);
+    }
+    for (size_t i = 0; i < thread_count; ++i)
+        pthread_join(threads[i], nullptr);
+
+    HashTable<int> seen;
+    for (auto& context : contexts) {
+        for (auto id : context.ids) {
+            EXPECT(!seen.contains(id));
+            seen.set(id);
+        }
+    }
+    EXPECT_EQ(seen.size(), thread_count * 5000);
+    EXPECT_EQ(allocator.allocated_count(), thread_count * 5000);
+    for (size_t i = 0; i < thread_count * 50; ++i)
+        allocator.allocate();
+    EXPECT(!allocator.try_allocate().has_value());
+}
+
+static constexpr int benchmark_live_ids = 60000;
+
+template<IDAllocatorStart start>
+static void benchmark_churn_near_full()
+{
+    IDAllocator allocator(1, 0xffff, start);
+    Vector<int> ids;
+    for (int i = 0; i < benchmark_live_ids; ++i)
+        ids.append(allocator.allocate());
+    u64 seed = 0x2545f4914f6cdd1d;
+    for (size_t i = 0; i < 1'000'000; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        auto& slot = ids[(seed >> 33) % ids.size()];
+        allocator.deallocate(slot);
+        slot = allocator.allocate();
+    }
+    EXPECT_EQ(allocator.allocated_count(), static_cast<size_t>(benchmark_live_ids));
+}
+
+BENCHMARK_CASE(churn_near_full_randomized)
+{
+    benchmark_churn_near_full<IDAllocatorStart::Randomized>();
+}
+
+BENCHMARK_CASE(churn_near_full_lowest)
+{
+    benchmark_churn_near_full<IDAllocatorStart::Lowest>();
+}
+
+TEST_MAIN(IDAllocator)
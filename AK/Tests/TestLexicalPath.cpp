@@ -84,4 +84,112 @@ TEST_CASE(has_extension)
     }
 }
 
+TEST_CASE(components)
+{
+    LexicalPath path("//usr/./local/../share//man/");
+    EXPECT_EQ(path.string(), "/usr/share/man");
+    EXPECT_EQ(path.component_count(), 3u);
+    EXPECT_EQ(path.component(1), "share");
+    EXPECT_EQ(path.dirname(), "/usr/share");
+    EXPECT_EQ(path.basename(), "man");
+    EXPECT_EQ(path.title(), "man");
+    EXPECT(path.extension().is_null());
+
+    Vector<StringView> parts;
+    for (auto part : path)
+        parts.append(part);
+    EXPECT_EQ(parts, path.parts_view());
+    EXPECT_EQ(path.parts(), Vector<String>({ "usr", "share", "man" }));
+}
+
+TEST_CASE(relative_paths)
+{
+    LexicalPath path("./a/../../b/./c.tar.gz");
+    EXPECT(!path.is_absolute());
+    EXPECT_EQ(path.string(), "../b/c.tar.gz");
+    EXPECT_EQ(path.dirname(), "../b");
+    EXPECT_EQ(path.title(), "c.tar");
+    EXPECT_EQ(path.extension(), "gz");
+
+    LexicalPath single("file");
+    EXPECT_EQ(single.dirname(), "");
+    EXPECT_EQ(single.basename(), "file");
+}
+
+TEST_CASE(root)
+{
+    LexicalPath root("/");
+    EXPECT_EQ(root.string(), "/");
+    EXPECT_EQ(root.dirname(), "/");
+    EXPECT_EQ(root.basename(), "/");
+    EXPECT_EQ(root.component_count(), 0u);
+    EXPECT(!(root.begin() != root.end()));
+}
+
+TEST_CASE(canonical_strings_are_shared)
+{
+    String canonical = "/home/anon/Documents";
+    EXPECT_EQ(LexicalPath(canonical).string().impl(), canonical.impl());
+
+    String not_canonical = "/home/anon/Documents/";
+    EXPECT(LexicalPath(not_canonical).string().impl() != not_canonical.impl());
+}
+
+TEST_CASE(is_child_of)
+{
+    LexicalPath home("/home/anon");
+    EXPECT(LexicalPath("/home/anon/Documents").is_child_of(home));
+    EXPECT(LexicalPath("/home/anon/Documents/a/b").is_child_of(home));
+    EXPECT(LexicalPath("/home/anon/x").is_child_of(LexicalPath("/")));
+    EXPECT(!home.is_child_of(home));
+    EXPECT(!LexicalPath("/home/anonymous").is_child_of(home));
+    EXPECT(!LexicalPath("/home").is_child_of(home));
+    EXPECT(!LexicalPath("home/anon/x").is_child_of(home));
+}
+
+TEST_CASE(relative_path)
+{
+    EXPECT_EQ(LexicalPath::relative_path("/home/anon/Documents/x.txt", "/home/anon"), "Documents/x.txt");
+    EXPECT_EQ(LexicalPath::relative_path("/home/anon/Documents/x.txt", "/home/anon/"), "Documents/x.txt");
+    EXPECT_EQ(LexicalPath::relative_path("/etc/passwd", "/home/anon"), "/etc/passwd");
+    EXPECT(LexicalPath::relative_path("/home/anon", "/home/anon").is_null());
+    EXPECT(LexicalPath::relative_path("home/anon", "/home").is_null());
+}
+
+static Vector<String> make_benchmark_paths()
+{
+    Vector<String> paths;
+    paths.ensure_capacity(1000);
+    for (size_t i = 0; i < 1000; ++i) {
+        switch (i % 4) {
+        case 0:
+            paths.unchecked_append(String::formatted("/home/anon/Source/serenity/Userland/Libraries/LibGUI/File{}.cpp", i));
+            break;
+        case 1:
+            paths.unchecked_append(String::formatted("/usr/share/man/man{}/page{}.md", i % 8, i));
+            break;
+        case 2:
+            paths.unchecked_append(String::formatted("/home/anon/Documents/../Downloads/./archive{}.tar.gz", i));
+            break;
+        default:
+            paths.unchecked_append(String::formatted("/res/icons/16x16//filetype-{}.png", i));
+            break;
+        }
+    }
+    return paths;
+}
+
+BENCHMARK_CASE(canonicalize_paths)
+{
+    auto paths = make_benchmark_paths();
+    size_t total_length = 0;
+    for (size_t round = 0; round < 1000; ++round) {
+        for (auto& path : paths) {
+            LexicalPath lexical_path(path);
+            total_length += lexical_path.string().length() + lexical_path.dirname().length() + lexical_path.basename().length() + lexical_path.extension().length();
+        }
+    }
+    EXPECT(total_length > 0);
+}
+
 TEST_MAIN(LexicalPath)
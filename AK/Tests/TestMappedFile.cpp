@@ -0,0 +1,246 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/ByteBuffer.h>
+#include <AK/MappedFile.h>
+#include <AK/String.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static String create_temporary_file(ReadonlyBytes contents)
+{
+    char path[] = "/tmp/TestMappedFile.XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT(fd >= 0);
+    EXPECT_EQ(write(fd, contents.data(), contents.size()), static_cast<ssize_t>(contents.size()));
+    close(fd);
+    return path;
+}
+
+static ByteBuffer make_test_data(size_t size)
+{
+    auto data = ByteBuffer::create_uninitialized(size);
+    for (size_t i = 0; i < size; ++i)
+        data[i] = static_cast<u8>(i * 13);
+    return data;
+}
+
+static ByteBuffer read_file(const String& path)
+{
+    int fd = open(path.characters(), O_RDONLY);
+    EXPECT(fd >= 0);
+    auto size = lseek(fd, 0, SEEK_END);
+    auto data = ByteBuffer::create_uninitialized(size);
+    EXPECT_EQ(pread(fd, data.data(), size, 0), size);
+    close(fd);
+    return data;
+}
+
+TEST_CASE(map_whole_file)
+{
+    auto data = make_test_data(10000);
+    auto path = create_temporary_file(data);
+
+    auto file_or_error = MappedFile::map(path);
+    EXPECT(!file_or_error.is_error());
+    auto file = file_or_error.release_value();
+    EXPECT_EQ(file->size(), data.size());
+    EXPECT_EQ(file->mode(), MappedFile::Mode::ReadOnly);
+    EXPECT(file->bytes() == data.bytes());
+    unlink(path.characters());
+}
+
+TEST_CASE(map_range)
+{
+    auto data = make_test_data(3 * PAGE_SIZE);
+    auto path = create_temporary_file(data);
+
+    MappedFile::Options options;
+    options.offset = PAGE_SIZE + 123;
+    options.size = 1000;
+    options.advice = MappedFile::Advice::Random;
+    auto file = MappedFile::map(path, options).release_value();
+    EXPECT_EQ(file->size(), 1000u);
+    EXPECT_EQ(file->offset(), static_cast<off_t>(PAGE_SIZE + 123));
+    EXPECT(file->bytes() == data.bytes().slice(PAGE_SIZE + 123, 1000));
+
+    // Everything up to the end of the file.
+    options.size = {};
+    options.populate = true;
+    file = MappedFile::map(path, options).release_value();
+    EXPECT(file->bytes() == data.bytes().slice(PAGE_SIZE + 123));
+    EXPECT(!file->advise(MappedFile::Advice::Sequential, 10, 100).is_error());
+
+    // Ranges past the end of the file are rejected instead of faulting later.
+    options.size = 2 * PAGE_SIZE;
+    EXPECT_EQ(MappedFile::map(path, options).error().error(), EINVAL);
+    options.offset = 4 * PAGE_SIZE;
+    options.size = {};
+    EXPECT_EQ(MappedFile::map(path, options).error().error(), EINVAL);
+
+    EXPECT_EQ(MappedFile::map("/tmp/TestMappedFile.does-not-exist").error().error(), ENOENT);
+    unlink(path.characters());
+}
+
+TEST_CASE(read_write_and_sync)
+{
+    auto data = make_test_data(2 * PAGE_SIZE);
+    auto path = create_temporary_file(data);
+
+    MappedFile::Options options;
+    options.mode = MappedFile::Mode::ReadWrite;
+    options.offset = 100;
+    options.size = PAGE_SIZE;
+    auto file = MappedFile::map(path, options).release_value();
+    auto bytes = file->writable_bytes();
+    for (size_t i = 0; i < bytes.size(); ++i)
+        bytes[i] = ~bytes[i];
+    EXPECT(!file->sync().is_error());
+    EXPECT(!file->sync(MappedFile::SyncMode::Asynchronous, 10, 20).is_error());
+
+    for (size_t i = 100; i < 100 + static_cast<size_t>(PAGE_SIZE); ++i)
+        data[i] = ~data[i];
+    EXPECT(read_file(path) == data);
+    unlink(path.characters());
+}
+
+TEST_CASE(create_and_grow)
+{
+    char path[] = "/tmp/TestMappedFile.XXXXXX";
+    EXPECT(mkdtemp(path));
+    auto file_path = String::formatted("{}/grown", path);
+
+    MappedFile::Options options;
+    options.mode = MappedFile::Mode::ReadWrite;
+    options.create = true;
+    options.advice = MappedFile::Advice::Sequential;
+    auto file = MappedFile::map(file_path, options).release_value();
+    EXPECT_EQ(file->size(), 0u);
+
+    auto data = make_test_data(1000000);
+    size_t written = 0;
+    for (size_t chunk_size = 1000; written < data.size(); chunk_size *= 3) {
+        auto chunk = data.bytes().slice(written, min(chunk_size, data.size() - written));
+        EXPECT(!file->grow(written + chunk.size()).is_error());
+        chunk.copy_to(file->writable_bytes().slice(written));
+        written += chunk.size();
+    }
+    EXPECT(file->bytes() == data.bytes());
+
+    // Shrinking is not a thing.
+    EXPECT(!file->grow(10).is_error());
+    EXPECT_EQ(file->size(), data.size());
+
+    EXPECT(!file->sync().is_error());
+    EXPECT(read_file(file_path) == data);
+    unlink(file_path.characters());
+    rmdir(path);
+}
+
+static constexpr size_t benchmark_file_size = 256 * MiB;
+
+static const String& benchmark_path()
+{
+    static String path;
+    if (path.is_null()) {
+        char name[] = "/tmp/TestMappedFile.XXXXXX";
+        int fd = mkstemp(name);
+        EXPECT(fd >= 0);
+        EXPECT_EQ(ftruncate(fd, benchmark_file_size), 0);
+        auto block = make_test_data(MiB);
+        for (size_t offset = 0; offset < benchmark_file_size; offset += block.size())
+            EXPECT_EQ(pwrite(fd, block.data(), block.size(), offset), static_cast<ssize_t>(block.size()));
+        fsync(fd);
+        close(fd);
+        path = name;
+    }
+    return path;
+}
+
+// Evict the file from the page cache, so the advice actually has disk reads to shape.
+static void drop_cached_pages()
+{
+#ifdef POSIX_FADV_DONTNEED
+    int fd = open(benchmark_path().characters(), O_RDONLY);
+    EXPECT(fd >= 0);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+#endif
+}
+
+static void benchmark_sequential_scan(MappedFile::Advice advice, bool populate = false)
+{
+    drop_cached_pages();
+    MappedFile::Options options;
+    options.advice = advice;
+    options.populate = populate;
+    auto file = MappedFile::map(benchmark_path(), options).release_value();
+
+    // One byte per cache line, so this measures paging rather than memory bandwidth.
+    auto* data = static_cast<const u8*>(file->data());
+    u64 checksum = 0;
+    for (size_t i = 0; i < file->size(); i += 64)
+        checksum += data[i];
+    EXPECT(checksum > 0);
+}
+
+BENCHMARK_CASE(create_benchmark_file)
+{
+    EXPECT(!benchmark_path().is_null());
+}
+
+BENCHMARK_CASE(sequential_scan_normal)
+{
+    benchmark_sequential_scan(MappedFile::Advice::Normal);
+}
+
+BENCHMARK_CASE(sequential_scan_sequential)
+{
+    benchmark_sequential_scan(MappedFile::Advice::Sequential);
+}
+
+BENCHMARK_CASE(sequential_scan_random)
+{
+    benchmark_sequential_scan(MappedFile::Advice::Random);
+}
+
+BENCHMARK_CASE(sequential_scan_willneed)
+{
+    benchmark_sequential_scan(MappedFile::Advice::WillNeed);
+}
+
+BENCHMARK_CASE(sequential_scan_populate)
+{
+    benchmark_sequential_scan(MappedFile::Advice::Normal, true);
+}
+
+BENCHMARK_CASE(remove_benchmark_file)
+{
+    EXPECT_EQ(unlink(benchmark_path().characters()), 0);
+}
+
+TEST_MAIN(MappedFile)
@@ -209,7 +209,7 @@ TEST_CASE(offset_of_out_of_bounds)
 {
     Array<u8, 4> target { 0xff, 0xff, 0xff, 0xff };
 
-    Array<u8, DuplexMemoryStream::chunk_size> whole_chunk;
+    Array<u8, DuplexMemoryStream::default_chunk_size> whole_chunk;
     whole_chunk.span().fill(0);
 
     DuplexMemoryStream stream;
@@ -221,7 +221,7 @@ TEST_CASE(offset_of_out_of_bounds)
 
 TEST_CASE(unsigned_integer_underflow_regression)
 {
-    Array<u8, DuplexMemoryStream::chunk_size + 1> buffer;
+    Array<u8, DuplexMemoryStream::default_chunk_size + 1> buffer;
 
     DuplexMemoryStream stream;
     stream << buffer;
@@ -229,7 +229,7 @@ TEST_CASE(unsigned_integer_underflow_regression)
 
 TEST_CASE(offset_calculation_error_regression)
 {
-    Array<u8, DuplexMemoryStream::chunk_size> input, output;
+    Array<u8, DuplexMemoryStream::default_chunk_size> input, output;
     input.span().fill(0xff);
 
     DuplexMemoryStream stream;
@@ -241,4 +241,136 @@ TEST_CASE(offset_calculation_error_regression)
     EXPECT_EQ(input, output);
 }
 
+TEST_CASE(vectored_read_and_write)
+{
+    Array<u8, 4> first { 1, 2, 3, 4 };
+    Array<u8, 2> second { 5, 6 };
+    ReadonlyBytes input_spans[] = { first, second };
+
+    DuplexMemoryStream stream;
+    EXPECT(stream.write_vectored_or_error(input_spans));
+    EXPECT_EQ(stream.size(), 6u);
+
+    Array<u8, 3> head, tail;
+    Bytes output_spans[] = { head, tail };
+    EXPECT_EQ(stream.read_vectored(output_spans), 6u);
+    EXPECT_EQ(head, (Array<u8, 3> { 1, 2, 3 }));
+    EXPECT_EQ(tail[0], 4);
+    EXPECT_EQ(tail[1], 5);
+    EXPECT_EQ(tail[2], 6);
+    EXPECT(stream.eof());
+}
+
+TEST_CASE(copy_duplex_stream_without_intermediate_buffer)
+{
+    Array<u8, DuplexMemoryStream::default_chunk_size * 2 + 100> data;
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<u8>(i);
+
+    DuplexMemoryStream input;
+    input << data;
+    input.discard_or_error(10);
+    EXPECT_EQ(input.readable_spans().size(), 3u);
+
+    Array<u8, data.size()> output_buffer;
+    OutputMemoryStream output { output_buffer };
+    EXPECT_EQ(copy_stream(input, output), data.size() - 10);
+    EXPECT(input.eof());
+    EXPECT(output.bytes() == data.span().slice(10));
+}
+
+TEST_CASE(duplex_chunks_are_reused)
+{
+    Array<u8, DuplexMemoryStream::default_chunk_size> data;
+    DuplexMemoryStream stream;
+
+    stream << data;
+    auto* first_chunk = stream.peek_chunk().data();
+    stream >> data;
+    EXPECT(stream.eof());
+
+    stream << data;
+    EXPECT_EQ(stream.peek_chunk().data(), first_chunk);
+}
+
+TEST_CASE(duplex_custom_chunk_size)
+{
+    DuplexMemoryStream stream { 7 };
+    EXPECT_EQ(stream.chunk_size(), 7u);
+    stream << "Well, hello friends!"sv.bytes();
+    EXPECT_EQ(stream.readable_spans().size(), 3u);
+    EXPECT_EQ(stream.offset_of("friends"sv.bytes()).value(), 12u);
+    EXPECT(!stream.offset_of("friendz"sv.bytes()).has_value());
+
+    stream.discard_or_error(6);
+    EXPECT(stream.peek_chunk() == "h"sv.bytes());
+    EXPECT_EQ(stream.offset_of("hello"sv.bytes()).value(), 0u);
+    EXPECT_EQ(stream.offset_of({}).value(), 0u);
+
+    // Long needles take a different path.
+    stream << " Nice to see you all here again today."sv.bytes();
+    EXPECT_EQ(stream.offset_of("friends! Nice to see you all here again"sv.bytes()).value(), 6u);
+    EXPECT(!stream.offset_of("friends! Nice to see you all here again!"sv.bytes()).has_value());
+}
+
+TEST_CASE(duplex_chunk_handoff)
+{
+    DuplexMemoryStream source { 8 };
+    source << "0123456789abcdefXYZ"sv.bytes();
+    source.discard_or_error(2);
+
+    // A partially read chunk is handed over without the bytes that were read.
+    auto chunk = source.take_chunk();
+    EXPECT(chunk.has_value());
+    EXPECT(chunk->bytes() == "234567"sv.bytes());
+    EXPECT_EQ(source.size(), 11u);
+
+    DuplexMemoryStream destination;
+    destination << "->"sv.bytes();
+    destination.append_chunk(chunk.release_value());
+    auto* moved_chunk = source.peek_chunk().data();
+    EXPECT_EQ(copy_stream(source, destination), 11u);
+    EXPECT(source.eof());
+    EXPECT(!source.take_chunk().has_value());
+    destination << "!"sv.bytes();
+
+    EXPECT_EQ(destination.readable_spans().size(), 5u);
+    EXPECT_EQ(destination.readable_spans()[2].data(), moved_chunk);
+    auto contents = destination.copy_into_contiguous_buffer();
+    EXPECT_EQ(StringView { contents.bytes() }, "->23456789abcdefXYZ!");
+    EXPECT_EQ(destination.offset_of("7890"sv.bytes()), Optional<size_t> {});
+    EXPECT_EQ(destination.offset_of("789a"sv.bytes()).value(), 7u);
+}
+
+BENCHMARK_CASE(duplex_write_read_ping_pong)
+{
+    Array<u8, 1500> packet;
+    packet.span().fill(1);
+    DuplexMemoryStream stream;
+    size_t total = 0;
+    for (size_t i = 0; i < 1'000'000; ++i) {
+        stream << packet << packet;
+        stream >> packet;
+        total += packet[0];
+        stream >> packet;
+    }
+    EXPECT_EQ(total, 1'000'000u);
+}
+
+BENCHMARK_CASE(duplex_offset_of)
+{
+    // A response body being searched for its terminator, which is only at the very end.
+    Array<u8, 1000> line;
+    line.span().fill('x');
+    DuplexMemoryStream stream;
+    for (size_t i = 0; i < 100; ++i)
+        stream << line;
+    stream << "\r\n"sv.bytes();
+
+    size_t found = 0;
+    for (size_t i = 0; i < 10'000; ++i)
+        found += stream.offset_of("\r\n"sv.bytes()).value();
+    EXPECT_EQ(found, 100'000u * 10'000);
+}
+
 TEST_MAIN(MemoryStream)
@@ -0,0 +1,306 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/QuickSort.h>
+#include <AK/RadixSort.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+
+static u64 s_seed = 0x2545f4914f6cdd1d;
+
+static u64 next_random()
+{
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 7;
+    s_seed ^= s_seed << 17;
+    return s_seed;
+}
+
+template<typename T>
+static Vector<T> make_random_vector(size_t size)
+{
+    Vector<T> values;
+    values.ensure_capacity(size);
+    for (size_t i = 0; i < size; ++i)
+        values.unchecked_append(static_cast<T>(next_random()));
+    return values;
+}
+
+template<typename T>
+static bool is_sorted(const Vector<T>& values)
+{
+    for (size_t i = 1; i < values.size(); ++i) {
+        if (values[i] < values[i - 1])
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE(sorts_unsigned_integers)
+{
+    auto bytes = make_random_vector<u8>(1000);
+    radix_sort(bytes.span());
+    EXPECT(is_sorted(bytes));
+
+    auto shorts = make_random_vector<u16>(1000);
+    radix_sort(shorts.span());
+    EXPECT(is_sorted(shorts));
+
+    auto ints = make_random_vector<u32>(1000);
+    radix_sort(ints.span());
+    EXPECT(is_sorted(ints));
+
+    auto longs = make_random_vector<u64>(1000);
+    radix_sort(longs.span());
+    EXPECT(is_sorted(longs));
+}
+
+TEST_CASE(sorts_signed_integers)
+{
+    auto ints = make_random_vector<i32>(1000);
+    ints.append(NumericLimits<i32>::min());
+    ints.append(NumericLimits<i32>::max());
+    ints.append(0);
+    ints.append(-1);
+    radix_sort(ints.span());
+    EXPECT(is_sorted(ints));
+    EXPECT_EQ(ints.first(), NumericLimits<i32>::min());
+    EXPECT_EQ(ints.last(), NumericLimits<i32>::max());
+
+    auto longs = make_random_vector<i64>(1000);
+    radix_sort(longs.span());
+    EXPECT(is_sorted(longs));
+}
+
+TEST_CASE(sorts_floating_point)
+{
+    Vector<float> floats { 3.5f, -0.25f, 0.0f, -100.0f, 1e10f, -1e-10f, 42.0f, -3.5f };
+    radix_sort(floats.span());
+    EXPECT(is_sorted(floats));
+    EXPECT_EQ(floats.first(), -100.0f);
+    EXPECT_EQ(floats.last(), 1e10f);
+
+    Vector<double> doubles;
+    for (size_t i = 0; i < 1000; ++i)
+        doubles.append(static_cast<double>(static_cast<i64>(next_random())) / 1e6);
+    radix_sort(doubles.span());
+    EXPECT(is_sorted(doubles));
+}
+
+TEST_CASE(skips_passes_with_a_shared_byte)
+{
+    // All keys share their upper bytes; the result must still be fully sorted.
+    Vector<u64> values;
+    for (size_t i = 0; i < 1000; ++i)
+        values.append(0x1122334455000000ull | (next_random() & 0xffffff));
+    radix_sort(values.span());
+    EXPECT(is_sorted(values));
+
+    Vector<u32> equal;
+    equal.resize(100);
+    for (auto& value : equal)
+        value = 7;
+    radix_sort(equal.span());
+    for (auto value : equal)
+        EXPECT_EQ(value, 7u);
+}
+
+TEST_CASE(sorts_by_projection_and_is_stable)
+{
+    struct Entry {
+        String name;
+        u64 size;
+        size_t original_position;
+    };
+
+    Vector<Entry> entries;
+    for (size_t i = 0; i < 500; ++i)
+        entries.append({ String::number(i), next_random() % 16, i });
+
+    radix_sort(entries.span(), [](const Entry& entry) { return entry.size; });
+
+    for (size_t i = 1; i < entries.size(); ++i) {
+        EXPECT(entries[i - 1].size <= entries[i].size);
+        if (entries[i - 1].size == entries[i].size)
+            EXPECT(entries[i - 1].original_position < entries[i].original_position);
+        EXPECT_EQ(entries[i].name, String::number(entries[i].original_position));
+    }
+}
+
+TEST_CASE(sorts_with_caller_provided_scratch)
+{
+    auto values = make_random_vector<i16>(1000);
+    Vector<i16> scratch;
+    scratch.resize(values.size());
+    radix_sort(values.span(), scratch.span(), [](i16 value) { return value; });
+    EXPECT(is_sorted(values));
+}
+
+TEST_CASE(sorts_with_parallel_histograms)
+{
+    auto values = make_random_vector<u32>(1 << 18);
+    radix_sort(values.span(), RadixSortHistogram::Parallel);
+    EXPECT(is_sorted(values));
+
+    auto floats = make_random_vector<i64>(1 << 18);
+    radix_sort(floats.span(), [](i64 value) { return static_cast<double>(value); }, RadixSortHistogram::Parallel);
+    EXPECT(is_sorted(floats));
+}
+
+TEST_CASE(sorts_strings)
+{
+    Vector<String> strings { "banana", "apple", "", "cherry", "app", "apple", "b", "Banana", "applesauce" };
+    radix_sort(strings.span());
+    EXPECT(is_sorted(strings));
+    EXPECT_EQ(strings.first(), "");
+    EXPECT_EQ(strings.last(), "cherry");
+
+    // Enough strings sharing long prefixes to exercise the MSD buckets.
+    Vector<String> paths;
+    for (size_t i = 0; i < 2000; ++i)
+        paths.append(String::formatted("/usr/share/res/icons/{}/{}.png", next_random() % 7, next_random() % 1000));
+    radix_sort(paths.span());
+    EXPECT(is_sorted(paths));
+}
+
+TEST_CASE(sorts_string_views)
+{
+    Vector<String> storage;
+    for (size_t i = 0; i < 1000; ++i)
+        storage.append(String::number(next_random() % 100000));
+
+    Vector<StringView> views;
+    for (auto& string : storage)
+        views.append(string);
+    radix_sort(views.span());
+    EXPECT(is_sorted(views));
+}
+
+TEST_CASE(sorts_by_string_projection)
+{
+    struct Bookmark {
+        String title;
+        int id;
+    };
+
+    Vector<Bookmark> bookmarks;
+    for (int i = 0; i < 300; ++i)
+        bookmarks.append({ String::formatted("site-{}", next_random() % 50), i });
+
+    // Returning the key by value must not leave dangling views behind.
+    radix_sort(bookmarks.span(), [](const Bookmark& bookmark) { return String::formatted("{}", bookmark.title); });
+
+    for (size_t i = 1; i < bookmarks.size(); ++i) {
+        EXPECT(!(bookmarks[i].title < bookmarks[i - 1].title));
+        if (bookmarks[i].title == bookmarks[i - 1].title)
+            EXPECT(bookmarks[i - 1].id < bookmarks[i].id);
+    }
+}
+
+// Each size is benchmarked as a radix_sort/quick_sort pair over identical input.
+// 10^8 elements is left out since the scratch buffer alone would not fit in
+// the default VM memory.
+template<typename T>
+static Vector<T> make_benchmark_input(size_t size)
+{
+    s_seed = 0x2545f4914f6cdd1d;
+    return make_random_vector<T>(size);
+}
+
+BENCHMARK_CASE(radix_sort_u32_1m)
+{
+    auto values = make_benchmark_input<u32>(1'000'000);
+    radix_sort(values.span());
+    EXPECT(is_sorted(values));
+}
+
+BENCHMARK_CASE(quick_sort_u32_1m)
+{
+    auto values = make_benchmark_input<u32>(1'000'000);
+    quick_sort(values);
+    EXPECT(is_sorted(values));
+}
+
+BENCHMARK_CASE(radix_sort_u64_1m)
+{
+    auto values = make_benchmark_input<u64>(1'000'000);
+    radix_sort(values.span());
+    EXPECT(is_sorted(values));
+}
+
+BENCHMARK_CASE(quick_sort_u64_1m)
+{
+    auto values = make_benchmark_input<u64>(1'000'000);
+    quick_sort(values);
+    EXPECT(is_sorted(values));
+}
+
+BENCHMARK_CASE(radix_sort_u32_10m)
+{
+    auto values = make_benchmark_input<u32>(10'000'000);
+    radix_sort(values.span());
+    EXPECT(is_sorted(values));
+}
+
+BENCHMARK_CASE(radix_sort_u32_10m_parallel_histogram)
+{
+    auto values = make_benchmark_input<u32>(10'000'000);
+    radix_sort(values.span(), RadixSortHistogram::Parallel);
+    EXPECT(is_sorted(values));
+}
+
+BENCHMARK_CASE(quick_sort_u32_10m)
+{
+    auto values = make_benchmark_input<u32>(10'000'000);
+    quick_sort(values);
+    EXPECT(is_sorted(values));
+}
+
+static Vector<String> make_benchmark_strings(size_t size)
+{
+    s_seed = 0x2545f4914f6cdd1d;
+    Vector<String> strings;
+    strings.ensure_capacity(size);
+    for (size_t i = 0; i < size; ++i)
+        strings.unchecked_append(String::number(next_random()));
+    return strings;
+}
+
+BENCHMARK_CASE(radix_sort_strings_1m)
+{
+    auto strings = make_benchmark_strings(1'000'000);
+    radix_sort(strings.span());
+    EXPECT(is_sorted(strings));
+}
+
+BENCHMARK_CASE(quick_sort_strings_1m)
+{
+    auto strings = make_benchmark_strings(1'000'000);
+    quick_sort(strings);
+    EXPECT(is_sorted(strings));
+}
+
+TEST_MAIN(RadixSort)
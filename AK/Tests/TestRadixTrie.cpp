@@ -0,0 +1,242 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/RadixTrie.h>
+#include <AK/RefCounted.h>
+#include <AK/RefPtr.h>
+#include <AK/String.h>
+#include <AK/Trie.h>
+
+TEST_CASE(set_and_get)
+{
+    RadixTrie<int> trie;
+    EXPECT(trie.is_empty());
+    EXPECT(trie.set("test", 1));
+    EXPECT(trie.set("team", 2));
+    EXPECT(trie.set("te", 3));
+    EXPECT(trie.set("toast", 4));
+    EXPECT(trie.set("", 5));
+    EXPECT(!trie.set("team", 6));
+    EXPECT_EQ(trie.size(), 5u);
+
+    EXPECT_EQ(trie.get("test").value(), 1);
+    EXPECT_EQ(trie.get("team").value(), 6);
+    EXPECT_EQ(trie.get("te").value(), 3);
+    EXPECT_EQ(trie.get("toast").value(), 4);
+    EXPECT_EQ(trie.get("").value(), 5);
+    EXPECT(!trie.get("t").has_value());
+    EXPECT(!trie.get("tes").has_value());
+    EXPECT(!trie.get("tests").has_value());
+    EXPECT(!trie.contains("toaster"));
+}
+
+TEST_CASE(edges_are_compressed)
+{
+    RadixTrie<int> trie;
+    trie.set("https://serenityos.org/", 1);
+    // Root plus a single leaf: the whole key is one edge.
+    EXPECT_EQ(trie.node_count(), 2u);
+
+    trie.set("https://github.com/", 2);
+    // The shared "https://" prefix becomes one node with two children.
+    EXPECT_EQ(trie.node_count(), 4u);
+}
+
+TEST_CASE(wide_nodes)
+{
+    RadixTrie<int> trie;
+    for (int i = 0; i < 256; ++i) {
+        char key[2] = { static_cast<char>(255 - i), 'x' };
+        trie.set(StringView(key, 2), i);
+    }
+    EXPECT_EQ(trie.size(), 256u);
+    for (int i = 0; i < 256; ++i) {
+        char key[2] = { static_cast<char>(255 - i), 'x' };
+        EXPECT_EQ(trie.get(StringView(key, 2)).value(), i);
+    }
+
+    // Children are visited in byte order even after spilling out of the inline array.
+    int previous = 256;
+    trie.for_each_with_prefix("", [&](auto&, int value) {
+        EXPECT(value < previous);
+        previous = value;
+        return IterationDecision::Continue;
+    });
+    EXPECT_EQ(previous, 0);
+}
+
+TEST_CASE(prefix_enumeration)
+{
+    RadixTrie<String> trie;
+    for (auto* command : { "ls", "less", "let", "ln", "lsblk", "cat", "cal" })
+        trie.set(command, command);
+
+    Vector<String> keys;
+    trie.for_each_with_prefix("l", [&](auto& key, auto& value) {
+        EXPECT_EQ(key, value);
+        keys.append(key);
+        return IterationDecision::Continue;
+    });
+    EXPECT_EQ(keys.size(), 5u);
+    EXPECT_EQ(keys[0], "less");
+    EXPECT_EQ(keys[1], "let");
+    EXPECT_EQ(keys[2], "ln");
+    EXPECT_EQ(keys[3], "ls");
+    EXPECT_EQ(keys[4], "lsblk");
+
+    // A prefix ending in the middle of an edge.
+    auto values = trie.values_with_prefix("lsb");
+    EXPECT_EQ(values.size(), 1u);
+    EXPECT_EQ(values[0], "lsblk");
+
+    EXPECT(trie.values_with_prefix("x").is_empty());
+    EXPECT(trie.values_with_prefix("lsblkx").is_empty());
+    EXPECT_EQ(trie.values_with_prefix("").size(), 7u);
+
+    size_t visited = 0;
+    trie.for_each_with_prefix("ca", [&](auto&, auto&) {
+        ++visited;
+        return IterationDecision::Break;
+    });
+    EXPECT_EQ(visited, 1u);
+}
+
+TEST_CASE(longest_prefix_and_remove)
+{
+    RadixTrie<int> trie;
+    trie.set("https://", 1);
+    trie.set("https://serenityos.org/", 2);
+    trie.set("https://serenityos.org/happy/", 3);
+
+    EXPECT_EQ(trie.longest_prefix_of("https://serenityos.org/happy/1st/").value(), 3);
+    EXPECT_EQ(trie.longest_prefix_of("https://serenityos.org/faq").value(), 2);
+    EXPECT_EQ(trie.longest_prefix_of("https://example.com/").value(), 1);
+    EXPECT(!trie.longest_prefix_of("http://").has_value());
+
+    EXPECT(trie.remove("https://serenityos.org/"));
+    EXPECT(!trie.remove("https://serenityos.org/"));
+    EXPECT_EQ(trie.size(), 2u);
+    EXPECT(!trie.contains("https://serenityos.org/"));
+    EXPECT_EQ(trie.longest_prefix_of("https://serenityos.org/faq").value(), 1);
+    EXPECT_EQ(trie.get("https://serenityos.org/happy/").value(), 3);
+
+    trie.clear();
+    EXPECT(trie.is_empty());
+    EXPECT(!trie.contains("https://"));
+}
+
+struct Counted : public RefCounted<Counted> {
+};
+
+TEST_CASE(remove_destroys_value_and_reuses_slot)
+{
+    auto value = adopt(*new Counted);
+    RadixTrie<RefPtr<Counted>> trie;
+    trie.set("key", value);
+    EXPECT_EQ(value->ref_count(), 2u);
+    EXPECT(trie.remove("key"));
+    EXPECT_EQ(value->ref_count(), 1u);
+
+    EXPECT(trie.set("key", value));
+    auto memory_usage = trie.memory_usage();
+    for (size_t i = 0; i < 10'000; ++i) {
+        EXPECT(trie.remove("key"));
+        EXPECT(trie.set("key", value));
+        EXPECT(!trie.set("key", value));
+    }
+    EXPECT_EQ(trie.memory_usage(), memory_usage);
+    EXPECT_EQ(trie.size(), 1u);
+    EXPECT_EQ(value->ref_count(), 2u);
+}
+
+static Vector<String> make_benchmark_keys()
+{
+    u64 seed = 0x853c49e6748fea9b;
+    Vector<String> keys;
+    for (size_t i = 0; i < 100'000; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        keys.append(String::formatted("https://site{}.example.com/path/{}/{}", (seed >> 33) % 500, (seed >> 20) % 100, i));
+    }
+    return keys;
+}
+
+BENCHMARK_CASE(radix_trie_insert_and_lookup)
+{
+    auto keys = make_benchmark_keys();
+    RadixTrie<size_t> trie;
+    for (size_t i = 0; i < keys.size(); ++i)
+        trie.set(keys[i], i);
+
+    size_t found = 0;
+    for (size_t round = 0; round < 10; ++round) {
+        for (auto& key : keys)
+            found += trie.contains(key);
+    }
+    EXPECT_EQ(found, keys.size() * 10);
+    outln("RadixTrie: {} nodes, {} bytes per key", trie.node_count(), trie.memory_usage() / keys.size());
+}
+
+BENCHMARK_CASE(trie_insert_and_lookup)
+{
+    auto keys = make_benchmark_keys();
+    Trie<char, size_t> trie('/', 0);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        auto view = keys[i].view();
+        trie.insert(view.begin(), view.end(), i, [](auto&, auto&) -> Optional<size_t> { return {}; });
+    }
+
+    size_t found = 0;
+    for (size_t round = 0; round < 10; ++round) {
+        for (auto& key : keys) {
+            auto view = key.view();
+            auto it = view.begin();
+            auto& node = trie.traverse_until_last_accessible_node(it, view.end());
+            found += it.is_end() && node.metadata().has_value();
+        }
+    }
+    EXPECT_EQ(found, keys.size() * 10);
+
+    // This is a lower bound: it does not count the HashMap bucket storage.
+    size_t node_count = 0;
+    for ([[maybe_unused]] auto& node : trie)
+        ++node_count;
+    outln("Trie: {} nodes, at least {} bytes per key", node_count, node_count * sizeof(trie) / keys.size());
+}
+
+BENCHMARK_CASE(radix_trie_prefix_enumeration)
+{
+    auto keys = make_benchmark_keys();
+    RadixTrie<size_t> trie;
+    for (size_t i = 0; i < keys.size(); ++i)
+        trie.set(keys[i], i);
+
+    size_t total = 0;
+    for (size_t site = 0; site < 500; ++site)
+        total += trie.values_with_prefix(String::formatted("https://site{}.", site)).size();
+    EXPECT_EQ(total, keys.size());
+}
+
+TEST_MAIN(RadixTrie)
@@ -0,0 +1,253 @@
+/*
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/BinarySearch.h>
+#include <AK/QuickSort.h>
+#include <AK/SortedIndex.h>
+#include <AK/Vector.h>
+
+static u64 s_seed = 0x9e3779b97f4a7c15;
+
+static u64 next_random()
+{
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 7;
+    s_seed ^= s_seed << 17;
+    return s_seed;
+}
+
+template<typename T>
+static Vector<T> make_sorted_values(size_t size, u64 modulus)
+{
+    Vector<T> values;
+    for (size_t i = 0; i < size; ++i)
+        values.append(static_cast<T>(next_random() % modulus));
+    quick_sort(values);
+    return values;
+}
+
+template<typename T>
+static size_t naive_lower_bound(const Vector<T>& values, T value)
+{
+    size_t i = 0;
+    while (i < values.size() && values[i] < value)
+        ++i;
+    return i;
+}
+
+template<typename T>
+static size_t naive_upper_bound(const Vector<T>& values, T value)
+{
+    size_t i = 0;
+    while (i < values.size() && !(value < values[i]))
+        ++i;
+    return i;
+}
+
+template<typename T, SortedIndexLayout layout>
+static void check_against_naive_search(size_t size, u64 modulus)
+{
+    auto values = make_sorted_values<T>(size, modulus);
+    SortedIndex<T, layout> index(values.span());
+    EXPECT_EQ(index.size(), size);
+
+    for (u64 probe = 0; probe <= modulus + 1; ++probe) {
+        auto value = static_cast<T>(probe);
+        auto lower = naive_lower_bound(values, value);
+        EXPECT_EQ(index.lower_bound(value), lower);
+        EXPECT_EQ(index.upper_bound(value), naive_upper_bound(values, value));
+
+        auto found = index.find(value);
+        if (lower < values.size() && values[lower] == value) {
+            EXPECT(found.has_value());
+            EXPECT_EQ(found.value(), lower);
+        } else {
+            EXPECT(!found.has_value());
+        }
+    }
+}
+
+TEST_CASE(empty_index)
+{
+    Vector<u32> values;
+    SortedIndex<u32> eytzinger(values.span());
+    EXPECT_EQ(eytzinger.lower_bound(5), 0u);
+    EXPECT(!eytzinger.find(5).has_value());
+
+    SortedIndex<u32, SortedIndexLayout::BTree> btree(values.span());
+    EXPECT_EQ(btree.upper_bound(5), 0u);
+    EXPECT(!btree.find(5).has_value());
+}
+
+TEST_CASE(eytzinger_matches_naive_search)
+{
+    for (size_t size : { 1, 2, 3, 15, 16, 17, 100, 1000 }) {
+        check_against_naive_search<u32, SortedIndexLayout::Eytzinger>(size, size * 2);
+        check_against_naive_search<i64, SortedIndexLayout::Eytzinger>(size, size / 2 + 1);
+    }
+}
+
+TEST_CASE(btree_matches_naive_search)
+{
+    for (size_t size : { 1, 2, 15, 16, 17, 272, 273, 1000, 5000 }) {
+        check_against_naive_search<u32, SortedIndexLayout::BTree>(size, size * 2);
+        check_against_naive_search<u64, SortedIndexLayout::BTree>(size, size / 2 + 1);
+        check_against_naive_search<u8, SortedIndexLayout::BTree>(size, 250);
+    }
+}
+
+TEST_CASE(btree_padding_is_never_found)
+{
+    Vector<u32> values { 1, 2, 3 };
+    SortedIndex<u32, SortedIndexLayout::BTree> index(values.span());
+    EXPECT_EQ(index.lower_bound(NumericLimits<u32>::max()), 3u);
+    EXPECT(!index.find(NumericLimits<u32>::max()).has_value());
+
+    values.append(NumericLimits<u32>::max());
+    SortedIndex<u32, SortedIndexLayout::BTree> with_max(values.span());
+    EXPECT_EQ(with_max.find(NumericLimits<u32>::max()).value(), 3u);
+}
+
+TEST_CASE(floating_point_keys)
+{
+    Vector<double> values { -10.5, -1.0, 0.0, 0.25, 3.0, 3.0, 1e9 };
+    SortedIndex<double> eytzinger(values.span());
+    SortedIndex<double, SortedIndexLayout::BTree> btree(values.span());
+
+    EXPECT_EQ(eytzinger.lower_bound(3.0), 4u);
+    EXPECT_EQ(btree.lower_bound(3.0), 4u);
+    EXPECT_EQ(eytzinger.upper_bound(3.0), 6u);
+    EXPECT_EQ(btree.upper_bound(3.0), 6u);
+    EXPECT_EQ(eytzinger.lower_bound(-100.0), 0u);
+    EXPECT_EQ(btree.find(0.25).value(), 3u);
+    EXPECT(!btree.find(0.5).has_value());
+}
+
+TEST_CASE(move_keeps_index_usable)
+{
+    auto values = make_sorted_values<u32>(1000, 5000);
+    SortedIndex<u32, SortedIndexLayout::BTree> index(values.span());
+    auto moved = move(index);
+    for (size_t i = 0; i < values.size(); i += 37)
+        EXPECT_EQ(values[moved.lower_bound(values[i])], values[i]);
+}
+
+// Sizes are picked to fit L1, L2, L3 and main memory respectively.
+static constexpr size_t benchmark_query_count = 1'000'000;
+
+static Vector<u32> make_benchmark_values(size_t size)
+{
+    Vector<u32> values;
+    values.ensure_capacity(size);
+    for (size_t i = 0; i < size; ++i)
+        values.unchecked_append(static_cast<u32>(i * 3));
+    return values;
+}
+
+static void benchmark_binary_search(size_t size)
+{
+    auto values = make_benchmark_values(size);
+    size_t checksum = 0;
+    for (size_t i = 0; i < benchmark_query_count; ++i) {
+        size_t nearby_index = 0;
+        binary_search(values, static_cast<u32>(next_random() % (size * 3)), &nearby_index);
+        checksum += nearby_index;
+    }
+    EXPECT(checksum > 0);
+}
+
+template<SortedIndexLayout layout>
+static void benchmark_sorted_index(size_t size)
+{
+    auto values = make_benchmark_values(size);
+    SortedIndex<u32, layout> index(values.span());
+    size_t checksum = 0;
+    for (size_t i = 0; i < benchmark_query_count; ++i)
+        checksum += index.lower_bound(static_cast<u32>(next_random() % (size * 3)));
+    EXPECT(checksum > 0);
+}
+
+BENCHMARK_CASE(binary_search_4k)
+{
+    benchmark_binary_search(1 << 10);
+}
+
+BENCHMARK_CASE(eytzinger_4k)
+{
+    benchmark_sorted_index<SortedIndexLayout::Eytzinger>(1 << 10);
+}
+
+BENCHMARK_CASE(btree_4k)
+{
+    benchmark_sorted_index<SortedIndexLayout::BTree>(1 << 10);
+}
+
+BENCHMARK_CASE(binary_search_256k)
+{
+    benchmark_binary_search(1 << 16);
+}
+
+BENCHMARK_CASE(eytzinger_256k)
+{
+    benchmark_sorted_index<SortedIndexLayout::Eytzinger>(1 << 16);
+}
+
+BENCHMARK_CASE(btree_256k)
+{
+    benchmark_sorted_index<SortedIndexLayout::BTree>(1 << 16);
+}
+
+BENCHMARK_CASE(binary_search_4m)
+{
+    benchmark_binary_search(1 << 20);
+}
+
+BENCHMARK_CASE(eytzinger_4m)
+{
+    benchmark_sorted_index<SortedIndexLayout::Eytzinger>(1 << 20);
+}
+
+BENCHMARK_CASE(btree_4m)
+{
+    benchmark_sorted_index<SortedIndexLayout::BTree>(1 << 20);
+}
+
+BENCHMARK_CASE(binary_search_64m)
+{
+    benchmark_binary_search(1 << 24);
+}
+
+BENCHMARK_CASE(eytzinger_64m)
+{
+    benchmark_sorted_index<SortedIndexLayout::Eytzinger>(1 << 24);
+}
+
+BENCHMARK_CASE(btree_64m)
+{
+    benchmark_sorted_index<SortedIndexLayout::BTree>(1 << 24);
+}
+
+TEST_MAIN(SortedIndex)
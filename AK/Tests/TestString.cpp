@@ -143,6 +143,15 @@ TEST_CASE(to_uppercase)
     EXPECT(String("AbC").to_uppercase() == "ABC");
 }
 
+TEST_CASE(to_lowercase_shares_lowercase_strings)
+{
+    String lower = "already lowercase, with digits 123 and punctuation!";
+    EXPECT_EQ(lower.to_lowercase().impl(), lower.impl());
+    String mixed = "Mostly lowercase but with one capital near the End";
+    EXPECT_EQ(mixed.to_lowercase(), "mostly lowercase but with one capital near the end");
+    EXPECT_EQ(mixed.to_uppercase(), "MOSTLY LOWERCASE BUT WITH ONE CAPITAL NEAR THE END");
+}
+
 TEST_CASE(flystring)
 {
     {
@@ -26,6 +26,8 @@
 
 #include <AK/TestSuite.h>
 
+#include <AK/HashMap.h>
+#include <AK/String.h>
 #include <AK/StringUtils.h>
 
 TEST_CASE(matches_null)
@@ -286,6 +288,42 @@ TEST_CASE(contains)
     EXPECT(!AK::StringUtils::contains("", test_string, CaseSensitivity::CaseInsensitive));
     EXPECT(!AK::StringUtils::contains(test_string, "L", CaseSensitivity::CaseSensitive));
     EXPECT(!AK::StringUtils::contains(test_string, "L", CaseSensitivity::CaseInsensitive));
+
+    // A partial match must not hide one that overlaps it.
+    EXPECT(AK::StringUtils::contains("aaab", "AAB", CaseSensitivity::CaseInsensitive));
+    EXPECT(AK::StringUtils::contains("#Serenity-Dev", "-dEV", CaseSensitivity::CaseInsensitive));
+    EXPECT(!AK::StringUtils::contains("abcab", "BCAX", CaseSensitivity::CaseInsensitive));
+}
+
+TEST_CASE(equals_ignoring_case)
+{
+    EXPECT(AK::StringUtils::equals_ignoring_case("", ""));
+    EXPECT(AK::StringUtils::equals_ignoring_case("NickServ", "nickserv"));
+    EXPECT(!AK::StringUtils::equals_ignoring_case("NickServ", "nickserv2"));
+    // Only ASCII letters are folded, so these differ by the case bit but are not letters.
+    EXPECT(!AK::StringUtils::equals_ignoring_case("@", "`"));
+    EXPECT(!AK::StringUtils::equals_ignoring_case("[", "{"));
+    EXPECT(!AK::StringUtils::equals_ignoring_case("\xc9", "\xe9"));
+
+    // Long enough to go through the vector path, with a difference in each position of the tail.
+    String upper = "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789";
+    String lower = upper.to_lowercase();
+    EXPECT(AK::StringUtils::equals_ignoring_case(upper, lower));
+    EXPECT(AK::StringUtils::starts_with(upper, lower.substring_view(0, 40), CaseSensitivity::CaseInsensitive));
+    EXPECT(AK::StringUtils::ends_with(upper, lower.substring_view(10), CaseSensitivity::CaseInsensitive));
+    for (size_t i = 0; i < lower.length(); ++i) {
+        auto changed = String::formatted("{}~{}", lower.substring_view(0, i), lower.substring_view(i + 1));
+        EXPECT(!AK::StringUtils::equals_ignoring_case(upper, changed));
+    }
+}
+
+TEST_CASE(case_insensitive_hash)
+{
+    for (auto* string : { "", "a", "NickServ", "#SerenityOS", "MIXED case WITH symbols [\\]^_` AND MORE THAN 16 BYTES" }) {
+        String mixed = string;
+        EXPECT_EQ(AK::StringUtils::case_insensitive_hash(mixed), mixed.to_lowercase().hash());
+        EXPECT_EQ(AK::StringUtils::case_insensitive_hash(mixed), AK::StringUtils::case_insensitive_hash(mixed.to_uppercase()));
+    }
 }
 
 TEST_CASE(is_whitespace)
@@ -325,4 +363,69 @@ TEST_CASE(to_snakecase)
     EXPECT_EQ(AK::StringUtils::to_snakecase("FooB"), "foo_b");
 }
 
+static Vector<String> make_nicknames()
+{
+    u64 seed = 0x2545f4914f6cdd1d;
+    Vector<String> nicknames;
+    for (size_t i = 0; i < 10'000; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        nicknames.append(String::formatted("{}User_{}{}", (seed >> 40) % 2 ? "Serenity" : "serenity", seed >> 50, i));
+    }
+    return nicknames;
+}
+
+BENCHMARK_CASE(case_insensitive_hash_map)
+{
+    auto nicknames = make_nicknames();
+    HashMap<String, size_t, CaseInsensitiveStringTraits> map;
+    for (size_t i = 0; i < nicknames.size(); ++i)
+        map.set(nicknames[i], i);
+
+    size_t found = 0;
+    for (size_t round = 0; round < 100; ++round) {
+        for (auto& nickname : nicknames)
+            found += map.contains(nickname);
+    }
+    EXPECT_EQ(found, nicknames.size() * 100);
+}
+
+BENCHMARK_CASE(equals_ignoring_case)
+{
+    auto nicknames = make_nicknames();
+    Vector<String> uppercased;
+    for (auto& nickname : nicknames)
+        uppercased.append(nickname.to_uppercase());
+
+    size_t equal = 0;
+    for (size_t round = 0; round < 1000; ++round) {
+        for (size_t i = 0; i < nicknames.size(); ++i)
+            equal += AK::StringUtils::equals_ignoring_case(nicknames[i], uppercased[i]);
+    }
+    EXPECT_EQ(equal, nicknames.size() * 1000);
+}
+
+BENCHMARK_CASE(contains_ignoring_case)
+{
+    StringBuilder builder;
+    while (builder.length() < 64 * KiB)
+        builder.append("<NickServ> This nickname is registered. Please choose a different nickname. ");
+    auto text = builder.to_string();
+
+    size_t found = 0;
+    for (size_t round = 0; round < 1000; ++round)
+        found += AK::StringUtils::contains(text, "PLEASE IDENTIFY", CaseSensitivity::CaseInsensitive);
+    EXPECT_EQ(found, 0u);
+}
+
+BENCHMARK_CASE(to_lowercase_and_uppercase)
+{
+    auto nicknames = make_nicknames();
+    size_t total_length = 0;
+    for (size_t round = 0; round < 100; ++round) {
+        for (auto& nickname : nicknames)
+            total_length += nickname.to_lowercase().length() + nickname.to_uppercase().length();
+    }
+    EXPECT(total_length > 0);
+}
+
 TEST_MAIN(StringUtils)
@@ -221,4 +221,89 @@ TEST_CASE(port_int_overflow_wrap)
     EXPECT_EQ(url.is_valid(), true);
 }
 
+TEST_CASE(component_views_and_setters)
+{
+    URL url("https://serenityos.org:8443/a/b.html?x=1#top");
+    EXPECT_EQ(url.protocol_view(), "https");
+    EXPECT_EQ(url.host_view(), "serenityos.org");
+    EXPECT_EQ(url.path_view(), "/a/b.html");
+    EXPECT_EQ(url.query_view(), "x=1");
+    EXPECT_EQ(url.fragment_view(), "top");
+
+    url.set_path("/c");
+    url.set_query({});
+    EXPECT_EQ(url.to_string(), "https://serenityos.org:8443/c#top");
+    url.set_port(443);
+    url.set_host("github.com");
+    EXPECT_EQ(url.to_string(), "https://github.com/c#top");
+    EXPECT_EQ(url.fragment(), "top");
+    EXPECT(url.is_valid());
+
+    url.set_host({});
+    EXPECT(!url.is_valid());
+
+    EXPECT_EQ(URL("https://github.com/c#top"), URL("https://github.com:443/c#top"));
+    EXPECT_EQ(URL::create_with_file_protocol("/etc/passwd").to_string(), "file:///etc/passwd");
+    EXPECT_EQ(URL::create_with_data("text/plain", "hi", true).to_string(), "data:text/plain;base64,hi");
+}
+
+TEST_CASE(urlencode_and_urldecode)
+{
+    EXPECT_EQ(urlencode("plain-text_1.2~"), "plain-text_1.2~");
+    EXPECT_EQ(urlencode("a b/c?d"), "a%20b%2Fc%3Fd");
+    EXPECT_EQ(urlencode("a b/c?d", "/?"), "a%20b/c?d");
+    EXPECT_EQ(urlencode("\xff\x01"), "%FF%01");
+    EXPECT_EQ(urlencode(""), "");
+
+    EXPECT_EQ(urldecode("plain"), "plain");
+    EXPECT_EQ(urldecode("a%20b%2fc%3F"), "a b/c?");
+    EXPECT_EQ(urldecode("100%"), "100%");
+    EXPECT_EQ(urldecode("%4"), "%4");
+    EXPECT_EQ(urldecode("%%41%zz"), "%A%zz");
+    EXPECT_EQ(urldecode(""), "");
+
+    String unchanged = "Documents-2021_final.txt";
+    EXPECT_EQ(urlencode(unchanged).impl(), unchanged.impl());
+    EXPECT_EQ(urldecode(unchanged).impl(), unchanged.impl());
+}
+
+static const char* s_url_corpus[] = {
+    "http://www.serenityos.org/",
+    "https://www.serenityos.org/happy/2nd/",
+    "https://github.com/SerenityOS/serenity/blob/master/AK/URL.cpp",
+    "https://github.com/SerenityOS/serenity/pulls?q=is%3Apr+is%3Aopen+sort%3Aupdated-desc",
+    "https://en.wikipedia.org/wiki/Uniform_Resource_Locator#Syntax",
+    "https://www.google.com/search?q=serenityos&oq=serenityos&sourceid=chrome&ie=UTF-8",
+    "https://news.ycombinator.com/item?id=23646287",
+    "http://localhost:8000/index.html",
+    "https://duckduckgo.com/?q=url+parser&t=h_&ia=web",
+    "https://www.youtube.com/watch?v=dQw4w9WgXcQ&t=42s",
+    "file:///home/anon/Documents/README.md",
+    "file:///res/icons/16x16/filetype-html.png",
+    "about:blank",
+    "irc://chat.freenode.net:6667/#serenityos",
+    "gemini://gemini.circumlunar.space/docs/specification.gmi",
+    "data:text/html,%3Ch1%3EHello%2C%20World%21%3C%2Fh1%3E",
+};
+
+BENCHMARK_CASE(parse_url_corpus)
+{
+    size_t valid = 0;
+    for (size_t round = 0; round < 100'000; ++round) {
+        for (auto* string : s_url_corpus)
+            valid += URL(string).is_valid();
+    }
+    EXPECT_EQ(valid, 100'000 * (sizeof(s_url_corpus) / sizeof(s_url_corpus[0])));
+}
+
+BENCHMARK_CASE(urlencode_urldecode_corpus)
+{
+    size_t total_length = 0;
+    for (size_t round = 0; round < 100'000; ++round) {
+        for (auto* string : s_url_corpus)
+            total_length += urldecode(urlencode(string, "#$&+,/:;=?@%")).length();
+    }
+    EXPECT(total_length > 0);
+}
+
 TEST_MAIN(URL)
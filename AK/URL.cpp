@@ -24,6 +24,7 @@
 
 #include <AK/LexicalPath.h>
 #include <AK/StringBuilder.h>
+#include <AK/StringUtils.h>
 #include <AK/URL.h>
 #include <AK/URLParser.h>
 
@@ -49,205 +50,107 @@ bool URL::parse(const StringView& string)
     if (string.is_null())
         return false;
 
-    enum class State {
-        InProtocol,
-        InHostname,
-        InPort,
-        InPath,
-        InQuery,
-        InFragment,
-        InDataMimeType,
-        InDataPayload,
-    };
-
-    Vector<char, 256> buffer;
-    State state { State::InProtocol };
-
+    // Components are first collected as views into the input, and only copied once,
+    // into the serialized form, by set_components().
+    Components components;
     size_t index = 0;
 
+    auto take_until = [&](auto is_delimiter) {
+        auto start = index;
+        while (index < string.length() && !is_delimiter(string[index]))
+            ++index;
+        return string.substring_view(start, index - start);
+    };
+
     auto peek = [&] {
         if (index >= string.length())
             return '\0';
         return string[index];
     };
 
-    auto consume = [&] {
-        if (index >= string.length())
-            return '\0';
-        return string[index++];
-    };
+    components.protocol = take_until([](char ch) { return !is_valid_protocol_character(ch); });
+    if (peek() != ':')
+        return false;
+    ++index;
 
-    while (index < string.length()) {
-        switch (state) {
-        case State::InProtocol: {
-            if (is_valid_protocol_character(peek())) {
-                buffer.append(consume());
-                continue;
-            }
-            if (consume() != ':')
+    if (components.protocol == "data") {
+        components.data_mime_type = take_until([](char ch) { return ch == ';' || ch == ','; });
+        if (peek() == ';') {
+            ++index;
+            if (!string.substring_view(index).starts_with("base64"))
                 return false;
+            index += 6;
+            m_data_payload_is_base64 = true;
+        }
+        if (peek() != ',')
+            return false;
+        ++index;
 
-            m_protocol = String::copy(buffer);
-
-            if (m_protocol == "data") {
-                buffer.clear();
-                m_host = "";
-                state = State::InDataMimeType;
-                continue;
-            }
-
-            if (m_protocol == "about") {
-                buffer.clear();
-                m_host = "";
-                state = State::InPath;
-                continue;
-            }
+        auto payload = urldecode(string.substring_view(index));
+        components.data_payload = payload;
+        set_components(components);
+        return compute_validity();
+    }
 
-            if (consume() != '/')
-                return false;
-            if (consume() != '/')
-                return false;
-            if (buffer.is_empty())
-                return false;
-            state = State::InHostname;
-            buffer.clear();
-            continue;
+    auto parse_path_query_and_fragment = [&] {
+        components.path = take_until([](char ch) { return ch == '?' || ch == '#'; });
+        if (peek() == '?') {
+            ++index;
+            components.query = take_until([](char ch) { return ch == '#'; });
         }
-        case State::InHostname:
-            if (is_valid_hostname_character(peek())) {
-                buffer.append(consume());
-                continue;
-            }
-            if (buffer.is_empty()) {
-                if (m_protocol == "file") {
-                    m_host = "";
-                    state = State::InPath;
-                    continue;
-                }
-                return false;
-            }
-            m_host = String::copy(buffer);
-            buffer.clear();
-            if (peek() == ':') {
-                consume();
-                state = State::InPort;
-                continue;
-            }
-            if (peek() == '/') {
-                state = State::InPath;
-                continue;
-            }
+        if (peek() == '#') {
+            ++index;
+            components.fragment = string.substring_view(index);
+        }
+    };
+
+    if (components.protocol == "about") {
+        parse_path_query_and_fragment();
+    } else {
+        if (peek() != '/')
             return false;
-        case State::InPort:
-            if (is_digit(peek())) {
-                buffer.append(consume());
-                continue;
-            }
-            if (buffer.is_empty())
-                return false;
-            {
-                auto port_opt = String::copy(buffer).to_uint();
-                buffer.clear();
-                if (!port_opt.has_value())
-                    return false;
-                m_port = port_opt.value();
-            }
-            if (peek() == '/') {
-                state = State::InPath;
-                continue;
-            }
+        ++index;
+        if (peek() != '/')
+            return false;
+        ++index;
+        if (components.protocol.is_empty())
             return false;
-        case State::InPath:
-            if (peek() == '?' || peek() == '#') {
-                m_path = String::copy(buffer);
-                buffer.clear();
-                state = peek() == '?' ? State::InQuery : State::InFragment;
-                consume();
-                continue;
-            }
-            buffer.append(consume());
-            continue;
-        case State::InQuery:
-            if (peek() == '#') {
-                m_query = String::copy(buffer);
-                buffer.clear();
-                consume();
-                state = State::InFragment;
-                continue;
-            }
-            buffer.append(consume());
-            continue;
-        case State::InFragment:
-            buffer.append(consume());
-            continue;
-        case State::InDataMimeType: {
-            if (peek() != ';' && peek() != ',') {
-                buffer.append(consume());
-                continue;
-            }
 
-            m_data_mime_type = String::copy(buffer);
-            buffer.clear();
+        components.host = take_until([](char ch) { return !is_valid_hostname_character(ch); });
+        if (components.host.is_empty() && components.protocol != "file")
+            return false;
 
-            if (peek() == ';') {
-                consume();
-                if (consume() != 'b')
-                    return false;
-                if (consume() != 'a')
-                    return false;
-                if (consume() != 's')
-                    return false;
-                if (consume() != 'e')
-                    return false;
-                if (consume() != '6')
+        if (!components.host.is_empty() && index == string.length()) {
+            // We're still in the hostname, so e.g "http://serenityos.org"
+            components.path = "/";
+        } else if (!components.host.is_empty() && peek() == ':') {
+            ++index;
+            auto port = take_until([](char ch) { return !is_digit(ch); });
+            if (index != string.length() && port.is_empty())
+                return false;
+            if (!port.is_empty()) {
+                auto port_number = StringUtils::convert_to_uint(port);
+                if (port_number.has_value())
+                    m_port = port_number.value();
+                else if (index != string.length())
                     return false;
-                if (consume() != '4')
+            }
+            if (index != string.length()) {
+                if (peek() != '/')
                     return false;
-                m_data_payload_is_base64 = true;
+                parse_path_query_and_fragment();
             }
-
-            if (consume() != ',')
-                return false;
-
-            state = State::InDataPayload;
-            break;
-        }
-        case State::InDataPayload:
-            buffer.append(consume());
-            break;
-        }
-    }
-    if (state == State::InHostname) {
-        // We're still in the hostname, so e.g "http://serenityos.org"
-        if (buffer.is_empty())
+        } else if (components.host.is_empty() || peek() == '/') {
+            parse_path_query_and_fragment();
+        } else {
             return false;
-        m_host = String::copy(buffer);
-        m_path = "/";
-    }
-    if (state == State::InProtocol)
-        return false;
-    if (state == State::InPath)
-        m_path = String::copy(buffer);
-    if (state == State::InQuery)
-        m_query = String::copy(buffer);
-    if (state == State::InFragment)
-        m_fragment = String::copy(buffer);
-    if (state == State::InDataPayload)
-        m_data_payload = urldecode(String::copy(buffer));
-    if (state == State::InPort) {
-        auto port_opt = String::copy(buffer).to_uint();
-        if (port_opt.has_value())
-            m_port = port_opt.value();
+        }
     }
 
-    if (m_query.is_null())
-        m_query = "";
-    if (m_fragment.is_null())
-        m_fragment = "";
-
-    if (!m_port && protocol_requires_port(m_protocol))
-        set_port(default_port_for_protocol(m_protocol));
+    if (!m_port && protocol_requires_port(components.protocol))
+        m_port = default_port_for_protocol(components.protocol);
 
+    set_components(components);
     return compute_validity();
 }
 
@@ -256,44 +159,90 @@ URL::URL(const StringView& string)
     m_valid = parse(string);
 }
 
-String URL::to_string() const
+URL::Components URL::components() const
 {
-    StringBuilder builder;
-    builder.append(m_protocol);
+    return {
+        protocol_view(),
+        host_view(),
+        path_view(),
+        query_view(),
+        fragment_view(),
+        component(m_data_mime_type),
+        component(m_data_payload),
+    };
+}
 
-    if (m_protocol == "about") {
-        builder.append(':');
-        builder.append(m_path);
-        return builder.to_string();
+// Builds the serialized form of the URL, which is what to_string() returns, and records where
+// each component ended up in it. This runs twice: once to measure, and once to write the string.
+void URL::set_components(const Components& components)
+{
+    char port_digits[5];
+    size_t port_length = 0;
+    if (components.protocol != "data" && components.protocol != "about" && default_port_for_protocol(components.protocol) != m_port) {
+        for (auto port = m_port; port_length == 0 || port != 0; port /= 10)
+            port_digits[sizeof(port_digits) - ++port_length] = '0' + port % 10;
     }
 
-    if (m_protocol == "data") {
-        builder.append(':');
-        builder.append(m_data_mime_type);
-        if (m_data_payload_is_base64)
-            builder.append(";base64");
-        builder.append(',');
-        builder.append(m_data_payload);
-        return builder.to_string();
-    }
+    char* buffer = nullptr;
+    size_t offset = 0;
+    auto append = [&](const StringView& value) {
+        // Empty and null views may not point anywhere, and memcpy() mustn't be given null even for 0 bytes.
+        if (buffer && !value.is_empty())
+            __builtin_memcpy(buffer + offset, value.characters_without_null_termination(), value.length());
+        offset += value.length();
+    };
+    auto append_component = [&](ComponentRange& range, const StringView& value) {
+        range = { static_cast<u32>(offset), static_cast<u32>(value.length()) };
+        append(value);
+    };
 
-    builder.append("://");
-    builder.append(m_host);
-    if (default_port_for_protocol(protocol()) != port()) {
-        builder.append(':');
-        builder.append(String::number(m_port));
-    }
+    auto serialize = [&] {
+        offset = 0;
+        m_host = {};
+        m_path = {};
+        m_query = {};
+        m_fragment = {};
+        m_data_mime_type = {};
+        m_data_payload = {};
+
+        append_component(m_protocol, components.protocol);
+
+        if (components.protocol == "data") {
+            append(":");
+            append_component(m_data_mime_type, components.data_mime_type);
+            if (m_data_payload_is_base64)
+                append(";base64");
+            append(",");
+            append_component(m_data_payload, components.data_payload);
+            return;
+        }
 
-    builder.append(m_path);
-    if (!m_query.is_empty()) {
-        builder.append('?');
-        builder.append(m_query);
-    }
-    if (!m_fragment.is_empty()) {
-        builder.append('#');
-        builder.append(m_fragment);
-    }
-    return builder.to_string();
+        if (components.protocol == "about") {
+            append(":");
+        } else {
+            append("://");
+            append_component(m_host, components.host);
+            if (port_length) {
+                append(":");
+                append({ port_digits + sizeof(port_digits) - port_length, port_length });
+            }
+        }
+
+        append_component(m_path, components.path);
+        if (!components.query.is_empty()) {
+            append("?");
+            append_component(m_query, components.query);
+        }
+        if (!components.fragment.is_empty()) {
+            append("#");
+            append_component(m_fragment, components.fragment);
+        }
+    };
+
+    serialize();
+    auto impl = StringImpl::create_uninitialized(offset, buffer);
+    serialize();
+    m_string = move(impl);
 }
 
 URL URL::complete_url(const String& string) const
@@ -305,11 +254,11 @@ URL URL::complete_url(const String& string) const
     if (url.is_valid())
         return url;
 
-    if (protocol() == "data")
+    if (protocol_view() == "data")
         return {};
 
     if (string.starts_with("//")) {
-        URL url(String::formatted("{}:{}", m_protocol, string));
+        URL url(String::formatted("{}:{}", protocol_view(), string));
         if (url.is_valid())
             return url;
     }
@@ -327,15 +276,15 @@ URL URL::complete_url(const String& string) const
     }
 
     StringBuilder builder;
-    LexicalPath lexical_path(path());
+    LexicalPath lexical_path(path_view());
     builder.append('/');
 
-    bool document_url_ends_in_slash = path()[path().length() - 1] == '/';
+    bool document_url_ends_in_slash = path_view().ends_with('/');
 
-    for (size_t i = 0; i < lexical_path.parts().size(); ++i) {
-        if (i == lexical_path.parts().size() - 1 && !document_url_ends_in_slash)
+    for (size_t i = 0; i < lexical_path.component_count(); ++i) {
+        if (i == lexical_path.component_count() - 1 && !document_url_ends_in_slash)
             break;
-        builder.append(lexical_path.parts()[i]);
+        builder.append(lexical_path.component(i));
         builder.append('/');
     }
     builder.append(string);
@@ -357,77 +306,89 @@ URL URL::complete_url(const String& string) const
 
 void URL::set_protocol(const String& protocol)
 {
-    m_protocol = protocol;
+    auto components = this->components();
+    components.protocol = protocol;
+    set_components(components);
     m_valid = compute_validity();
 }
 
 void URL::set_host(const String& host)
 {
-    m_host = host;
+    auto components = this->components();
+    components.host = host;
+    set_components(components);
     m_valid = compute_validity();
 }
 
 void URL::set_port(u16 port)
 {
     m_port = port;
+    set_components(components());
     m_valid = compute_validity();
 }
 
 void URL::set_path(const String& path)
 {
-    m_path = path;
+    auto components = this->components();
+    components.path = path;
+    set_components(components);
     m_valid = compute_validity();
 }
 
 void URL::set_query(const String& query)
 {
-    m_query = query;
+    auto components = this->components();
+    components.query = query;
+    set_components(components);
 }
 
 void URL::set_fragment(const String& fragment)
 {
-    m_fragment = fragment;
+    auto components = this->components();
+    components.fragment = fragment;
+    set_components(components);
 }
 
 bool URL::compute_validity() const
 {
     // FIXME: This is by no means complete.
-    if (m_protocol.is_empty())
+    auto protocol = protocol_view();
+    if (protocol.is_empty())
         return false;
 
-    if (m_protocol == "about") {
-        if (m_path.is_empty())
+    if (protocol == "about") {
+        if (path_view().is_empty())
             return false;
         return true;
     }
 
-    if (m_protocol == "file") {
-        if (m_path.is_empty())
+    if (protocol == "file") {
+        if (path_view().is_empty())
             return false;
         return true;
     }
 
-    if (m_protocol == "data") {
-        if (m_data_mime_type.is_empty())
+    if (protocol == "data") {
+        if (component(m_data_mime_type).is_empty())
             return false;
         return true;
     }
 
-    if (m_host.is_empty())
+    if (host_view().is_empty())
         return false;
 
-    if (!m_port && protocol_requires_port(m_protocol))
+    if (!m_port && protocol_requires_port(protocol))
         return false;
 
     return true;
 }
 
-bool URL::protocol_requires_port(const String& protocol)
+bool URL::protocol_requires_port(const StringView& protocol)
 {
     return (default_port_for_protocol(protocol) != 0);
 }
 
-u16 URL::default_port_for_protocol(const String& protocol)
+u16 URL::default_port_for_protocol(const StringView& protocol)
 {
     if (protocol == "http")
         return 80;
@@ -445,9 +406,12 @@ u16 URL::default_port_for_protocol(const String& protocol)
 URL URL::create_with_file_protocol(const String& path, const String& fragment)
 {
     URL url;
-    url.set_protocol("file");
-    url.set_path(path);
-    url.set_fragment(fragment);
+    Components components;
+    components.protocol = "file";
+    components.path = path;
+    components.fragment = fragment;
+    url.set_components(components);
+    url.m_valid = url.compute_validity();
     return url;
 }
 
@@ -464,12 +428,13 @@ URL URL::create_with_url_or_path(const String& url_or_path)
 URL URL::create_with_data(const StringView& mime_type, const StringView& payload, bool is_base64)
 {
     URL url;
-    url.set_protocol("data");
-    url.m_valid = true;
-    url.m_data_payload = payload;
-    url.m_data_mime_type = mime_type;
+    Components components;
+    components.protocol = "data";
+    components.data_mime_type = mime_type;
+    components.data_payload = payload;
     url.m_data_payload_is_base64 = is_base64;
-
+    url.set_components(components);
+    url.m_valid = true;
     return url;
 }
 
@@ -477,7 +442,7 @@ String URL::basename() const
 {
     if (!m_valid)
         return {};
-    return LexicalPath(m_path).basename();
+    return LexicalPath(path_view()).basename();
 }
 
 }
@@ -32,6 +32,10 @@ namespace AK {
 
 // FIXME: URL needs query string parsing.
 
+// A URL is stored as its serialized form, with every component recorded as a
+// range in that string. Parsing makes one pass over the input and one allocation
+// for the result, the *_view() accessors don't allocate at all, and to_string(),
+// comparisons and hashing work on the stored string directly.
 class URL {
 public:
     URL() = default;
@@ -46,13 +50,20 @@ public:
     }
 
     bool is_valid() const { return m_valid; }
-    String protocol() const { return m_protocol; }
-    String host() const { return m_host; }
-    String path() const { return m_path; }
-    String query() const { return m_query; }
-    String fragment() const { return m_fragment; }
+    String protocol() const { return protocol_view(); }
+    String host() const { return host_view(); }
+    String path() const { return path_view(); }
+    String query() const { return query_view(); }
+    String fragment() const { return fragment_view(); }
     u16 port() const { return m_port; }
 
+    // These point into the URL and are invalidated by any of the setters.
+    StringView protocol_view() const { return component(m_protocol); }
+    StringView host_view() const { return component(m_host); }
+    StringView path_view() const { return component(m_path); }
+    StringView query_view() const { return component(m_query); }
+    StringView fragment_view() const { return component(m_fragment); }
+
     void set_protocol(const String& protocol);
     void set_host(const String& host);
     void set_port(const u16 port);
@@ -61,7 +72,7 @@ public:
     void set_fragment(const String& fragment);
 
     String basename() const;
-    String to_string() const;
+    String to_string() const { return m_string; }
     String to_string_encoded() const
     {
         // Exclusion character set is the same JS's encodeURI() uses
@@ -71,36 +82,64 @@ public:
     URL complete_url(const String&) const;
 
     bool data_payload_is_base64() const { return m_data_payload_is_base64; }
-    const String& data_mime_type() const { return m_data_mime_type; }
-    const String& data_payload() const { return m_data_payload; }
+    String data_mime_type() const { return component(m_data_mime_type); }
+    String data_payload() const { return component(m_data_payload); }
 
     static URL create_with_url_or_path(const String& url_or_path);
     static URL create_with_file_protocol(const String& path, const String& fragment = {});
     static URL create_with_data(const StringView& mime_type, const StringView& payload, bool is_base64 = false);
-    static bool protocol_requires_port(const String& protocol);
-    static u16 default_port_for_protocol(const String& protocol);
+    static bool protocol_requires_port(const StringView& protocol);
+    static u16 default_port_for_protocol(const StringView& protocol);
 
     bool operator==(const URL& other) const
     {
         if (this == &other)
             return true;
-        return to_string() == other.to_string();
+        return m_string == other.m_string;
     }
 
+    unsigned hash() const { return m_string.hash(); }
+
 private:
+    struct ComponentRange {
+        u32 start { 0 };
+        u32 length { 0 };
+    };
+
+    struct Components {
+        StringView protocol;
+        StringView host;
+        StringView path;
+        StringView query;
+        StringView fragment;
+        StringView data_mime_type;
+        StringView data_payload;
+    };
+
+    StringView component(const ComponentRange& range) const
+    {
+        if (m_string.is_null())
+            return {};
+        return m_string.view().substring_view(range.start, range.length);
+    }
+
+    Components components() const;
+    void set_components(const Components&);
+
     bool parse(const StringView&);
     bool compute_validity() const;
 
+    String m_string;
+    ComponentRange m_protocol;
+    ComponentRange m_host;
+    ComponentRange m_path;
+    ComponentRange m_query;
+    ComponentRange m_fragment;
+    ComponentRange m_data_mime_type;
+    ComponentRange m_data_payload;
     bool m_valid { false };
     u16 m_port { 0 };
     bool m_data_payload_is_base64 { false };
-    String m_protocol;
-    String m_host;
-    String m_path;
-    String m_query;
-    String m_fragment;
-    String m_data_mime_type;
-    String m_data_payload;
 };
 
 template<>
@@ -113,7 +152,7 @@ struct Formatter<URL> : Formatter<StringView> {
 
 template<>
 struct Traits<URL> : public GenericTraits<URL> {
-    static unsigned hash(const URL& url) { return url.to_string().hash(); }
+    static unsigned hash(const URL& url) { return url.hash(); }
 };
 
 }
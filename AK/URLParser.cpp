@@ -22,10 +22,9 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/Optional.h>
+#include <AK/Array.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
-#include <AK/StringUtils.h>
 #include <AK/URLParser.h>
 
 namespace AK {
@@ -35,69 +34,108 @@ static bool is_ascii_hex_digit(u8 ch)
     return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
 }
 
+static u8 hex_digit_value(u8 ch)
+{
+    if (ch <= '9')
+        return ch - '0';
+    return (ch | 0x20) - 'a' + 10;
+}
+
+// Most inputs contain long runs that need no decoding, so those are found with memchr() and
+// copied in one go. If there is nothing to decode at all, the input string is returned as is.
 String urldecode(const StringView& input)
 {
-    size_t cursor = 0;
+    if (input.is_empty())
+        return String::empty();
 
-    auto peek = [&](size_t offset = 0) -> u8 {
-        if (cursor + offset >= input.length())
-            return 0;
-        return input[cursor + offset];
-    };
+    auto* characters = input.characters_without_null_termination();
+    auto length = input.length();
+    if (!__builtin_memchr(characters, '%', length))
+        return input;
 
-    auto consume = [&] {
-        return input[cursor++];
-    };
+    StringBuilder builder(length);
+    size_t cursor = 0;
+    while (cursor < length) {
+        auto* percent = static_cast<const char*>(__builtin_memchr(characters + cursor, '%', length - cursor));
+        size_t run_end = percent ? percent - characters : length;
+        builder.append(characters + cursor, run_end - cursor);
+        cursor = run_end;
+        if (cursor == length)
+            break;
 
-    StringBuilder builder;
-    while (cursor < input.length()) {
-        if (peek() != '%') {
-            builder.append(consume());
-            continue;
-        }
-        if (!is_ascii_hex_digit(peek(1)) || !is_ascii_hex_digit(peek(2))) {
-            builder.append(consume());
-            continue;
+        if (cursor + 2 < length && is_ascii_hex_digit(characters[cursor + 1]) && is_ascii_hex_digit(characters[cursor + 2])) {
+            builder.append(static_cast<char>(hex_digit_value(characters[cursor + 1]) << 4 | hex_digit_value(characters[cursor + 2])));
+            cursor += 3;
+        } else {
+            builder.append('%');
+            ++cursor;
         }
-        auto byte_point = StringUtils::convert_to_uint_from_hex(input.substring_view(cursor + 1, 2));
-        builder.append(byte_point.value());
-        consume();
-        consume();
-        consume();
     }
     return builder.to_string();
 }
 
-static inline bool in_c0_control_set(u32 c)
+static constexpr bool in_c0_control_set(u32 c)
 {
     return c <= 0x1f || c > '~';
 }
 
-static inline bool in_fragment_set(u32 c)
+static constexpr bool in_fragment_set(u32 c)
 {
     return in_c0_control_set(c) || c == ' ' || c == '"' || c == '<' || c == '>' || c == '`';
 }
 
-static inline bool in_path_set(u32 c)
+static constexpr bool in_path_set(u32 c)
 {
     return in_fragment_set(c) || c == '#' || c == '?' || c == '{' || c == '}';
 }
 
-static inline bool in_userinfo_set(u32 c)
+static constexpr bool in_userinfo_set(u32 c)
 {
     return in_path_set(c) || c == '/' || c == ':' || c == ';' || c == '=' || c == '@' || (c >= '[' && c <= '^') || c == '|';
 }
 
+static constexpr auto s_userinfo_set_table = [] {
+    Array<bool, 256> table {};
+    for (u32 c = 0; c < 256; ++c)
+        table[c] = in_userinfo_set(c);
+    return table;
+}();
+
+// Like urldecode(), this copies runs of characters that can stay as they are in bulk,
+// and returns the input string itself if nothing needs encoding.
 String urlencode(const StringView& input, const StringView& exclude)
 {
-    StringBuilder builder;
-    for (unsigned char ch : input) {
-        if (in_userinfo_set((u8)ch) && !exclude.contains(ch)) {
-            builder.append('%');
-            builder.appendff("{:02X}", ch);
-        } else {
-            builder.append(ch);
-        }
+    auto* characters = reinterpret_cast<const u8*>(input.characters_without_null_termination());
+    auto length = input.length();
+
+    auto table = s_userinfo_set_table;
+    for (u8 ch : exclude)
+        table[ch] = false;
+    auto needs_encoding = [&](u8 ch) {
+        return table[ch];
+    };
+
+    size_t cursor = 0;
+    while (cursor < length && !needs_encoding(characters[cursor]))
+        ++cursor;
+    if (cursor == length)
+        return input.is_null() ? String::empty() : String(input);
+
+    constexpr char hex_digits[] = "0123456789ABCDEF";
+    StringBuilder builder(length + length / 2);
+    builder.append(input.substring_view(0, cursor));
+    while (cursor < length) {
+        auto run_start = cursor;
+        while (cursor < length && !needs_encoding(characters[cursor]))
+            ++cursor;
+        builder.append(input.substring_view(run_start, cursor - run_start));
+        if (cursor == length)
+            break;
+
+        auto ch = characters[cursor++];
+        builder.append('%');
+        builder.append(hex_digits[ch >> 4]);
+        builder.append(hex_digits[ch & 0xf]);
     }
     return builder.to_string();
 }
@@ -0,0 +1,824 @@
+#include "DirectoryModel.h"
+#include <AK/LexicalPath.h>
+#include <AK/StringBuilder.h>
+#include <AK/URL.h>
+#include <LibGUI/FileIconProvider.h>
+#include <LibGUI/FileSystemModel.h>
+#include <errno.h>
+#include <grp.h>
+#include <pwd.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#    include <sys/inotify.h>
+#endif
+
+namespace FileManager {
+
+// Changes often come in bursts, e.g. while something unpacks an archive, so they are collected for a moment.
+static constexpr int change_coalescing_interval_ms = 50;
+
+static String permission_string(mode_t mode)
+{
+    StringBuilder builder;
+    if (S_ISDIR(mode))
+        builder.append("d");
+    else if (S_ISLNK(mode))
+        builder.append("l");
+    else if (S_ISBLK(mode))
+        builder.append("b");
+    else if (S_ISCHR(mode))
+        builder.append("c");
+    else if (S_ISFIFO(mode))
+        builder.append("f");
+    else if (S_ISSOCK(mode))
+        builder.append("s");
+    else if (S_ISREG(mode))
+        builder.append("-");
+    else
+        builder.append("?");
+
+    builder.append(mode & S_IRUSR ? 'r' : '-');
+    builder.append(mode & S_IWUSR ? 'w' : '-');
+    builder.append(mode & S_ISUID ? 's' : (mode & S_IXUSR ? 'x' : '-'));
+    builder.append(mode & S_IRGRP ? 'r' : '-');
+    builder.append(mode & S_IWGRP ? 'w' : '-');
+    builder.append(mode & S_ISGID ? 's' : (mode & S_IXGRP ? 'x' : '-'));
+    builder.append(mode & S_IROTH ? 'r' : '-');
+    builder.append(mode & S_IWOTH ? 'w' : '-');
+    builder.append(mode & S_ISVTX ? 't' : (mode & S_IXOTH ? 'x' : '-'));
+    return builder.to_string();
+}
+
+String DirectoryModel::Node::full_path() const
+{
+    if (!parent)
+        return name;
+    auto parent_path = parent->full_path();
+    if (parent_path == "/")
+        return String::formatted("/{}", name);
+    return String::formatted("{}/{}", parent_path, name);
+}
+
+DirectoryModel::DirectoryModel(const StringView& root_path)
+    : m_root(make<Node>())
+    , m_liveness(adopt(*new Liveness))
+{
+    m_update_timer = Core::Timer::create_single_shot(update_interval_ms, [this] { flush_update(); });
+    m_change_timer = Core::Timer::create_single_shot(change_coalescing_interval_ms, [this] { stat_changed_entries(); });
+    ThumbnailCache::the().register_client(*this);
+
+#ifdef __linux__
+    m_watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_watch_fd < 0) {
+        perror("inotify_init1");
+    } else {
+        m_watch_notifier = Core::Notifier::construct(m_watch_fd, Core::Notifier::Read);
+        m_watch_notifier->on_ready_to_read = [this] { handle_watch_events(); };
+    }
+#endif
+
+    if (!root_path.is_null())
+        set_root_path(root_path);
+}
+
+DirectoryModel::~DirectoryModel()
+{
+    m_liveness->is_alive = false;
+    ThumbnailCache::the().unregister_client(*this);
+    forget_subtree(*m_root);
+    if (m_watch_notifier)
+        m_watch_notifier->set_enabled(false);
+    if (m_watch_fd >= 0)
+        close(m_watch_fd);
+}
+
+String DirectoryModel::root_path() const
+{
+    return m_root->name;
+}
+
+void DirectoryModel::set_root_path(const StringView& path)
+{
+    forget_subtree(*m_root);
+    m_root = make<Node>();
+    m_root->name = path.is_null() ? String {} : LexicalPath::canonicalized_path(path);
+    if (!m_pending_thumbnails.is_empty()) {
+        m_pending_thumbnails.clear();
+        m_thumbnail_progress = 0;
+        m_thumbnail_progress_total = 0;
+        if (on_thumbnail_progress)
+            on_thumbnail_progress(0, 0);
+    }
+    m_update_timer->stop();
+    m_pending_update_flags = 0;
+    m_has_pending_update = false;
+
+    if (m_root->name.is_empty()) {
+        did_update();
+        return;
+    }
+
+    struct stat st;
+    int error = 0;
+    if (stat(m_root->name.characters(), &st) < 0)
+        error = errno;
+    else if (!S_ISDIR(st.st_mode))
+        error = ENOTDIR;
+    if (error) {
+        m_root->has_been_read = true;
+        did_update();
+        if (on_error)
+            on_error(error, strerror(error));
+        return;
+    }
+
+    m_root->mode = st.st_mode;
+    m_root->size = st.st_size;
+    m_root->uid = st.st_uid;
+    m_root->gid = st.st_gid;
+    m_root->inode = st.st_ino;
+    m_root->mtime = st.st_mtime;
+    m_root->has_metadata = true;
+
+    read_directory(*m_root);
+    did_update();
+    // The first batch of entries should show up as soon as it arrives.
+    m_last_update_ms = 0;
+
+    if (on_complete)
+        on_complete();
+}
+
+void DirectoryModel::set_should_show_dotfiles(bool show)
+{
+    if (m_should_show_dotfiles == show)
+        return;
+    m_should_show_dotfiles = show;
+    reread_directories(*m_root, true);
+}
+
+const DirectoryModel::Node& DirectoryModel::node(const GUI::ModelIndex& index) const
+{
+    if (!index.is_valid())
+        return *m_root;
+    VERIFY(index.internal_data());
+    return *static_cast<Node*>(index.internal_data());
+}
+
+GUI::ModelIndex DirectoryModel::index(const Node& node, int column) const
+{
+    if (!node.parent)
+        return {};
+    return create_index(node.row, column, &node);
+}
+
+GUI::ModelIndex DirectoryModel::index(int row, int column, const GUI::ModelIndex& parent) const
+{
+    if (row < 0 || column < 0)
+        return {};
+    auto& node = this->node(parent);
+    if (static_cast<size_t>(row) >= node.children.size())
+        return {};
+    return create_index(row, column, &node.children[row]);
+}
+
+GUI::ModelIndex DirectoryModel::parent_index(const GUI::ModelIndex& index) const
+{
+    if (!index.is_valid())
+        return {};
+    auto& node = this->node(index);
+    if (!node.parent)
+        return {};
+    return this->index(*node.parent, index.column());
+}
+
+DirectoryModel::Node* DirectoryModel::node_for_path(const StringView& path)
+{
+    auto& root_path = m_root->name;
+    if (!path.starts_with(root_path))
+        return nullptr;
+    auto relative_path = path.substring_view(root_path.length());
+    if (!relative_path.is_empty() && root_path != "/" && !relative_path.starts_with('/'))
+        return nullptr;
+
+    Node* node = m_root.ptr();
+    for (auto& part : relative_path.split_view('/')) {
+        node = node->children_by_name.get(part).value_or(nullptr);
+        if (!node)
+            return nullptr;
+    }
+    return node;
+}
+
+int DirectoryModel::row_count(const GUI::ModelIndex& index) const
+{
+    auto& node = const_cast<DirectoryModel&>(*this).mutable_node(index);
+    if (!node.is_directory())
+        return 0;
+    if (!node.has_been_read && !node.is_reading() && !node.name.is_empty())
+        const_cast<DirectoryModel&>(*this).read_directory(node);
+    return node.children.size();
+}
+
+int DirectoryModel::column_count(const GUI::ModelIndex&) const
+{
+    return Column::__Count;
+}
+
+String DirectoryModel::column_name(int column) const
+{
+    switch (column) {
+    case Column::Icon:
+        return "";
+    case Column::Name:
+        return "Name";
+    case Column::Size:
+        return "Size";
+    case Column::Owner:
+        return "Owner";
+    case Column::Group:
+        return "Group";
+    case Column::Permissions:
+        return "Mode";
+    case Column::ModificationTime:
+        return "Modified";
+    case Column::Inode:
+        return "Inode";
+    case Column::SymlinkTarget:
+        return "Symlink target";
+    }
+    VERIFY_NOT_REACHED();
+}
+
+GUI::Variant DirectoryModel::data(const GUI::ModelIndex& index, GUI::ModelRole role) const
+{
+    VERIFY(index.is_valid());
+    auto& node = this->node(index);
+
+    if (role == GUI::ModelRole::TextAlignment) {
+        switch (index.column()) {
+        case Column::Icon:
+            return Gfx::TextAlignment::Center;
+        case Column::Size:
+        case Column::Inode:
+            return Gfx::TextAlignment::CenterRight;
+        default:
+            return Gfx::TextAlignment::CenterLeft;
+        }
+    }
+
+    if (role == GUI::ModelRole::Custom) {
+        // Like GUI::FileSystemModel, the custom role is the full path.
+        VERIFY(index.column() == Column::Name);
+        return node.full_path();
+    }
+
+    if (role == GUI::ModelRole::DragData) {
+        if (index.column() == Column::Name)
+            return URL::create_with_file_protocol(node.full_path()).to_string();
+        return {};
+    }
+
+    if (role == GUI::ModelRole::Sort) {
+        switch (index.column()) {
+        case Column::Icon:
+            return node.is_directory() ? 0 : 1;
+        case Column::Name:
+            return node.name;
+        case Column::Size:
+            return (int)node.size;
+        case Column::Owner:
+            return user_name(node.uid);
+        case Column::Group:
+            return group_name(node.gid);
+        case Column::Permissions:
+            return permission_string(node.mode);
+        case Column::ModificationTime:
+            return (int)node.mtime;
+        case Column::Inode:
+            return (int)node.inode;
+        case Column::SymlinkTarget:
+            return node.symlink_target;
+        }
+        VERIFY_NOT_REACHED();
+    }
+
+    if (role == GUI::ModelRole::Display) {
+        switch (index.column()) {
+        case Column::Icon:
+            return icon_for(node);
+        case Column::Name:
+            return node.name;
+        case Column::SymlinkTarget:
+            return node.symlink_target;
+        default:
+            break;
+        }
+        // Rows show up before their entries have been stat-ed.
+        if (!node.has_metadata)
+            return {};
+        switch (index.column()) {
+        case Column::Size:
+            return (int)node.size;
+        case Column::Owner:
+            return user_name(node.uid);
+        case Column::Group:
+            return group_name(node.gid);
+        case Column::Permissions:
+            return permission_string(node.mode);
+        case Column::ModificationTime:
+            return GUI::FileSystemModel::timestamp_string(node.mtime);
+        case Column::Inode:
+            return (int)node.inode;
+        default:
+            VERIFY_NOT_REACHED();
+        }
+    }
+
+    if (role == GUI::ModelRole::Icon)
+        return icon_for(node);
+
+    return {};
+}
+
+GUI::Icon DirectoryModel::icon_for(const Node& node) const
+{
+    auto path = node.full_path();
+    if (path == "/")
+        return GUI::FileIconProvider::icon_for_path("/");
+
+    if (Gfx::Bitmap::is_path_a_supported_image_format(node.name)) {
+        // Thumbnails are only good for the size and mtime they were made for, so they wait for those.
+        if (!node.has_metadata)
+            return GUI::FileIconProvider::filetype_image_icon();
+        auto lookup = ThumbnailCache::the().get(path, node.size, node.mtime);
+        if (lookup.is_pending)
+            const_cast<DirectoryModel&>(*this).did_request_thumbnail(path);
+        if (!lookup.thumbnail)
+            return GUI::FileIconProvider::filetype_image_icon();
+        return GUI::Icon(GUI::FileIconProvider::filetype_image_icon().bitmap_for_size(16), *lookup.thumbnail);
+    }
+
+    return GUI::FileIconProvider::icon_for_path(path, node.mode);
+}
+
+void DirectoryModel::did_request_thumbnail(const String& path)
+{
+    if (m_pending_thumbnails.set(path) != AK::HashSetResult::InsertedNewEntry)
+        return;
+    ++m_thumbnail_progress_total;
+    if (on_thumbnail_progress)
+        on_thumbnail_progress(m_thumbnail_progress, m_thumbnail_progress_total);
+}
+
+void DirectoryModel::thumbnail_did_finish(const String& path)
+{
+    // Thumbnails asked for before the directory was left don't count anymore.
+    if (!m_pending_thumbnails.remove(path))
+        return;
+    ++m_thumbnail_progress;
+    if (on_thumbnail_progress)
+        on_thumbnail_progress(m_thumbnail_progress, m_thumbnail_progress_total);
+    if (m_thumbnail_progress == m_thumbnail_progress_total) {
+        m_thumbnail_progress = 0;
+        m_thumbnail_progress_total = 0;
+    }
+    schedule_update(UpdateFlag::DontInvalidateIndexes);
+}
+
+const String& DirectoryModel::user_name(uid_t uid) const
+{
+    if (auto it = m_user_names.find(uid); it != m_user_names.end())
+        return it->value;
+    auto* password = getpwuid(uid);
+    m_user_names.set(uid, password ? String(password->pw_name) : String::number(uid));
+    return m_user_names.find(uid)->value;
+}
+
+const String& DirectoryModel::group_name(gid_t gid) const
+{
+    if (auto it = m_group_names.find(gid); it != m_group_names.end())
+        return it->value;
+    auto* group = getgrgid(gid);
+    m_group_names.set(gid, group ? String(group->gr_name) : String::number(gid));
+    return m_group_names.find(gid)->value;
+}
+
+void DirectoryModel::read_directory(Node& node)
+{
+    if (node.scanner)
+        node.scanner->cancel();
+    // Watch first, so nothing that changes while the directory is being read goes unnoticed.
+    watch(node);
+
+    ++node.scan_generation;
+    node.scanned_children.clear();
+    node.scanner = DirectoryScanner::create(node.full_path(), m_should_show_dotfiles);
+    node.scanner->on_entries = [this, &node](size_t first_index, auto& entries) {
+        did_read_entries(node, first_index, entries);
+    };
+    node.scanner->on_metadata = [this, &node](size_t first_index, auto& metadata) {
+        did_read_metadata(node, first_index, metadata);
+    };
+    node.scanner->on_complete = [this, &node] {
+        did_finish_reading(node);
+    };
+    node.scanner->on_error = [this, &node](int error) {
+        node.scanner = nullptr;
+        node.scanned_children.clear();
+        node.has_been_read = true;
+        if (&node == m_root.ptr() && on_error)
+            on_error(error, strerror(error));
+    };
+    node.scanner->start();
+}
+
+void DirectoryModel::did_read_entries(Node& node, size_t first_index, const Vector<DirectoryScanner::Entry>& entries)
+{
+    VERIFY(first_index == node.scanned_children.size());
+    bool did_add_children = false;
+    for (auto& entry : entries) {
+        auto* child = node.children_by_name.get(entry.name).value_or(nullptr);
+        if (!child) {
+            child = &add_child(node, entry.name, entry.type);
+            did_add_children = true;
+        }
+        child->seen_in_generation = node.scan_generation;
+        node.scanned_children.append(child);
+    }
+    if (did_add_children)
+        schedule_update(UpdateFlag::DontInvalidateIndexes);
+}
+
+void DirectoryModel::did_read_metadata(Node& node, size_t first_index, const Vector<DirectoryScanner::Metadata>& metadata)
+{
+    for (size_t i = 0; i < metadata.size(); ++i) {
+        // Null if the child was removed in the meantime.
+        auto* child = node.scanned_children[first_index + i];
+        if (!child)
+            continue;
+        // The entry was removed after it was read; it goes away with the others the scan didn't see.
+        if (!metadata[i].is_valid) {
+            child->seen_in_generation = 0;
+            continue;
+        }
+        set_metadata(*child, metadata[i]);
+    }
+    schedule_update(UpdateFlag::DontInvalidateIndexes);
+}
+
+void DirectoryModel::did_finish_reading(Node& node)
+{
+    node.scanner = nullptr;
+    node.scanned_children.clear();
+    node.has_been_read = true;
+    remove_stale_children(node);
+
+    if (!node.changed_names.is_empty()) {
+        m_nodes_with_changes.set(&node);
+        m_change_timer->start();
+    }
+
+    if (&node == m_root.ptr()) {
+        flush_update();
+        if (on_root_read)
+            on_root_read();
+    }
+}
+
+void DirectoryModel::reread_directories(Node& node, bool even_if_watched)
+{
+    if (!node.has_been_read)
+        return;
+    if (even_if_watched || node.watch_descriptor < 0)
+        read_directory(node);
+    for (auto& child : node.children) {
+        if (child.is_directory())
+            reread_directories(child, even_if_watched);
+    }
+}
+
+void DirectoryModel::update()
+{
+    reread_directories(*m_root, false);
+    stat_changed_entries();
+}
+
+DirectoryModel::Node& DirectoryModel::add_child(Node& parent, const String& name, mode_t type)
+{
+    auto child = make<Node>();
+    child->name = name;
+    child->mode = type;
+    child->parent = &parent;
+    child->row = parent.children.size();
+    auto& child_ref = *child;
+    parent.children.append(move(child));
+    parent.children_by_name.set(child_ref.name, &child_ref);
+    return child_ref;
+}
+
+void DirectoryModel::set_metadata(Node& node, const DirectoryScanner::Metadata& metadata)
+{
+    if (node.parent)
+        node.parent->total_size = node.parent->total_size - node.size + metadata.size;
+    node.mode = metadata.mode;
+    node.size = metadata.size;
+    node.uid = metadata.uid;
+    node.gid = metadata.gid;
+    node.inode = metadata.inode;
+    node.mtime = metadata.mtime;
+    node.symlink_target = metadata.symlink_target;
+    node.has_metadata = true;
+}
+
+void DirectoryModel::renumber_children(Node& parent, size_t from_row)
+{
+    for (size_t row = from_row; row < parent.children.size(); ++row)
+        parent.children[row].row = row;
+}
+
+void DirectoryModel::remove_stale_children(Node& parent)
+{
+    size_t stale_count = 0;
+    for (auto& child : parent.children) {
+        if (child.seen_in_generation != parent.scan_generation)
+            ++stale_count;
+    }
+    if (!stale_count)
+        return;
+
+    // Removing them one by one would move the rest of the vector every time.
+    NonnullOwnPtrVector<Node> kept_children;
+    kept_children.ensure_capacity(parent.children.size() - stale_count);
+    for (size_t i = 0; i < parent.children.size(); ++i) {
+        auto& child = parent.children[i];
+        if (child.seen_in_generation == parent.scan_generation) {
+            kept_children.unchecked_append(move(parent.children.ptr_at(i)));
+            continue;
+        }
+        parent.total_size -= child.size;
+        parent.children_by_name.remove(child.name);
+        forget_subtree(child);
+    }
+    parent.children = move(kept_children);
+    renumber_children(parent, 0);
+    update_now(UpdateFlag::InvalidateAllIndexes);
+}
+
+void DirectoryModel::remove_child(Node& parent, Node& child)
+{
+    // The metadata of a scan that's still running is matched up by position, so the slot stays.
+    if (parent.is_reading()) {
+        for (auto*& scanned_child : parent.scanned_children) {
+            if (scanned_child == &child)
+                scanned_child = nullptr;
+        }
+    }
+    auto row = child.row;
+    parent.total_size -= child.size;
+    parent.children_by_name.remove(child.name);
+    forget_subtree(child);
+    parent.children.remove(row);
+    renumber_children(parent, row);
+}
+
+void DirectoryModel::forget_subtree(Node& node)
+{
+    if (node.scanner) {
+        node.scanner->cancel();
+        node.scanner = nullptr;
+    }
+    unwatch(node);
+    m_nodes_with_changes.remove(&node);
+    for (auto& child : node.children)
+        forget_subtree(child);
+}
+
+void DirectoryModel::schedule_update(unsigned flags)
+{
+    m_pending_update_flags |= flags;
+    m_has_pending_update = true;
+    if (m_update_timer->is_active())
+        return;
+    auto elapsed_ms = WorkerPool::now_ms() - m_last_update_ms;
+    m_update_timer->start(elapsed_ms >= update_interval_ms ? 0 : static_cast<int>(update_interval_ms - elapsed_ms));
+}
+
+void DirectoryModel::update_now(unsigned flags)
+{
+    m_pending_update_flags |= flags;
+    m_has_pending_update = true;
+    flush_update();
+}
+
+void DirectoryModel::flush_update()
+{
+    m_update_timer->stop();
+    if (!m_has_pending_update)
+        return;
+    auto flags = m_pending_update_flags;
+    m_pending_update_flags = 0;
+    m_has_pending_update = false;
+    m_last_update_ms = WorkerPool::now_ms();
+    did_update(flags);
+}
+
+void DirectoryModel::watch([[maybe_unused]] Node& node)
+{
+#ifdef __linux__
+    if (m_watch_fd < 0 || node.watch_descriptor >= 0)
+        return;
+    int watch_descriptor = inotify_add_watch(m_watch_fd, node.full_path().characters(),
+        IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK);
+    if (watch_descriptor < 0)
+        return;
+    // The same directory can be reached twice, e.g. through a symlink. Only the first node gets the
+    // watch; the other one is read again on update(), like everything that can't be watched.
+    if (m_nodes_by_watch_descriptor.contains(watch_descriptor))
+        return;
+    node.watch_descriptor = watch_descriptor;
+    m_nodes_by_watch_descriptor.set(watch_descriptor, &node);
+#endif
+}
+
+void DirectoryModel::unwatch(Node& node)
+{
+    if (node.watch_descriptor < 0)
+        return;
+#ifdef __linux__
+    inotify_rm_watch(m_watch_fd, node.watch_descriptor);
+#endif
+    m_nodes_by_watch_descriptor.remove(node.watch_descriptor);
+    node.watch_descriptor = -1;
+}
+
+void DirectoryModel::handle_watch_events()
+{
+#ifdef __linux__
+    alignas(inotify_event) u8 buffer[16 * KiB];
+    for (;;) {
+        auto nread = read(m_watch_fd, buffer, sizeof(buffer));
+        if (nread <= 0)
+            break;
+        for (ssize_t offset = 0; offset < nread;) {
+            auto& event = *reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event.len;
+
+            if (event.mask & IN_Q_OVERFLOW) {
+                // Some changes were dropped, so there's no telling what changed.
+                reread_directories(*m_root, true);
+                continue;
+            }
+
+            auto* node = m_nodes_by_watch_descriptor.get(event.wd).value_or(nullptr);
+            if (!node)
+                continue;
+            if (event.mask & IN_IGNORED) {
+                m_nodes_by_watch_descriptor.remove(event.wd);
+                node->watch_descriptor = -1;
+                continue;
+            }
+            if (event.mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                // Other directories are removed when their parent hears about it; the root has no parent to tell us.
+                if (node == m_root.ptr())
+                    read_directory(*m_root);
+                continue;
+            }
+            if (!event.len)
+                continue;
+
+            StringView name { event.name };
+            if (!m_should_show_dotfiles && name.starts_with('.'))
+                continue;
+            node->changed_names.set(name);
+            m_nodes_with_changes.set(node);
+        }
+    }
+    if (!m_nodes_with_changes.is_empty() && !m_change_timer->is_active())
+        m_change_timer->start();
+#endif
+}
+
+void DirectoryModel::stat_changed_entries()
+{
+    m_change_timer->stop();
+    auto nodes = move(m_nodes_with_changes);
+    for (auto* node : nodes) {
+        // Changes that come in while a directory is being read are looked at once it's done.
+        if (node->is_reading() || node->changed_names.is_empty())
+            continue;
+
+        Vector<String> names;
+        names.ensure_capacity(node->changed_names.size());
+        for (auto& name : node->changed_names)
+            names.unchecked_append(name);
+        node->changed_names.clear();
+
+        auto path = node->full_path();
+        DirectoryScanner::stat_entries(path, names, [this, liveness = m_liveness, path, names](auto& metadata) {
+            if (liveness->is_alive)
+                did_stat_changed_entries(path, names, metadata);
+        });
+    }
+}
+
+void DirectoryModel::did_stat_changed_entries(const String& directory_path, const Vector<String>& names, const Vector<DirectoryScanner::Metadata>& metadata)
+{
+    auto* node = node_for_path(directory_path);
+    if (!node || !node->has_been_read)
+        return;
+    if (node->is_reading()) {
+        for (auto& name : names)
+            node->changed_names.set(name);
+        return;
+    }
+
+    bool did_remove_children = false;
+    for (size_t i = 0; i < names.size(); ++i) {
+        auto* child = node->children_by_name.get(names[i]).value_or(nullptr);
+        if (!metadata[i].is_valid) {
+            if (child) {
+                remove_child(*node, *child);
+                did_remove_children = true;
+            }
+            continue;
+        }
+        if (!child)
+            child = &add_child(*node, names[i], metadata[i].mode & S_IFMT);
+        set_metadata(*child, metadata[i]);
+    }
+    if (did_remove_children)
+        update_now(UpdateFlag::InvalidateAllIndexes);
+    else
+        schedule_update(UpdateFlag::DontInvalidateIndexes);
+}
+
+bool DirectoryModel::accepts_drag(const GUI::ModelIndex& index, const Vector<String>& mime_types) const
+{
+    if (!mime_types.contains_slow("text/uri-list"))
+        return false;
+    if (!index.is_valid())
+        return true;
+    return node(index).is_directory();
+}
+
+bool DirectoryModel::is_editable(const GUI::ModelIndex& index) const
+{
+    return index.is_valid() && index.column() == Column::Name;
+}
+
+void DirectoryModel::set_data(const GUI::ModelIndex& index, const GUI::Variant& data)
+{
+    VERIFY(is_editable(index));
+    auto& node = mutable_node(index);
+    auto new_name = data.to_string();
+    if (new_name.is_empty() || new_name == node.name || new_name.contains("/"))
+        return;
+
+    auto& parent = *node.parent;
+    auto new_path = LexicalPath::canonicalized_path(String::formatted("{}/{}", parent.full_path(), new_name));
+    if (rename(node.full_path().characters(), new_path.characters()) < 0) {
+        auto saved_errno = errno;
+        if (on_rename_error)
+            on_rename_error(saved_errno, strerror(saved_errno));
+        return;
+    }
+
+    // Whatever had the new name before has just been replaced.
+    if (auto* replaced = parent.children_by_name.get(new_name).value_or(nullptr))
+        remove_child(parent, *replaced);
+    parent.children_by_name.remove(node.name);
+    node.name = new_name;
+    parent.children_by_name.set(node.name, &node);
+
+    // Everything below a renamed directory has a new path, so it's simply read again when needed.
+    if (node.is_directory()) {
+        forget_subtree(node);
+        node.children.clear();
+        node.children_by_name.clear();
+        node.total_size = 0;
+        node.has_been_read = false;
+    }
+    update_now(UpdateFlag::InvalidateAllIndexes);
+}
+
+Vector<GUI::ModelIndex, 1> DirectoryModel::matches(const StringView& searching, unsigned flags, const GUI::ModelIndex& index)
+{
+    auto& node = this->node(index);
+    Vector<GUI::ModelIndex, 1> found_indexes;
+    for (auto& child : node.children) {
+        bool is_match = (flags & MatchesFlag::MatchFull) ? child.name == searching : child.name.view().contains(searching);
+        if (!is_match)
+            continue;
+        found_indexes.append(this->index(child, Column::Name));
+        if (flags & MatchesFlag::FirstMatchOnly)
+            break;
+    }
+    return found_indexes;
+}
+
+}
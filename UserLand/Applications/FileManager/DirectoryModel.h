@@ -0,0 +1,212 @@
+#pragma once
+
+#include "DirectoryScanner.h"
+#include "ThumbnailCache.h"
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/OwnPtr.h>
+#include <AK/String.h>
+#include <LibCore/Notifier.h>
+#include <LibCore/Timer.h>
+#include <LibGUI/Icon.h>
+#include <LibGUI/Model.h>
+#include <LibGfx/Bitmap.h>
+#include <sys/stat.h>
+
+namespace FileManager {
+
+// The file system below a root directory, as a DirectoryView shows it.
+//
+// Unlike GUI::FileSystemModel, this never waits for the disk on the GUI
+// thread. A directory is read by a DirectoryScanner the first time its rows
+// are asked for, and its entries show up in batches while the rest of it is
+// still being read and stat-ed. Views hear about new rows at most every
+// update_interval_ms, so they don't re-sort a huge directory for every batch.
+// Removals are reported right away, since the views' indexes point at the
+// nodes that were removed.
+//
+// Directories that have been read are watched for changes where the system
+// supports it (inotify), and only the entries that changed are stat-ed again.
+// Without a watch, update() reads the directory again and merges the result
+// into the existing nodes, so unchanged rows keep their indexes.
+//
+// Image files show their thumbnail from the ThumbnailCache as their icon, and
+// a generic image icon until it's there.
+class DirectoryModel final
+    : public GUI::Model
+    , private ThumbnailCache::Client {
+public:
+    enum Column {
+        Icon = 0,
+        Name,
+        Size,
+        Owner,
+        Group,
+        Permissions,
+        ModificationTime,
+        Inode,
+        SymlinkTarget,
+        __Count,
+    };
+
+    static constexpr int update_interval_ms = 100;
+
+    class Node {
+        AK_MAKE_NONCOPYABLE(Node);
+        AK_MAKE_NONMOVABLE(Node);
+
+    public:
+        Node() = default;
+
+        String name;
+        String symlink_target;
+        size_t size { 0 };
+        mode_t mode { 0 };
+        uid_t uid { 0 };
+        gid_t gid { 0 };
+        ino_t inode { 0 };
+        time_t mtime { 0 };
+        // Until this is set, only the file type bits of the mode are known, if any.
+        bool has_metadata { false };
+        // For directories, the sizes of all children read so far added up.
+        size_t total_size { 0 };
+
+        bool is_directory() const { return S_ISDIR(mode); }
+        bool is_executable() const { return mode & (S_IXUSR | S_IXGRP | S_IXOTH); }
+        bool is_reading() const { return scanner; }
+        String full_path() const;
+
+    private:
+        friend class DirectoryModel;
+
+        Node* parent { nullptr };
+        int row { 0 };
+        NonnullOwnPtrVector<Node> children;
+        HashMap<String, Node*> children_by_name;
+
+        bool has_been_read { false };
+        RefPtr<DirectoryScanner> scanner;
+        u32 scan_generation { 0 };
+        // For children: the scan_generation of the parent's last scan that reported this entry.
+        u32 seen_in_generation { 0 };
+        // The children in the order the current scan reported them, to match up the metadata that follows.
+        // Children that were removed since are null.
+        Vector<Node*> scanned_children;
+
+        int watch_descriptor { -1 };
+        // Entries that were reported as changed and haven't been stat-ed again yet.
+        HashTable<String> changed_names;
+    };
+
+    static NonnullRefPtr<DirectoryModel> create(const StringView& root_path = {})
+    {
+        return adopt(*new DirectoryModel(root_path));
+    }
+    virtual ~DirectoryModel() override;
+
+    String root_path() const;
+    void set_root_path(const StringView&);
+
+    // The root node for an invalid index.
+    const Node& node(const GUI::ModelIndex&) const;
+    GUI::ModelIndex index(const Node&, int column) const;
+
+    bool should_show_dotfiles() const { return m_should_show_dotfiles; }
+    void set_should_show_dotfiles(bool);
+
+    bool has_read_root() const { return m_root->has_been_read && !m_root->is_reading(); }
+
+    Function<void(int error, const char* error_string)> on_error;
+    // The root directory was opened. Its entries keep coming in afterwards.
+    Function<void()> on_complete;
+    // All entries of the root directory and their metadata have arrived.
+    Function<void()> on_root_read;
+    Function<void(int error, const char* error_string)> on_rename_error;
+    Function<void(int done, int total)> on_thumbnail_progress;
+
+    virtual int row_count(const GUI::ModelIndex& = GUI::ModelIndex()) const override;
+    virtual int column_count(const GUI::ModelIndex& = GUI::ModelIndex()) const override;
+    virtual String column_name(int column) const override;
+    virtual GUI::Variant data(const GUI::ModelIndex&, GUI::ModelRole = GUI::ModelRole::Display) const override;
+    virtual void update() override;
+    virtual GUI::ModelIndex parent_index(const GUI::ModelIndex&) const override;
+    virtual GUI::ModelIndex index(int row, int column = 0, const GUI::ModelIndex& parent = GUI::ModelIndex()) const override;
+    virtual int tree_column() const override { return Column::Name; }
+    virtual StringView drag_data_type() const override { return "text/uri-list"; }
+    virtual bool accepts_drag(const GUI::ModelIndex&, const Vector<String>& mime_types) const override;
+    virtual bool is_column_sortable(int column_index) const override { return column_index != Column::Icon; }
+    virtual bool is_editable(const GUI::ModelIndex&) const override;
+    virtual void set_data(const GUI::ModelIndex&, const GUI::Variant&) override;
+    virtual Vector<GUI::ModelIndex, 1> matches(const StringView&, unsigned = MatchesFlag::AllMatching, const GUI::ModelIndex& = GUI::ModelIndex()) override;
+
+private:
+    explicit DirectoryModel(const StringView& root_path);
+
+    // Callbacks from the worker pool may arrive after the model is gone, so they hold on to this instead.
+    struct Liveness : public RefCounted<Liveness> {
+        bool is_alive { true };
+    };
+
+    Node& mutable_node(const GUI::ModelIndex& index) { return const_cast<Node&>(node(index)); }
+    Node* node_for_path(const StringView&);
+
+    void read_directory(Node&);
+    void did_read_entries(Node&, size_t first_index, const Vector<DirectoryScanner::Entry>&);
+    void did_read_metadata(Node&, size_t first_index, const Vector<DirectoryScanner::Metadata>&);
+    void did_finish_reading(Node&);
+    // Reads the directories that have been read before again; those with a watch only if even_if_watched.
+    void reread_directories(Node&, bool even_if_watched);
+
+    Node& add_child(Node& parent, const String& name, mode_t type);
+    void set_metadata(Node&, const DirectoryScanner::Metadata&);
+    // Removes the children that the last scan didn't report.
+    void remove_stale_children(Node& parent);
+    // The caller has to update_now() before returning to the event loop, since views may still hold indexes of the child.
+    void remove_child(Node& parent, Node& child);
+    void forget_subtree(Node&);
+    void renumber_children(Node& parent, size_t from_row);
+
+    // Only for updates that add rows or change their data. Views keep the old row counts until then.
+    void schedule_update(unsigned flags);
+    // For removals: the views' indexes point at the freed nodes until they've been told.
+    void update_now(unsigned flags);
+    void flush_update();
+
+    void watch(Node&);
+    void unwatch(Node&);
+    void handle_watch_events();
+    void stat_changed_entries();
+    void did_stat_changed_entries(const String& directory_path, const Vector<String>& names, const Vector<DirectoryScanner::Metadata>&);
+
+    GUI::Icon icon_for(const Node&) const;
+    void did_request_thumbnail(const String& path);
+    virtual void thumbnail_did_finish(const String& path) override;
+    const String& user_name(uid_t) const;
+    const String& group_name(gid_t) const;
+
+    OwnPtr<Node> m_root;
+    bool m_should_show_dotfiles { false };
+    NonnullRefPtr<Liveness> m_liveness;
+
+    RefPtr<Core::Timer> m_update_timer;
+    unsigned m_pending_update_flags { 0 };
+    bool m_has_pending_update { false };
+    u64 m_last_update_ms { 0 };
+
+    int m_watch_fd { -1 };
+    RefPtr<Core::Notifier> m_watch_notifier;
+    HashMap<int, Node*> m_nodes_by_watch_descriptor;
+    HashTable<Node*> m_nodes_with_changes;
+    RefPtr<Core::Timer> m_change_timer;
+
+    // Thumbnails this model is waiting for, to count them for on_thumbnail_progress.
+    HashTable<String> m_pending_thumbnails;
+    int m_thumbnail_progress { 0 };
+    int m_thumbnail_progress_total { 0 };
+
+    mutable HashMap<uid_t, String> m_user_names;
+    mutable HashMap<gid_t, String> m_group_names;
+};
+
+}
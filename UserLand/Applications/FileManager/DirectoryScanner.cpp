@@ -0,0 +1,205 @@
+#include "DirectoryScanner.h"
+#include <AK/Format.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace FileManager {
+
+DirectoryScanner::DirectoryScanner(const String& path, bool include_dotfiles, WorkerPool& pool)
+    : m_pool(pool)
+    , m_path(path)
+    , m_include_dotfiles(include_dotfiles)
+{
+}
+
+DirectoryScanner::~DirectoryScanner()
+{
+    if (m_directory)
+        closedir(m_directory);
+}
+
+void DirectoryScanner::start()
+{
+    VERIFY(!m_directory);
+    m_pending_jobs = 1;
+    m_pool.submit([this, protector = NonnullRefPtr(*this)] {
+        m_directory = opendir(m_path.characters());
+        if (!m_directory) {
+            m_pool.post_to_main_thread([this, protector, error = errno] {
+                if (!is_cancelled() && on_error)
+                    on_error(error);
+            });
+            return;
+        }
+        m_directory_fd = dirfd(m_directory);
+        read_entries();
+    });
+}
+
+void DirectoryScanner::cancel()
+{
+    m_cancelled.store(true, AK::MemoryOrder::memory_order_relaxed);
+}
+
+mode_t DirectoryScanner::type_from_dirent(const dirent& entry)
+{
+    switch (entry.d_type) {
+    case DT_REG:
+        return S_IFREG;
+    case DT_DIR:
+        return S_IFDIR;
+    case DT_LNK:
+        return S_IFLNK;
+    case DT_CHR:
+        return S_IFCHR;
+    case DT_BLK:
+        return S_IFBLK;
+    case DT_FIFO:
+        return S_IFIFO;
+    case DT_SOCK:
+        return S_IFSOCK;
+    default:
+        return 0;
+    }
+}
+
+DirectoryScanner::Metadata DirectoryScanner::stat_entry(int directory_fd, const char* name)
+{
+    Metadata metadata;
+#ifdef STATX_BASIC_STATS
+    // Skips the fields we don't show, like the block counts and the access and change times.
+    struct statx stx;
+    unsigned mask = STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_UID | STATX_GID | STATX_INO | STATX_MTIME;
+    if (statx(directory_fd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, mask, &stx) < 0)
+        return metadata;
+    metadata.mode = stx.stx_mode;
+    metadata.size = stx.stx_size;
+    metadata.uid = stx.stx_uid;
+    metadata.gid = stx.stx_gid;
+    metadata.inode = stx.stx_ino;
+    metadata.mtime = stx.stx_mtime.tv_sec;
+#else
+    struct stat st;
+    if (fstatat(directory_fd, name, &st, AT_SYMLINK_NOFOLLOW) < 0)
+        return metadata;
+    metadata.mode = st.st_mode;
+    metadata.size = st.st_size;
+    metadata.uid = st.st_uid;
+    metadata.gid = st.st_gid;
+    metadata.inode = st.st_ino;
+    metadata.mtime = st.st_mtime;
+#endif
+    metadata.is_valid = true;
+
+    if (S_ISLNK(metadata.mode)) {
+        char buffer[PATH_MAX];
+        auto length = readlinkat(directory_fd, name, buffer, sizeof(buffer));
+        if (length > 0)
+            metadata.symlink_target = String(buffer, length);
+    }
+    return metadata;
+}
+
+void DirectoryScanner::read_entries()
+{
+    size_t next_index = 0;
+    Vector<Entry> batch;
+    batch.ensure_capacity(batch_size);
+
+    auto deliver_batch = [&] {
+        auto first_index = next_index;
+        next_index += batch.size();
+        ++m_pending_jobs;
+        m_pool.post_to_main_thread([this, protector = NonnullRefPtr(*this), first_index, entries = batch] {
+            if (!is_cancelled() && on_entries)
+                on_entries(first_index, entries);
+        });
+        m_pool.submit([this, protector = NonnullRefPtr(*this), first_index, entries = move(batch)] {
+            stat_batch(first_index, entries);
+            finish_job();
+        });
+        batch = {};
+        batch.ensure_capacity(batch_size);
+    };
+
+    for (;;) {
+        if (is_cancelled())
+            break;
+        errno = 0;
+        auto* entry = readdir(m_directory);
+        if (!entry) {
+            if (errno)
+                dbgln("DirectoryScanner: readdir({}) failed: {}", m_path, strerror(errno));
+            break;
+        }
+        StringView name { entry->d_name };
+        if (name == "." || name == "..")
+            continue;
+        if (!m_include_dotfiles && name.starts_with('.'))
+            continue;
+        batch.append({ name, type_from_dirent(*entry) });
+        if (batch.size() == batch_size)
+            deliver_batch();
+    }
+    if (!batch.is_empty())
+        deliver_batch();
+    finish_job();
+}
+
+void DirectoryScanner::stat_batch(size_t first_index, const Vector<Entry>& entries)
+{
+    Vector<Metadata> metadata;
+    metadata.ensure_capacity(entries.size());
+    for (auto& entry : entries) {
+        if (is_cancelled())
+            return;
+        metadata.unchecked_append(stat_entry(m_directory_fd, entry.name.characters()));
+    }
+    m_pool.post_to_main_thread([this, protector = NonnullRefPtr(*this), first_index, metadata = move(metadata)] {
+        if (!is_cancelled() && on_metadata)
+            on_metadata(first_index, metadata);
+    });
+}
+
+void DirectoryScanner::finish_job()
+{
+    // Whoever finishes last has posted all of its batches already, so on_complete comes after every one of them.
+    if (m_pending_jobs.fetch_sub(1) != 1)
+        return;
+    m_pool.post_to_main_thread([this, protector = NonnullRefPtr(*this)] {
+        if (!is_cancelled() && on_complete)
+            on_complete();
+    });
+}
+
+void DirectoryScanner::stat_entries(const String& directory_path, Vector<String> names, Function<void(const Vector<Metadata>&)> on_done, WorkerPool& pool)
+{
+    struct Request : public RefCounted<Request> {
+        String directory_path;
+        Vector<String> names;
+        Function<void(const Vector<Metadata>&)> on_done;
+    };
+    auto request = adopt(*new Request);
+    request->directory_path = directory_path;
+    request->names = move(names);
+    request->on_done = move(on_done);
+
+    pool.submit([&pool, request] {
+        Vector<Metadata> metadata;
+        metadata.ensure_capacity(request->names.size());
+        int directory_fd = open(request->directory_path.characters(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        for (auto& name : request->names)
+            metadata.unchecked_append(directory_fd < 0 ? Metadata {} : stat_entry(directory_fd, name.characters()));
+        if (directory_fd >= 0)
+            close(directory_fd);
+        pool.post_to_main_thread([request, metadata = move(metadata)] {
+            request->on_done(metadata);
+        });
+    });
+}
+
+}
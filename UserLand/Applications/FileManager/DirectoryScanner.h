@@ -0,0 +1,89 @@
+#pragma once
+
+#include "WorkerPool.h"
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <time.h>
+
+namespace FileManager {
+
+// Reads a directory on the worker pool and streams its entries to the main
+// thread in batches, so that even huge directories start showing up at once.
+//
+// A batch first arrives with just the names and, where the file system keeps
+// it in the directory itself, the file types. The entries of each batch are
+// then stat-ed on the pool while the next batch is being read, and their
+// metadata follows in on_metadata. Where statx() is available, only the
+// fields a DirectoryModel shows are asked for.
+//
+// All callbacks run on the main thread, from WorkerPool::process_completions().
+class DirectoryScanner : public RefCounted<DirectoryScanner> {
+public:
+    static constexpr size_t batch_size = 256;
+
+    struct Metadata {
+        // False if the entry has vanished or could not be stat-ed.
+        bool is_valid { false };
+        mode_t mode { 0 };
+        off_t size { 0 };
+        uid_t uid { 0 };
+        gid_t gid { 0 };
+        ino_t inode { 0 };
+        time_t mtime { 0 };
+        String symlink_target;
+    };
+
+    struct Entry {
+        String name;
+        // The S_IFMT bits of the mode, or 0 if the directory entry doesn't say.
+        mode_t type { 0 };
+    };
+
+    static NonnullRefPtr<DirectoryScanner> create(const String& path, bool include_dotfiles, WorkerPool& pool = WorkerPool::the())
+    {
+        return adopt(*new DirectoryScanner(path, include_dotfiles, pool));
+    }
+    ~DirectoryScanner();
+
+    // first_index is the position of the batch's first entry among all entries of this scan.
+    Function<void(size_t first_index, const Vector<Entry>&)> on_entries;
+    Function<void(size_t first_index, const Vector<Metadata>&)> on_metadata;
+    Function<void(int error)> on_error;
+    // Runs after all entries and their metadata have been delivered.
+    Function<void()> on_complete;
+
+    void start();
+    // Drops everything that has not been delivered yet. No callbacks run after this.
+    void cancel();
+    bool is_cancelled() const { return m_cancelled.load(AK::MemoryOrder::memory_order_relaxed); }
+
+    // Stats some entries of a directory on the pool, e.g. after they were reported as changed.
+    static void stat_entries(const String& directory_path, Vector<String> names, Function<void(const Vector<Metadata>&)> on_done, WorkerPool& pool = WorkerPool::the());
+
+private:
+    DirectoryScanner(const String& path, bool include_dotfiles, WorkerPool&);
+
+    static Metadata stat_entry(int directory_fd, const char* name);
+    static mode_t type_from_dirent(const dirent&);
+
+    void read_entries();
+    void stat_batch(size_t first_index, const Vector<Entry>&);
+    void finish_job();
+
+    WorkerPool& m_pool;
+    String m_path;
+    DIR* m_directory { nullptr };
+    int m_directory_fd { -1 };
+    bool m_include_dotfiles { false };
+    Atomic<bool> m_cancelled { false };
+    // The reader and every batch still being stat-ed.
+    Atomic<size_t> m_pending_jobs { 0 };
+};
+
+}
@@ -0,0 +1,284 @@
+#include "DirectorySizeCalculator.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace FileManager {
+
+// Directories are only cached once their mtime is this far in the past, since
+// another change within the same second would leave the mtime as it is.
+static constexpr time_t cache_settle_seconds = 2;
+static constexpr size_t max_cache_entries = 100000;
+
+static void add_totals(DirectorySizeCalculator::Totals& totals, const DirectorySizeCalculator::Totals& other)
+{
+    totals.size += other.size;
+    totals.file_count += other.file_count;
+    totals.directory_count += other.directory_count;
+}
+
+static String child_path(const String& path, const StringView& name)
+{
+    if (path == "/")
+        return String::formatted("/{}", name);
+    return String::formatted("{}/{}", path, name);
+}
+
+struct DirectorySizeCalculator::DirectoryData {
+    DirectoryData() { pthread_mutex_init(&mutex, nullptr); }
+    ~DirectoryData() { pthread_mutex_destroy(&mutex); }
+
+    String path;
+    dev_t device { 0 };
+    ino_t inode { 0 };
+    time_t mtime { 0 };
+
+    // Guards the totals, which finished subdirectories add themselves to.
+    pthread_mutex_t mutex;
+    // Everything except files with several hard links. Those are in linked_files so they can be counted once.
+    Totals totals;
+    HashMap<InodeKey, u64> linked_files;
+};
+
+// What a directory contains directly. The subdirectories' own contents have entries of their own.
+struct DirectorySizeCalculator::CacheEntry {
+    dev_t device { 0 };
+    ino_t inode { 0 };
+    time_t mtime { 0 };
+    // The files, and a directory_count that includes every subdirectory and mount point.
+    Totals totals;
+    HashMap<InodeKey, u64> linked_files;
+    // Those on the same file system, which the walk goes into.
+    Vector<String> subdirectory_names;
+};
+
+static pthread_mutex_t s_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+HashMap<String, DirectorySizeCalculator::CacheEntry>& DirectorySizeCalculator::cache()
+{
+    static HashMap<String, CacheEntry>* s_cache;
+    if (!s_cache)
+        s_cache = new HashMap<String, CacheEntry>;
+    return *s_cache;
+}
+
+Optional<DirectorySizeCalculator::CacheEntry> DirectorySizeCalculator::find_in_cache(const Directory& directory)
+{
+    Optional<CacheEntry> result;
+    pthread_mutex_lock(&s_cache_mutex);
+    if (auto it = cache().find(directory.path); it != cache().end()) {
+        auto& entry = it->value;
+        if (entry.device == directory.device && entry.inode == directory.inode && entry.mtime == directory.mtime)
+            result = entry;
+    }
+    pthread_mutex_unlock(&s_cache_mutex);
+    return result;
+}
+
+void DirectorySizeCalculator::add_to_cache(const Directory& directory, CacheEntry&& entry)
+{
+    if (directory.mtime > time(nullptr) - cache_settle_seconds)
+        return;
+
+    entry.device = directory.device;
+    entry.inode = directory.inode;
+    entry.mtime = directory.mtime;
+
+    pthread_mutex_lock(&s_cache_mutex);
+    // Directories are only ever looked up by path, so there's nothing smarter to evict.
+    if (cache().size() >= max_cache_entries)
+        cache().clear();
+    cache().set(directory.path, move(entry));
+    pthread_mutex_unlock(&s_cache_mutex);
+}
+
+DirectorySizeCalculator::DirectorySizeCalculator(const String& path, WorkerPool& pool)
+    : m_pool(pool)
+    , m_walk(*this, pool)
+    , m_path(path)
+{
+    pthread_mutex_init(&m_mutex, nullptr);
+}
+
+DirectorySizeCalculator::~DirectorySizeCalculator()
+{
+    pthread_mutex_destroy(&m_mutex);
+}
+
+void DirectorySizeCalculator::start()
+{
+    m_pool.submit([this, protector = NonnullRefPtr(*this)] {
+        // Anything but a directory has nothing below it.
+        struct stat st;
+        if (lstat(m_path.characters(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            m_device = st.st_dev;
+            m_walk.add_root([&](Directory& root) {
+                root.path = m_path;
+                root.device = st.st_dev;
+                root.inode = st.st_ino;
+                root.mtime = st.st_mtime;
+            });
+        }
+        m_walk.finish_adding_roots();
+    });
+}
+
+void DirectorySizeCalculator::cancel()
+{
+    m_cancelled.store(true, AK::MemoryOrder::memory_order_relaxed);
+}
+
+void DirectorySizeCalculator::visit(Directory& directory)
+{
+    if (is_cancelled()) {
+        m_walk.finish(directory);
+        return;
+    }
+
+    CacheEntry entry;
+    if (auto cached = find_in_cache(directory); cached.has_value()) {
+        entry = cached.release_value();
+        // The names are all that's known about the subdirectories, which may have changed since.
+        for (auto& name : entry.subdirectory_names) {
+            if (is_cancelled())
+                break;
+            struct stat st;
+            if (lstat(child_path(directory.path, name).characters(), &st) < 0 || !S_ISDIR(st.st_mode) || st.st_dev != m_device)
+                continue;
+            add_subdirectory(directory, name, st);
+        }
+    } else {
+        if (!read_directory(directory, entry)) {
+            m_walk.finish(directory);
+            return;
+        }
+    }
+
+    pthread_mutex_lock(&directory.mutex);
+    add_totals(directory.totals, entry.totals);
+    for (auto& it : entry.linked_files)
+        directory.linked_files.set(it.key, it.value);
+    pthread_mutex_unlock(&directory.mutex);
+
+    add_to_progress(entry.totals, entry.linked_files);
+    m_walk.finish(directory);
+}
+
+bool DirectorySizeCalculator::read_directory(Directory& directory, CacheEntry& entry)
+{
+    int fd = open(directory.path.characters(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    DIR* dir = fd < 0 ? nullptr : fdopendir(fd);
+    if (!dir) {
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    while (auto* dirent = readdir(dir)) {
+        if (is_cancelled())
+            break;
+        StringView name { dirent->d_name };
+        if (name == "." || name == "..")
+            continue;
+
+        struct stat st;
+        if (fstatat(fd, dirent->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0)
+            continue;
+
+        if (!S_ISDIR(st.st_mode)) {
+            if (st.st_nlink > 1) {
+                entry.linked_files.set({ st.st_dev, st.st_ino }, st.st_size);
+                continue;
+            }
+            entry.totals.size += st.st_size;
+            ++entry.totals.file_count;
+            continue;
+        }
+
+        ++entry.totals.directory_count;
+        // Like du -x: mount points are counted, but what's mounted on them isn't.
+        if (st.st_dev != m_device)
+            continue;
+
+        entry.subdirectory_names.append(name);
+        add_subdirectory(directory, name, st);
+    }
+    closedir(dir);
+
+    // A cancelled read may have skipped entries.
+    if (!is_cancelled())
+        add_to_cache(directory, CacheEntry(entry));
+    return true;
+}
+
+void DirectorySizeCalculator::add_subdirectory(Directory& parent, const StringView& name, const struct stat& st)
+{
+    m_walk.add_subdirectory(parent, [&](Directory& child) {
+        child.path = child_path(parent.path, name);
+        child.device = st.st_dev;
+        child.inode = st.st_ino;
+        child.mtime = st.st_mtime;
+    });
+}
+
+void DirectorySizeCalculator::add_to_progress(const Totals& totals, const HashMap<InodeKey, u64>& linked_files)
+{
+    pthread_mutex_lock(&m_mutex);
+    add_totals(m_progress, totals);
+    for (auto& it : linked_files) {
+        if (m_counted_links.set(it.key) != AK::HashSetResult::InsertedNewEntry)
+            continue;
+        m_progress.size += it.value;
+        ++m_progress.file_count;
+    }
+
+    auto now = WorkerPool::now_ms();
+    if (now - m_last_progress_ms >= progress_interval_ms) {
+        m_last_progress_ms = now;
+        m_pool.post_to_main_thread([this, protector = NonnullRefPtr(*this), totals = m_progress] {
+            if (is_cancelled() || m_completed)
+                return;
+            if (on_progress)
+                on_progress(totals);
+        });
+    }
+    pthread_mutex_unlock(&m_mutex);
+}
+
+DirectorySizeCalculator::Totals DirectorySizeCalculator::totals_with_links(const Totals& totals, const HashMap<InodeKey, u64>& linked_files)
+{
+    auto result = totals;
+    for (auto& it : linked_files) {
+        result.size += it.value;
+        ++result.file_count;
+    }
+    return result;
+}
+
+void DirectorySizeCalculator::did_finish(Directory& directory)
+{
+    auto* parent = directory.parent;
+    if (!parent) {
+        m_totals = totals_with_links(directory.totals, directory.linked_files);
+        return;
+    }
+    pthread_mutex_lock(&parent->mutex);
+    add_totals(parent->totals, directory.totals);
+    for (auto& it : directory.linked_files)
+        parent->linked_files.set(it.key, it.value);
+    pthread_mutex_unlock(&parent->mutex);
+}
+
+void DirectorySizeCalculator::did_finish_walk()
+{
+    m_pool.post_to_main_thread([this, protector = NonnullRefPtr(*this), totals = m_totals] {
+        if (is_cancelled())
+            return;
+        m_completed = true;
+        if (on_complete)
+            on_complete(totals);
+    });
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "DirectoryWalk.h"
+#include "WorkerPool.h"
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/Optional.h>
+#include <AK/RefCounted.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+
+namespace FileManager {
+
+struct InodeKey {
+    u64 device { 0 };
+    u64 inode { 0 };
+
+    bool operator==(const InodeKey& other) const { return device == other.device && inode == other.inode; }
+};
+
+}
+
+namespace AK {
+
+template<>
+struct Traits<FileManager::InodeKey> : public GenericTraits<FileManager::InodeKey> {
+    static constexpr unsigned hash(const FileManager::InodeKey& key) { return pair_int_hash(u64_hash(key.device), u64_hash(key.inode)); }
+};
+
+}
+
+namespace FileManager {
+
+// Adds up the sizes of everything below a directory, like du(1), without
+// blocking the GUI thread.
+//
+// The directories are read in parallel by a DirectoryWalk, and each adds its
+// totals to its parent's once it's finished. Files with several hard links are
+// counted once, and the walk doesn't leave the directory's file system.
+// Totals so far are reported every progress_interval_ms while it runs.
+//
+// What every directory that has been read contains directly, the sizes of its
+// files and the names of its subdirectories, is kept for the rest of the
+// process and reused as long as the directory's mtime stays the same. Only the
+// directories that changed are read again when sizing the same tree later,
+// though every subdirectory is still stat-ed to find out which those are,
+// since a change deep down doesn't touch the mtimes of the directories above.
+// Note that a file that grows in place doesn't change its directory's mtime.
+class DirectorySizeCalculator : public RefCounted<DirectorySizeCalculator> {
+public:
+    static constexpr int progress_interval_ms = 100;
+
+    struct Totals {
+        u64 size { 0 };
+        u64 file_count { 0 };
+        u64 directory_count { 0 };
+    };
+
+    static NonnullRefPtr<DirectorySizeCalculator> create(const String& path, WorkerPool& pool = WorkerPool::the())
+    {
+        return adopt(*new DirectorySizeCalculator(path, pool));
+    }
+    ~DirectorySizeCalculator();
+
+    // Both run on the main thread. The totals don't include the directory itself.
+    Function<void(const Totals&)> on_progress;
+    Function<void(const Totals&)> on_complete;
+
+    void start();
+    // No callbacks run after this.
+    void cancel();
+    bool is_cancelled() const { return m_cancelled.load(AK::MemoryOrder::memory_order_relaxed); }
+
+private:
+    DirectorySizeCalculator(const String& path, WorkerPool&);
+
+    struct DirectoryData;
+    using Walk = DirectoryWalk<DirectorySizeCalculator, DirectoryData>;
+    using Directory = Walk::Directory;
+    friend Walk;
+    struct CacheEntry;
+
+    static HashMap<String, CacheEntry>& cache();
+    static Optional<CacheEntry> find_in_cache(const Directory&);
+    static void add_to_cache(const Directory&, CacheEntry&&);
+
+    void visit(Directory&);
+    void did_finish(Directory&);
+    void did_finish_walk();
+    // Reads the directory's entries into the entry, and starts on the subdirectories while doing so.
+    bool read_directory(Directory&, CacheEntry&);
+    void add_subdirectory(Directory& parent, const StringView& name, const struct stat&);
+    void add_to_progress(const Totals&, const HashMap<InodeKey, u64>& linked_files);
+
+    static Totals totals_with_links(const Totals&, const HashMap<InodeKey, u64>& linked_files);
+
+    WorkerPool& m_pool;
+    Walk m_walk;
+    String m_path;
+    dev_t m_device { 0 };
+    Atomic<bool> m_cancelled { false };
+    bool m_completed { false };
+    // Only touched by the job that finishes the root.
+    Totals m_totals;
+
+    // Guards everything below.
+    pthread_mutex_t m_mutex;
+    Totals m_progress;
+    HashTable<InodeKey> m_counted_links;
+    u64 m_last_progress_ms { 0 };
+};
+
+}
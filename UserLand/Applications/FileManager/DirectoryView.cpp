@@ -103,7 +103,7 @@ void DirectoryView::handle_activation(const GUI::ModelIndex& index)
 
 DirectoryView::DirectoryView(Mode mode)
     : m_mode(mode)
-    , m_model(GUI::FileSystemModel::create({}))
+    , m_model(DirectoryModel::create())
     , m_sorting_model(GUI::SortingProxyModel::create(m_model))
 {
     set_active_widget(nullptr);
@@ -125,7 +125,7 @@ DirectoryView::DirectoryView(Mode mode)
     set_view_mode(ViewMode::Icon);
 }
 
-const GUI::FileSystemModel::Node& DirectoryView::node(const GUI::ModelIndex& index) const
+const DirectoryModel::Node& DirectoryView::node(const GUI::ModelIndex& index) const
 {
     return model().node(m_sorting_model->map_to_source(index));
 }
@@ -164,6 +164,16 @@ void DirectoryView::setup_model()
             on_path_change(model().root_path(), true, can_write_in_path);
     };
 
+    m_model->on_root_read = [this] {
+        if (!m_entry_to_focus.is_null())
+            select_entry(exchange(m_entry_to_focus, {}));
+        update_statusbar();
+    };
+
+    m_model->on_rename_error = [this](int, const char* error_string) {
+        GUI::MessageBox::show(window(), String::formatted("Unable to rename file: {}", error_string), "Error", GUI::MessageBox::Type::Error);
+    };
+
     m_model->register_client(*this);
 
     m_model->on_thumbnail_progress = [this](int done, int total) {
@@ -195,7 +205,7 @@ void DirectoryView::setup_icon_view()
     }
 
     m_icon_view->set_model(m_sorting_model);
-    m_icon_view->set_model_column(GUI::FileSystemModel::Column::Name);
+    m_icon_view->set_model_column(DirectoryModel::Column::Name);
     m_icon_view->on_activation = [&](auto& index) {
         handle_activation(index);
     };
@@ -223,7 +233,7 @@ void DirectoryView::setup_columns_view()
     };
 
     m_columns_view->set_model(m_sorting_model);
-    m_columns_view->set_model_column(GUI::FileSystemModel::Column::Name);
+    m_columns_view->set_model_column(DirectoryModel::Column::Name);
 
     m_columns_view->on_activation = [&](auto& index) {
         handle_activation(index);
@@ -255,7 +265,7 @@ void DirectoryView::setup_table_view()
     };
 
     m_table_view->set_model(m_sorting_model);
-    m_table_view->set_key_column_and_sort_order(GUI::FileSystemModel::Column::Name, GUI::SortOrder::Ascending);
+    m_table_view->set_key_column_and_sort_order(DirectoryModel::Column::Name, GUI::SortOrder::Ascending);
 
     m_table_view->on_activation = [&](auto& index) {
         handle_activation(index);
@@ -336,6 +346,22 @@ void DirectoryView::open(const StringView& path)
     model().set_root_path(real_path);
 }
 
+void DirectoryView::focus_entry(const String& name)
+{
+    if (model().has_read_root()) {
+        select_entry(name);
+        return;
+    }
+    m_entry_to_focus = name;
+}
+
+void DirectoryView::select_entry(const String& name)
+{
+    auto matches = m_sorting_model->matches(name, GUI::Model::MatchesFlag::MatchFull | GUI::Model::MatchesFlag::FirstMatchOnly);
+    if (!matches.is_empty())
+        current_view().set_cursor(matches.first(), GUI::AbstractView::SelectionUpdate::Set);
+}
+
 void DirectoryView::set_status_message(const StringView& message)
 {
     if (on_status_message)
@@ -376,11 +402,24 @@ void DirectoryView::update_statusbar()
     if (m_view_mode == ViewMode::Invalid)
         return;
 
+    // Model updates and selection changes tend to come in bunches; the status bar only needs the last one.
+    if (m_statusbar_update_pending)
+        return;
+    m_statusbar_update_pending = true;
+    deferred_invoke([this](auto&) {
+        m_statusbar_update_pending = false;
+        update_statusbar_now();
+    });
+}
+
+void DirectoryView::update_statusbar_now()
+{
     size_t total_size = model().node({}).total_size;
     if (current_view().selection().is_empty()) {
-        set_status_message(String::formatted("{} item(s) ({})",
+        set_status_message(String::formatted("{} item(s) ({}){}",
             model().row_count(),
-            human_readable_size(total_size)));
+            human_readable_size(total_size),
+            model().has_read_root() ? "" : ", reading..."));
         return;
     }
 
@@ -442,7 +481,7 @@ Vector<String> DirectoryView::selected_file_paths() const
     auto& model = *view.model();
     view.selection().for_each_index([&](const GUI::ModelIndex& index) {
         auto parent_index = model.parent_index(index);
-        auto name_index = model.index(index.row(), GUI::FileSystemModel::Column::Name, parent_index);
+        auto name_index = model.index(index.row(), DirectoryModel::Column::Name, parent_index);
         auto path = name_index.data(GUI::ModelRole::Custom).to_string();
         paths.append(path);
     });
@@ -545,23 +584,22 @@ void DirectoryView::handle_drop(const GUI::ModelIndex& index, const GUI::DropEve
     if (!target_node.is_directory())
         return;
 
-    bool had_accepted_drop = false;
+    Vector<String> paths_to_copy;
     for (auto& url_to_copy : urls) {
         if (!url_to_copy.is_valid() || url_to_copy.path() == target_node.full_path())
             continue;
         auto new_path = String::formatted("{}/{}", target_node.full_path(), LexicalPath(url_to_copy.path()).basename());
         if (url_to_copy.path() == new_path)
             continue;
-
-        if (auto result = Core::File::copy_file_or_directory(new_path, url_to_copy.path()); result.is_error()) {
-            auto error_message = String::formatted("Could not copy {} into {}: {}", url_to_copy.to_string(), new_path, result.error().error_code);
-            GUI::MessageBox::show(window(), error_message, "File Manager", GUI::MessageBox::Type::Error);
-        } else {
-            had_accepted_drop = true;
-        }
+        paths_to_copy.append(url_to_copy.path());
     }
-    if (had_accepted_drop && on_accepted_drop)
-        on_accepted_drop();
+    if (paths_to_copy.is_empty())
+        return;
+
+    FileUtils::transfer_paths(paths_to_copy, target_node.full_path(), FileUtils::FileOperation::Copy, window(), [this] {
+        if (on_accepted_drop)
+            on_accepted_drop();
+    });
 }
 
 }
@@ -2,12 +2,12 @@
 
 //includes
 
+#include "DirectoryModel.h"
 #include <AK/URL.h>
 #include <AK/Vector.h>
 #include <LibDesktop/Launcher.h>
 #include <LibGUI/Action.h>
 #include <LibGUI/ColumnsView.h>
-#include <LibGUI/FileSystemModel.h>
 #include <LibGUI/IconView.h>
 #include <LibGUI/StackWidget.h>
 #include <LibGUI/TableView.h>
@@ -105,7 +105,10 @@ public:
 
     void set_should_show_dotfiles(bool);
 
-    const GUI::FileSystemModel::Node& node(const GUI::ModelIndex&) const;
+    const DirectoryModel::Node& node(const GUI::ModelIndex&) const;
+
+    // Selects the entry once it has been read; the root directory is read in the background.
+    void focus_entry(const String& name);
 
     bool is_desktop() const { return m_mode == Mode::Desktop; }
 
@@ -120,8 +123,8 @@ public:
 private:
     explicit DirectoryView(Mode);
 
-    const GUI::FileSystemModel& model() const { return *m_model; }
-    GUI::FileSystemModel& model() { return *m_model; }
+    const DirectoryModel& model() const { return *m_model; }
+    DirectoryModel& model() { return *m_model; }
 
     void handle_selection_change();
     void handle_drop(const GUI::ModelIndex&, const GUI::DropEvent&);
@@ -140,17 +143,21 @@ private:
 
     void set_status_message(const StringView&);
     void update_statusbar();
+    void update_statusbar_now();
+    void select_entry(const String& name);
 
     Mode m_mode { Mode::Normal };
     ViewMode m_view_mode { Invalid };
 
-    NonnullRefPtr<GUI::FileSystemModel> m_model;
+    NonnullRefPtr<DirectoryModel> m_model;
     NonnullRefPtr<GUI::SortingProxyModel> m_sorting_model;
     size_t m_path_history_position { 0 };
     Vector<String> m_path_history;
     void add_path_to_history(const StringView& path);
 
     RefPtr<GUI::Label> m_error_label;
+    String m_entry_to_focus;
+    bool m_statusbar_update_pending { false };
 
     RefPtr<GUI::TableView> m_table_view;
     RefPtr<GUI::IconView> m_icon_view;
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "WorkerPool.h"
+#include <AK/Atomic.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullRefPtr.h>
+
+namespace FileManager {
+
+// The bookkeeping for walking directory trees on the worker pool.
+//
+// Every directory gets its own job, so idle workers steal whole subtrees from
+// busy ones. A directory is finished once its job and all of its
+// subdirectories are, so the owner hears about directories bottom-up, which is
+// what it needs to add up their sizes or to remove them once they're empty.
+//
+// The owner is RefCounted and kept alive by the jobs. Its Data is what it
+// keeps per directory. It has three members for the walk to call, on
+// whichever worker gets there:
+//
+//   void visit(Directory&)       The job of a directory. It adds the
+//                                subdirectories it finds and then calls
+//                                finish() on the directory.
+//   void did_finish(Directory&)  Everything below the directory has finished,
+//                                and so has it. It's deleted right after, and
+//                                its parent is still around.
+//   void did_finish_walk()       Every root has finished.
+template<typename Owner, typename Data>
+class DirectoryWalk {
+    AK_MAKE_NONCOPYABLE(DirectoryWalk);
+    AK_MAKE_NONMOVABLE(DirectoryWalk);
+
+public:
+    struct Directory : public Data {
+        // Null for roots.
+        Directory* parent { nullptr };
+        // Its own job, and every subdirectory that hasn't finished yet.
+        Atomic<size_t> pending_count { 1 };
+    };
+
+    DirectoryWalk(Owner& owner, WorkerPool& pool)
+        : m_owner(owner)
+        , m_pool(pool)
+    {
+    }
+
+    // `initialize` is called with the new directory before its job is submitted.
+    template<typename Initializer>
+    void add_root(Initializer initialize)
+    {
+        ++m_pending_root_count;
+        submit(create(nullptr, initialize));
+    }
+
+    template<typename Initializer>
+    void add_subdirectory(Directory& parent, Initializer initialize)
+    {
+        ++parent.pending_count;
+        submit(create(&parent, initialize));
+    }
+
+    // The walk can't finish before this, even if every root added so far has.
+    void finish_adding_roots() { finish_root(); }
+
+    void finish(Directory& directory)
+    {
+        for (auto* current = &directory; --current->pending_count == 0;) {
+            auto* parent = current->parent;
+            m_owner.did_finish(*current);
+            delete current;
+            if (!parent) {
+                finish_root();
+                return;
+            }
+            current = parent;
+        }
+    }
+
+private:
+    template<typename Initializer>
+    Directory* create(Directory* parent, Initializer& initialize)
+    {
+        auto* directory = new Directory;
+        directory->parent = parent;
+        initialize(*directory);
+        return directory;
+    }
+
+    void submit(Directory* directory)
+    {
+        m_pool.submit([&owner = m_owner, protector = NonnullRefPtr<Owner>(m_owner), directory] {
+            owner.visit(*directory);
+        });
+    }
+
+    void finish_root()
+    {
+        if (--m_pending_root_count == 0)
+            m_owner.did_finish_walk();
+    }
+
+    Owner& m_owner;
+    WorkerPool& m_pool;
+    // Every root that hasn't finished yet, and one until finish_adding_roots().
+    Atomic<size_t> m_pending_root_count { 1 };
+};
+
+}
@@ -0,0 +1,254 @@
+#include "FileDeletion.h"
+#include <AK/LexicalPath.h>
+#include <AK/StringBuilder.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace FileManager {
+
+// Removed entries are added to the progress this many at a time, so the workers don't queue up on its lock.
+static constexpr size_t progress_batch_size = 256;
+
+// Reads the entries of a directory without taking over its descriptor, which the *at() calls keep using.
+class DirectoryReader {
+public:
+#ifdef __linux__
+    explicit DirectoryReader(int fd)
+        : m_fd(fd)
+    {
+    }
+
+    // Returns false at the end of the directory, and when reading it failed, which error() then says why.
+    bool next(const char*& name, unsigned char& type)
+    {
+        if (m_offset >= m_size) {
+            ssize_t nread;
+            do {
+                nread = getdents64(m_fd, m_buffer, sizeof(m_buffer));
+            } while (nread < 0 && errno == EINTR);
+            if (nread <= 0) {
+                if (nread < 0)
+                    m_error = errno;
+                return false;
+            }
+            m_size = nread;
+            m_offset = 0;
+        }
+        auto* entry = reinterpret_cast<const dirent64*>(m_buffer + m_offset);
+        m_offset += entry->d_reclen;
+        name = entry->d_name;
+        type = entry->d_type;
+        return true;
+    }
+#else
+    explicit DirectoryReader(int fd)
+    {
+        int reader_fd = dup(fd);
+        m_dir = reader_fd < 0 ? nullptr : fdopendir(reader_fd);
+        if (!m_dir) {
+            m_error = errno;
+            if (reader_fd >= 0)
+                close(reader_fd);
+        }
+    }
+
+    ~DirectoryReader()
+    {
+        if (m_dir)
+            closedir(m_dir);
+    }
+
+    bool next(const char*& name, unsigned char& type)
+    {
+        if (!m_dir)
+            return false;
+        errno = 0;
+        auto* entry = readdir(m_dir);
+        if (!entry) {
+            m_error = errno;
+            return false;
+        }
+        name = entry->d_name;
+        type = entry->d_type;
+        return true;
+    }
+#endif
+
+    int error() const { return m_error; }
+
+private:
+    int m_error { 0 };
+#ifdef __linux__
+    int m_fd { -1 };
+    // getdents64() fills this with as many entries as fit, which saves a system call per entry.
+    alignas(dirent64) u8 m_buffer[32 * KiB];
+    size_t m_offset { 0 };
+    size_t m_size { 0 };
+#else
+    DIR* m_dir { nullptr };
+#endif
+};
+
+struct FileDeletion::DirectoryData {
+    // Relative to the parent, whose fd stays open until this is gone. Directories given to the deletion have their full path.
+    String name;
+    int fd { -1 };
+    // Something in it is still there, so removing it would fail anyway.
+    Atomic<bool> has_failed { false };
+};
+
+FileDeletion::FileDeletion(const Vector<String>& paths, WorkerPool& pool)
+    : FileOperationJob(pool)
+    , m_walk(*this, pool)
+{
+    m_paths.ensure_capacity(paths.size());
+    for (auto& path : paths)
+        m_paths.append(LexicalPath::canonicalized_path(path));
+}
+
+String FileDeletion::description() const
+{
+    if (m_paths.size() == 1)
+        return String::formatted("Deleting {}", m_paths.first());
+    return String::formatted("Deleting {} items", m_paths.size());
+}
+
+void FileDeletion::start()
+{
+    m_pool.submit([this, protector = NonnullRefPtr(*this)] {
+        for (auto& path : m_paths) {
+            if (is_cancelled())
+                break;
+            struct stat st;
+            if (lstat(path.characters(), &st) < 0) {
+                add_failure(path, errno);
+                continue;
+            }
+            if (!S_ISDIR(st.st_mode)) {
+                if (unlink(path.characters()) < 0)
+                    add_failure(path, errno);
+                else
+                    add_progress(0, 1);
+                continue;
+            }
+
+            m_walk.add_root([&](Directory& root) {
+                root.name = path;
+            });
+        }
+        m_walk.finish_adding_roots();
+    });
+}
+
+String FileDeletion::path_of(const Directory& directory, const StringView& name)
+{
+    Vector<const Directory*, 32> ancestors;
+    for (auto* ancestor = &directory; ancestor; ancestor = ancestor->parent)
+        ancestors.append(ancestor);
+
+    StringBuilder builder;
+    for (size_t i = ancestors.size(); i > 0; --i) {
+        if (i != ancestors.size())
+            builder.append('/');
+        builder.append(ancestors[i - 1]->name);
+    }
+    if (!name.is_null()) {
+        builder.append('/');
+        builder.append(name);
+    }
+    return builder.to_string();
+}
+
+void FileDeletion::visit(Directory& directory)
+{
+    if (is_cancelled()) {
+        m_walk.finish(directory);
+        return;
+    }
+
+    int parent_fd = directory.parent ? directory.parent->fd : AT_FDCWD;
+    directory.fd = openat(parent_fd, directory.name.characters(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (directory.fd < 0) {
+        add_failure(path_of(directory), errno);
+        directory.has_failed.store(true);
+        m_walk.finish(directory);
+        return;
+    }
+
+    DirectoryReader reader(directory.fd);
+    size_t removed_count = 0;
+    const char* name;
+    unsigned char type;
+    while (reader.next(name, type)) {
+        if (is_cancelled())
+            break;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            continue;
+
+        // Not every file system says what an entry is.
+        if (type == DT_UNKNOWN) {
+            struct stat st;
+            if (fstatat(directory.fd, name, &st, AT_SYMLINK_NOFOLLOW) < 0) {
+                if (errno != ENOENT) {
+                    add_failure(path_of(directory, name), errno);
+                    directory.has_failed.store(true);
+                }
+                continue;
+            }
+            type = S_ISDIR(st.st_mode) ? DT_DIR : DT_REG;
+        }
+
+        if (type == DT_DIR) {
+            m_walk.add_subdirectory(directory, [&](Directory& child) {
+                child.name = name;
+            });
+            continue;
+        }
+
+        // Something else may have removed it in the meantime, which is just as good.
+        if (unlinkat(directory.fd, name, 0) < 0) {
+            if (errno != ENOENT) {
+                add_failure(path_of(directory, name), errno);
+                directory.has_failed.store(true);
+            }
+            continue;
+        }
+        if (++removed_count == progress_batch_size) {
+            add_progress(0, removed_count);
+            removed_count = 0;
+        }
+    }
+
+    if (reader.error()) {
+        add_failure(path_of(directory), reader.error());
+        directory.has_failed.store(true);
+    }
+    if (removed_count)
+        add_progress(0, removed_count);
+    m_walk.finish(directory);
+}
+
+void FileDeletion::did_finish(Directory& directory)
+{
+    if (directory.fd >= 0)
+        close(directory.fd);
+
+    auto* parent = directory.parent;
+    bool has_failed = directory.has_failed.load();
+    if (!has_failed && !is_cancelled()) {
+        int parent_fd = parent ? parent->fd : AT_FDCWD;
+        if (unlinkat(parent_fd, directory.name.characters(), AT_REMOVEDIR) == 0) {
+            add_progress(0, 1);
+        } else if (errno != ENOENT) {
+            add_failure(path_of(directory), errno);
+            has_failed = true;
+        }
+    }
+    if (parent && has_failed)
+        parent->has_failed.store(true);
+}
+
+}
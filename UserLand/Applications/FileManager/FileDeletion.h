@@ -0,0 +1,55 @@
+#pragma once
+
+#include "DirectoryWalk.h"
+#include "FileOperationJob.h"
+#include <AK/Atomic.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+
+namespace FileManager {
+
+// Deletes files and whole directory trees on the worker pool, like rm -r.
+//
+// The directories are read in parallel by a DirectoryWalk. Entries are
+// removed with unlinkat() relative to their directory's file descriptor while
+// it's being read, which saves the
+// kernel from looking up the full path of every single file, and means a
+// symlink or a directory renamed in the meantime can't send the deletion
+// anywhere else. A directory is removed once everything in it is gone, so
+// one that still has something in it after a failure is left alone. How many
+// entries have been removed is reported every progress_interval_ms; how many
+// there are isn't known until the end.
+class FileDeletion final : public FileOperationJob {
+public:
+    static NonnullRefPtr<FileDeletion> create(const Vector<String>& paths, WorkerPool& pool = WorkerPool::the())
+    {
+        return adopt(*new FileDeletion(paths, pool));
+    }
+
+    virtual String title() const override { return "Deleting Files"; }
+    virtual String description() const override;
+    virtual StringView past_tense_verb() const override { return "deleted"; }
+    virtual bool knows_totals() const override { return false; }
+
+    // Cancelling leaves whatever hasn't been deleted yet where it is.
+    virtual void start() override;
+
+private:
+    FileDeletion(const Vector<String>& paths, WorkerPool&);
+
+    struct DirectoryData;
+    using Walk = DirectoryWalk<FileDeletion, DirectoryData>;
+    using Directory = Walk::Directory;
+    friend Walk;
+
+    void visit(Directory&);
+    void did_finish(Directory&);
+    void did_finish_walk() { complete(); }
+    static String path_of(const Directory&, const StringView& name = {});
+
+    Vector<String> m_paths;
+    Walk m_walk;
+};
+
+}
@@ -0,0 +1,71 @@
+#include "FileOperationJob.h"
+#include <AK/NonnullRefPtr.h>
+
+namespace FileManager {
+
+FileOperationJob::FileOperationJob(WorkerPool& pool)
+    : m_pool(pool)
+{
+    pthread_mutex_init(&m_mutex, nullptr);
+}
+
+FileOperationJob::~FileOperationJob()
+{
+    pthread_mutex_destroy(&m_mutex);
+}
+
+void FileOperationJob::cancel()
+{
+    m_cancelled.store(true, AK::MemoryOrder::memory_order_relaxed);
+}
+
+void FileOperationJob::add_failure(const String& path, int error)
+{
+    pthread_mutex_lock(&m_mutex);
+    m_failures.append({ path, error });
+    pthread_mutex_unlock(&m_mutex);
+}
+
+void FileOperationJob::add_to_totals(u64 bytes, size_t files)
+{
+    pthread_mutex_lock(&m_mutex);
+    m_progress.total_bytes += bytes;
+    m_progress.total_files += files;
+    pthread_mutex_unlock(&m_mutex);
+}
+
+void FileOperationJob::add_progress(u64 bytes, size_t files)
+{
+    pthread_mutex_lock(&m_mutex);
+    m_progress.processed_bytes += bytes;
+    m_progress.processed_files += files;
+
+    auto now = WorkerPool::now_ms();
+    if (now - m_last_progress_ms >= progress_interval_ms) {
+        m_last_progress_ms = now;
+        m_pool.post_to_main_thread([this, protector = NonnullRefPtr(*this), progress = m_progress] {
+            if (is_cancelled())
+                return;
+            if (on_progress)
+                on_progress(progress);
+        });
+    }
+    pthread_mutex_unlock(&m_mutex);
+}
+
+void FileOperationJob::complete()
+{
+    pthread_mutex_lock(&m_mutex);
+    auto progress = m_progress;
+    auto failures = m_failures;
+    pthread_mutex_unlock(&m_mutex);
+
+    m_pool.post_to_main_thread([this, protector = NonnullRefPtr(*this), progress, failures = move(failures)] {
+        if (is_cancelled())
+            return;
+        if (on_complete)
+            on_complete(progress, failures);
+    });
+}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "WorkerPool.h"
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/RefCounted.h>
+#include <AK/String.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <pthread.h>
+
+namespace FileManager {
+
+// A change to the file system that runs on the worker pool, like copying or
+// deleting files. It counts what it has done and the paths that failed, and
+// reports both to the main thread every progress_interval_ms while it runs.
+// FileOperationProgressWindow shows how far along it is.
+class FileOperationJob : public RefCounted<FileOperationJob> {
+public:
+    static constexpr int progress_interval_ms = 100;
+
+    struct Progress {
+        // Both stay 0 for jobs that don't know up front how much there is to do.
+        u64 total_bytes { 0 };
+        size_t total_files { 0 };
+        u64 processed_bytes { 0 };
+        size_t processed_files { 0 };
+    };
+
+    struct Failure {
+        String path;
+        int error { 0 };
+    };
+
+    virtual ~FileOperationJob();
+
+    // What FileOperationProgressWindow says about the job, like "Copying Files", "Copying to /home/anon" and "copied".
+    virtual String title() const = 0;
+    virtual String description() const = 0;
+    virtual StringView past_tense_verb() const = 0;
+    // Whether Progress has totals to compare against.
+    virtual bool knows_totals() const = 0;
+
+    // Both run on the main thread.
+    Function<void(const Progress&)> on_progress;
+    Function<void(const Progress&, const Vector<Failure>&)> on_complete;
+
+    virtual void start() = 0;
+    // Stops as soon as it can. No callbacks run after this.
+    void cancel();
+    bool is_cancelled() const { return m_cancelled.load(AK::MemoryOrder::memory_order_relaxed); }
+
+protected:
+    explicit FileOperationJob(WorkerPool&);
+
+    void add_failure(const String& path, int error);
+    void add_to_totals(u64 bytes, size_t files);
+    void add_progress(u64 bytes, size_t files);
+    // Hands the final progress and the failures to on_complete.
+    void complete();
+
+    WorkerPool& m_pool;
+    Atomic<bool> m_cancelled { false };
+
+    // Guards everything below, and whatever subclasses keep alongside the failures.
+    pthread_mutex_t m_mutex;
+    Progress m_progress;
+    Vector<Failure> m_failures;
+    u64 m_last_progress_ms { 0 };
+};
+
+}
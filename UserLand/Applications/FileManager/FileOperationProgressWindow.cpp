@@ -0,0 +1,150 @@
+#include "FileOperationProgressWindow.h"
+#include <AK/LexicalPath.h>
+#include <AK/NumberFormat.h>
+#include <AK/StringBuilder.h>
+#include <LibGUI/BoxLayout.h>
+#include <LibGUI/MessageBox.h>
+#include <string.h>
+
+namespace FileManager {
+
+// Failures beyond this many are only counted in the error message.
+static constexpr size_t max_listed_failures = 5;
+
+static String duration_string(u64 seconds)
+{
+    if (seconds < 60)
+        return String::formatted("{} s", seconds);
+    if (seconds < 3600)
+        return String::formatted("{} min {} s", seconds / 60, seconds % 60);
+    return String::formatted("{} h {} min", seconds / 3600, (seconds % 3600) / 60);
+}
+
+FileOperationProgressWindow::FileOperationProgressWindow(NonnullRefPtr<FileOperationJob> job, Window* parent_window)
+    : Window(parent_window)
+    , m_job(move(job))
+    , m_parent_window(parent_window)
+{
+    // Without totals there is nothing to show a bar or the bytes for, only how much has been done so far.
+    bool knows_totals = m_job->knows_totals();
+    set_title(m_job->title());
+    set_icon(Gfx::Bitmap::load_from_file("/res/icons/16x16/app-file-manager.png"));
+    set_rect({ 0, 0, 360, knows_totals ? 150 : 110 });
+    set_resizable(false);
+
+    auto& main_widget = set_main_widget<GUI::Widget>();
+    main_widget.set_fill_with_background_color(true);
+    auto& layout = main_widget.set_layout<GUI::VerticalBoxLayout>();
+    layout.set_margins({ 8, 8, 8, 8 });
+    layout.set_spacing(4);
+
+    auto& description_label = main_widget.add<GUI::Label>(m_job->description());
+    description_label.set_text_alignment(Gfx::TextAlignment::CenterLeft);
+    description_label.set_fixed_height(16);
+
+    if (knows_totals) {
+        m_progress_bar = main_widget.add<GUI::ProgressBar>();
+        m_progress_bar->set_fixed_height(20);
+        m_progress_bar->set_min(0);
+        m_progress_bar->set_max(100);
+
+        m_bytes_label = main_widget.add<GUI::Label>("Preparing...");
+        m_bytes_label->set_text_alignment(Gfx::TextAlignment::CenterLeft);
+        m_bytes_label->set_fixed_height(16);
+    }
+
+    m_files_label = main_widget.add<GUI::Label>();
+    m_files_label->set_text_alignment(Gfx::TextAlignment::CenterLeft);
+    m_files_label->set_fixed_height(16);
+
+    m_estimate_label = main_widget.add<GUI::Label>();
+    m_estimate_label->set_text_alignment(Gfx::TextAlignment::CenterLeft);
+    m_estimate_label->set_fixed_height(16);
+
+    auto& button_container = main_widget.add<GUI::Widget>();
+    button_container.set_fixed_height(22);
+    button_container.set_layout<GUI::HorizontalBoxLayout>();
+    button_container.layout()->add_spacer();
+    auto& cancel_button = button_container.add<GUI::Button>("Cancel");
+    cancel_button.set_fixed_size(80, 22);
+    cancel_button.on_click = [this](auto) {
+        close();
+    };
+
+    on_close = [this] {
+        m_job->cancel();
+        m_show_timer->stop();
+        remove_from_parent();
+    };
+
+    m_job->on_progress = [this](auto& progress) {
+        did_progress(progress);
+    };
+    m_job->on_complete = [this](auto& progress, auto& failures) {
+        did_complete(progress, failures);
+    };
+
+    m_show_timer = Core::Timer::create_single_shot(show_delay_ms, [this] {
+        if (m_parent_window)
+            center_within(*m_parent_window);
+        show();
+    });
+    m_show_timer->start();
+    m_elapsed_timer.start();
+}
+
+FileOperationProgressWindow::~FileOperationProgressWindow()
+{
+    m_job->cancel();
+}
+
+void FileOperationProgressWindow::did_progress(const FileOperationJob::Progress& progress)
+{
+    auto elapsed_ms = m_elapsed_timer.elapsed();
+
+    if (!m_job->knows_totals()) {
+        m_files_label->set_text(String::formatted("{} items {}", progress.processed_files, m_job->past_tense_verb()));
+        if (elapsed_ms >= 1000)
+            m_estimate_label->set_text(String::formatted("{} items per second", progress.processed_files * 1000 / elapsed_ms));
+        return;
+    }
+
+    if (progress.total_bytes) {
+        int percent = progress.processed_bytes * 100 / progress.total_bytes;
+        m_progress_bar->set_value(percent);
+        set_progress(percent);
+    }
+
+    m_bytes_label->set_text(String::formatted("{} of {}", human_readable_size(progress.processed_bytes), human_readable_size(progress.total_bytes)));
+    m_files_label->set_text(String::formatted("{} of {} files", progress.processed_files, progress.total_files));
+
+    // The first moments aren't worth an estimate; they're mostly spent walking the sources.
+    if (elapsed_ms < 1000 || !progress.processed_bytes)
+        return;
+    u64 bytes_per_second = progress.processed_bytes * 1000 / elapsed_ms;
+    if (!bytes_per_second)
+        return;
+    auto remaining_seconds = (progress.total_bytes - min(progress.processed_bytes, progress.total_bytes)) / bytes_per_second;
+    m_estimate_label->set_text(String::formatted("{}/s, about {} left", human_readable_size(bytes_per_second), duration_string(remaining_seconds)));
+}
+
+void FileOperationProgressWindow::did_complete(const FileOperationJob::Progress& progress, const Vector<FileOperationJob::Failure>& failures)
+{
+    if (!failures.is_empty()) {
+        StringBuilder builder;
+        builder.appendff("{} item{} could not be {}:\n", failures.size(), failures.size() == 1 ? "" : "s", m_job->past_tense_verb());
+        for (size_t i = 0; i < min(failures.size(), max_listed_failures); ++i)
+            builder.appendff("\n{}: {}", LexicalPath(failures[i].path).basename(), strerror(failures[i].error));
+        if (failures.size() > max_listed_failures)
+            builder.appendff("\n...and {} more", failures.size() - max_listed_failures);
+        GUI::MessageBox::show(m_parent_window, builder.to_string(), "File Manager", GUI::MessageBox::Type::Error);
+    }
+
+    // Closing this removes it, so hold on to what's still needed.
+    auto on_done = move(this->on_done);
+    close();
+    if (progress.processed_files && on_done)
+        on_done();
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "FileOperationJob.h"
+#include <LibCore/ElapsedTimer.h>
+#include <LibCore/Timer.h>
+#include <LibGUI/Button.h>
+#include <LibGUI/Label.h>
+#include <LibGUI/ProgressBar.h>
+#include <LibGUI/Window.h>
+
+namespace FileManager {
+
+// Shows how a FileOperationJob is getting along, and lets the user cancel it.
+// Jobs that are done quickly finish without the window ever showing up.
+class FileOperationProgressWindow final : public GUI::Window {
+    C_OBJECT(FileOperationProgressWindow);
+
+public:
+    static constexpr int show_delay_ms = 300;
+
+    virtual ~FileOperationProgressWindow() override;
+
+    // Runs when the job is done, if it did anything.
+    Function<void()> on_done;
+
+private:
+    FileOperationProgressWindow(NonnullRefPtr<FileOperationJob>, Window* parent = nullptr);
+
+    void did_progress(const FileOperationJob::Progress&);
+    void did_complete(const FileOperationJob::Progress&, const Vector<FileOperationJob::Failure>&);
+
+    NonnullRefPtr<FileOperationJob> m_job;
+    // What to center on and report failures over. Null if the window has none.
+    Window* m_parent_window { nullptr };
+    RefPtr<GUI::ProgressBar> m_progress_bar;
+    RefPtr<GUI::Label> m_bytes_label;
+    RefPtr<GUI::Label> m_files_label;
+    RefPtr<GUI::Label> m_estimate_label;
+    RefPtr<Core::Timer> m_show_timer;
+    Core::ElapsedTimer m_elapsed_timer;
+};
+
+}
@@ -0,0 +1,453 @@
+#include "FileTransfer.h"
+#include <AK/LexicalPath.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#ifdef __linux__
+#    include <linux/fs.h>
+#    include <sys/ioctl.h>
+#    include <sys/sendfile.h>
+#endif
+
+namespace FileManager {
+
+// How much the kernel copies per call, so that progress and cancellation don't wait for a whole big file.
+static constexpr size_t kernel_copy_chunk_size = 8 * MiB;
+
+static String join_path(const String& directory, const StringView& name)
+{
+    if (directory == "/")
+        return String::formatted("/{}", name);
+    return String::formatted("{}/{}", directory, name);
+}
+
+static bool write_all(int fd, const u8* data, size_t size, int& error)
+{
+    while (size) {
+        auto nwritten = write(fd, data, size);
+        if (nwritten < 0) {
+            if (errno == EINTR)
+                continue;
+            error = errno;
+            return false;
+        }
+        data += nwritten;
+        size -= nwritten;
+    }
+    return true;
+}
+
+// Removes a moved source once it has been copied, without following symlinks.
+static bool remove_tree(int parent_fd, const char* name, bool is_directory)
+{
+    if (!is_directory)
+        return unlinkat(parent_fd, name, 0) == 0;
+
+    int fd = openat(parent_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    DIR* dir = fd < 0 ? nullptr : fdopendir(fd);
+    if (!dir) {
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    bool success = true;
+    while (auto* entry = readdir(dir)) {
+        StringView entry_name { entry->d_name };
+        if (entry_name == "." || entry_name == "..")
+            continue;
+        struct stat st;
+        if (fstatat(fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0 || !remove_tree(fd, entry->d_name, S_ISDIR(st.st_mode)))
+            success = false;
+    }
+    closedir(dir);
+    return success && unlinkat(parent_fd, name, AT_REMOVEDIR) == 0;
+}
+
+FileTransfer::FileTransfer(FileUtils::FileOperation operation, const Vector<String>& source_paths, const String& destination_directory, WorkerPool& pool)
+    : FileOperationJob(pool)
+    , m_operation(operation)
+    , m_destination_directory(LexicalPath::canonicalized_path(destination_directory))
+    , m_is_root_user(geteuid() == 0)
+{
+    m_roots.ensure_capacity(source_paths.size());
+    for (auto& source_path : source_paths) {
+        auto source = LexicalPath::canonicalized_path(source_path);
+        m_roots.append({ source, join_path(m_destination_directory, LexicalPath(source).basename()) });
+    }
+}
+
+String FileTransfer::title() const
+{
+    return m_operation == FileUtils::FileOperation::Cut ? "Moving Files" : "Copying Files";
+}
+
+String FileTransfer::description() const
+{
+    return String::formatted("{} to {}", m_operation == FileUtils::FileOperation::Cut ? "Moving" : "Copying", m_destination_directory);
+}
+
+StringView FileTransfer::past_tense_verb() const
+{
+    return m_operation == FileUtils::FileOperation::Cut ? "moved" : "copied";
+}
+
+void FileTransfer::start()
+{
+    m_pool.submit([this, protector = NonnullRefPtr(*this)] {
+        plan();
+        if (is_cancelled() || m_files.is_empty()) {
+            finish();
+            return;
+        }
+
+        auto job_count = m_pool.long_running_job_limit(min(max_parallel_copies, m_files.size()));
+        m_running_copy_jobs = job_count;
+        for (size_t i = 0; i < job_count; ++i) {
+            m_pool.submit([this, protector] {
+                copy_files();
+            });
+        }
+    });
+}
+
+void FileTransfer::plan()
+{
+    struct stat destination_st;
+    int error = 0;
+    if (stat(m_destination_directory.characters(), &destination_st) < 0)
+        error = errno;
+    else if (!S_ISDIR(destination_st.st_mode))
+        error = ENOTDIR;
+    if (error) {
+        for (size_t i = 0; i < m_roots.size(); ++i)
+            add_failure(i, m_destination_directory, error);
+        return;
+    }
+
+    for (size_t i = 0; i < m_roots.size(); ++i) {
+        if (is_cancelled())
+            return;
+        auto& root = m_roots[i];
+        // Pasting something where it already is does nothing.
+        if (root.source == root.destination)
+            continue;
+        // Copying a directory into itself would never end.
+        if (m_destination_directory == root.source || m_destination_directory.starts_with(String::formatted("{}/", root.source))) {
+            add_failure(i, root.source, EINVAL);
+            continue;
+        }
+
+        struct stat st;
+        if (lstat(root.source.characters(), &st) < 0) {
+            add_failure(i, root.source, errno);
+            continue;
+        }
+        struct stat existing_st;
+        if (lstat(root.destination.characters(), &existing_st) == 0) {
+            add_failure(i, root.destination, EEXIST);
+            continue;
+        }
+
+        if (m_operation == FileUtils::FileOperation::Cut && st.st_dev == destination_st.st_dev) {
+            if (rename(root.source.characters(), root.destination.characters()) == 0) {
+                add_to_totals(0, 1);
+                add_progress(0, 1);
+                continue;
+            }
+            if (errno != EXDEV) {
+                add_failure(i, root.source, errno);
+                continue;
+            }
+        }
+
+        auto file_count = m_files.size();
+        u64 byte_count = 0;
+        walk(i, root.source, root.destination);
+        for (size_t j = file_count; j < m_files.size(); ++j)
+            byte_count += m_files[j].size;
+
+        add_to_totals(byte_count, m_files.size() - file_count);
+    }
+
+    create_directories();
+}
+
+void FileTransfer::walk(size_t root_index, const String& source, const String& destination)
+{
+    struct stat st;
+    if (lstat(source.characters(), &st) < 0) {
+        add_failure(root_index, source, errno);
+        return;
+    }
+
+    Item item;
+    item.root_index = root_index;
+    item.source = source;
+    item.destination = destination;
+    item.mode = st.st_mode;
+    item.uid = st.st_uid;
+    item.gid = st.st_gid;
+    item.atime = st.st_atime;
+    item.mtime = st.st_mtime;
+
+    if (S_ISREG(st.st_mode) || S_ISLNK(st.st_mode)) {
+        item.size = S_ISREG(st.st_mode) ? st.st_size : 0;
+        m_files.append(move(item));
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        add_failure(root_index, source, ENOTSUP);
+        return;
+    }
+
+    m_directories.append(move(item));
+    DIR* dir = opendir(source.characters());
+    if (!dir) {
+        add_failure(root_index, source, errno);
+        return;
+    }
+    while (auto* entry = readdir(dir)) {
+        if (is_cancelled())
+            break;
+        StringView name { entry->d_name };
+        if (name == "." || name == "..")
+            continue;
+        walk(root_index, join_path(source, name), join_path(destination, name));
+    }
+    closedir(dir);
+}
+
+void FileTransfer::create_directories()
+{
+    // Parents come before their children. They're writable for now, their real modes are set at the end.
+    for (auto& directory : m_directories) {
+        if (is_cancelled())
+            return;
+        if (mkdir(directory.destination.characters(), 0700) < 0)
+            add_failure(directory.root_index, directory.destination, errno);
+    }
+}
+
+void FileTransfer::copy_files()
+{
+    auto buffer = ByteBuffer::create_uninitialized(buffer_size);
+    for (;;) {
+        if (is_cancelled())
+            break;
+        auto index = m_next_file_index++;
+        if (index >= m_files.size())
+            break;
+        auto& item = m_files[index];
+        int error = 0;
+        if (copy_item(item, buffer, error)) {
+            if (S_ISLNK(item.mode))
+                set_metadata(item);
+            add_progress(0, 1);
+        } else if (!is_cancelled()) {
+            add_failure(item.root_index, item.source, error);
+        }
+    }
+
+    if (--m_running_copy_jobs == 0)
+        finish();
+}
+
+bool FileTransfer::copy_item(const Item& item, ByteBuffer& buffer, int& error)
+{
+    if (S_ISLNK(item.mode)) {
+        char target[PATH_MAX];
+        auto length = readlink(item.source.characters(), target, sizeof(target) - 1);
+        if (length < 0) {
+            error = errno;
+            return false;
+        }
+        target[length] = '\0';
+        if (symlink(target, item.destination.characters()) < 0) {
+            error = errno;
+            return false;
+        }
+        return true;
+    }
+
+    int source_fd = open(item.source.characters(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (source_fd < 0) {
+        error = errno;
+        return false;
+    }
+    int destination_fd = open(item.destination.characters(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (destination_fd < 0) {
+        error = errno;
+        close(source_fd);
+        return false;
+    }
+
+    bool success = copy_contents(source_fd, destination_fd, item.size, buffer, error);
+    if (success)
+        set_metadata(item, destination_fd);
+    close(source_fd);
+    if (close(destination_fd) < 0 && success) {
+        error = errno;
+        success = false;
+    }
+    if (!success || is_cancelled()) {
+        unlink(item.destination.characters());
+        return false;
+    }
+    return true;
+}
+
+bool FileTransfer::copy_contents(int source_fd, int destination_fd, off_t size, ByteBuffer& buffer, int& error)
+{
+    // The size is the one seen when the sources were walked. Stopping there saves asking for more on every file.
+    off_t copied = 0;
+
+#ifdef FICLONE
+    // Shares the data blocks on file systems that can do that, which takes no time at all.
+    if (size && m_may_clone.load(AK::MemoryOrder::memory_order_relaxed)) {
+        if (ioctl(destination_fd, FICLONE, source_fd) == 0) {
+            add_progress(size, 0);
+            return true;
+        }
+        if (errno == EOPNOTSUPP || errno == ENOTTY || errno == EXDEV || errno == EINVAL)
+            m_may_clone.store(false, AK::MemoryOrder::memory_order_relaxed);
+    }
+#endif
+
+#ifdef __linux__
+    // This only works between some kinds of files. If the first call fails, nothing has been copied yet.
+    while (copied < size && m_may_copy_in_kernel.load(AK::MemoryOrder::memory_order_relaxed)) {
+        if (is_cancelled())
+            return false;
+        auto ncopied = copy_file_range(source_fd, nullptr, destination_fd, nullptr, min<size_t>(size - copied, kernel_copy_chunk_size), 0);
+        if (ncopied < 0) {
+            if (errno == EINTR)
+                continue;
+            if (copied || (errno != EXDEV && errno != ENOSYS && errno != EINVAL && errno != EOPNOTSUPP)) {
+                error = errno;
+                return false;
+            }
+            // Older kernels can't copy_file_range() across file systems, but can still sendfile().
+            while (copied < size) {
+                if (is_cancelled())
+                    return false;
+                auto nsent = sendfile(destination_fd, source_fd, nullptr, min<size_t>(size - copied, kernel_copy_chunk_size));
+                if (nsent < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    if (copied || (errno != EINVAL && errno != ENOSYS)) {
+                        error = errno;
+                        return false;
+                    }
+                    m_may_copy_in_kernel.store(false, AK::MemoryOrder::memory_order_relaxed);
+                    break;
+                }
+                if (nsent == 0)
+                    return true;
+                copied += nsent;
+                add_progress(nsent, 0);
+            }
+            if (copied == size)
+                return true;
+            break;
+        }
+        // Some file systems, like procfs, report files as empty that aren't. Reading them works.
+        if (ncopied == 0) {
+            if (copied)
+                return true;
+            break;
+        }
+        copied += ncopied;
+        add_progress(ncopied, 0);
+    }
+    if (copied && copied == size)
+        return true;
+#endif
+
+    for (;;) {
+        if (is_cancelled())
+            return false;
+        auto nread = read(source_fd, buffer.data(), buffer.size());
+        if (nread < 0) {
+            if (errno == EINTR)
+                continue;
+            error = errno;
+            return false;
+        }
+        if (nread == 0)
+            return true;
+        if (!write_all(destination_fd, buffer.data(), nread, error))
+            return false;
+        copied += nread;
+        add_progress(nread, 0);
+        if (copied >= size && static_cast<size_t>(nread) < buffer.size())
+            return true;
+    }
+}
+
+void FileTransfer::set_metadata(const Item& item, int fd)
+{
+    // Symlinks have no permissions of their own, and their times can't be set portably.
+    if (S_ISLNK(item.mode)) {
+        if (m_is_root_user)
+            (void)lchown(item.destination.characters(), item.uid, item.gid);
+        return;
+    }
+    // The owner goes first, since changing it may clear the setuid and setgid bits.
+    if (fd >= 0) {
+        if (m_is_root_user)
+            (void)fchown(fd, item.uid, item.gid);
+        (void)fchmod(fd, item.mode & 07777);
+    } else {
+        if (m_is_root_user)
+            (void)chown(item.destination.characters(), item.uid, item.gid);
+        (void)chmod(item.destination.characters(), item.mode & 07777);
+    }
+    utimbuf times { item.atime, item.mtime };
+    (void)utime(item.destination.characters(), &times);
+}
+
+void FileTransfer::finish()
+{
+    if (!is_cancelled()) {
+        // Children come after their parents, so going backwards sets each directory after its contents are done.
+        for (size_t i = m_directories.size(); i > 0; --i)
+            set_metadata(m_directories[i - 1]);
+    }
+
+    if (!is_cancelled() && m_operation == FileUtils::FileOperation::Cut) {
+        for (size_t i = 0; i < m_roots.size(); ++i) {
+            auto& root = m_roots[i];
+            pthread_mutex_lock(&m_mutex);
+            bool has_failed = root.has_failed;
+            pthread_mutex_unlock(&m_mutex);
+            if (has_failed)
+                continue;
+            // Sources that were renamed, or skipped because they were already in place, are gone or must stay.
+            struct stat source_st;
+            struct stat destination_st;
+            if (lstat(root.source.characters(), &source_st) < 0 || lstat(root.destination.characters(), &destination_st) < 0)
+                continue;
+            if (source_st.st_dev == destination_st.st_dev && source_st.st_ino == destination_st.st_ino)
+                continue;
+            if (!remove_tree(AT_FDCWD, root.source.characters(), S_ISDIR(source_st.st_mode)))
+                add_failure(i, root.source, errno);
+        }
+    }
+
+    complete();
+}
+
+void FileTransfer::add_failure(size_t root_index, const String& path, int error)
+{
+    pthread_mutex_lock(&m_mutex);
+    m_roots[root_index].has_failed = true;
+    pthread_mutex_unlock(&m_mutex);
+    FileOperationJob::add_failure(path, error);
+}
+
+}
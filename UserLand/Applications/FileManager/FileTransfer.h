@@ -0,0 +1,97 @@
+#pragma once
+
+#include "FileOperationJob.h"
+#include "FileUtils.h"
+#include <AK/Atomic.h>
+#include <AK/ByteBuffer.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <sys/types.h>
+#include <time.h>
+
+namespace FileManager {
+
+// Copies or moves files and directories into a directory on the worker pool.
+//
+// A move within one file system is a rename(). Everything else is copied: the
+// sources are walked up front to know the total size, the directories are
+// created, and then the files are copied by up to max_parallel_copies jobs at
+// once, which mostly helps with many small files. File contents are cloned
+// where the file system supports it (FICLONE), otherwise copied in the kernel
+// (copy_file_range, sendfile) where available, and through a large buffer
+// everywhere else. Permissions, ownership (as root) and modification times are
+// kept; those of the directories are set in one pass at the end, after their
+// contents stopped changing them. Moved sources are only removed once
+// everything in them has been copied.
+class FileTransfer final : public FileOperationJob {
+public:
+    static constexpr size_t max_parallel_copies = 4;
+    static constexpr size_t buffer_size = 1 * MiB;
+
+    static NonnullRefPtr<FileTransfer> create(FileUtils::FileOperation operation, const Vector<String>& source_paths, const String& destination_directory, WorkerPool& pool = WorkerPool::the())
+    {
+        return adopt(*new FileTransfer(operation, source_paths, destination_directory, pool));
+    }
+    FileUtils::FileOperation operation() const { return m_operation; }
+    const String& destination_directory() const { return m_destination_directory; }
+
+    virtual String title() const override;
+    virtual String description() const override;
+    virtual StringView past_tense_verb() const override;
+    virtual bool knows_totals() const override { return true; }
+
+    // Cancelling stops after the files that are being copied right now; those are removed again.
+    virtual void start() override;
+
+private:
+    FileTransfer(FileUtils::FileOperation, const Vector<String>& source_paths, const String& destination_directory, WorkerPool&);
+
+    struct Root {
+        String source;
+        String destination;
+        // Guarded by m_mutex.
+        bool has_failed { false };
+    };
+
+    struct Item {
+        size_t root_index { 0 };
+        String source;
+        String destination;
+        mode_t mode { 0 };
+        uid_t uid { 0 };
+        gid_t gid { 0 };
+        time_t atime { 0 };
+        time_t mtime { 0 };
+        off_t size { 0 };
+    };
+
+    void plan();
+    void walk(size_t root_index, const String& source, const String& destination);
+    void create_directories();
+    void copy_files();
+    void finish();
+
+    bool copy_item(const Item&, ByteBuffer&, int& error);
+    bool copy_contents(int source_fd, int destination_fd, off_t size, ByteBuffer&, int& error);
+    void set_metadata(const Item&, int fd = -1);
+
+    void add_failure(size_t root_index, const String& path, int error);
+
+    FileUtils::FileOperation m_operation;
+    String m_destination_directory;
+    bool m_is_root_user { false };
+    // Cleared once the file systems involved turned out not to support these, so the other files don't try again.
+    Atomic<bool> m_may_clone { true };
+    Atomic<bool> m_may_copy_in_kernel { true };
+
+    // Filled in by the planning job before the copies start.
+    Vector<Root> m_roots;
+    Vector<Item> m_directories;
+    Vector<Item> m_files;
+
+    Atomic<size_t> m_next_file_index { 0 };
+    Atomic<size_t> m_running_copy_jobs { 0 };
+};
+
+}
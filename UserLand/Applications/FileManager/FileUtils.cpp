@@ -1,44 +1,14 @@
 // includes
 #include "FileUtils.h"
+#include "FileDeletion.h"
+#include "FileOperationProgressWindow.h"
+#include "FileTransfer.h"
 #include <AK/LexicalPath.h>
-#include <LibCore/DirIterator.h>
-#include <LibCore/File.h>
 #include <LibGUI/MessageBox.h>
-#include <sys/stat.h>
-#include <unistd.h>
 
 namespace FileUtils {
 
-void delete_path(const String& path, GUI::Window* parent_window)
-{
-    struct stat st;
-    if (lstat(path.characters(), &st)) {
-        GUI::MessageBox::show(parent_window,
-            String::formatted("lstat({}) failed: {}", path, strerror(errno)),
-            "Delete failed",
-            GUI::MessageBox::Type::Error);
-    }
-
-    bool is_directory = S_ISDIR(st.st_mode);
-    auto result = Core::File::remove(path, Core::File::RecursionMode::Allowed, false);
-
-    if (result.is_error()) {
-        auto& error = result.error();
-        if (is_directory) {
-            GUI::MessageBox::show(parent_window,
-                String::formatted("Failed to delete directory \"{}\": {}", error.file, error.error_code),
-                "Delete failed",
-                GUI::MessageBox::Type::Error);
-        } else {
-            GUI::MessageBox::show(parent_window,
-                String::formatted("Failed to delete file \"{}\": {}", error.file, error.error_code),
-                "Delete failed",
-                GUI::MessageBox::Type::Error);
-        }
-    }
-}
-
-void delete_paths(const Vector<String>& paths, bool should_confirm, GUI::Window* parent_window)
+void delete_paths(const Vector<String>& paths, bool should_confirm, GUI::Window* parent_window, Function<void()> on_done)
 {
     String message;
     if (paths.size() == 1) {
@@ -57,9 +27,20 @@ void delete_paths(const Vector<String>& paths, bool should_confirm, GUI::Window*
             return;
     }
 
-    for (auto& path : paths) {
-        delete_path(path, parent_window);
-    }
+    VERIFY(parent_window);
+    auto deletion = FileManager::FileDeletion::create(paths);
+    auto window = parent_window->add<FileManager::FileOperationProgressWindow>(deletion, parent_window);
+    window->on_done = move(on_done);
+    deletion->start();
+}
+
+void transfer_paths(const Vector<String>& paths, const String& destination_directory, FileOperation operation, GUI::Window* parent_window, Function<void()> on_done)
+{
+    VERIFY(parent_window);
+    auto transfer = FileManager::FileTransfer::create(operation, paths, destination_directory);
+    auto window = parent_window->add<FileManager::FileOperationProgressWindow>(transfer, parent_window);
+    window->on_done = move(on_done);
+    transfer->start();
 }
 
 }
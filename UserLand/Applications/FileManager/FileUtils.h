@@ -1,5 +1,6 @@
 #pragma once
 
+#include <AK/Function.h>
 #include <AK/String.h>
 #include <LibCore/Forward.h>
 #include <LibGUI/Forward.h>
@@ -12,6 +13,8 @@ enum class FileOperation {
     Cut
 };
 
-void delete_path(const String&, GUI::Window*);
-void delete_paths(const Vector<String>&, bool should_confirm, GUI::Window*);
+// Deletes the paths in the background, after asking first if should_confirm. on_done runs if anything was deleted.
+void delete_paths(const Vector<String>&, bool should_confirm, GUI::Window*, Function<void()> on_done = {});
+// Copies or moves the paths into the directory in the background. on_done runs if anything was transferred.
+void transfer_paths(const Vector<String>&, const String& destination_directory, FileOperation, GUI::Window*, Function<void()> on_done = {});
 }
@@ -103,13 +103,32 @@ PropertiesWindow::PropertiesWindow(const String& path, bool disable_rename, Wind
         }
     }
 
-    properties.append({ "Size:", human_readable_size_long(st.st_size) });
+    // For directories, both are filled in as the directory is walked.
+    size_t size_row = properties.size();
+    properties.append({ "Size:", S_ISDIR(m_mode) ? "Calculating..." : human_readable_size_long(st.st_size) });
+    Optional<size_t> contents_row;
+    if (S_ISDIR(m_mode)) {
+        contents_row = properties.size();
+        properties.append({ "Contains:", "Calculating..." });
+    }
     properties.append({ "Owner:", String::formatted("{} ({})", owner_name, st.st_uid) });
     properties.append({ "Group:", String::formatted("{} ({})", group_name, st.st_gid) });
     properties.append({ "Created at:", GUI::FileSystemModel::timestamp_string(st.st_ctime) });
     properties.append({ "Last modified:", GUI::FileSystemModel::timestamp_string(st.st_mtime) });
 
-    make_property_value_pairs(properties, general_tab);
+    auto value_labels = make_property_value_pairs(properties, general_tab);
+    if (contents_row.has_value()) {
+        m_size_label = value_labels[size_row];
+        m_contents_label = value_labels[contents_row.value()];
+        m_size_calculator = FileManager::DirectorySizeCalculator::create(path);
+        m_size_calculator->on_progress = [this](auto& totals) {
+            update_directory_size(totals, false);
+        };
+        m_size_calculator->on_complete = [this](auto& totals) {
+            update_directory_size(totals, true);
+        };
+        m_size_calculator->start();
+    }
 
     general_tab.add<GUI::SeparatorWidget>(Gfx::Orientation::Horizontal);
 
@@ -143,6 +162,22 @@ PropertiesWindow::PropertiesWindow(const String& path, bool disable_rename, Wind
 
 PropertiesWindow::~PropertiesWindow()
 {
+    if (m_size_calculator)
+        m_size_calculator->cancel();
+}
+
+void PropertiesWindow::update_directory_size(const FileManager::DirectorySizeCalculator::Totals& totals, bool is_complete)
+{
+    auto size_text = human_readable_size_long(totals.size);
+    auto contents_text = String::formatted("{} file{}, {} folder{}",
+        totals.file_count, totals.file_count == 1 ? "" : "s",
+        totals.directory_count, totals.directory_count == 1 ? "" : "s");
+    if (!is_complete) {
+        size_text = String::formatted("{}...", size_text);
+        contents_text = String::formatted("{}...", contents_text);
+    }
+    m_size_label->set_text(size_text);
+    m_contents_label->set_text(contents_text);
 }
 
 void PropertiesWindow::update()
@@ -238,12 +273,14 @@ void PropertiesWindow::make_permission_checkboxes(GUI::Widget& parent, Permissio
     box_execute.set_enabled(can_edit_checkboxes);
 }
 
-void PropertiesWindow::make_property_value_pairs(const Vector<PropertyValuePair>& pairs, GUI::Widget& parent)
+Vector<NonnullRefPtr<GUI::Label>> PropertiesWindow::make_property_value_pairs(const Vector<PropertyValuePair>& pairs, GUI::Widget& parent)
 {
     int max_width = 0;
     Vector<NonnullRefPtr<GUI::Label>> property_labels;
+    Vector<NonnullRefPtr<GUI::Label>> value_labels;
 
     property_labels.ensure_capacity(pairs.size());
+    value_labels.ensure_capacity(pairs.size());
     for (auto pair : pairs) {
         auto& label_container = parent.add<GUI::Widget>();
         label_container.set_layout<GUI::HorizontalBoxLayout>();
@@ -254,13 +291,16 @@ void PropertiesWindow::make_property_value_pairs(const Vector<PropertyValuePair>
         label_property.set_text_alignment(Gfx::TextAlignment::CenterLeft);
 
         if (!pair.link.has_value()) {
-            label_container.add<GUI::Label>(pair.value).set_text_alignment(Gfx::TextAlignment::CenterLeft);
+            auto& label_value = label_container.add<GUI::Label>(pair.value);
+            label_value.set_text_alignment(Gfx::TextAlignment::CenterLeft);
+            value_labels.append(label_value);
         } else {
             auto& link = label_container.add<GUI::LinkLabel>(pair.value);
             link.set_text_alignment(Gfx::TextAlignment::CenterLeft);
             link.on_click = [pair]() {
                 Desktop::Launcher::open(pair.link.value());
             };
+            value_labels.append(link);
         }
 
         max_width = max(max_width, label_property.font().width(pair.property));
@@ -269,6 +309,8 @@ void PropertiesWindow::make_property_value_pairs(const Vector<PropertyValuePair>
 
     for (auto label : property_labels)
         label->set_fixed_width(max_width);
+
+    return value_labels;
 }
 
 GUI::Button& PropertiesWindow::make_button(String text, GUI::Widget& parent)
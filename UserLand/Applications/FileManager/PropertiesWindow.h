@@ -1,5 +1,6 @@
 #pragma once
 
+#include "DirectorySizeCalculator.h"
 #include <LibCore/File.h>
 #include <LibGUI/Button.h>
 #include <LibGUI/Dialog.h>
@@ -52,16 +53,21 @@ private:
     }
 
     GUI::Button& make_button(String, GUI::Widget& parent);
-    void make_property_value_pairs(const Vector<PropertyValuePair>& pairs, GUI::Widget& parent);
+    // Returns the value labels, in the same order as the pairs.
+    Vector<NonnullRefPtr<GUI::Label>> make_property_value_pairs(const Vector<PropertyValuePair>& pairs, GUI::Widget& parent);
     void make_permission_checkboxes(GUI::Widget& parent, PermissionMasks, String label_string, mode_t mode);
     void permission_changed(mode_t mask, bool set);
     bool apply_changes();
     void update();
     String make_full_path(const String& name);
+    void update_directory_size(const FileManager::DirectorySizeCalculator::Totals&, bool is_complete);
 
     RefPtr<GUI::Button> m_apply_button;
     RefPtr<GUI::TextBox> m_name_box;
     RefPtr<GUI::ImageWidget> m_icon;
+    RefPtr<GUI::Label> m_size_label;
+    RefPtr<GUI::Label> m_contents_label;
+    RefPtr<FileManager::DirectorySizeCalculator> m_size_calculator;
     String m_name;
     String m_parent_path;
     String m_path;
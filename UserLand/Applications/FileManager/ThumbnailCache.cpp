@@ -0,0 +1,336 @@
+#include "ThumbnailCache.h"
+#include "WorkerPool.h"
+#include <AK/ByteBuffer.h>
+#include <AK/LexicalPath.h>
+#include <AK/MappedFile.h>
+#include <AK/Optional.h>
+#include <AK/QuickSort.h>
+#include <AK/StringBuilder.h>
+#include <LibGfx/Painter.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace FileManager {
+
+static constexpr u32 disk_entry_magic = 0x48544d46; // "FMTH"
+static constexpr u16 disk_entry_version = 1;
+static constexpr size_t max_running_decodes = 4;
+
+// The cache never leaves the machine, so everything is in its byte order.
+struct [[gnu::packed]] DiskEntryHeader {
+    u32 magic;
+    u16 version;
+    // Both 0 for an image that couldn't be decoded.
+    u16 width;
+    u16 height;
+    u16 path_length;
+    u32 reserved;
+    u64 size;
+    i64 mtime;
+};
+static_assert(sizeof(DiskEntryHeader) == 32);
+// The header is followed by the pixels, BGRA8888 rows without padding, and then the image's path.
+
+static u64 path_hash(const StringView& path)
+{
+    // FNV-1a. The 32-bit string hash would collide every so often with a few thousand thumbnails around.
+    u64 hash = 0xcbf29ce484222325;
+    for (auto ch : path) {
+        hash ^= static_cast<u8>(ch);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+static String disk_entry_path(const String& directory, const String& path)
+{
+    return String::formatted("{}/{:016x}", directory, path_hash(path));
+}
+
+static RefPtr<Gfx::Bitmap> render_thumbnail(const String& path)
+{
+    auto bitmap = Gfx::Bitmap::load_from_file(path);
+    if (!bitmap)
+        return nullptr;
+    auto thumbnail = Gfx::Bitmap::create(Gfx::BitmapFormat::BGRA8888, { ThumbnailCache::thumbnail_size, ThumbnailCache::thumbnail_size });
+    if (!thumbnail)
+        return nullptr;
+    double scale = min(ThumbnailCache::thumbnail_size / (double)bitmap->width(), ThumbnailCache::thumbnail_size / (double)bitmap->height());
+    auto destination = Gfx::IntRect(0, 0, (int)(bitmap->width() * scale), (int)(bitmap->height() * scale)).centered_within(thumbnail->rect());
+    Gfx::Painter painter(*thumbnail);
+    painter.draw_scaled_bitmap(destination, *bitmap, bitmap->rect());
+    return thumbnail;
+}
+
+// An empty result means there's no usable entry. A null bitmap means the image couldn't be decoded last time.
+static Optional<RefPtr<Gfx::Bitmap>> read_disk_entry(const String& entry_path, const String& path, off_t size, time_t mtime)
+{
+    auto result = MappedFile::map(entry_path);
+    if (result.is_error())
+        return {};
+    auto& file = *result.value();
+    if (file.size() < sizeof(DiskEntryHeader))
+        return {};
+
+    DiskEntryHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    size_t pixel_byte_count = static_cast<size_t>(header.width) * header.height * sizeof(Gfx::RGBA32);
+    if (header.magic != disk_entry_magic || header.version != disk_entry_version)
+        return {};
+    if (header.size != static_cast<u64>(size) || header.mtime != static_cast<i64>(mtime) || header.path_length != path.length())
+        return {};
+    if (file.size() != sizeof(header) + pixel_byte_count + header.path_length)
+        return {};
+    auto* pixels = static_cast<const u8*>(file.data()) + sizeof(header);
+    if (StringView(reinterpret_cast<const char*>(pixels + pixel_byte_count), header.path_length) != path)
+        return {};
+
+    // Pruning removes the entries that haven't been used for the longest time first.
+    (void)utimensat(AT_FDCWD, entry_path.characters(), nullptr, 0);
+
+    if (!header.width || !header.height)
+        return RefPtr<Gfx::Bitmap> {};
+    auto thumbnail = Gfx::Bitmap::create(Gfx::BitmapFormat::BGRA8888, { header.width, header.height });
+    if (!thumbnail)
+        return {};
+    size_t row_byte_count = header.width * sizeof(Gfx::RGBA32);
+    for (int y = 0; y < header.height; ++y)
+        memcpy(thumbnail->scanline(y), pixels + y * row_byte_count, row_byte_count);
+    return thumbnail;
+}
+
+static void write_disk_entry(const String& directory, const String& entry_path, const String& path, off_t size, time_t mtime, const Gfx::Bitmap* thumbnail)
+{
+    // Paths this long aren't worth caching, and wouldn't fit the header.
+    if (path.length() > NumericLimits<u16>::max())
+        return;
+
+    DiskEntryHeader header {};
+    header.magic = disk_entry_magic;
+    header.version = disk_entry_version;
+    header.width = thumbnail ? thumbnail->width() : 0;
+    header.height = thumbnail ? thumbnail->height() : 0;
+    header.path_length = path.length();
+    header.size = size;
+    header.mtime = mtime;
+
+    size_t row_byte_count = header.width * sizeof(Gfx::RGBA32);
+    size_t pixel_byte_count = row_byte_count * header.height;
+    auto buffer = ByteBuffer::create_uninitialized(sizeof(header) + pixel_byte_count + path.length());
+    memcpy(buffer.data(), &header, sizeof(header));
+    for (int y = 0; y < header.height; ++y)
+        memcpy(buffer.data() + sizeof(header) + y * row_byte_count, thumbnail->scanline(y), row_byte_count);
+    memcpy(buffer.data() + sizeof(header) + pixel_byte_count, path.characters(), path.length());
+
+    // Written next to the entry and renamed over it, so nobody ever maps half of one.
+    auto temporary_path_template = String::formatted("{}/.new-XXXXXX", directory);
+    Vector<char> temporary_path;
+    temporary_path.append(temporary_path_template.characters(), temporary_path_template.length() + 1);
+    int fd = mkstemp(temporary_path.data());
+    if (fd < 0)
+        return;
+    size_t offset = 0;
+    while (offset < buffer.size()) {
+        auto nwritten = write(fd, buffer.data() + offset, buffer.size() - offset);
+        if (nwritten < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        offset += nwritten;
+    }
+    if (close(fd) < 0 || offset != buffer.size() || rename(temporary_path.data(), entry_path.characters()) < 0)
+        unlink(temporary_path.data());
+}
+
+static RefPtr<Gfx::Bitmap> load_thumbnail(const String& disk_cache_directory, const String& path, off_t size, time_t mtime)
+{
+    if (disk_cache_directory.is_null())
+        return render_thumbnail(path);
+
+    auto entry_path = disk_entry_path(disk_cache_directory, path);
+    if (auto cached = read_disk_entry(entry_path, path, size, mtime); cached.has_value())
+        return cached.value();
+    auto thumbnail = render_thumbnail(path);
+    write_disk_entry(disk_cache_directory, entry_path, path, size, mtime, thumbnail);
+    return thumbnail;
+}
+
+static void prune_disk_cache(const String& directory)
+{
+    struct DiskEntry {
+        String name;
+        time_t mtime { 0 };
+    };
+    Vector<DiskEntry> entries;
+
+    int fd = open(directory.characters(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    DIR* dir = fd < 0 ? nullptr : fdopendir(fd);
+    if (!dir) {
+        if (fd >= 0)
+            close(fd);
+        return;
+    }
+    while (auto* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.')
+            continue;
+        struct stat st;
+        if (fstatat(fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISREG(st.st_mode))
+            entries.append({ entry->d_name, st.st_mtime });
+    }
+
+    // Pruning down to a bit less than the limit means it doesn't have to happen again on the next run already.
+    if (entries.size() > ThumbnailCache::max_disk_entries) {
+        quick_sort(entries, [](auto& a, auto& b) { return a.mtime < b.mtime; });
+        auto remove_count = entries.size() - ThumbnailCache::max_disk_entries * 3 / 4;
+        for (size_t i = 0; i < remove_count; ++i)
+            (void)unlinkat(fd, entries[i].name.characters(), 0);
+    }
+    closedir(dir);
+}
+
+ThumbnailCache& ThumbnailCache::the()
+{
+    static ThumbnailCache* s_the;
+    if (!s_the)
+        s_the = new ThumbnailCache;
+    return *s_the;
+}
+
+void ThumbnailCache::set_disk_cache_directory(const String& directory)
+{
+    // Like mkdir -p.
+    StringBuilder builder;
+    for (auto& part : LexicalPath(directory).parts()) {
+        builder.append('/');
+        builder.append(part);
+        if (mkdir(builder.to_string().characters(), 0700) < 0 && errno != EEXIST) {
+            perror("mkdir");
+            return;
+        }
+    }
+
+    m_disk_cache_directory = directory;
+    WorkerPool::the().submit([directory] {
+        prune_disk_cache(directory);
+    });
+}
+
+void ThumbnailCache::register_client(Client& client)
+{
+    m_clients.set(&client);
+}
+
+void ThumbnailCache::unregister_client(Client& client)
+{
+    m_clients.remove(&client);
+}
+
+ThumbnailCache::Lookup ThumbnailCache::get(const String& path, off_t size, time_t mtime)
+{
+    if (auto it = m_entries.find(path); it != m_entries.end()) {
+        auto& entry = *it->value;
+        if (entry.size == size && entry.mtime == mtime) {
+            m_lru_list.remove(entry);
+            m_lru_list.append(entry);
+            return { entry.thumbnail, false };
+        }
+        remove_entry(entry);
+    }
+
+    if (m_in_progress.contains(path))
+        return { nullptr, true };
+
+    auto serial = m_next_serial++;
+    if (auto it = m_pending_handles.find(path); it != m_pending_handles.end()) {
+        auto& request = m_pending.value(it->value);
+        request.size = size;
+        request.mtime = mtime;
+        request.serial = serial;
+        m_pending.update_key(it->value, priority_key(serial));
+    } else {
+        Request request;
+        request.path = path;
+        request.size = size;
+        request.mtime = mtime;
+        request.serial = serial;
+        m_pending_handles.set(path, m_pending.insert(priority_key(serial), move(request)));
+    }
+
+    start_requests();
+    return { nullptr, true };
+}
+
+void ThumbnailCache::start_requests()
+{
+    auto max_running = WorkerPool::the().long_running_job_limit(max_running_decodes);
+    while (m_in_progress.size() < max_running && !m_pending.is_empty()) {
+        auto request = m_pending.pop_min();
+        m_pending_handles.remove(request.path);
+        if (request.serial + max_pending_requests < m_next_serial) {
+            notify_clients(request.path);
+            continue;
+        }
+
+        m_in_progress.set(request.path);
+        WorkerPool::the().submit([this, request = move(request), directory = m_disk_cache_directory] {
+            auto thumbnail = load_thumbnail(directory, request.path, request.size, request.mtime);
+            WorkerPool::the().post_to_main_thread([this, request, thumbnail = move(thumbnail)] {
+                did_make(request, thumbnail);
+            });
+        });
+    }
+}
+
+void ThumbnailCache::did_make(const Request& request, RefPtr<Gfx::Bitmap> thumbnail)
+{
+    m_in_progress.remove(request.path);
+    add_entry(request, move(thumbnail));
+    notify_clients(request.path);
+    start_requests();
+}
+
+void ThumbnailCache::add_entry(const Request& request, RefPtr<Gfx::Bitmap> thumbnail)
+{
+    if (auto it = m_entries.find(request.path); it != m_entries.end())
+        remove_entry(*it->value);
+
+    auto entry = make<Entry>();
+    entry->path = request.path;
+    entry->size = request.size;
+    entry->mtime = request.mtime;
+    entry->byte_count = sizeof(Entry) + request.path.length();
+    if (thumbnail)
+        entry->byte_count += thumbnail->width() * thumbnail->height() * sizeof(Gfx::RGBA32);
+    entry->thumbnail = move(thumbnail);
+
+    m_memory_bytes += entry->byte_count;
+    m_lru_list.append(*entry);
+    auto* new_entry = entry.ptr();
+    m_entries.set(request.path, move(entry));
+
+    while (m_memory_bytes > max_memory_bytes && m_lru_list.first() != new_entry)
+        remove_entry(*m_lru_list.first());
+}
+
+void ThumbnailCache::remove_entry(Entry& entry)
+{
+    m_memory_bytes -= entry.byte_count;
+    m_lru_list.remove(entry);
+    // The key belongs to the entry that's about to go away.
+    auto path = entry.path;
+    m_entries.remove(path);
+}
+
+void ThumbnailCache::notify_clients(const String& path)
+{
+    for (auto* client : m_clients)
+        client->thumbnail_did_finish(path);
+}
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <AK/DAryHeap.h>
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+#include <AK/IntrusiveList.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/RefPtr.h>
+#include <AK/String.h>
+#include <LibGfx/Bitmap.h>
+#include <sys/types.h>
+#include <time.h>
+
+namespace FileManager {
+
+// The thumbnails of image files, for the main thread.
+//
+// Thumbnails that have been used recently are kept in memory, up to
+// max_memory_bytes. Every thumbnail that was made is also written to the disk
+// cache directory, one file each, named after a hash of the image's path. The
+// file starts with a fixed header, followed by the pixels exactly as the
+// bitmap has them, so reading it back is a mapping and a copy. Entries are
+// only used while the image's size and mtime are what they were, and the
+// oldest ones are removed once there are more than max_disk_entries. Images
+// that can't be decoded are remembered the same way, so they aren't tried
+// again.
+//
+// Thumbnails that aren't cached are made on the worker pool, a few at a time.
+// Whatever was asked for most recently goes first. Views ask for the icons of
+// the rows they paint, so the visible rows come first, and requests that
+// haven't been repeated in the last max_pending_requests are dropped once
+// their turn comes, since they have long been scrolled away.
+class ThumbnailCache {
+    AK_MAKE_NONCOPYABLE(ThumbnailCache);
+    AK_MAKE_NONMOVABLE(ThumbnailCache);
+
+public:
+    static constexpr int thumbnail_size = 32;
+    static constexpr size_t max_memory_bytes = 16 * MiB;
+    static constexpr size_t max_disk_entries = 10000;
+    static constexpr u64 max_pending_requests = 1000;
+
+    class Client {
+    public:
+        virtual ~Client() { }
+        // The thumbnail for the path was made, or its request was dropped. Either way, ask again if it's still needed.
+        virtual void thumbnail_did_finish(const String& path) = 0;
+    };
+
+    struct Lookup {
+        // Null while it's being made, and for images that can't be decoded.
+        RefPtr<Gfx::Bitmap> thumbnail;
+        bool is_pending { false };
+    };
+
+    static ThumbnailCache& the();
+
+    // Where thumbnails are kept between runs. It's created if needed. Without one, they're only kept in memory.
+    void set_disk_cache_directory(const String&);
+
+    void register_client(Client&);
+    void unregister_client(Client&);
+
+    Lookup get(const String& path, off_t size, time_t mtime);
+
+private:
+    ThumbnailCache() = default;
+
+    struct Entry {
+        String path;
+        off_t size { 0 };
+        time_t mtime { 0 };
+        RefPtr<Gfx::Bitmap> thumbnail;
+        size_t byte_count { 0 };
+        IntrusiveListNode list_node;
+    };
+
+    struct Request {
+        String path;
+        off_t size { 0 };
+        time_t mtime { 0 };
+        u64 serial { 0 };
+    };
+
+    // The heap puts the smallest key first, and the newest requests should go first.
+    static u64 priority_key(u64 serial) { return ~serial; }
+
+    void start_requests();
+    void did_make(const Request&, RefPtr<Gfx::Bitmap>);
+    void add_entry(const Request&, RefPtr<Gfx::Bitmap>);
+    void remove_entry(Entry&);
+    void notify_clients(const String& path);
+
+    String m_disk_cache_directory;
+
+    HashMap<String, NonnullOwnPtr<Entry>> m_entries;
+    // Least recently used first.
+    IntrusiveList<Entry, &Entry::list_node> m_lru_list;
+    size_t m_memory_bytes { 0 };
+
+    IndexedDAryHeap<u64, Request> m_pending;
+    HashMap<String, IndexedDAryHeap<u64, Request>::Handle> m_pending_handles;
+    HashTable<String> m_in_progress;
+    u64 m_next_serial { 0 };
+
+    HashTable<Client*> m_clients;
+};
+
+}
@@ -0,0 +1,226 @@
+#include "WorkerPool.h"
+#include <AK/Format.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace FileManager {
+
+WorkerPool& WorkerPool::the()
+{
+    static WorkerPool* s_the;
+    if (!s_the) {
+        // Most of the work is waiting for the disk, so there can be a few more threads than CPUs.
+        auto cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+        s_the = new WorkerPool(clamp<long>(cpu_count * 2, 4, 16));
+    }
+    return *s_the;
+}
+
+u64 WorkerPool::now_ms()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<u64>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+WorkerPool::WorkerPool(size_t thread_count)
+{
+    pthread_mutex_init(&m_mutex, nullptr);
+    pthread_cond_init(&m_work_available, nullptr);
+    pthread_mutex_init(&m_completion_mutex, nullptr);
+
+    int fds[2];
+    if (pipe(fds) < 0) {
+        perror("pipe");
+        VERIFY_NOT_REACHED();
+    }
+    for (auto fd : fds) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    m_notify_read_fd = fds[0];
+    m_notify_write_fd = fds[1];
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        auto worker = make<Worker>();
+        worker->pool = this;
+        worker->index = i;
+        pthread_mutex_init(&worker->mutex, nullptr);
+        m_workers.append(move(worker));
+    }
+
+    // The workers look at each other's queues, so they wait on m_mutex until we know how many of them there are.
+    pthread_mutex_lock(&m_mutex);
+    size_t started_count = 0;
+    for (auto& worker : m_workers) {
+        int rc = pthread_create(
+            &worker.thread, nullptr, [](void* argument) -> void* {
+                auto& worker = *static_cast<Worker*>(argument);
+                worker.pool->work(worker);
+                return nullptr;
+            },
+            &worker);
+        if (rc != 0) {
+            dbgln("WorkerPool: pthread_create failed: {}", strerror(rc));
+            break;
+        }
+        ++started_count;
+    }
+    while (m_workers.size() > started_count) {
+        pthread_mutex_destroy(&m_workers.last().mutex);
+        m_workers.take_last();
+    }
+    VERIFY(!m_workers.is_empty());
+    pthread_mutex_unlock(&m_mutex);
+}
+
+WorkerPool::~WorkerPool()
+{
+    pthread_mutex_lock(&m_mutex);
+    m_shutting_down = true;
+    pthread_cond_broadcast(&m_work_available);
+    pthread_mutex_unlock(&m_mutex);
+    for (auto& worker : m_workers)
+        pthread_join(worker.thread, nullptr);
+    for (auto& worker : m_workers)
+        pthread_mutex_destroy(&worker.mutex);
+
+    close(m_notify_read_fd);
+    close(m_notify_write_fd);
+    pthread_cond_destroy(&m_work_available);
+    pthread_mutex_destroy(&m_mutex);
+    pthread_mutex_destroy(&m_completion_mutex);
+}
+
+Optional<size_t> WorkerPool::current_worker_index() const
+{
+    auto self = pthread_self();
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        if (pthread_equal(m_workers[i].thread, self))
+            return i;
+    }
+    return {};
+}
+
+void WorkerPool::submit(Function<void()> job)
+{
+    if (auto worker_index = current_worker_index(); worker_index.has_value()) {
+        auto& worker = m_workers[worker_index.value()];
+        pthread_mutex_lock(&worker.mutex);
+        worker.jobs.append(move(job));
+        pthread_mutex_unlock(&worker.mutex);
+        pthread_mutex_lock(&m_mutex);
+    } else {
+        pthread_mutex_lock(&m_mutex);
+        m_jobs.enqueue(move(job));
+    }
+    // Counted under m_mutex, so a worker that just found nothing to do can't miss it before going to sleep.
+    ++m_queued_job_count;
+    if (m_idle_worker_count)
+        pthread_cond_signal(&m_work_available);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+void WorkerPool::post_to_main_thread(Function<void()> completion)
+{
+    pthread_mutex_lock(&m_completion_mutex);
+    // One byte in the pipe is enough to wake the main thread up for everything posted until it drains.
+    if (m_completions.is_empty()) {
+        u8 byte = 0;
+        [[maybe_unused]] auto rc = write(m_notify_write_fd, &byte, 1);
+    }
+    m_completions.append(move(completion));
+    pthread_mutex_unlock(&m_completion_mutex);
+}
+
+void WorkerPool::process_completions()
+{
+    pthread_mutex_lock(&m_completion_mutex);
+    auto completions = move(m_completions);
+    u8 drain[64];
+    while (read(m_notify_read_fd, drain, sizeof(drain)) > 0)
+        ;
+    pthread_mutex_unlock(&m_completion_mutex);
+
+    for (auto& completion : completions)
+        completion();
+}
+
+Function<void()> WorkerPool::take_newest(Worker& worker)
+{
+    Function<void()> job;
+    pthread_mutex_lock(&worker.mutex);
+    if (worker.jobs.size() > worker.head) {
+        job = worker.jobs.take_last();
+        if (worker.jobs.size() == worker.head) {
+            worker.jobs.clear_with_capacity();
+            worker.head = 0;
+        }
+    }
+    pthread_mutex_unlock(&worker.mutex);
+    return job;
+}
+
+Function<void()> WorkerPool::take_oldest(Worker& worker)
+{
+    Function<void()> job;
+    pthread_mutex_lock(&worker.mutex);
+    if (worker.jobs.size() > worker.head) {
+        job = move(worker.jobs[worker.head++]);
+        if (worker.jobs.size() == worker.head) {
+            worker.jobs.clear_with_capacity();
+            worker.head = 0;
+        }
+    }
+    pthread_mutex_unlock(&worker.mutex);
+    return job;
+}
+
+Function<void()> WorkerPool::take_job(size_t worker_index)
+{
+    if (auto job = take_newest(m_workers[worker_index]))
+        return job;
+
+    pthread_mutex_lock(&m_mutex);
+    Function<void()> job;
+    if (!m_jobs.is_empty())
+        job = m_jobs.dequeue();
+    pthread_mutex_unlock(&m_mutex);
+    if (job)
+        return job;
+
+    for (size_t i = 1; i < m_workers.size(); ++i) {
+        if (auto job = take_oldest(m_workers[(worker_index + i) % m_workers.size()]))
+            return job;
+    }
+    return {};
+}
+
+void WorkerPool::work(Worker& worker)
+{
+    pthread_mutex_lock(&m_mutex);
+    pthread_mutex_unlock(&m_mutex);
+
+    for (;;) {
+        if (auto job = take_job(worker.index)) {
+            --m_queued_job_count;
+            job();
+            continue;
+        }
+
+        pthread_mutex_lock(&m_mutex);
+        ++m_idle_worker_count;
+        while (!m_queued_job_count && !m_shutting_down)
+            pthread_cond_wait(&m_work_available, &m_mutex);
+        --m_idle_worker_count;
+        bool shutting_down = m_shutting_down;
+        pthread_mutex_unlock(&m_mutex);
+        if (shutting_down)
+            break;
+    }
+}
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <AK/Optional.h>
+#include <AK/Queue.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Vector.h>
+#include <pthread.h>
+
+namespace FileManager {
+
+// A fixed set of threads for the file system work that must not block the
+// GUI thread: reading directories, stat-ing their entries and so on.
+//
+// Jobs hand their results back with post_to_main_thread(). Those functions
+// are run by process_completions(), which the main thread calls whenever
+// notify_fd() becomes readable.
+//
+// Jobs submitted from outside the pool are run in order. Jobs submitted by a
+// job go onto its own worker's queue, which that worker works through newest
+// first; idle workers take the oldest jobs from there. A recursive walk thus
+// stays depth-first on each thread, and the other threads pick up whole
+// subtrees instead of single entries.
+class WorkerPool {
+    AK_MAKE_NONCOPYABLE(WorkerPool);
+    AK_MAKE_NONMOVABLE(WorkerPool);
+
+public:
+    static WorkerPool& the();
+
+    explicit WorkerPool(size_t thread_count);
+    ~WorkerPool();
+
+    size_t thread_count() const { return m_workers.size(); }
+    // How many jobs that hold on to their worker for a while (copying, decoding) to run at once,
+    // so that some workers are left for reading directories in the meantime.
+    size_t long_running_job_limit(size_t at_most) const { return clamp<size_t>(thread_count() / 2, 1, at_most); }
+
+    // Milliseconds since some fixed point, for throttling updates to the main thread.
+    static u64 now_ms();
+
+    void submit(Function<void()>);
+    void post_to_main_thread(Function<void()>);
+
+    int notify_fd() const { return m_notify_read_fd; }
+    void process_completions();
+
+private:
+    struct Worker {
+        WorkerPool* pool { nullptr };
+        size_t index { 0 };
+        pthread_t thread;
+        pthread_mutex_t mutex;
+        // Jobs before head have been stolen already.
+        Vector<Function<void()>> jobs;
+        size_t head { 0 };
+    };
+
+    void work(Worker&);
+    Optional<size_t> current_worker_index() const;
+    Function<void()> take_job(size_t worker_index);
+    static Function<void()> take_newest(Worker&);
+    static Function<void()> take_oldest(Worker&);
+
+    NonnullOwnPtrVector<Worker> m_workers;
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_work_available;
+    Queue<Function<void()>> m_jobs;
+    // All jobs that are queued anywhere, so idle workers know whether to go to sleep.
+    Atomic<size_t> m_queued_job_count { 0 };
+    size_t m_idle_worker_count { 0 };
+    bool m_shutting_down { false };
+
+    pthread_mutex_t m_completion_mutex;
+    Vector<Function<void()>> m_completions;
+    int m_notify_read_fd { -1 };
+    int m_notify_write_fd { -1 };
+};
+
+}
@@ -2,6 +2,8 @@
 #include "DirectoryView.h"
 #include "FileUtils.h"
 #include "PropertiesWindow.h"
+#include "ThumbnailCache.h"
+#include "WorkerPool.h"
 #include <AK/LexicalPath.h>
 #include <AK/StringBuilder.h>
 #include <AK/URL.h>
@@ -10,6 +12,7 @@
 #include <LibCore/ConfigFile.h>
 #include <LibCore/File.h>
 #include <LibCore/MimeData.h>
+#include <LibCore/Notifier.h>
 #include <LibCore/StandardPaths.h>
 #include <LibDesktop/Launcher.h>
 #include <LibGUI/Action.h>
@@ -90,6 +93,14 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    // Directories are read on worker threads, which hand their results back through here.
+    auto worker_pool_notifier = Core::Notifier::construct(WorkerPool::the().notify_fd(), Core::Notifier::Read);
+    worker_pool_notifier->on_ready_to_read = [] {
+        WorkerPool::the().process_completions();
+    };
+
+    ThumbnailCache::the().set_disk_cache_directory(String::formatted("{}/.cache/FileManager/thumbnails", Core::StandardPaths::home_directory()));
+
     if (is_desktop_mode)
         return run_in_desktop_mode(move(config));
 
@@ -151,12 +162,13 @@ void do_paste(const String& target_directory, GUI::Window* window)
         return;
     }
 
-    bool should_delete_src = false;
+    auto operation = FileUtils::FileOperation::Copy;
     if (copied_lines[0] == "#cut") { // cut operation encoded as a text/uri-list commen
-        should_delete_src = true;
+        operation = FileUtils::FileOperation::Cut;
         copied_lines.remove(0);
     }
 
+    Vector<String> paths;
     for (auto& uri_as_string : copied_lines) {
         if (uri_as_string.is_empty())
             continue;
@@ -165,15 +177,10 @@ void do_paste(const String& target_directory, GUI::Window* window)
             dbgln("Cannot paste URI {}", uri_as_string);
             continue;
         }
-
-        auto new_path = String::formatted("{}/{}", target_directory, url.basename());
-        if (auto result = Core::File::copy_file_or_directory(new_path, url.path()); result.is_error()) {
-            auto error_message = String::formatted("Could not paste '{}': {}", url.path(), result.error().error_code);
-            GUI::MessageBox::show(window, error_message, "File Manager", GUI::MessageBox::Type::Error);
-        } else if (should_delete_src) {
-            FileUtils::delete_path(url.path(), window);
-        }
+        paths.append(url.path());
     }
+    if (!paths.is_empty())
+        FileUtils::transfer_paths(paths, target_directory, operation, window);
 }
 
 void do_create_link(const Vector<String>& selected_file_paths, GUI::Window* window)
@@ -699,8 +706,9 @@ int run_in_windowed_mode(RefPtr<Core::ConfigFile> config, String initial_locatio
 
     auto tree_view_delete_action = GUI::CommonActions::make_delete_action(
         [&](auto&) {
-            FileUtils::delete_paths(tree_view_selected_file_paths(), true, window);
-            refresh_tree_view();
+            FileUtils::delete_paths(tree_view_selected_file_paths(), true, window, [&] {
+                refresh_tree_view();
+            });
         },
         &tree_view);
 
@@ -835,7 +843,7 @@ int run_in_windowed_mode(RefPtr<Core::ConfigFile> config, String initial_locatio
                 breadcrumb_bar.append_segment("/", GUI::FileIconProvider::icon_for_path("/").bitmap_for_size(16), "/", "/");
                 StringBuilder builder;
 
-                for (auto& part : lexical_path.parts()) {
+                for (auto part : lexical_path) {
                     // NOTE: We rebuild the path as we go, so we have something to pass to GUI::FileIconProvider.
                     builder.append('/');
                     builder.append(part);
@@ -1000,23 +1008,20 @@ int run_in_windowed_mode(RefPtr<Core::ConfigFile> config, String initial_locatio
             dbgln("No files to copy");
             return;
         }
-        bool had_accepted_copy = false;
+        Vector<String> paths_to_copy;
         for (auto& url_to_copy : urls) {
             if (!url_to_copy.is_valid() || url_to_copy.path() == directory)
                 continue;
             auto new_path = String::formatted("{}/{}", directory, LexicalPath(url_to_copy.path()).basename());
             if (url_to_copy.path() == new_path)
                 continue;
-
-            if (auto result = Core::File::copy_file_or_directory(url_to_copy.path(), new_path); result.is_error()) {
-                auto error_message = String::formatted("Could not copy {} into {}:\n {}", url_to_copy.to_string(), new_path, result.error().error_code);
-                GUI::MessageBox::show(window, error_message, "File Manager", GUI::MessageBox::Type::Error);
-            } else {
-                had_accepted_copy = true;
-            }
+            paths_to_copy.append(url_to_copy.path());
         }
-        if (had_accepted_copy)
+        if (paths_to_copy.is_empty())
+            return;
+        FileUtils::transfer_paths(paths_to_copy, directory, FileUtils::FileOperation::Copy, window, [&] {
             refresh_tree_view();
+        });
     };
 
     breadcrumb_bar.on_segment_drop = [&](size_t segment_index, const GUI::DropEvent& event) {
@@ -1065,11 +1070,8 @@ int run_in_windowed_mode(RefPtr<Core::ConfigFile> config, String initial_locatio
         view_as_icons_action->set_checked(true);
     }
 
-    if (!entry_focused_on_init.is_empty()) {
-        auto matches = directory_view.current_view().model()->matches(entry_focused_on_init, GUI::Model::MatchesFlag::MatchFull | GUI::Model::MatchesFlag::FirstMatchOnly);
-        if (!matches.is_empty())
-            directory_view.current_view().set_cursor(matches.first(), GUI::AbstractView::SelectionUpdate::Set);
-    }
+    if (!entry_focused_on_init.is_empty())
+        directory_view.focus_entry(entry_focused_on_init);
 
     // Write window position to config file on close request.
     window->on_close_request = [&] {
@@ -10,6 +10,7 @@ IRCChannel::IRCChannel(IRCClient& client, const String& name)
     , m_member_model(IRCChannelMemberListModel::create(*this))
 {
     m_window = m_client.aid_create_window(this, IRCWindow::Channel, m_name);
+    m_log->set_max_line_count(m_client.scrollback_line_count());
     m_window->set_log_buffer(*m_log);
 }
 
@@ -24,24 +25,55 @@ NonnullRefPtr<IRCChannel> IRCChannel::create(IRCClient& client, const String& na
 
 void IRCChannel::add_member(const String& name, char prefix)
 {
-    for (auto& member : m_members) {
-        if (member.name == name) {
-            member.prefix = prefix;
-            return;
-        }
-    }
-    m_members.append({ name, prefix });
+    if (m_members.add(name, prefix))
+        m_client.register_channel_member(name, *this);
     m_member_model->update();
 }
 
 void IRCChannel::remove_member(const String& name)
 {
-    m_members.remove_first_matching([&](auto& member) { return name == member.name; });
+    if (m_members.remove(name))
+        m_client.unregister_channel_member(name, *this);
+}
+
+void IRCChannel::clear_members()
+{
+    for (auto* member : m_members.members())
+        m_client.unregister_channel_member(member->nick, *this);
+    m_members.clear();
+}
+
+String IRCChannel::member_at(int i) const
+{
+    auto& member = m_members.at(i);
+    if (!member.prefix)
+        return member.nick;
+    return String::formatted("{}{}", member.prefix, member.nick);
+}
+
+void IRCChannel::add_names(Vector<IRCChannelMemberList::Member>&& names)
+{
+    if (m_pending_names.is_empty()) {
+        m_pending_names = move(names);
+        return;
+    }
+    m_pending_names.append(move(names));
+}
+
+void IRCChannel::did_receive_end_of_names()
+{
+    clear_members();
+    m_members.set_members(move(m_pending_names));
+    m_pending_names.clear();
+    for (auto* member : m_members.members())
+        m_client.register_channel_member(member->nick, *this);
+    m_member_model->update();
 }
 
 void IRCChannel::add_message(char prefix, const String& name, const String& text, Color color)
 {
     log().add_message(prefix, name, text, color);
+    m_client.log_message(m_name, name, text);
     window().did_add_message(name, text);
 }
 
@@ -64,7 +96,6 @@ void IRCChannel::handle_join(const String& nick, const String& hostmask)
         return;
     }
     add_member(nick, (char)0);
-    m_member_model->update();
     if (m_client.show_join_part_messages())
         add_message(String::formatted("*** {} [{}] has joined {}", nick, hostmask, m_name), Color::MidGreen);
 }
@@ -73,7 +104,7 @@ void IRCChannel::handle_part(const String& nick, const String& hostmask)
 {
     if (nick == m_client.nickname()) {
         m_open = false;
-        m_members.clear();
+        clear_members();
         m_client.did_part_from_channel({}, *this);
     } else {
         remove_member(nick);
@@ -87,7 +118,7 @@ void IRCChannel::handle_quit(const String& nick, const String& hostmask, const S
 {
     if (nick == m_client.nickname()) {
         m_open = false;
-        m_members.clear();
+        clear_members();
         m_client.did_part_from_channel({}, *this);
     } else {
         remove_member(nick);
@@ -104,15 +135,12 @@ void IRCChannel::handle_topic(const String& nick, const String& topic)
         add_message(String::formatted("*** {} set topic to \"{}\"", nick, topic), Color::MidBlue);
 }
 
+// The client moves the nick in its registry itself, since it does so once for all channels.
 void IRCChannel::notify_nick_changed(const String& old_nick, const String& new_nick)
 {
-    for (auto& member : m_members) {
-        if (member.name == old_nick) {
-            member.name = new_nick;
-            m_member_model->update();
-            if (m_client.show_nick_change_messages())
-                add_message(String::formatted("~ {} changed nickname to {}", old_nick, new_nick), Color::MidMagenta);
-            return;
-        }
-    }
+    if (!m_members.rename(old_nick, new_nick))
+        return;
+    m_member_model->update();
+    if (m_client.show_nick_change_messages())
+        add_message(String::formatted("~ {} changed nickname to {}", old_nick, new_nick), Color::MidMagenta);
 }
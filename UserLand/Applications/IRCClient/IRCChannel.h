@@ -1,5 +1,6 @@
 #pragma once
 
+#include "IRCChannelMemberList.h"
 #include "IRCLogBuffer.h"
 #include <AK/RefCounted.h>
 #include <AK/RefPtr.h>
@@ -23,6 +24,10 @@ public:
     void add_member(const String& name, char prefix);
     void remove_member(const String& name);
 
+    // NAMES replies are collected until the end of the list and then replace the members in one go.
+    void add_names(Vector<IRCChannelMemberList::Member>&&);
+    void did_receive_end_of_names();
+
     void add_message(char prefix, const String& name, const String& text, Color = Color::Black);
     void add_message(const String& text, Color = Color::Black);
 
@@ -34,8 +39,9 @@ public:
     IRCChannelMemberListModel* member_model() { return m_member_model.ptr(); }
     const IRCChannelMemberListModel* member_model() const { return m_member_model.ptr(); }
 
+    const IRCChannelMemberList& members() const { return m_members; }
     int member_count() const { return m_members.size(); }
-    String member_at(int i) { return m_members[i].name; }
+    String member_at(int i) const;
 
     void handle_join(const String& nick, const String& hostmask);
     void handle_part(const String& nick, const String& hostmask);
@@ -55,11 +61,10 @@ private:
     IRCClient& m_client;
     String m_name;
     String m_topic;
-    struct Member {
-        String name;
-        char prefix { 0 };
-    };
-    Vector<Member> m_members;
+    void clear_members();
+
+    IRCChannelMemberList m_members;
+    Vector<IRCChannelMemberList::Member> m_pending_names;
     bool m_open { false };
 
     NonnullRefPtr<IRCLogBuffer> m_log;
@@ -0,0 +1,131 @@
+#include "IRCChannelMemberList.h"
+#include <AK/QuickSort.h>
+#include <strings.h>
+
+int IRCChannelMemberList::prefix_rank(char prefix)
+{
+    switch (prefix) {
+    case '~':
+        return 0;
+    case '&':
+        return 1;
+    case '@':
+        return 2;
+    case '%':
+        return 3;
+    case '+':
+        return 4;
+    default:
+        return 5;
+    }
+}
+
+bool IRCChannelMemberList::comes_before(const Member& a, const Member& b)
+{
+    auto a_rank = prefix_rank(a.prefix);
+    auto b_rank = prefix_rank(b.prefix);
+    if (a_rank != b_rank)
+        return a_rank < b_rank;
+    return strcasecmp(a.nick.characters(), b.nick.characters()) < 0;
+}
+
+size_t IRCChannelMemberList::lower_bound(const Member& member) const
+{
+    size_t low = 0;
+    size_t high = m_sorted_members.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (comes_before(*m_sorted_members[middle], member))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+void IRCChannelMemberList::insert_sorted(Member& member)
+{
+    m_sorted_members.insert(lower_bound(member), &member);
+}
+
+void IRCChannelMemberList::remove_sorted(const Member& member)
+{
+    auto index = lower_bound(member);
+    VERIFY(index < m_sorted_members.size());
+    VERIFY(m_sorted_members[index] == &member);
+    m_sorted_members.remove(index);
+}
+
+Optional<char> IRCChannelMemberList::prefix_of(const String& nick) const
+{
+    auto it = m_members_by_nick.find(nick);
+    if (it == m_members_by_nick.end())
+        return {};
+    return it->value->prefix;
+}
+
+bool IRCChannelMemberList::add(const String& nick, char prefix)
+{
+    auto it = m_members_by_nick.find(nick);
+    if (it != m_members_by_nick.end()) {
+        auto& member = *it->value;
+        if (member.prefix != prefix) {
+            remove_sorted(member);
+            member.prefix = prefix;
+            insert_sorted(member);
+        }
+        return false;
+    }
+    auto member = make<Member>(Member { nick, prefix });
+    insert_sorted(*member);
+    m_members_by_nick.set(nick, move(member));
+    return true;
+}
+
+bool IRCChannelMemberList::remove(const String& nick)
+{
+    auto it = m_members_by_nick.find(nick);
+    if (it == m_members_by_nick.end())
+        return false;
+    remove_sorted(*it->value);
+    m_members_by_nick.remove(it);
+    return true;
+}
+
+bool IRCChannelMemberList::rename(const String& old_nick, const String& new_nick)
+{
+    auto it = m_members_by_nick.find(old_nick);
+    if (it == m_members_by_nick.end())
+        return false;
+    auto member = move(it->value);
+    m_members_by_nick.remove(it);
+    remove_sorted(*member);
+    if (m_members_by_nick.contains(new_nick))
+        return true;
+    member->nick = new_nick;
+    insert_sorted(*member);
+    m_members_by_nick.set(new_nick, move(member));
+    return true;
+}
+
+void IRCChannelMemberList::set_members(Vector<Member>&& members)
+{
+    clear();
+    m_members_by_nick.ensure_capacity(members.size());
+    m_sorted_members.ensure_capacity(members.size());
+    for (auto& member : members) {
+        // A nick must only have one row, so later duplicates are dropped.
+        if (m_members_by_nick.contains(member.nick))
+            continue;
+        auto owned_member = make<Member>(move(member));
+        m_sorted_members.unchecked_append(owned_member.ptr());
+        m_members_by_nick.set(owned_member->nick, move(owned_member));
+    }
+    quick_sort(m_sorted_members, [](auto* a, auto* b) { return comes_before(*a, *b); });
+}
+
+void IRCChannelMemberList::clear()
+{
+    m_sorted_members.clear();
+    m_members_by_nick.clear();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+
+// The members of a channel, indexed by nick for membership changes and kept
+// sorted by prefix rank (owners first, then ops, voiced users etc.) and nick
+// for display. The sorted list only holds pointers, so keeping it in order moves
+// a few bytes per member instead of constructing and destroying Strings.
+class IRCChannelMemberList {
+public:
+    struct Member {
+        String nick;
+        char prefix { 0 };
+    };
+
+    size_t size() const { return m_sorted_members.size(); }
+    bool is_empty() const { return m_sorted_members.is_empty(); }
+
+    // Members in display order.
+    const Member& at(size_t index) const { return *m_sorted_members[index]; }
+    const Vector<Member*>& members() const { return m_sorted_members; }
+
+    bool contains(const String& nick) const { return m_members_by_nick.contains(nick); }
+    Optional<char> prefix_of(const String& nick) const;
+
+    // Returns false if the nick was already a member, in which case only its prefix is updated.
+    bool add(const String& nick, char prefix);
+    bool remove(const String& nick);
+    bool rename(const String& old_nick, const String& new_nick);
+
+    // Replaces all members at once, e.g. with the result of a NAMES query. This sorts once
+    // instead of inserting every member into place.
+    void set_members(Vector<Member>&&);
+    void clear();
+
+    static int prefix_rank(char prefix);
+
+private:
+    static bool comes_before(const Member&, const Member&);
+    size_t lower_bound(const Member&) const;
+    void insert_sorted(Member&);
+    void remove_sorted(const Member&);
+
+    HashMap<String, NonnullOwnPtr<Member>, CaseInsensitiveStringTraits> m_members_by_nick;
+    Vector<Member*> m_sorted_members;
+};
@@ -0,0 +1,643 @@
+#include "IRCChatLog.h"
+#include <AK/NumericLimits.h>
+#include <AK/QuickSort.h>
+#include <AK/RefCounted.h>
+#include <AK/RefPtr.h>
+#include <AK/StringImpl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A record in a .log file is this header followed by the channel, the nick and the text.
+struct [[gnu::packed]] RecordHeader {
+    i64 timestamp;
+    u16 text_length;
+    u8 channel_length;
+    u8 nick_length;
+};
+
+// A .idx file is this header, the offset of every record in the log, the trigram and
+// nick tables sorted by key, and finally the posting lists they point to. A posting
+// list is the ascending indices of the records containing the term, stored as
+// LEB128-encoded differences.
+static constexpr u32 index_magic = 0x58435249; // "IRCX"
+static constexpr u32 index_version = 1;
+
+struct IndexHeader {
+    u32 magic;
+    u32 version;
+    u64 log_size;
+    u32 record_count;
+    u32 trigram_count;
+    u32 nick_count;
+    u32 postings_size;
+};
+
+struct TermEntry {
+    u32 key;
+    u32 count;
+    u32 postings_offset;
+    u32 postings_length;
+};
+
+struct Record {
+    time_t timestamp;
+    StringView channel;
+    StringView nick;
+    StringView text;
+};
+
+static Optional<Record> parse_record(ReadonlyBytes records, size_t offset, size_t* next_offset = nullptr)
+{
+    if (offset + sizeof(RecordHeader) > records.size())
+        return {};
+    RecordHeader header;
+    memcpy(&header, records.offset_pointer(offset), sizeof(header));
+    auto* strings = reinterpret_cast<const char*>(records.offset_pointer(offset + sizeof(header)));
+    size_t end = offset + sizeof(header) + header.channel_length + header.nick_length + header.text_length;
+    if (end > records.size())
+        return {};
+    if (next_offset)
+        *next_offset = end;
+    return Record {
+        static_cast<time_t>(header.timestamp),
+        { strings, header.channel_length },
+        { strings + header.channel_length, header.nick_length },
+        { strings + header.channel_length + header.nick_length, header.text_length },
+    };
+}
+
+static u8 to_ascii_lowercase(u8 byte)
+{
+    return byte >= 'A' && byte <= 'Z' ? byte | 0x20 : byte;
+}
+
+static u32 trigram_at(const StringView& text, size_t index)
+{
+    auto* bytes = reinterpret_cast<const u8*>(text.characters_without_null_termination()) + index;
+    return to_ascii_lowercase(bytes[0]) << 16 | to_ascii_lowercase(bytes[1]) << 8 | to_ascii_lowercase(bytes[2]);
+}
+
+static u32 nick_key(const StringView& nick)
+{
+    return case_insensitive_string_hash(nick.characters_without_null_termination(), nick.length());
+}
+
+struct Postings {
+    ReadonlyBytes encoded;
+    u32 count { 0 };
+};
+
+static Vector<u32> decode_postings(const Postings& postings)
+{
+    Vector<u32> indices;
+    indices.ensure_capacity(postings.count);
+    u32 previous = 0;
+    size_t offset = 0;
+    while (offset < postings.encoded.size() && indices.size() < postings.count) {
+        u32 delta = 0;
+        for (u32 shift = 0; offset < postings.encoded.size(); shift += 7) {
+            u8 byte = postings.encoded[offset++];
+            delta |= static_cast<u32>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+        previous += delta;
+        indices.unchecked_append(previous);
+    }
+    return indices;
+}
+
+class IRCChatLog::IndexBuilder {
+public:
+    void add(u32 offset, const StringView& nick, const StringView& text)
+    {
+        u32 record_index = m_record_offsets.size();
+        m_record_offsets.append(offset);
+        if (!nick.is_empty())
+            m_nicks.ensure(nick_key(nick)).add(record_index);
+        for (size_t i = 0; i + 3 <= text.length(); ++i)
+            m_trigrams.ensure(trigram_at(text, i)).add(record_index);
+    }
+
+    size_t record_count() const { return m_record_offsets.size(); }
+    u32 record_offset(size_t index) const { return m_record_offsets[index]; }
+
+    Optional<Postings> trigram_postings(u32 key) const { return postings(m_trigrams, key); }
+    Optional<Postings> nick_postings(u32 key) const { return postings(m_nicks, key); }
+
+    ByteBuffer serialize(u64 log_size) const
+    {
+        Vector<TermEntry> trigram_entries;
+        Vector<TermEntry> nick_entries;
+        Vector<u8> postings_area;
+        auto collect = [&](auto& lists, auto& entries) {
+            entries.ensure_capacity(lists.size());
+            for (auto& it : lists)
+                entries.unchecked_append({ it.key, it.value.count, 0, static_cast<u32>(it.value.encoded.size()) });
+            quick_sort(entries, [](auto& a, auto& b) { return a.key < b.key; });
+            for (auto& entry : entries) {
+                auto& encoded = lists.find(entry.key)->value.encoded;
+                entry.postings_offset = postings_area.size();
+                postings_area.append(encoded.data(), encoded.size());
+            }
+        };
+        collect(m_trigrams, trigram_entries);
+        collect(m_nicks, nick_entries);
+
+        IndexHeader header {
+            index_magic,
+            index_version,
+            log_size,
+            static_cast<u32>(m_record_offsets.size()),
+            static_cast<u32>(trigram_entries.size()),
+            static_cast<u32>(nick_entries.size()),
+            static_cast<u32>(postings_area.size()),
+        };
+        auto index = ByteBuffer::create_uninitialized(sizeof(header) + m_record_offsets.size() * sizeof(u32)
+            + (trigram_entries.size() + nick_entries.size()) * sizeof(TermEntry) + postings_area.size());
+        size_t offset = 0;
+        auto write = [&](const void* data, size_t size) {
+            if (size)
+                memcpy(index.offset_pointer(offset), data, size);
+            offset += size;
+        };
+        write(&header, sizeof(header));
+        write(m_record_offsets.data(), m_record_offsets.size() * sizeof(u32));
+        write(trigram_entries.data(), trigram_entries.size() * sizeof(TermEntry));
+        write(nick_entries.data(), nick_entries.size() * sizeof(TermEntry));
+        write(postings_area.data(), postings_area.size());
+        return index;
+    }
+
+private:
+    struct List {
+        Vector<u8> encoded;
+        u32 count { 0 };
+        u32 last { 0 };
+
+        void add(u32 record_index)
+        {
+            // A trigram that occurs several times in one message is only listed once.
+            if (count && record_index == last)
+                return;
+            u32 delta = record_index - (count ? last : 0);
+            while (delta >= 0x80) {
+                encoded.append(static_cast<u8>(delta) | 0x80);
+                delta >>= 7;
+            }
+            encoded.append(static_cast<u8>(delta));
+            last = record_index;
+            ++count;
+        }
+    };
+
+    static Optional<Postings> postings(const HashMap<u32, List>& lists, u32 key)
+    {
+        auto it = lists.find(key);
+        if (it == lists.end())
+            return {};
+        return Postings { it->value.encoded.span(), it->value.count };
+    }
+
+    Vector<u32> m_record_offsets;
+    HashMap<u32, List> m_trigrams;
+    HashMap<u32, List> m_nicks;
+};
+
+// The records of one day, indexed either in memory (the current day, or a day whose
+// sidecar was missing) or by a mapped .idx file.
+class IRCChatLog::Segment {
+public:
+    Segment() = default;
+
+    Segment(NonnullRefPtr<MappedFile> log, NonnullRefPtr<MappedFile> index)
+        : m_log(move(log))
+        , m_index(move(index))
+    {
+        auto bytes = m_index->bytes();
+        memcpy(&m_header, bytes.data(), sizeof(m_header));
+        m_record_offsets = reinterpret_cast<const u32*>(bytes.offset_pointer(sizeof(IndexHeader)));
+        m_trigrams = reinterpret_cast<const TermEntry*>(m_record_offsets + m_header.record_count);
+        m_nicks = m_trigrams + m_header.trigram_count;
+        m_postings = reinterpret_cast<const u8*>(m_nicks + m_header.nick_count);
+    }
+
+    static bool is_valid_index(ReadonlyBytes index, size_t log_size)
+    {
+        if (index.size() < sizeof(IndexHeader))
+            return false;
+        IndexHeader header;
+        memcpy(&header, index.data(), sizeof(header));
+        if (header.magic != index_magic || header.version != index_version || header.log_size != log_size)
+            return false;
+        u64 expected_size = sizeof(IndexHeader) + (u64)header.record_count * sizeof(u32)
+            + ((u64)header.trigram_count + header.nick_count) * sizeof(TermEntry) + header.postings_size;
+        return expected_size == index.size();
+    }
+
+    // Indexes existing records, and returns how many bytes of them were complete.
+    size_t load(ReadonlyBytes records)
+    {
+        size_t offset = 0;
+        size_t next_offset = 0;
+        for (;;) {
+            auto record = parse_record(records, offset, &next_offset);
+            if (!record.has_value())
+                break;
+            m_builder.add(offset, record->nick, record->text);
+            offset = next_offset;
+        }
+        m_records.append(records.data(), offset);
+        return offset;
+    }
+
+    void append(time_t timestamp, const StringView& channel, const StringView& nick, const StringView& text)
+    {
+        VERIFY(!m_log);
+        RecordHeader header {
+            timestamp,
+            static_cast<u16>(min(text.length(), (size_t)NumericLimits<u16>::max())),
+            static_cast<u8>(min(channel.length(), (size_t)NumericLimits<u8>::max())),
+            static_cast<u8>(min(nick.length(), (size_t)NumericLimits<u8>::max())),
+        };
+        u32 offset = m_records.size();
+        m_records.append(reinterpret_cast<const u8*>(&header), sizeof(header));
+        m_records.append(reinterpret_cast<const u8*>(channel.characters_without_null_termination()), header.channel_length);
+        m_records.append(reinterpret_cast<const u8*>(nick.characters_without_null_termination()), header.nick_length);
+        m_records.append(reinterpret_cast<const u8*>(text.characters_without_null_termination()), header.text_length);
+        m_builder.add(offset, nick.substring_view(0, header.nick_length), text.substring_view(0, header.text_length));
+    }
+
+    bool is_mapped() const { return m_log; }
+    ReadonlyBytes records() const { return m_log ? m_log->bytes() : m_records.span(); }
+    const IndexBuilder& builder() const { return m_builder; }
+
+    size_t record_count() const { return m_log ? m_header.record_count : m_builder.record_count(); }
+    u32 record_offset(size_t index) const { return m_log ? m_record_offsets[index] : m_builder.record_offset(index); }
+
+    Optional<Postings> trigram_postings(u32 key) const
+    {
+        if (!m_log)
+            return m_builder.trigram_postings(key);
+        return find_postings(m_trigrams, m_header.trigram_count, key);
+    }
+
+    Optional<Postings> nick_postings(u32 key) const
+    {
+        if (!m_log)
+            return m_builder.nick_postings(key);
+        return find_postings(m_nicks, m_header.nick_count, key);
+    }
+
+    void search(const Query&, size_t max_results, Vector<Match>&) const;
+
+private:
+    Optional<Postings> find_postings(const TermEntry* entries, size_t count, u32 key) const
+    {
+        size_t low = 0;
+        size_t high = count;
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (entries[middle].key < key)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        if (low == count || entries[low].key != key)
+            return {};
+        auto& entry = entries[low];
+        if ((u64)entry.postings_offset + entry.postings_length > m_header.postings_size)
+            return {};
+        return Postings { { m_postings + entry.postings_offset, entry.postings_length }, entry.count };
+    }
+
+    // In memory.
+    Vector<u8> m_records;
+    IndexBuilder m_builder;
+
+    // Mapped.
+    RefPtr<MappedFile> m_log;
+    RefPtr<MappedFile> m_index;
+    IndexHeader m_header {};
+    const u32* m_record_offsets { nullptr };
+    const TermEntry* m_trigrams { nullptr };
+    const TermEntry* m_nicks { nullptr };
+    const u8* m_postings { nullptr };
+};
+
+static Vector<u32> intersect(const Vector<u32>& a, const Vector<u32>& b)
+{
+    Vector<u32> result;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            result.append(a[i]);
+            ++i;
+            ++j;
+        }
+    }
+    return result;
+}
+
+void IRCChatLog::Segment::search(const Query& query, size_t max_results, Vector<Match>& matches) const
+{
+    // Collect the posting lists of every term the query requires. If any term doesn't
+    // occur at all, nothing in this segment can match.
+    Vector<Postings> terms;
+    if (!query.nick.is_empty()) {
+        auto postings = nick_postings(nick_key(query.nick));
+        if (!postings.has_value())
+            return;
+        terms.append(postings.value());
+    }
+    for (size_t i = 0; i + 3 <= query.text.length(); ++i) {
+        auto postings = trigram_postings(trigram_at(query.text, i));
+        if (!postings.has_value())
+            return;
+        terms.append(postings.value());
+    }
+
+    // Starting with the rarest term keeps the intermediate results small.
+    Optional<Vector<u32>> candidates;
+    quick_sort(terms, [](auto& a, auto& b) { return a.count < b.count; });
+    for (auto& term : terms) {
+        auto indices = decode_postings(term);
+        candidates = candidates.has_value() ? intersect(candidates.value(), indices) : move(indices);
+        if (candidates->is_empty())
+            return;
+    }
+
+    auto records = this->records();
+    auto check = [&](size_t record_index) {
+        // A damaged index may list records that aren't there.
+        if (record_index >= record_count())
+            return;
+        auto record = parse_record(records, record_offset(record_index));
+        if (!record.has_value())
+            return;
+        if (!query.channel.is_empty() && !record->channel.equals_ignoring_case(query.channel))
+            return;
+        if (!query.nick.is_empty() && !record->nick.equals_ignoring_case(query.nick))
+            return;
+        if (!query.text.is_empty() && !record->text.contains(query.text, CaseSensitivity::CaseInsensitive))
+            return;
+        matches.append({ record->timestamp, record->channel, record->nick, record->text });
+    };
+
+    if (candidates.has_value()) {
+        for (size_t i = candidates->size(); i-- > 0 && matches.size() < max_results;)
+            check(candidates.value()[i]);
+    } else {
+        for (size_t i = record_count(); i-- > 0 && matches.size() < max_results;)
+            check(i);
+    }
+}
+
+// Keeps an fd open until the last write to it has completed.
+class IRCChatLog::WriteTarget : public RefCounted<WriteTarget> {
+public:
+    explicit WriteTarget(int fd)
+        : fd(fd)
+    {
+    }
+    ~WriteTarget() { close(fd); }
+
+    int fd { -1 };
+};
+
+// Keeps the data of a write alive, at a fixed address, until it has completed.
+class WriteBuffer : public RefCounted<WriteBuffer> {
+public:
+    explicit WriteBuffer(ByteBuffer&& bytes)
+        : bytes(move(bytes))
+    {
+    }
+
+    ByteBuffer bytes;
+};
+
+static RefPtr<IRCChatLog::WriteTarget> open_for_writing(const String& path, bool truncate)
+{
+    int fd = ::open(path.characters(), O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0600);
+    if (fd < 0) {
+        dbgln("IRCChatLog: Unable to open {}: {}", path, strerror(errno));
+        return {};
+    }
+    return adopt(*new IRCChatLog::WriteTarget(fd));
+}
+
+static String day_for(time_t timestamp, time_t* day_end = nullptr)
+{
+    struct tm tm;
+    localtime_r(&timestamp, &tm);
+    auto day = String::formatted("{:04}-{:02}-{:02}", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+    if (day_end) {
+        tm.tm_hour = 0;
+        tm.tm_min = 0;
+        tm.tm_sec = 0;
+        tm.tm_isdst = -1;
+        ++tm.tm_mday;
+        *day_end = mktime(&tm);
+    }
+    return day;
+}
+
+Result<NonnullOwnPtr<IRCChatLog>, OSError> IRCChatLog::open(const String& directory)
+{
+    // Create every missing directory along the path.
+    for (size_t i = 1; i <= directory.length(); ++i) {
+        if (i != directory.length() && directory[i] != '/')
+            continue;
+        auto prefix = directory.substring(0, i);
+        if (mkdir(prefix.characters(), 0700) < 0 && errno != EEXIST)
+            return OSError(errno);
+    }
+
+    auto io = AsyncFileIO::create(AsyncFileIO::Backend::ThreadPool);
+    if (io.is_error())
+        return io.error();
+    auto log = adopt_own(*new IRCChatLog(directory, io.release_value()));
+    auto result = log->open_active_segment(time(nullptr));
+    if (result.is_error())
+        return result.error();
+    return log;
+}
+
+IRCChatLog::IRCChatLog(const String& directory, NonnullOwnPtr<AsyncFileIO> io)
+    : m_directory(directory)
+    , m_io(move(io))
+{
+}
+
+IRCChatLog::~IRCChatLog()
+{
+    close_active_segment();
+    while (m_io->in_flight() || m_io->queued())
+        m_io->wait();
+}
+
+String IRCChatLog::path_for(const String& day, const StringView& extension) const
+{
+    return String::formatted("{}/{}.{}", m_directory, day, extension);
+}
+
+Result<void, OSError> IRCChatLog::open_active_segment(time_t timestamp)
+{
+    m_active_day = day_for(timestamp, &m_active_day_end);
+    m_active_segment = make<Segment>();
+    m_flushed_size = 0;
+
+    // Pick up where an earlier session left off today. A record cut short by a crash is dropped.
+    auto log_path = path_for(m_active_day, "log");
+    auto existing = MappedFile::map(log_path);
+    if (!existing.is_error())
+        m_flushed_size = m_active_segment->load(existing.value()->bytes());
+
+    m_active_file = open_for_writing(log_path, false);
+    if (!m_active_file)
+        return OSError(errno);
+    if (ftruncate(m_active_file->fd, m_flushed_size) < 0)
+        return OSError(errno);
+    return {};
+}
+
+void IRCChatLog::close_active_segment()
+{
+    if (!m_active_segment)
+        return;
+    flush();
+    if (auto index_file = open_for_writing(path_for(m_active_day, "idx"), true))
+        write(m_active_day, index_file.release_nonnull(), m_active_segment->builder().serialize(m_flushed_size), 0);
+    m_io->submit();
+
+    // The in-memory index stays usable for searches while the writes are in flight.
+    m_closed_segments.set(m_active_day, move(m_active_segment));
+    m_active_file = nullptr;
+    drop_written_segment(m_active_day);
+}
+
+void IRCChatLog::write(const String& day, NonnullRefPtr<WriteTarget> target, ByteBuffer&& bytes, u64 offset)
+{
+    ++m_pending_writes.ensure(day).count;
+    auto buffer = adopt(*new WriteBuffer(move(bytes)));
+    auto span = buffer->bytes.span();
+    m_io->write(target->fd, span, offset, [this, day, target, buffer](ssize_t result) {
+        auto& writes = m_pending_writes.find(day)->value;
+        --writes.count;
+        if (result < 0) {
+            dbgln("IRCChatLog: Write failed: {}", strerror(-result));
+            writes.has_failed = true;
+        } else if ((size_t)result != buffer->bytes.size()) {
+            dbgln("IRCChatLog: Short write of {} out of {} bytes", result, buffer->bytes.size());
+            writes.has_failed = true;
+        }
+        drop_written_segment(day);
+    });
+}
+
+void IRCChatLog::drop_written_segment(const String& day)
+{
+    auto it = m_closed_segments.find(day);
+    if (it == m_closed_segments.end() || it->value->is_mapped())
+        return;
+    if (auto writes = m_pending_writes.find(day); writes != m_pending_writes.end()) {
+        // If a write failed, the files are missing some of the day, so it stays in memory.
+        if (writes->value.count || writes->value.has_failed)
+            return;
+        m_pending_writes.remove(writes);
+    }
+    // segment_for_day() maps the files the next time the day is searched.
+    m_closed_segments.remove(it);
+}
+
+void IRCChatLog::append(time_t timestamp, const StringView& channel, const StringView& nick, const StringView& text)
+{
+    if (timestamp >= m_active_day_end) {
+        close_active_segment();
+        if (auto result = open_active_segment(timestamp); result.is_error()) {
+            dbgln("IRCChatLog: Unable to start a new segment: {}", result.error());
+            return;
+        }
+    }
+    m_active_segment->append(timestamp, channel, nick, text);
+}
+
+void IRCChatLog::flush()
+{
+    if (!m_active_file)
+        return;
+    auto records = m_active_segment->records();
+    if (records.size() == m_flushed_size)
+        return;
+    auto pending = records.slice(m_flushed_size, records.size() - m_flushed_size);
+    write(m_active_day, *m_active_file, ByteBuffer::copy(pending.data(), pending.size()), m_flushed_size);
+    m_flushed_size = records.size();
+    m_io->submit();
+}
+
+IRCChatLog::Segment* IRCChatLog::segment_for_day(const String& day)
+{
+    if (auto it = m_closed_segments.find(day); it != m_closed_segments.end())
+        return it->value.ptr();
+
+    auto log = MappedFile::map(path_for(day, "log"));
+    if (log.is_error())
+        return nullptr;
+    (void)log.value()->advise(MappedFile::Advice::Random);
+
+    OwnPtr<Segment> segment;
+    auto index = MappedFile::map(path_for(day, "idx"));
+    if (!index.is_error() && Segment::is_valid_index(index.value()->bytes(), log.value()->size())) {
+        segment = make<Segment>(log.release_value(), index.release_value());
+    } else {
+        // The sidecar is missing or stale, so index the log in memory and write a new one.
+        segment = make<Segment>();
+        auto size = segment->load(log.value()->bytes());
+        if (auto index_file = open_for_writing(path_for(day, "idx"), true)) {
+            write(day, index_file.release_nonnull(), segment->builder().serialize(size), 0);
+            m_io->submit();
+        }
+    }
+
+    auto* segment_pointer = segment.ptr();
+    m_closed_segments.set(day, move(segment));
+    return segment_pointer;
+}
+
+Vector<IRCChatLog::Match> IRCChatLog::search(const Query& query, size_t max_results)
+{
+    Vector<Match> matches;
+    if (m_active_segment)
+        m_active_segment->search(query, max_results, matches);
+
+    Vector<String> days;
+    if (auto* directory = opendir(m_directory.characters())) {
+        while (auto* entry = readdir(directory)) {
+            StringView name { entry->d_name };
+            if (!name.ends_with(".log"))
+                continue;
+            auto day = name.substring_view(0, name.length() - 4);
+            if (day != m_active_day)
+                days.append(day);
+        }
+        closedir(directory);
+    }
+    // Day names sort chronologically, and the newest day is searched first.
+    quick_sort(days, [](auto& a, auto& b) { return a > b; });
+
+    for (auto& day : days) {
+        if (matches.size() >= max_results)
+            break;
+        if (auto* segment = segment_for_day(day))
+            segment->search(query, max_results, matches);
+    }
+    return matches;
+}
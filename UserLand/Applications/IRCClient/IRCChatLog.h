@@ -0,0 +1,91 @@
+#pragma once
+
+#include <AK/AsyncFileIO.h>
+#include <AK/ByteBuffer.h>
+#include <AK/HashMap.h>
+#include <AK/MappedFile.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/OSError.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefPtr.h>
+#include <AK/Result.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <time.h>
+
+// An append-only, searchable history of everything said on one network.
+//
+// Every day gets its own segment: a .log file of compact binary records and,
+// once the day is over, a .idx sidecar with a trigram index of the message
+// texts and an index of the nicks. Searches look up the trigrams of the query,
+// intersect their posting lists and only look at the records that survive, so
+// they don't have to read the logs themselves. Old segments are mapped with
+// MappedFile; the current one is kept and indexed in memory, and so is a day
+// that just ended, until its .log and .idx have been written.
+//
+// append() only buffers; flush() hands the buffered records to an AsyncFileIO,
+// so the disk is never written from the calling thread.
+class IRCChatLog {
+    AK_MAKE_NONCOPYABLE(IRCChatLog);
+    AK_MAKE_NONMOVABLE(IRCChatLog);
+
+public:
+    struct Query {
+        // Matched case-insensitively anywhere in the message text.
+        String text;
+        String nick;
+        String channel;
+    };
+
+    struct Match {
+        time_t timestamp { 0 };
+        String channel;
+        String nick;
+        String text;
+    };
+
+    static Result<NonnullOwnPtr<IRCChatLog>, OSError> open(const String& directory);
+    ~IRCChatLog();
+
+    void append(time_t timestamp, const StringView& channel, const StringView& nick, const StringView& text);
+    void flush();
+
+    // Becomes readable when writes have completed and process_completions() should be called.
+    int notify_fd() const { return m_io->notify_fd(); }
+    void process_completions() { m_io->process_completions(); }
+
+    // Newest matches first.
+    Vector<Match> search(const Query&, size_t max_results = 100);
+
+    class Segment;
+    class IndexBuilder;
+    class WriteTarget;
+
+private:
+    IRCChatLog(const String& directory, NonnullOwnPtr<AsyncFileIO>);
+
+    Result<void, OSError> open_active_segment(time_t timestamp);
+    void close_active_segment();
+    Segment* segment_for_day(const String& day);
+    // Replaces a closed day's in-memory segment with the files, once they're complete.
+    void drop_written_segment(const String& day);
+    void write(const String& day, NonnullRefPtr<WriteTarget>, ByteBuffer&&, u64 offset);
+    String path_for(const String& day, const StringView& extension) const;
+
+    String m_directory;
+    NonnullOwnPtr<AsyncFileIO> m_io;
+
+    String m_active_day;
+    time_t m_active_day_end { 0 };
+    RefPtr<WriteTarget> m_active_file;
+    OwnPtr<Segment> m_active_segment;
+    size_t m_flushed_size { 0 };
+
+    HashMap<String, OwnPtr<Segment>> m_closed_segments;
+
+    struct PendingWrites {
+        size_t count { 0 };
+        bool has_failed { false };
+    };
+    HashMap<String, PendingWrites> m_pending_writes;
+};
@@ -6,17 +6,19 @@
 #include "IRCWindow.h"
 #include "IRCWindowListModel.h"
 #include <AK/Debug.h>
-#include <AK/QuickSort.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/DateTime.h>
 #include <LibCore/Notifier.h>
+#include <LibCore/StandardPaths.h>
 #include <pwd.h>
 #include <stdio.h>
-#include <strings.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 enum IRCNumeric {
     RPL_WELCOME = 1,
+    RPL_ISUPPORT = 5,
     RPL_WHOISUSER = 311,
     RPL_WHOISSERVER = 312,
     RPL_WHOISOPERATOR = 313,
@@ -45,6 +47,7 @@ IRCClient::IRCClient(String server, int port)
 {
     struct passwd* user_pw = getpwuid(getuid());
     m_socket = Core::TCPSocket::construct(this);
+    m_send_timer = Core::Timer::create_single_shot(0, [this] { flush_send_queue(); }, this);
     m_nickname = m_config->read_entry("User", "Nickname", String::formatted("{}_seren1ty", user_pw->pw_name));
 
     if (server.is_empty()) {
@@ -57,6 +60,10 @@ IRCClient::IRCClient(String server, int port)
 
     m_show_join_part_messages = m_config->read_bool_entry("Messaging", "ShowJoinPartMessages", 1);
     m_show_nick_change_messages = m_config->read_bool_entry("Messaging", "ShowNickChangeMessages", 1);
+    m_scrollback_line_count = max(1, m_config->read_num_entry("Messaging", "ScrollbackLines", IRCScrollback::default_max_line_count));
+    m_log->set_max_line_count(m_scrollback_line_count);
+
+    m_chat_logging_enabled = m_config->read_bool_entry("Logging", "Enabled", 1);
 
     m_notify_on_message = m_config->read_bool_entry("Notifications", "NotifyOnMessage", 1);
     m_notify_on_mention = m_config->read_bool_entry("Notifications", "NotifyOnMention", 1);
@@ -68,6 +75,8 @@ IRCClient::IRCClient(String server, int port)
 
 IRCClient::~IRCClient()
 {
+    if (m_chat_log)
+        m_chat_log->flush();
 }
 
 void IRCClient::set_server(const String& hostname, int port)
@@ -83,6 +92,9 @@ void IRCClient::on_socket_connected()
 {
     m_notifier = Core::Notifier::construct(m_socket->fd(), Core::Notifier::Read);
     m_notifier->on_ready_to_read = [this] { receive_from_server(); };
+    m_write_notifier = Core::Notifier::construct(m_socket->fd(), Core::Notifier::Write);
+    m_write_notifier->on_ready_to_write = [this] { flush_send_queue(); };
+    m_write_notifier->set_enabled(false);
 
     send_user();
     send_nick();
@@ -95,6 +107,9 @@ bool IRCClient::connect()
 
     m_socket->on_connected = [this] { on_socket_connected(); };
 
+    if (m_chat_logging_enabled && !m_chat_log)
+        open_chat_log();
+
     return m_socket->connect(m_hostname, m_port);
 }
 
@@ -113,116 +128,155 @@ void IRCClient::receive_from_server()
     }
 }
 
-void IRCClient::process_line(const String& line)
-{
-    Message msg;
-    Vector<char, 32> prefix;
-    Vector<char, 32> command;
-    Vector<char, 256> current_parameter;
-    enum {
-        Start,
-        InPrefix,
-        InCommand,
-        InStartOfParameter,
-        InParameter,
-        InTrailingParameter,
-    } state
-        = Start;
-
-    for (size_t i = 0; i < line.length(); ++i) {
-        char ch = line[i];
-        if (ch == '\r')
-            continue;
-        if (ch == '\n')
-            break;
-        switch (state) {
-        case Start:
-            if (ch == ':') {
-                state = InPrefix;
-                continue;
-            }
-            state = InCommand;
-            [[fallthrough]];
-        case InCommand:
-            if (ch == ' ') {
-                state = InStartOfParameter;
-                continue;
-            }
-            command.append(ch);
-            continue;
-        case InPrefix:
-            if (ch == ' ') {
-                state = InCommand;
-                continue;
-            }
-            prefix.append(ch);
-            continue;
-        case InStartOfParameter:
-            if (ch == ':') {
-                state = InTrailingParameter;
-                continue;
-            }
-            state = InParameter;
-            [[fallthrough]];
-        case InParameter:
-            if (ch == ' ') {
-                if (!current_parameter.is_empty())
-                    msg.arguments.append(String(current_parameter.data(), current_parameter.size()));
-                current_parameter.clear_with_capacity();
-                state = InStartOfParameter;
-                continue;
-            }
-            current_parameter.append(ch);
+void IRCClient::process_line(const StringView& line)
+{
+    handle(Message::parse(line));
+}
+
+static u64 monotonic_ms()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Everything queued during one event loop iteration goes out together.
+void IRCClient::schedule_send()
+{
+    if (m_send_timer->is_active() && m_send_timer->interval() == 0)
+        return;
+    m_send_timer->restart(0);
+}
+
+void IRCClient::flush_send_queue()
+{
+    // Anything queued before the connection is up goes out once it is.
+    if (!m_socket->is_connected() || !m_write_notifier)
+        return;
+
+    switch (m_send_queue.flush(m_socket->fd(), monotonic_ms())) {
+    case IRCSendQueue::FlushResult::WouldBlock:
+        m_write_notifier->set_enabled(true);
+        return;
+    case IRCSendQueue::FlushResult::Error:
+        add_server_message(String::formatted("*** Sending to the server failed: {}", strerror(errno)), Color::Red);
+        m_send_queue.clear();
+        m_write_notifier->set_enabled(false);
+        return;
+    case IRCSendQueue::FlushResult::Done:
+        m_write_notifier->set_enabled(false);
+        break;
+    }
+
+    // The rest is held back by flood control.
+    if (auto wait_ms = m_send_queue.ms_until_next_release(monotonic_ms()); wait_ms.has_value())
+        m_send_timer->restart(wait_ms.value());
+}
+
+void IRCClient::open_chat_log()
+{
+    auto directory = String::formatted("{}/irc-logs/{}", Core::StandardPaths::home_directory(), m_hostname);
+    auto chat_log_or_error = IRCChatLog::open(directory);
+    if (chat_log_or_error.is_error()) {
+        add_server_message(String::formatted("*** Can't open chat log in {}: {}", directory, chat_log_or_error.error()), Color::Red);
+        return;
+    }
+    m_chat_log = chat_log_or_error.release_value();
+    m_chat_log_notifier = Core::Notifier::construct(m_chat_log->notify_fd(), Core::Notifier::Read);
+    m_chat_log_notifier->on_ready_to_read = [this] { m_chat_log->process_completions(); };
+    // Messages are written out in batches at most a second after they arrived.
+    m_chat_log_flush_timer = Core::Timer::create_single_shot(1000, [this] { m_chat_log->flush(); }, this);
+}
+
+void IRCClient::log_message(const String& target, const String& nick, const String& text)
+{
+    if (!m_chat_log)
+        return;
+    m_chat_log->append(time(nullptr), target, nick, text);
+    if (!m_chat_log_flush_timer->is_active())
+        m_chat_log_flush_timer->start();
+}
+
+void IRCClient::search_chat_log(const StringView& arguments)
+{
+    if (!m_chat_log) {
+        add_server_message("*** Chat logging is disabled", Color::Red);
+        return;
+    }
+
+    IRCChatLog::Query query;
+    StringBuilder text;
+    for (auto& part : arguments.split_view(' ')) {
+        // A leading #channel and @nick narrow the search; everything after them is the text.
+        if (text.is_empty() && query.channel.is_null() && is_channel_prefix(part[0])) {
+            query.channel = part;
             continue;
-        case InTrailingParameter:
-            current_parameter.append(ch);
+        }
+        if (text.is_empty() && query.nick.is_null() && part.length() > 1 && part[0] == '@') {
+            query.nick = part.substring_view(1);
             continue;
         }
+        if (!text.is_empty())
+            text.append(' ');
+        text.append(part);
     }
-    if (!current_parameter.is_empty())
-        msg.arguments.append(String::copy(current_parameter));
-    msg.prefix = String::copy(prefix);
-    msg.command = String::copy(command);
-    handle(msg);
+    query.text = text.to_string();
+    if (query.text.is_empty() && query.nick.is_null()) {
+        add_server_message("*** Usage: /SEARCH [#channel] [@nick] text", Color::Red);
+        return;
+    }
+
+    auto start_ms = monotonic_ms();
+    auto matches = m_chat_log->search(query);
+    auto elapsed_ms = monotonic_ms() - start_ms;
+
+    for (size_t i = matches.size(); i-- > 0;) {
+        auto& match = matches[i];
+        add_server_message(String::formatted("[{}] {} <{}> {}", Core::DateTime::from_timestamp(match.timestamp).to_string(), match.channel, match.nick, match.text), Color::MidGray);
+    }
+    add_server_message(String::formatted("*** {} matches in {} ms", matches.size(), elapsed_ms), Color::Blue);
 }
 
-void IRCClient::send(const String& text)
+void IRCClient::send_raw(const StringView& line)
 {
-    if (!m_socket->send(text.bytes())) {
-        perror("send");
-        exit(1);
-    }
+    m_send_queue.enqueue_raw(IRCSendQueue::Lane::Normal, line);
+    schedule_send();
 }
 
 void IRCClient::send_user()
 {
-    send(String::formatted("USER {} 0 * :{}\r\n", m_nickname, m_nickname));
+    m_send_queue.enqueue(IRCSendQueue::Lane::Normal, "USER", { m_nickname, "0", "*" }, m_nickname);
+    schedule_send();
 }
 
 void IRCClient::send_nick()
 {
-    send(String::formatted("NICK {}\r\n", m_nickname));
+    m_send_queue.enqueue(IRCSendQueue::Lane::Normal, "NICK", { m_nickname });
+    schedule_send();
 }
 
 void IRCClient::send_pong(const String& server)
 {
-    send(String::formatted("PONG {}\r\n", server));
-    sleep(1);
+    m_send_queue.enqueue(IRCSendQueue::Lane::Urgent, "PONG", { server });
+    schedule_send();
 }
 
 void IRCClient::join_channel(const String& channel_name)
 {
-    send(String::formatted("JOIN {}\r\n", channel_name));
+    m_send_queue.enqueue_join(channel_name);
+    schedule_send();
 }
 
 void IRCClient::part_channel(const String& channel_name)
 {
-    send(String::formatted("PART {}\r\n", channel_name));
+    m_send_queue.enqueue(IRCSendQueue::Lane::Normal, "PART", { channel_name });
+    schedule_send();
 }
 
 void IRCClient::send_whois(const String& nick)
 {
-    send(String::formatted("WHOIS {}\r\n", nick));
+    m_send_queue.enqueue(IRCSendQueue::Lane::Normal, "WHOIS", { nick });
+    schedule_send();
 }
 
 void IRCClient::handle(const Message& msg)
@@ -238,12 +292,15 @@ void IRCClient::handle(const Message& msg)
         outln("    [{}]: {}", index++, arg);
 #endif
 
-    auto numeric = msg.command.to_uint();
-
-    if (numeric.has_value()) {
-        switch (numeric.value()) {
+    switch (msg.command_type) {
+    case Message::Command::Numeric:
+        switch (msg.numeric) {
         case RPL_WELCOME:
             return handle_rpl_welcome(msg);
+        case RPL_ISUPPORT:
+            // Also shown as a server message below.
+            handle_rpl_isupport(msg);
+            break;
         case RPL_WHOISCHANNELS:
             return handle_rpl_whoischannels(msg);
         case RPL_ENDOFWHO:
@@ -281,31 +338,26 @@ void IRCClient::handle(const Message& msg)
         case ERR_NICKNAMEINUSE:
             return handle_err_nicknameinuse(msg);
         }
-    }
-
-    if (msg.command == "PING")
+        break;
+    case Message::Command::Ping:
         return handle_ping(msg);
-
-    if (msg.command == "JOIN")
+    case Message::Command::Join:
         return handle_join(msg);
-
-    if (msg.command == "PART")
+    case Message::Command::Part:
         return handle_part(msg);
-
-    if (msg.command == "QUIT")
+    case Message::Command::Quit:
         return handle_quit(msg);
-
-    if (msg.command == "TOPIC")
+    case Message::Command::Topic:
         return handle_topic(msg);
-
-    if (msg.command == "PRIVMSG")
+    case Message::Command::Privmsg:
         return handle_privmsg_or_notice(msg, PrivmsgOrNotice::Privmsg);
-
-    if (msg.command == "NOTICE")
+    case Message::Command::Notice:
         return handle_privmsg_or_notice(msg, PrivmsgOrNotice::Notice);
-
-    if (msg.command == "NICK")
+    case Message::Command::Nick:
         return handle_nick(msg);
+    default:
+        break;
+    }
 
     if (msg.arguments.size() >= 2)
         add_server_message(String::formatted("[{}] {}", msg.command, msg.arguments[1]));
@@ -319,67 +371,80 @@ void IRCClient::add_server_message(const String& text, Color color)
 
 void IRCClient::send_topic(const String& channel_name, const String& text)
 {
-    send(String::formatted("TOPIC {} :{}\r\n", channel_name, text));
+    m_send_queue.enqueue(IRCSendQueue::Lane::Normal, "TOPIC", { channel_name }, text);
+    schedule_send();
 }
 
 void IRCClient::send_invite(const String& channel_name, const String& nick)
 {
-    send(String::formatted("INVITE {} {}\r\n", nick, channel_name));
+    m_send_queue.enqueue(IRCSendQueue::Lane::Normal, "INVITE", { nick, channel_name });
+    schedule_send();
 }
 
 void IRCClient::send_banlist(const String& channel_name)
 {
-    send(String::formatted("MODE {} +b\r\n", channel_name));
+    m_send_queue.enqueue(IRCSendQueue::Lane::Normal, "MODE", { channel_name, "+b" });
+    schedule_send();
 }
 
 void IRCClient::send_voice_user(const String& channel_name, const String& nick)
 {
-    send(String::formatted("MODE {} +v {}\r\n", channel_name, nick));
+    m_send_queue.enqueue_mode(channel_name, '+', 'v', nick);
+    schedule_send();
 }
 
 void IRCClient::send_devoice_user(const String& channel_name, const String& nick)
 {
-    send(String::formatted("MODE {} -v {}\r\n", channel_name, nick));
+    m_send_queue.enqueue_mode(channel_name, '-', 'v', nick);
+    schedule_send();
 }
 
 void IRCClient::send_hop_user(const String& channel_name, const String& nick)
 {
-    send(String::formatted("MODE {} +h {}\r\n", channel_name, nick));
+    m_send_queue.enqueue_mode(channel_name, '+', 'h', nick);
+    schedule_send();
 }
 
 void IRCClient::send_dehop_user(const String& channel_name, const String& nick)
 {
-    send(String::formatted("MODE {} -h {}\r\n", channel_name, nick));
+    m_send_queue.enqueue_mode(channel_name, '-', 'h', nick);
+    schedule_send();
 }
 
 void IRCClient::send_op_user(const String& channel_name, const String& nick)
 {
-    send(String::formatted("MODE {} +o {}\r\n", channel_name, nick));
+    m_send_queue.enqueue_mode(channel_name, '+', 'o', nick);
+    schedule_send();
 }
 
 void IRCClient::send_deop_user(const String& channel_name, const String& nick)
 {
-    send(String::formatted("MODE {} -o {}\r\n", channel_name, nick));
+    m_send_queue.enqueue_mode(channel_name, '-', 'o', nick);
+    schedule_send();
 }
 
 void IRCClient::send_kick(const String& channel_name, const String& nick, const String& comment)
 {
-    send(String::formatted("KICK {} {} :{}\r\n", channel_name, nick, comment));
+    m_send_queue.enqueue(IRCSendQueue::Lane::Normal, "KICK", { channel_name, nick }, comment.is_null() ? "" : comment.view());
+    schedule_send();
 }
 
 void IRCClient::send_list()
 {
-    send("LIST\r\n");
+    m_send_queue.enqueue(IRCSendQueue::Lane::Normal, "LIST", {});
+    schedule_send();
 }
 
 void IRCClient::send_privmsg(const String& target, const String& text)
 {
-    send(String::formatted("PRIVMSG {} :{}\r\n", target, text));
+    m_send_queue.enqueue(IRCSendQueue::Lane::Normal, "PRIVMSG", { target }, text.is_null() ? "" : text.view());
+    schedule_send();
 }
 
 void IRCClient::send_notice(const String& target, const String& text)
 {
-    send(String::formatted("NOTICE {} :{}\r\n", target, text));
+    m_send_queue.enqueue(IRCSendQueue::Lane::Normal, "NOTICE", { target }, text.is_null() ? "" : text.view());
+    schedule_send();
 }
 
 void IRCClient::handle_user_input_in_channel(const String& channel_name, const String& input)
@@ -452,8 +517,7 @@ void IRCClient::handle_privmsg_or_notice(const Message& msg, PrivmsgOrNotice typ
         return;
     if (msg.prefix.is_empty())
         return;
-    auto parts = msg.prefix.split('!');
-    auto sender_nick = parts[0];
+    auto sender_nick = msg.nick;
     auto target = msg.arguments[0];
 
     bool is_ctcp = has_ctcp_payload(msg.arguments[1]);
@@ -472,7 +536,7 @@ void IRCClient::handle_privmsg_or_notice(const Message& msg, PrivmsgOrNotice typ
     char sender_prefix = 0;
     if (is_nick_prefix(sender_nick[0])) {
         sender_prefix = sender_nick[0];
-        sender_nick = sender_nick.substring(1, sender_nick.length() - 1);
+        sender_nick = sender_nick.substring_view(1);
     }
 
     String message_text = msg.arguments[1];
@@ -565,57 +629,70 @@ void IRCClient::handle_join(const Message& msg)
 {
     if (msg.arguments.size() != 1)
         return;
-    auto prefix_parts = msg.prefix.split('!');
-    if (prefix_parts.size() < 1)
+    if (msg.nick.is_empty())
         return;
-    auto nick = prefix_parts[0];
     auto& channel_name = msg.arguments[0];
-    ensure_channel(channel_name).handle_join(nick, msg.prefix);
+    ensure_channel(channel_name).handle_join(msg.nick, msg.prefix);
 }
 
 void IRCClient::handle_part(const Message& msg)
 {
     if (msg.arguments.size() < 1)
         return;
-    auto prefix_parts = msg.prefix.split('!');
-    if (prefix_parts.size() < 1)
+    if (msg.nick.is_empty())
         return;
-    auto nick = prefix_parts[0];
     auto& channel_name = msg.arguments[0];
-    ensure_channel(channel_name).handle_part(nick, msg.prefix);
+    ensure_channel(channel_name).handle_part(msg.nick, msg.prefix);
 }
 
 void IRCClient::handle_quit(const Message& msg)
 {
     if (msg.arguments.size() < 1)
         return;
-    auto prefix_parts = msg.prefix.split('!');
-    if (prefix_parts.size() < 1)
+    if (msg.nick.is_empty())
+        return;
+    String nick = msg.nick;
+    String prefix = msg.prefix;
+    String message = msg.arguments[0];
+    if (nick == m_nickname) {
+        for (auto& it : m_channels)
+            it.value->handle_quit(nick, prefix, message);
         return;
-    auto nick = prefix_parts[0];
-    auto& message = msg.arguments[0];
-    for (auto& it : m_channels) {
-        it.value->handle_quit(nick, msg.prefix, message);
     }
+    auto it = m_channels_by_nick.find(nick);
+    if (it == m_channels_by_nick.end())
+        return;
+    // Leaving a channel unregisters the nick from it, so walk a copy.
+    auto channels = it->value;
+    for (auto* channel : channels)
+        channel->handle_quit(nick, prefix, message);
 }
 
 void IRCClient::handle_nick(const Message& msg)
 {
-    auto prefix_parts = msg.prefix.split('!');
-    if (prefix_parts.size() < 1)
+    if (msg.nick.is_empty())
         return;
-    auto old_nick = prefix_parts[0];
+    String old_nick = msg.nick;
     if (msg.arguments.size() != 1)
         return;
-    auto& new_nick = msg.arguments[0];
+    String new_nick = msg.arguments[0];
     if (old_nick == m_nickname)
         m_nickname = new_nick;
     if (m_show_nick_change_messages)
         add_server_message(String::formatted("~ {} changed nickname to {}", old_nick, new_nick));
     if (on_nickname_changed)
         on_nickname_changed(new_nick);
-    for (auto& it : m_channels) {
-        it.value->notify_nick_changed(old_nick, new_nick);
+    auto it = m_channels_by_nick.find(old_nick);
+    if (it == m_channels_by_nick.end())
+        return;
+    auto channels = move(it->value);
+    m_channels_by_nick.remove(it);
+    for (auto* channel : channels)
+        channel->notify_nick_changed(old_nick, new_nick);
+    auto& new_nick_channels = m_channels_by_nick.ensure(new_nick);
+    for (auto* channel : channels) {
+        if (!new_nick_channels.contains_slow(channel))
+            new_nick_channels.append(channel);
     }
 }
 
@@ -623,12 +700,10 @@ void IRCClient::handle_topic(const Message& msg)
 {
     if (msg.arguments.size() != 2)
         return;
-    auto prefix_parts = msg.prefix.split('!');
-    if (prefix_parts.size() < 1)
+    if (msg.nick.is_empty())
         return;
-    auto nick = prefix_parts[0];
     auto& channel_name = msg.arguments[0];
-    ensure_channel(channel_name).handle_topic(nick, msg.arguments[1]);
+    ensure_channel(channel_name).handle_topic(msg.nick, msg.arguments[1]);
 }
 
 void IRCClient::handle_rpl_welcome(const Message& msg)
@@ -649,6 +724,23 @@ void IRCClient::handle_rpl_welcome(const Message& msg)
     }
 }
 
+void IRCClient::handle_rpl_isupport(const Message& msg)
+{
+    // The first argument is our nick and the last one the "are supported by this server" text.
+    for (size_t i = 1; i + 1 < msg.arguments.size(); ++i) {
+        auto& token = msg.arguments[i];
+        if (!token.starts_with("MODES"))
+            continue;
+        if (token == "MODES") {
+            // No value means there is no limit, so only the line length matters.
+            m_send_queue.set_max_modes_per_line(IRCSendQueue::max_line_length);
+        } else if (token.starts_with("MODES=")) {
+            if (auto max_modes = token.substring_view(6).to_uint(); max_modes.has_value())
+                m_send_queue.set_max_modes_per_line(max_modes.value());
+        }
+    }
+}
+
 void IRCClient::handle_rpl_topic(const Message& msg)
 {
     if (msg.arguments.size() < 3)
@@ -664,24 +756,27 @@ void IRCClient::handle_rpl_namreply(const Message& msg)
         return;
     auto& channel_name = msg.arguments[2];
     auto& channel = ensure_channel(channel_name);
-    auto members = msg.arguments[3].split(' ');
-
-    quick_sort(members, [](auto& a, auto& b) {
-        return strcasecmp(a.characters(), b.characters()) < 0;
-    });
 
-    for (auto& member : members) {
-        if (member.is_empty())
+    Vector<IRCChannelMemberList::Member> members;
+    for (auto& name : msg.arguments[3].split_view(' ')) {
+        // With multi-prefix, a member can have several prefixes; the first one is the highest.
+        size_t prefix_length = 0;
+        while (prefix_length < name.length() && is_nick_prefix(name[prefix_length]))
+            ++prefix_length;
+        if (prefix_length == name.length())
             continue;
-        char prefix = 0;
-        if (is_nick_prefix(member[0]))
-            prefix = member[0];
-        channel.add_member(member, prefix);
+        members.append({ name.substring_view(prefix_length), prefix_length ? name[0] : (char)0 });
     }
+    channel.add_names(move(members));
 }
 
-void IRCClient::handle_rpl_endofnames(const Message&)
+void IRCClient::handle_rpl_endofnames(const Message& msg)
 {
+    if (msg.arguments.size() >= 2) {
+        auto it = m_channels.find(msg.arguments[1]);
+        if (it != m_channels.end())
+            it->value->did_receive_end_of_names();
+    }
     add_server_message("// End of NAMES");
 }
 
@@ -774,7 +869,7 @@ void IRCClient::handle_rpl_topicwhotime(const Message& msg)
         return;
     auto& channel_name = msg.arguments[1];
     auto& nick = msg.arguments[2];
-    auto setat = msg.arguments[3];
+    String setat = msg.arguments[3];
     auto setat_time = setat.to_uint();
     if (setat_time.has_value())
         setat = Core::DateTime::from_timestamp(setat_time.value()).to_string();
@@ -841,7 +936,7 @@ void IRCClient::handle_user_command(const String& input)
             return;
         int command_length = command.length() + 1;
         StringView raw_message = input.view().substring_view(command_length, input.view().length() - command_length);
-        send(String::formatted("{}\r\n", raw_message));
+        send_raw(raw_message);
         return;
     }
     if (command == "/NICK") {
@@ -990,11 +1085,16 @@ void IRCClient::handle_user_command(const String& input)
             send_whois(parts[1]);
         return;
     }
+    if (command == "/SEARCH") {
+        search_chat_log(input.view().substring_view(parts[0].length()));
+        return;
+    }
 }
 
 void IRCClient::change_nick(const String& nick)
 {
-    send(String::formatted("NICK {}\r\n", nick));
+    m_send_queue.enqueue(IRCSendQueue::Lane::Normal, "NICK", { nick });
+    schedule_send();
 }
 
 void IRCClient::handle_list_channels_action()
@@ -1094,6 +1194,21 @@ void IRCClient::handle_cycle_channel_action(const String& channel)
     join_channel(channel);
 }
 
+void IRCClient::register_channel_member(const String& nick, IRCChannel& channel)
+{
+    m_channels_by_nick.ensure(nick).append(&channel);
+}
+
+void IRCClient::unregister_channel_member(const String& nick, IRCChannel& channel)
+{
+    auto it = m_channels_by_nick.find(nick);
+    if (it == m_channels_by_nick.end())
+        return;
+    it->value.remove_first_matching([&](auto* entry) { return entry == &channel; });
+    if (it->value.is_empty())
+        m_channels_by_nick.remove(it);
+}
+
 void IRCClient::did_part_from_channel(Badge<IRCChannel>, IRCChannel& channel)
 {
     if (on_part_from_channel)
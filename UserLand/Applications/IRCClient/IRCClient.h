@@ -1,6 +1,9 @@
 #pragma once
 
+#include "IRCChatLog.h"
 #include "IRCLogBuffer.h"
+#include "IRCMessage.h"
+#include "IRCSendQueue.h"
 #include "IRCWindow.h"
 #include <AK/CircularQueue.h>
 #include <AK/Function.h>
@@ -8,6 +11,7 @@
 #include <AK/String.h>
 #include <LibCore/ConfigFile.h>
 #include <LibCore/TCPSocket.h>
+#include <LibCore/Timer.h>
 
 class IRCChannel;
 class IRCQuery;
@@ -35,6 +39,7 @@ public:
     String ctcp_finger_reply() const { return m_ctcp_finger_reply; }
 
     bool show_join_part_messages() const { return m_show_join_part_messages; }
+    size_t scrollback_line_count() const { return m_scrollback_line_count; }
     bool show_nick_change_messages() const { return m_show_nick_change_messages; }
 
     bool notify_on_message() const { return m_notify_on_message; }
@@ -111,14 +116,13 @@ public:
 
     void add_server_message(const String&, Color = Color::Black);
 
+    // Records a message in the persistent chat log, if logging is enabled.
+    void log_message(const String& target, const String& nick, const String& text);
+
 private:
     IRCClient(String server, int port);
 
-    struct Message {
-        String prefix;
-        String command;
-        Vector<String> arguments;
-    };
+    using Message = IRCMessage;
 
     enum class PrivmsgOrNotice {
         Privmsg,
@@ -126,7 +130,9 @@ private:
     };
 
     void receive_from_server();
-    void send(const String&);
+    void send_raw(const StringView&);
+    void schedule_send();
+    void flush_send_queue();
     void send_user();
     void send_nick();
     void send_pong(const String& server);
@@ -144,13 +150,14 @@ private:
     void send_kick(const String& channel_name, const String& nick, const String&);
     void send_list();
     void send_whois(const String&);
-    void process_line(const String&);
+    void process_line(const StringView&);
     void handle_join(const Message&);
     void handle_part(const Message&);
     void handle_quit(const Message&);
     void handle_ping(const Message&);
     void handle_topic(const Message&);
     void handle_rpl_welcome(const Message&);
+    void handle_rpl_isupport(const Message&);
     void handle_rpl_topic(const Message&);
     void handle_rpl_whoisuser(const Message&);
     void handle_rpl_whoisserver(const Message&);
@@ -180,6 +187,13 @@ private:
 
     void on_socket_connected();
 
+    void open_chat_log();
+    void search_chat_log(const StringView& arguments);
+
+    // Which channels every known nick is in, so QUIT and NICK only visit those channels.
+    void register_channel_member(const String& nick, IRCChannel&);
+    void unregister_channel_member(const String& nick, IRCChannel&);
+
     String m_hostname;
     int m_port { 6667 };
 
@@ -187,11 +201,22 @@ private:
 
     String m_nickname;
     RefPtr<Core::Notifier> m_notifier;
+    RefPtr<Core::Notifier> m_write_notifier;
+
+    IRCSendQueue m_send_queue;
+    RefPtr<Core::Timer> m_send_timer;
     HashMap<String, RefPtr<IRCChannel>, CaseInsensitiveStringTraits> m_channels;
     HashMap<String, RefPtr<IRCQuery>, CaseInsensitiveStringTraits> m_queries;
+    HashMap<String, Vector<IRCChannel*>, CaseInsensitiveStringTraits> m_channels_by_nick;
+
+    OwnPtr<IRCChatLog> m_chat_log;
+    RefPtr<Core::Notifier> m_chat_log_notifier;
+    RefPtr<Core::Timer> m_chat_log_flush_timer;
 
     bool m_show_join_part_messages { 1 };
     bool m_show_nick_change_messages { 1 };
+    size_t m_scrollback_line_count { IRCScrollback::default_max_line_count };
+    bool m_chat_logging_enabled { 1 };
 
     bool m_notify_on_message { 1 };
     bool m_notify_on_mention { 1 };
@@ -4,7 +4,9 @@
 #include <LibWeb/DOM/DocumentType.h>
 #include <LibWeb/DOM/ElementFactory.h>
 #include <LibWeb/DOM/Text.h>
+#include <LibWeb/HTML/AttributeNames.h>
 #include <LibWeb/HTML/HTMLBodyElement.h>
+#include <LibWeb/HTML/TagNames.h>
 #include <time.h>
 
 NonnullRefPtr<IRCLogBuffer> IRCLogBuffer::create()
@@ -26,47 +28,91 @@ IRCLogBuffer::IRCLogBuffer()
     auto body_element = m_document->create_element("body");
     html_element->append_child(body_element);
     m_container_element = body_element;
+
+    m_flush_timer = Core::Timer::create_single_shot(0, [this] { flush(); });
 }
 
 IRCLogBuffer::~IRCLogBuffer()
 {
 }
 
-static String timestamp_string()
+static String timestamp_string(time_t timestamp)
 {
-    auto now = time(nullptr);
-    auto* tm = localtime(&now);
-    return String::formatted("{:02}:{:02}:{:02} ", tm->tm_hour, tm->tm_min, tm->tm_sec);
+    // Floods put many lines in the same second, so the last string is reused.
+    static time_t s_last_timestamp = -1;
+    static String s_last_string;
+    if (timestamp == s_last_timestamp)
+        return s_last_string;
+    auto* tm = localtime(&timestamp);
+    s_last_timestamp = timestamp;
+    s_last_string = String::formatted("{:02}:{:02}:{:02} ", tm->tm_hour, tm->tm_min, tm->tm_sec);
+    return s_last_string;
 }
 
 void IRCLogBuffer::add_message(char prefix, const String& name, const String& text, Color color)
 {
-    auto nick_string = String::formatted("<{}{}> ", prefix ? prefix : ' ', name.characters());
-    auto html = String::formatted(
-        "<span>{}</span>"
-        "<b>{}</b>"
-        "<span>{}</span>",
-        timestamp_string(),
-        escape_html_entities(nick_string),
-        escape_html_entities(text));
-
-    auto wrapper = m_document->create_element(Web::HTML::TagNames::div);
-    wrapper->set_attribute(Web::HTML::AttributeNames::style, String::formatted("color: {}", color.to_string()));
-    wrapper->set_inner_html(html);
-    m_container_element->append_child(wrapper);
-    m_document->force_layout();
+    m_scrollback.append(time(nullptr), color.value(), prefix, true, name, text);
+    schedule_flush();
 }
 
 void IRCLogBuffer::add_message(const String& text, Color color)
 {
-    auto html = String::formatted(
-        "<span>{}</span>"
-        "<span>{}</span>",
-        timestamp_string(),
-        escape_html_entities(text));
+    m_scrollback.append(time(nullptr), color.value(), 0, false, {}, text);
+    schedule_flush();
+}
+
+void IRCLogBuffer::set_max_line_count(size_t max_line_count)
+{
+    m_scrollback.set_max_line_count(max_line_count);
+    schedule_flush();
+}
+
+void IRCLogBuffer::schedule_flush()
+{
+    if (!m_flush_timer->is_active())
+        m_flush_timer->start();
+}
+
+NonnullRefPtr<Web::DOM::Element> IRCLogBuffer::create_line_element(const IRCScrollback::Line& line)
+{
+    // The text goes into Text nodes as is, so unlike with set_inner_html() there is nothing to escape or parse.
+    auto append_text_element = [&](auto& parent, auto& tag_name, String text) {
+        auto element = m_document->create_element(tag_name);
+        element->append_child(adopt(*new Web::DOM::Text(document(), move(text))));
+        parent->append_child(element);
+    };
+
     auto wrapper = m_document->create_element(Web::HTML::TagNames::div);
-    wrapper->set_attribute(Web::HTML::AttributeNames::style, String::formatted("color: {}", color.to_string()));
-    wrapper->set_inner_html(html);
-    m_container_element->append_child(wrapper);
+    wrapper->set_attribute(Web::HTML::AttributeNames::style, String::formatted("color: {}", Color::from_rgba(line.color).to_string()));
+    append_text_element(wrapper, Web::HTML::TagNames::span, timestamp_string(line.timestamp));
+    if (line.has_sender)
+        append_text_element(wrapper, Web::HTML::TagNames::b, String::formatted("<{}{}> ", line.prefix ? line.prefix : ' ', line.sender));
+    append_text_element(wrapper, Web::HTML::TagNames::span, line.text);
+    return wrapper;
+}
+
+void IRCLogBuffer::flush()
+{
+    auto first_line_number = m_scrollback.first_line_number();
+    auto end_line_number = m_scrollback.end_line_number();
+
+    // Drop the elements of lines that have left the scrollback. Lines that were evicted
+    // before they were ever shown are skipped.
+    bool removed_any = false;
+    while (m_first_rendered_line_number < min(first_line_number, m_end_rendered_line_number)) {
+        m_container_element->remove_child(*m_container_element->first_child());
+        ++m_first_rendered_line_number;
+        removed_any = true;
+    }
+    m_first_rendered_line_number = max(m_first_rendered_line_number, first_line_number);
+    m_end_rendered_line_number = max(m_end_rendered_line_number, first_line_number);
+
+    if (!removed_any && m_end_rendered_line_number == end_line_number)
+        return;
+
+    for (; m_end_rendered_line_number < end_line_number; ++m_end_rendered_line_number)
+        m_container_element->append_child(create_line_element(m_scrollback.line_with_number(m_end_rendered_line_number)));
     m_document->force_layout();
+    if (on_flush)
+        on_flush();
 }
@@ -1,32 +1,47 @@
 #pragma once
 
+#include "IRCScrollback.h"
+#include <AK/Function.h>
 #include <AK/RefCounted.h>
 #include <AK/RefPtr.h>
 #include <AK/String.h>
+#include <LibCore/Timer.h>
 #include <LibGfx/Color.h>
 #include <LibWeb/DOM/Document.h>
 
+// Messages are stored in a bounded scrollback and only turned into DOM nodes
+// once per event loop iteration, so a burst of lines costs one layout.
 class IRCLogBuffer : public RefCounted<IRCLogBuffer> {
 public:
     static NonnullRefPtr<IRCLogBuffer> create();
     ~IRCLogBuffer();
 
-    struct Message {
-        time_t timestamp { 0 };
-        char prefix { 0 };
-        String sender;
-        String text;
-        Color color { Color::Black };
-    };
-
     void add_message(char prefix, const String& name, const String& text, Color = Color::Black);
     void add_message(const String& text, Color = Color::Black);
 
+    size_t max_line_count() const { return m_scrollback.max_line_count(); }
+    void set_max_line_count(size_t);
+
     const Web::DOM::Document& document() const { return *m_document; }
     Web::DOM::Document& document() { return *m_document; }
 
+    // New lines are in the document and laid out.
+    Function<void()> on_flush;
+
 private:
     IRCLogBuffer();
+
+    void schedule_flush();
+    void flush();
+    NonnullRefPtr<Web::DOM::Element> create_line_element(const IRCScrollback::Line&);
+
+    IRCScrollback m_scrollback;
+
+    // The line numbers of the lines that currently have an element in the document.
+    u64 m_first_rendered_line_number { 0 };
+    u64 m_end_rendered_line_number { 0 };
+
+    RefPtr<Core::Timer> m_flush_timer;
     RefPtr<Web::DOM::Document> m_document;
     RefPtr<Web::DOM::Element> m_container_element;
 };
@@ -0,0 +1,158 @@
+#include "IRCMessage.h"
+#include <AK/GenericLexer.h>
+#include <AK/StringBuilder.h>
+
+static constexpr CharacterSet s_space { " " };
+
+IRCMessage IRCMessage::parse(const StringView& input)
+{
+    IRCMessage message;
+
+    auto line = input;
+    if (auto newline = line.find_first_of('\n'); newline.has_value())
+        line = line.substring_view(0, newline.value());
+    if (line.ends_with('\r'))
+        line = line.substring_view(0, line.length() - 1);
+
+    GenericLexer lexer(line);
+
+    if (lexer.consume_specific('@')) {
+        GenericLexer tags(lexer.consume_until(' '));
+        while (!tags.is_eof()) {
+            auto tag = tags.consume_until(';');
+            if (tag.is_empty())
+                continue;
+            auto equals = tag.find_first_of('=');
+            if (equals.has_value())
+                message.tags.append({ tag.substring_view(0, equals.value()), tag.substring_view(equals.value() + 1) });
+            else
+                message.tags.append({ tag, {} });
+        }
+        lexer.ignore_while(s_space);
+    }
+
+    if (lexer.consume_specific(':')) {
+        message.prefix = lexer.consume_until(' ');
+        GenericLexer prefix(message.prefix);
+        message.nick = prefix.consume_until(is_any_of("!@"));
+        if (prefix.consume_specific('!'))
+            message.user = prefix.consume_until(is_any_of("@"));
+        if (prefix.consume_specific('@'))
+            message.host = prefix.remaining();
+        lexer.ignore_while(s_space);
+    }
+
+    message.command = lexer.consume_until(s_space);
+    message.command_type = command_from_token(message.command);
+    if (message.command_type == Command::Numeric)
+        message.numeric = message.command.to_uint().value();
+
+    for (;;) {
+        lexer.ignore_while(s_space);
+        if (lexer.is_eof())
+            break;
+        if (lexer.consume_specific(':')) {
+            message.arguments.append(lexer.remaining());
+            break;
+        }
+        message.arguments.append(lexer.consume_until(s_space));
+    }
+
+    return message;
+}
+
+IRCMessage::Command IRCMessage::command_from_token(const StringView& token)
+{
+    auto is = [&](const char* name) { return !__builtin_memcmp(token.characters_without_null_termination(), name, token.length()); };
+    auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+
+    // The length and first character tell all known commands apart, so at most one compare is needed.
+    switch (token.length()) {
+    case 3:
+        if (is_digit(token[0]) && is_digit(token[1]) && is_digit(token[2]))
+            return Command::Numeric;
+        return is("CAP") ? Command::Cap : Command::Unknown;
+    case 4:
+        switch (token[0]) {
+        case 'J':
+            return is("JOIN") ? Command::Join : Command::Unknown;
+        case 'K':
+            return is("KICK") ? Command::Kick : Command::Unknown;
+        case 'M':
+            return is("MODE") ? Command::Mode : Command::Unknown;
+        case 'N':
+            return is("NICK") ? Command::Nick : Command::Unknown;
+        case 'P':
+            if (is("PART"))
+                return Command::Part;
+            if (is("PING"))
+                return Command::Ping;
+            return is("PONG") ? Command::Pong : Command::Unknown;
+        case 'Q':
+            return is("QUIT") ? Command::Quit : Command::Unknown;
+        }
+        return Command::Unknown;
+    case 5:
+        switch (token[0]) {
+        case 'E':
+            return is("ERROR") ? Command::Error : Command::Unknown;
+        case 'T':
+            return is("TOPIC") ? Command::Topic : Command::Unknown;
+        }
+        return Command::Unknown;
+    case 6:
+        switch (token[0]) {
+        case 'I':
+            return is("INVITE") ? Command::Invite : Command::Unknown;
+        case 'N':
+            return is("NOTICE") ? Command::Notice : Command::Unknown;
+        }
+        return Command::Unknown;
+    case 7:
+        return is("PRIVMSG") ? Command::Privmsg : Command::Unknown;
+    }
+    return Command::Unknown;
+}
+
+Optional<StringView> IRCMessage::tag(const StringView& key) const
+{
+    for (auto& tag : tags) {
+        if (tag.key == key)
+            return tag.value;
+    }
+    return {};
+}
+
+String IRCMessage::unescape_tag_value(const StringView& value)
+{
+    if (!value.contains('\\'))
+        return value;
+
+    StringBuilder builder(value.length());
+    for (size_t i = 0; i < value.length(); ++i) {
+        if (value[i] != '\\') {
+            builder.append(value[i]);
+            continue;
+        }
+        if (++i == value.length())
+            break;
+        switch (value[i]) {
+        case ':':
+            builder.append(';');
+            break;
+        case 's':
+            builder.append(' ');
+            break;
+        case 'r':
+            builder.append('\r');
+            break;
+        case 'n':
+            builder.append('\n');
+            break;
+        default:
+            builder.append(value[i]);
+            break;
+        }
+    }
+    return builder.to_string();
+}
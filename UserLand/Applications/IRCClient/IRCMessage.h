@@ -0,0 +1,57 @@
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/String.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+
+// One line of the IRC protocol, split into its parts without copying them.
+// All views point into the parsed line, so a message must not outlive it.
+struct IRCMessage {
+    enum class Command : u8 {
+        Unknown,
+        Numeric,
+        Cap,
+        Error,
+        Invite,
+        Join,
+        Kick,
+        Mode,
+        Nick,
+        Notice,
+        Part,
+        Ping,
+        Pong,
+        Privmsg,
+        Quit,
+        Topic,
+    };
+
+    // IRCv3 message tags (https://ircv3.net/specs/extensions/message-tags).
+    // Values are kept escaped, see unescape_tag_value().
+    struct Tag {
+        StringView key;
+        StringView value;
+    };
+
+    static IRCMessage parse(const StringView& line);
+    static Command command_from_token(const StringView&);
+    static String unescape_tag_value(const StringView&);
+
+    Optional<StringView> tag(const StringView& key) const;
+
+    Vector<Tag, 4> tags;
+
+    // A "nick!user@host" prefix is also available pre-split. For server prefixes, nick is the server name.
+    StringView prefix;
+    StringView nick;
+    StringView user;
+    StringView host;
+
+    StringView command;
+    Command command_type { Command::Unknown };
+    // Only valid for Command::Numeric.
+    u16 numeric { 0 };
+
+    Vector<StringView, 15> arguments;
+};
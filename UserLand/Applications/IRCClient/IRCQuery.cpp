@@ -8,6 +8,7 @@ IRCQuery::IRCQuery(IRCClient& client, const String& name)
     , m_log(IRCLogBuffer::create())
 {
     m_window = m_client->aid_create_window(this, IRCWindow::Query, m_name);
+    m_log->set_max_line_count(m_client->scrollback_line_count());
     m_window->set_log_buffer(*m_log);
 }
 
@@ -23,6 +24,7 @@ NonnullRefPtr<IRCQuery> IRCQuery::create(IRCClient& client, const String& name)
 void IRCQuery::add_message(char prefix, const String& name, const String& text, Color color)
 {
     log().add_message(prefix, name, text, color);
+    m_client->log_message(m_name, name, text);
     window().did_add_message(name, text);
 }
 
@@ -0,0 +1,102 @@
+#include "IRCScrollback.h"
+#include <AK/NumericLimits.h>
+#include <string.h>
+
+// Evicted lines leave a dead region at the front of the arena. It is only
+// reclaimed once it makes up most of the arena, which keeps the cost of
+// moving the live bytes down amortized constant per line.
+static constexpr size_t minimum_arena_size_to_compact = 64 * KiB;
+
+IRCScrollback::IRCScrollback(size_t max_line_count)
+{
+    set_max_line_count(max_line_count);
+}
+
+void IRCScrollback::set_max_line_count(size_t max_line_count)
+{
+    VERIFY(max_line_count > 0);
+    while (m_size > max_line_count)
+        evict_oldest();
+
+    Vector<Record> records;
+    records.ensure_capacity(max_line_count);
+    for (size_t i = 0; i < m_size; ++i)
+        records.unchecked_append(record_at(i));
+    records.resize(max_line_count);
+
+    m_records = move(records);
+    m_head = 0;
+    m_max_line_count = max_line_count;
+}
+
+void IRCScrollback::append(time_t timestamp, u32 color, char prefix, bool has_sender, const StringView& sender, const StringView& text)
+{
+    if (m_size == m_max_line_count)
+        evict_oldest();
+
+    auto sender_length = min(sender.length(), (size_t)NumericLimits<u16>::max());
+    auto text_length = text.length();
+    VERIFY(m_arena.size() + sender_length + text_length <= NumericLimits<u32>::max());
+
+    m_records[(m_head + m_size) % m_max_line_count] = {
+        timestamp,
+        color,
+        static_cast<u32>(m_arena.size()),
+        static_cast<u32>(text_length),
+        static_cast<u16>(sender_length),
+        prefix,
+        has_sender,
+    };
+    ++m_size;
+    m_arena.append(sender.characters_without_null_termination(), sender_length);
+    m_arena.append(text.characters_without_null_termination(), text_length);
+}
+
+IRCScrollback::Line IRCScrollback::at(size_t index) const
+{
+    VERIFY(index < m_size);
+    auto& record = record_at(index);
+    auto* sender = m_arena.data() + record.arena_offset;
+    return {
+        record.timestamp,
+        record.color,
+        record.prefix,
+        record.has_sender,
+        { sender, record.sender_length },
+        { sender + record.sender_length, record.text_length },
+    };
+}
+
+void IRCScrollback::evict_oldest()
+{
+    VERIFY(m_size > 0);
+    m_head = (m_head + 1) % m_max_line_count;
+    --m_size;
+    ++m_first_line_number;
+
+    if (m_size == 0) {
+        m_arena.clear_with_capacity();
+        return;
+    }
+    size_t dead_bytes = record_at(0).arena_offset;
+    if (dead_bytes >= minimum_arena_size_to_compact && dead_bytes * 2 >= m_arena.size())
+        compact_arena();
+}
+
+void IRCScrollback::compact_arena()
+{
+    size_t dead_bytes = record_at(0).arena_offset;
+    size_t live_bytes = m_arena.size() - dead_bytes;
+    memmove(m_arena.data(), m_arena.data() + dead_bytes, live_bytes);
+    m_arena.resize(live_bytes, true);
+    for (size_t i = 0; i < m_size; ++i)
+        m_records[(m_head + i) % m_max_line_count].arena_offset -= dead_bytes;
+}
+
+void IRCScrollback::clear()
+{
+    m_first_line_number += m_size;
+    m_head = 0;
+    m_size = 0;
+    m_arena.clear_with_capacity();
+}
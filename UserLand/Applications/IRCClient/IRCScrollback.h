@@ -0,0 +1,67 @@
+#pragma once
+
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <time.h>
+
+// A bounded history of log lines. Lines are compact records in a ring, and
+// their nick and text live back to back in one shared byte arena, so a flood
+// of messages costs two memcpys per line and no String allocations. Once the
+// ring is full, adding a line evicts the oldest one.
+//
+// Every line ever added has a line number that keeps counting up across
+// evictions, which lets a view track what it has already shown.
+class IRCScrollback {
+public:
+    static constexpr size_t default_max_line_count = 2000;
+
+    struct Line {
+        time_t timestamp { 0 };
+        u32 color { 0 };
+        char prefix { 0 };
+        bool has_sender { false };
+        StringView sender;
+        StringView text;
+    };
+
+    explicit IRCScrollback(size_t max_line_count = default_max_line_count);
+
+    size_t size() const { return m_size; }
+    bool is_empty() const { return m_size == 0; }
+    size_t max_line_count() const { return m_max_line_count; }
+    void set_max_line_count(size_t);
+
+    // The number of the oldest line still held, and the number the next added line will get.
+    u64 first_line_number() const { return m_first_line_number; }
+    u64 end_line_number() const { return m_first_line_number + m_size; }
+
+    void append(time_t timestamp, u32 color, char prefix, bool has_sender, const StringView& sender, const StringView& text);
+
+    // 0 is the oldest line still held. The views in a Line are only valid until the next append().
+    Line at(size_t index) const;
+    Line line_with_number(u64 number) const { return at(number - m_first_line_number); }
+
+    void clear();
+
+private:
+    struct Record {
+        time_t timestamp;
+        u32 color;
+        u32 arena_offset;
+        u32 text_length;
+        u16 sender_length;
+        char prefix;
+        bool has_sender;
+    };
+
+    const Record& record_at(size_t index) const { return m_records[(m_head + index) % m_max_line_count]; }
+    void evict_oldest();
+    void compact_arena();
+
+    Vector<Record> m_records;
+    Vector<char> m_arena;
+    size_t m_head { 0 };
+    size_t m_size { 0 };
+    size_t m_max_line_count { 0 };
+    u64 m_first_line_number { 0 };
+};
@@ -0,0 +1,279 @@
+#include "IRCSendQueue.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+
+// Written bytes at the front of a lane are only dropped once they make up most
+// of it, so the memmove is amortized over the lines that were written.
+static constexpr size_t minimum_written_size_to_compact = 4 * KiB;
+
+static void append(Vector<u8>& buffer, const StringView& string)
+{
+    buffer.append(reinterpret_cast<const u8*>(string.characters_without_null_termination()), string.length());
+}
+
+bool IRCSendQueue::LaneBuffer::is_in_middle_of_line() const
+{
+    auto line_start = written_line_count ? line_ends[written_line_count - 1] : 0;
+    return written != line_start;
+}
+
+void IRCSendQueue::LaneBuffer::consume(size_t size)
+{
+    written += size;
+    VERIFY(written <= released_end());
+    while (written_line_count < line_ends.size() && line_ends[written_line_count] <= written)
+        ++written_line_count;
+    if (written != buffer.size())
+        return;
+    buffer.clear_with_capacity();
+    line_ends.clear_with_capacity();
+    written = 0;
+    written_line_count = 0;
+    released_line_count = 0;
+}
+
+void IRCSendQueue::set_pacing(u64 message_cost_ms, u64 burst_window_ms)
+{
+    m_message_cost_ms = message_cost_ms;
+    m_burst_window_ms = burst_window_ms;
+}
+
+void IRCSendQueue::begin_line(Lane lane)
+{
+    if (lane == Lane::Normal)
+        m_batch = {};
+}
+
+void IRCSendQueue::end_line(Lane lane)
+{
+    auto& buffer = this->lane(lane);
+    append(buffer.buffer, "\r\n");
+    buffer.line_ends.append(buffer.buffer.size());
+}
+
+void IRCSendQueue::enqueue(Lane lane, const StringView& command, std::initializer_list<StringView> parameters, const StringView& trailing)
+{
+    begin_line(lane);
+    auto& buffer = this->lane(lane).buffer;
+    append(buffer, command);
+    for (auto& parameter : parameters) {
+        buffer.append(' ');
+        append(buffer, parameter);
+    }
+    if (!trailing.is_null()) {
+        append(buffer, " :");
+        append(buffer, trailing);
+    }
+    end_line(lane);
+}
+
+void IRCSendQueue::enqueue_raw(Lane lane, const StringView& line)
+{
+    begin_line(lane);
+    append(this->lane(lane).buffer, line);
+    end_line(lane);
+}
+
+bool IRCSendQueue::can_merge(BatchKind kind, const StringView& channel, size_t added_length) const
+{
+    if (m_batch.kind != kind)
+        return false;
+    auto& normal = lane(Lane::Normal);
+    if (!normal.last_line_is_unreleased())
+        return false;
+    auto line_length = normal.line_ends.last() - 2 - m_batch.line_start;
+    if (line_length + added_length > max_line_length)
+        return false;
+    if (kind == BatchKind::Mode) {
+        if (m_batch.mode_count >= m_max_modes_per_line)
+            return false;
+        StringView batch_channel { normal.buffer.data() + m_batch.line_start + 5, m_batch.channel_length };
+        if (!batch_channel.equals_ignoring_case(channel))
+            return false;
+    }
+    return true;
+}
+
+void IRCSendQueue::enqueue_join(const StringView& channel)
+{
+    // A channel key would have to go into a second list, so only plain channel names are merged.
+    bool mergeable = !channel.contains(' ') && !channel.contains(',');
+    auto& normal = lane(Lane::Normal);
+    if (mergeable && can_merge(BatchKind::Join, channel, 1 + channel.length())) {
+        normal.buffer.resize(normal.buffer.size() - 2, true);
+        normal.line_ends.take_last();
+        normal.buffer.append(',');
+        append(normal.buffer, channel);
+        end_line(Lane::Normal);
+        return;
+    }
+
+    auto line_start = normal.buffer.size();
+    enqueue(Lane::Normal, "JOIN", { channel });
+    if (mergeable)
+        m_batch = { BatchKind::Join, line_start };
+}
+
+void IRCSendQueue::enqueue_mode(const StringView& channel, char sign, char mode, const StringView& argument)
+{
+    VERIFY(sign == '+' || sign == '-');
+    VERIFY(!argument.is_empty());
+    auto& normal = lane(Lane::Normal);
+    size_t added_length = (sign != m_batch.last_sign) + 1 + 1 + argument.length();
+    if (can_merge(BatchKind::Mode, channel, added_length)) {
+        normal.buffer.resize(normal.buffer.size() - 2, true);
+        normal.line_ends.take_last();
+        if (sign != m_batch.last_sign)
+            normal.buffer.insert(m_batch.modes_end++, sign);
+        normal.buffer.insert(m_batch.modes_end++, mode);
+        normal.buffer.append(' ');
+        append(normal.buffer, argument);
+        end_line(Lane::Normal);
+        ++m_batch.mode_count;
+        m_batch.last_sign = sign;
+        return;
+    }
+
+    begin_line(Lane::Normal);
+    auto line_start = normal.buffer.size();
+    append(normal.buffer, "MODE ");
+    append(normal.buffer, channel);
+    normal.buffer.append(' ');
+    normal.buffer.append(sign);
+    normal.buffer.append(mode);
+    auto modes_end = normal.buffer.size();
+    normal.buffer.append(' ');
+    append(normal.buffer, argument);
+    end_line(Lane::Normal);
+    m_batch = { BatchKind::Mode, line_start, channel.length(), modes_end, 1, sign };
+}
+
+bool IRCSendQueue::is_empty() const
+{
+    for (auto& lane : m_lanes) {
+        if (lane.written != lane.buffer.size())
+            return false;
+    }
+    return true;
+}
+
+size_t IRCSendQueue::line_count() const
+{
+    size_t count = 0;
+    for (auto& lane : m_lanes) {
+        for (auto end : lane.line_ends) {
+            if (end > lane.written)
+                ++count;
+        }
+    }
+    return count;
+}
+
+void IRCSendQueue::clear()
+{
+    for (auto& lane : m_lanes)
+        lane = {};
+    m_batch = {};
+}
+
+void IRCSendQueue::charge(u64 now_ms)
+{
+    m_penalty_until_ms = max(m_penalty_until_ms, now_ms) + m_message_cost_ms;
+}
+
+void IRCSendQueue::release(u64 now_ms)
+{
+    auto& urgent = lane(Lane::Urgent);
+    for (; urgent.last_line_is_unreleased(); ++urgent.released_line_count)
+        charge(now_ms);
+
+    auto& normal = lane(Lane::Normal);
+    while (normal.last_line_is_unreleased() && max(m_penalty_until_ms, now_ms) - now_ms < m_burst_window_ms) {
+        ++normal.released_line_count;
+        charge(now_ms);
+    }
+}
+
+Optional<u64> IRCSendQueue::ms_until_next_release(u64 now_ms) const
+{
+    if (!lane(Lane::Normal).last_line_is_unreleased())
+        return {};
+    auto penalty_until_ms = max(m_penalty_until_ms, now_ms);
+    if (penalty_until_ms - now_ms < m_burst_window_ms)
+        return 0;
+    return penalty_until_ms - m_burst_window_ms - now_ms + 1;
+}
+
+IRCSendQueue::FlushResult IRCSendQueue::flush(int fd, u64 now_ms)
+{
+    release(now_ms);
+    for (;;) {
+        iovec iov[static_cast<size_t>(Lane::__Count)];
+        LaneBuffer* iov_lanes[static_cast<size_t>(Lane::__Count)];
+        int iov_count = 0;
+        // Lines must not interleave on the wire, so a line that was only partially written
+        // is finished before anything else goes out, even an urgent one.
+        for (auto& lane : m_lanes) {
+            if (lane.is_in_middle_of_line()) {
+                auto line_end = lane.line_ends[lane.written_line_count];
+                iov_lanes[iov_count] = &lane;
+                iov[iov_count++] = { lane.buffer.data() + lane.written, line_end - lane.written };
+                break;
+            }
+        }
+        if (!iov_count) {
+            for (auto& lane : m_lanes) {
+                auto size = lane.released_end() - lane.written;
+                if (!size)
+                    continue;
+                iov_lanes[iov_count] = &lane;
+                iov[iov_count++] = { lane.buffer.data() + lane.written, size };
+            }
+        }
+        if (!iov_count)
+            return FlushResult::Done;
+
+        auto nwritten = writev(fd, iov, iov_count);
+        if (nwritten < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return FlushResult::WouldBlock;
+            return FlushResult::Error;
+        }
+
+        size_t remaining = nwritten;
+        for (int i = 0; i < iov_count; ++i) {
+            auto size = min(remaining, iov[i].iov_len);
+            iov_lanes[i]->consume(size);
+            remaining -= size;
+        }
+        compact(Lane::Urgent);
+        compact(Lane::Normal);
+    }
+}
+
+void IRCSendQueue::compact(Lane lane)
+{
+    auto& buffer = this->lane(lane);
+    auto written = buffer.written;
+    if (written < minimum_written_size_to_compact || written * 2 < buffer.buffer.size() || buffer.is_in_middle_of_line())
+        return;
+
+    buffer.line_ends.remove(0, buffer.written_line_count);
+    for (auto& end : buffer.line_ends)
+        end -= written;
+    buffer.released_line_count -= buffer.written_line_count;
+    buffer.written_line_count = 0;
+
+    memmove(buffer.buffer.data(), buffer.buffer.data() + written, buffer.buffer.size() - written);
+    buffer.buffer.resize(buffer.buffer.size() - written, true);
+    buffer.written = 0;
+
+    if (lane == Lane::Normal && m_batch.kind != BatchKind::None) {
+        m_batch.line_start -= written;
+        if (m_batch.kind == BatchKind::Mode)
+            m_batch.modes_end -= written;
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <initializer_list>
+
+// Outgoing lines wait here until the socket is writable and the server's
+// flood limit allows them. Lines are appended straight into one reusable
+// buffer per lane and written with a single writev() per flush.
+//
+// Pacing follows the classic ircd penalty scheme: every line costs
+// message_cost_ms, and lines may be sent as long as the accumulated penalty
+// stays within burst_window_ms of the current time. Urgent lines (PONG) are
+// charged as well but never wait.
+//
+// Consecutive JOINs and MODE changes on the same channel that have not been
+// released yet are merged into one line, as far as the protocol allows.
+class IRCSendQueue {
+public:
+    enum class Lane {
+        Urgent,
+        Normal,
+        __Count,
+    };
+
+    enum class FlushResult {
+        Done,
+        WouldBlock,
+        Error,
+    };
+
+    // The longest line servers accept, without the CRLF.
+    static constexpr size_t max_line_length = 510;
+    static constexpr u64 default_message_cost_ms = 2000;
+    static constexpr u64 default_burst_window_ms = 10000;
+    static constexpr size_t default_max_modes_per_line = 3;
+
+    void set_pacing(u64 message_cost_ms, u64 burst_window_ms);
+    void set_max_modes_per_line(size_t max_modes) { m_max_modes_per_line = max(max_modes, (size_t)1); }
+
+    // Parameters must not contain spaces; the trailing parameter is omitted if it is null.
+    void enqueue(Lane, const StringView& command, std::initializer_list<StringView> parameters, const StringView& trailing = {});
+    void enqueue_raw(Lane, const StringView& line);
+    void enqueue_join(const StringView& channel);
+    void enqueue_mode(const StringView& channel, char sign, char mode, const StringView& argument);
+
+    bool is_empty() const;
+    size_t line_count() const;
+    void clear();
+
+    // Writes as many released lines to the fd as it accepts. On Error, errno is set.
+    FlushResult flush(int fd, u64 now_ms);
+
+    // How long until more queued lines may be released, if any are held back by pacing.
+    Optional<u64> ms_until_next_release(u64 now_ms) const;
+
+private:
+    struct LaneBuffer {
+        Vector<u8> buffer;
+        // The end offsets of all lines that are not completely written yet.
+        Vector<size_t> line_ends;
+        // Bytes before this have been written to the fd.
+        size_t written { 0 };
+        size_t written_line_count { 0 };
+        size_t released_line_count { 0 };
+
+        size_t released_end() const { return released_line_count ? line_ends[released_line_count - 1] : written; }
+        bool last_line_is_unreleased() const { return released_line_count < line_ends.size(); }
+        bool is_in_middle_of_line() const;
+        void consume(size_t);
+    };
+
+    enum class BatchKind {
+        None,
+        Join,
+        Mode,
+    };
+
+    // The unreleased line at the end of the normal lane that later JOINs or MODEs may be merged into.
+    struct Batch {
+        BatchKind kind { BatchKind::None };
+        size_t line_start { 0 };
+        size_t channel_length { 0 };
+        size_t modes_end { 0 };
+        size_t mode_count { 0 };
+        char last_sign { 0 };
+    };
+
+    LaneBuffer& lane(Lane lane) { return m_lanes[static_cast<size_t>(lane)]; }
+    const LaneBuffer& lane(Lane lane) const { return m_lanes[static_cast<size_t>(lane)]; }
+
+    void begin_line(Lane);
+    void end_line(Lane);
+    bool can_merge(BatchKind, const StringView& channel, size_t added_length) const;
+    void compact(Lane);
+    void release(u64 now_ms);
+    void charge(u64 now_ms);
+
+    LaneBuffer m_lanes[static_cast<size_t>(Lane::__Count)];
+    Batch m_batch;
+
+    u64 m_message_cost_ms { default_message_cost_ms };
+    u64 m_burst_window_ms { default_burst_window_ms };
+    u64 m_penalty_until_ms { 0 };
+    size_t m_max_modes_per_line { default_max_modes_per_line };
+};
@@ -3,6 +3,7 @@
 #include "IRCChannel.h"
 #include "IRCChannelMemberListModel.h"
 #include "IRCClient.h"
+#include "IRCLogBuffer.h"
 #include <AK/StringBuilder.h>
 #include <LibGUI/Action.h>
 #include <LibGUI/BoxLayout.h>
@@ -182,12 +183,22 @@ IRCWindow::IRCWindow(IRCClient& client, void* owner, Type type, const String& na
 
 IRCWindow::~IRCWindow()
 {
+    if (m_log_buffer)
+        m_log_buffer->on_flush = nullptr;
     m_client->unregister_subwindow(*this);
 }
 
 void IRCWindow::set_log_buffer(const IRCLogBuffer& log_buffer)
 {
+    if (m_log_buffer)
+        m_log_buffer->on_flush = nullptr;
     m_log_buffer = &log_buffer;
+    m_log_buffer->on_flush = [this] {
+        if (!m_should_scroll_to_bottom)
+            return;
+        m_should_scroll_to_bottom = false;
+        m_page_view->scroll_to_bottom();
+    };
     m_page_view->set_document(const_cast<Web::DOM::Document*>(&log_buffer.document()));
 }
 
@@ -236,7 +247,7 @@ void IRCWindow::did_add_message(const String& name, const String& message)
         m_client->aid_update_window_list();
         return;
     }
-    m_page_view->scroll_to_bottom();
+    m_should_scroll_to_bottom = true;
 }
 
 void IRCWindow::clear_unread_count()
@@ -53,4 +53,6 @@ private:
     RefPtr<IRCLogBuffer> m_log_buffer;
     RefPtr<GUI::Menu> m_context_menu;
     int m_unread_count { 0 };
+    // The lines of a message only get laid out when the log buffer flushes, so that's when to scroll to them.
+    bool m_should_scroll_to_bottom { false };
 };